@@ -0,0 +1,325 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/core/objectmodel/Data.h>
+#include <sofa/core/DataEngine.h>
+#include <sofa/core/DataTracker.h>
+#include <sofa/simulation/DataGraphUpdate.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+
+namespace sofa {
+
+using core::objectmodel::DDGNode;
+using core::objectmodel::Data;
+
+/// output = a + b
+class SumEngine : public core::DataEngine
+{
+public:
+    SOFA_CLASS(SumEngine,core::DataEngine);
+
+    Data<int> a;
+    Data<int> b;
+    Data<int> output;
+    int nbUpdates;
+
+    SumEngine()
+        : a(initData(&a,0,"a","a"))
+        , b(initData(&b,0,"b","b"))
+        , output(initData(&output,0,"output","output"))
+        , nbUpdates(0)
+    {}
+
+    void init() override
+    {
+        addInput(&a);
+        addInput(&b);
+        addOutput(&output);
+        setDirtyValue();
+    }
+
+    void reinit() override
+    {
+        update();
+    }
+
+    void doUpdate() override
+    {
+        ++nbUpdates;
+        output.setValue(a.getValue() + b.getValue());
+    }
+};
+
+struct CountFunctor
+{
+    int nbCalls;
+    CountFunctor() : nbCalls(0) {}
+    void operator()(DDGNode*) { ++nbCalls; }
+};
+
+/// Counts the calls to setDirtyValue, as a plugin overriding it would do
+class CountingNode : public DDGNode
+{
+public:
+    int nbCalls;
+    std::string name;
+
+    CountingNode() : nbCalls(0), name("counting") {}
+
+    void setDirtyValue(const core::ExecParams* params = 0) override
+    {
+        ++nbCalls;
+        DDGNode::setDirtyValue(params);
+    }
+
+    void update() override { cleanDirty(); }
+    const std::string& getName() const override { return name; }
+    core::objectmodel::Base* getOwner() const override { return NULL; }
+    core::objectmodel::BaseData* getData() const override { return NULL; }
+};
+
+/** Test suite for the dirty flags propagation.
+ *  source -> chain[0] -> ... -> chain[N-1] -> engine1.a, and source -> engine1.b, engine1 -> engine2.a
+ */
+struct DDGNode_test: public BaseTest
+{
+    enum { N = 10 };
+    Data<int> source;
+    Data<int> chain[N];
+    SumEngine engine1;
+    SumEngine engine2;
+
+    void SetUp()
+    {
+        chain[0].setParent(&source);
+        for (int i=1; i<N; ++i)
+            chain[i].setParent(&chain[i-1]);
+        engine1.a.setParent(&chain[N-1]);
+        engine1.b.setParent(&source);
+        engine2.a.setParent(&engine1.output);
+        engine1.init();
+        engine2.init();
+    }
+
+    void testPropagation()
+    {
+        for (int v=1; v<5; ++v)
+        {
+            source.setValue(v);
+            for (int i=0; i<N; ++i)
+                ASSERT_TRUE(chain[i].isDirty());
+            ASSERT_TRUE(engine1.isDirty());
+            ASSERT_TRUE(engine2.output.isDirty());
+            ASSERT_EQ(2*v, engine2.output.getValue());
+            for (int i=0; i<N; ++i)
+                ASSERT_FALSE(chain[i].isDirty());
+        }
+
+        // a link added after the first writes
+        Data<int> other;
+        engine2.b.setParent(&other);
+        for (int v=1; v<4; ++v)
+        {
+            other.setValue(10*v);
+            ASSERT_TRUE(engine2.output.isDirty());
+            ASSERT_FALSE(engine1.isDirty());
+            ASSERT_EQ(8 + 10*v, engine2.output.getValue());
+        }
+    }
+
+    void testOverriddenSetDirtyValue()
+    {
+        // chain[N-1] -> node -> downstream, node overriding setDirtyValue
+        CountingNode node;
+        CountingNode downstream;
+        node.addInput(&chain[N-1]);
+        downstream.addInput(&node);
+        for (int v=1; v<5; ++v)
+        {
+            chain[N-1].getValue();
+            node.update();
+            downstream.update();
+            const int nbCalls = node.nbCalls;
+            const int nbDownstreamCalls = downstream.nbCalls;
+            source.setValue(v);
+            ASSERT_EQ(nbCalls+1, node.nbCalls);
+            ASSERT_EQ(nbDownstreamCalls+1, downstream.nbCalls);
+            ASSERT_TRUE(node.isDirty());
+            ASSERT_TRUE(downstream.isDirty());
+        }
+    }
+
+    void testDataTracker()
+    {
+        CountFunctor functor;
+        core::DataTrackerFunctor<CountFunctor> tracker(functor);
+        tracker.addInput(&chain[N-1]);
+        chain[N-1].getValue();
+        for (int v=1; v<5; ++v)
+        {
+            // the tracked Data was read, so writing the source must call the functor
+            const int nbCalls = functor.nbCalls;
+            source.setValue(v);
+            ASSERT_LT(nbCalls, functor.nbCalls);
+            chain[N-1].getValue();
+        }
+    }
+
+    void testDependencyLevels()
+    {
+        helper::vector<DDGNode*> sources(1, &source);
+        helper::vector< helper::vector<DDGNode*> > levels;
+        ASSERT_TRUE(DDGNode::getDependencyLevels(sources, levels));
+        // chain (N), engine1.a, engine1, engine1.output, engine2.a, engine2, engine2.output
+        ASSERT_EQ((std::size_t)N+6, levels.size());
+        ASSERT_EQ(2u, levels[0].size()); // chain[0] and engine1.b
+        ASSERT_EQ(&engine2.output, levels.back()[0]);
+    }
+
+    void testCycle()
+    {
+        CountingNode x, y;
+        x.addInput(&y);
+        y.addInput(&x);
+        x.update();
+        y.update();
+        x.setDirtyValue();
+        ASSERT_TRUE(y.isDirty());
+
+        helper::vector<DDGNode*> sources(1, &x);
+        helper::vector< helper::vector<DDGNode*> > levels;
+        ASSERT_FALSE(DDGNode::getDependencyLevels(sources, levels));
+        ASSERT_EQ(1u, levels.size());
+
+        // x -> y is left once the cycle is broken, the levels set while it existed being fixed
+        x.delInput(&y);
+        ASSERT_TRUE(DDGNode::getDependencyLevels(sources, levels));
+        ASSERT_EQ(1u, levels.size());
+        ASSERT_EQ(&y, levels[0][0]);
+    }
+
+    void testUpdateDirtyDependencies(bool parallel)
+    {
+        source.setValue(3);
+        const int nbUpdates = engine2.nbUpdates;
+        helper::vector<DDGNode*> sources(1, &source);
+        ASSERT_TRUE(simulation::updateDirtyDependencies(sources, parallel));
+        ASSERT_FALSE(engine2.output.isDirty());
+        ASSERT_EQ(nbUpdates+1, engine2.nbUpdates);
+        ASSERT_EQ(6, engine2.output.getValue());
+    }
+};
+
+TEST_F(DDGNode_test, propagation )
+{
+    this->testPropagation();
+}
+TEST_F(DDGNode_test, overriddenSetDirtyValue )
+{
+    this->testOverriddenSetDirtyValue();
+}
+TEST_F(DDGNode_test, dataTracker )
+{
+    this->testDataTracker();
+}
+TEST_F(DDGNode_test, dependencyLevels )
+{
+    this->testDependencyLevels();
+}
+TEST_F(DDGNode_test, cycle )
+{
+    this->testCycle();
+}
+TEST_F(DDGNode_test, updateDirtyDependencies )
+{
+    this->testUpdateDirtyDependencies(false);
+}
+TEST_F(DDGNode_test, updateDirtyDependenciesParallel )
+{
+    this->testUpdateDirtyDependencies(true);
+}
+
+/** Two independent diamonds: source -> left[d], right[d] -> bottom[d], the left and right engines
+ *  of a diamond sharing both their input and their downstream nodes.
+ */
+struct DDGNodeDiamond_test: public BaseTest
+{
+    enum { D = 2 };
+    Data<int> source;
+    SumEngine left[D];
+    SumEngine right[D];
+    SumEngine bottom[D];
+
+    void SetUp()
+    {
+        for (int d=0; d<D; ++d)
+        {
+            left[d].a.setParent(&source);
+            left[d].b.setValue(d);
+            right[d].a.setParent(&source);
+            right[d].b.setValue(10*d);
+            bottom[d].a.setParent(&left[d].output);
+            bottom[d].b.setParent(&right[d].output);
+            left[d].init();
+            right[d].init();
+            bottom[d].init();
+        }
+    }
+
+    void testUpdateDirtyDependencies(bool parallel)
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        scheduler->init(4);
+        helper::vector<DDGNode*> sources(1, &source);
+        for (int v=1; v<50; ++v)
+        {
+            source.setValue(v);
+            int nbUpdates[D];
+            for (int d=0; d<D; ++d)
+                nbUpdates[d] = left[d].nbUpdates + right[d].nbUpdates + bottom[d].nbUpdates;
+            ASSERT_TRUE(simulation::updateDirtyDependencies(sources, parallel));
+            for (int d=0; d<D; ++d)
+            {
+                ASSERT_FALSE(left[d].isDirty());
+                ASSERT_FALSE(right[d].isDirty());
+                ASSERT_FALSE(bottom[d].output.isDirty());
+                ASSERT_EQ(nbUpdates[d]+3, left[d].nbUpdates + right[d].nbUpdates + bottom[d].nbUpdates);
+                ASSERT_EQ(2*v + 11*d, bottom[d].output.getValue());
+            }
+        }
+        scheduler->stop();
+    }
+};
+
+TEST_F(DDGNodeDiamond_test, updateDirtyDependencies )
+{
+    this->testUpdateDirtyDependencies(false);
+}
+TEST_F(DDGNodeDiamond_test, updateDirtyDependenciesParallel )
+{
+    this->testUpdateDirtyDependencies(true);
+}
+
+}// namespace sofa
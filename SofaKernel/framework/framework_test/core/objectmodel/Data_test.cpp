@@ -68,6 +68,59 @@ TEST_F(DataLink_test , testDataLink )
     this->testDataLink();
 }
 
+/** Test suite for the copy of the modified values between aspects.
+ *  data1 -> data2, copied from aspect 0 into aspect 1.
+ */
+struct DataCopyAspect_test: public BaseTest
+{
+    Data<int> data1;
+    Data<int> data2;
+
+    void SetUp()
+    {
+        data2.setParent(&data1);
+    }
+
+    static int getValueInAspect(const Data<int>& data, int aspect)
+    {
+        core::ExecParams* params = core::ExecParams::defaultInstance();
+        const int previous = params->aspectID();
+        params->setAspectID(aspect);
+        const int value = data.getValue();
+        params->setAspectID(previous);
+        return value;
+    }
+
+    void testCopyAspectIfModified()
+    {
+        if (core::SOFA_DATA_MAX_ASPECTS < 2)
+            return; // the aspects are disabled, see SOFA_MAX_THREADS
+
+        data1.setValue(1);
+        ASSERT_TRUE(data1.copyAspectIfModified(1, 0));
+        ASSERT_EQ(1, getValueInAspect(data1, 1));
+        // not modified since the last copy
+        ASSERT_FALSE(data1.copyAspectIfModified(1, 0));
+        data1.setValue(2);
+        ASSERT_TRUE(data1.copyAspectIfModified(1, 0));
+        ASSERT_EQ(2, getValueInAspect(data1, 1));
+
+        // data2 is dirty: not copied until it is computed in the source aspect
+        ASSERT_TRUE(data2.isDirty());
+        ASSERT_FALSE(data2.copyAspectIfModified(1, 0));
+        ASSERT_EQ(2, data2.getValue());
+        ASSERT_TRUE(data2.copyAspectIfModified(1, 0));
+        // the copy is clean in the destination aspect
+        ASSERT_FALSE(data2.isDirtyAspect(1));
+        ASSERT_EQ(2, getValueInAspect(data2, 1));
+    }
+};
+
+TEST_F(DataCopyAspect_test , copyAspectIfModified )
+{
+    this->testCopyAspectIfModified();
+}
+
 /** Test suite for vectorData
  *
  * @author Thomas Lemaire @date 2014
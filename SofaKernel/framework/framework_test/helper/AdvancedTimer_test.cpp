@@ -0,0 +1,182 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/AdvancedTimer.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+using sofa::helper::AdvancedTimer;
+
+namespace
+{
+
+/// number of occurrences of a substring
+std::size_t count(const std::string& str, const std::string& sub)
+{
+    std::size_t n = 0;
+    for (std::size_t pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos+sub.size()))
+        ++n;
+    return n;
+}
+
+void recordSteps(const char* threadName)
+{
+    AdvancedTimer::setTraceThreadName(threadName);
+    for (int i=0; i<3; ++i)
+    {
+        AdvancedTimer::stepBegin("TraceOuter");
+        AdvancedTimer::stepBegin(SOFA_TRACE_ID("TraceInner"));
+        AdvancedTimer::step("TraceInstant", "obj\"1");
+        AdvancedTimer::stepEnd(SOFA_TRACE_ID("TraceInner"));
+        AdvancedTimer::stepEnd("TraceOuter");
+    }
+}
+
+}
+
+TEST(AdvancedTimer_test, traceTwoThreads)
+{
+    AdvancedTimer::setTraceEnabled(true);
+    AdvancedTimer::clearTrace();
+    std::thread worker(recordSteps, "TraceWorker");
+    recordSteps("TraceMain");
+    worker.join();
+    AdvancedTimer::setTraceEnabled(false);
+
+    std::ostringstream out;
+    AdvancedTimer::writeChromeTrace(out);
+    const std::string json = out.str();
+
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_EQ(1u, count(json, "\"args\":{\"name\":\"TraceWorker\"}"));
+    EXPECT_EQ(1u, count(json, "\"args\":{\"name\":\"TraceMain\"}"));
+    EXPECT_EQ(6u, count(json, "{\"name\":\"TraceOuter\",\"cat\":\"sofa\",\"ph\":\"B\""));
+    EXPECT_EQ(6u, count(json, "{\"name\":\"TraceOuter\",\"cat\":\"sofa\",\"ph\":\"E\""));
+    EXPECT_EQ(6u, count(json, "{\"name\":\"TraceInner\",\"cat\":\"sofa\",\"ph\":\"B\""));
+    EXPECT_EQ(6u, count(json, "{\"name\":\"TraceInner\",\"cat\":\"sofa\",\"ph\":\"E\""));
+    EXPECT_EQ(6u, count(json, "\"args\":{\"object\":\"obj\\\"1\"}"));
+}
+
+TEST(AdvancedTimer_test, traceDisabled)
+{
+    AdvancedTimer::setTraceEnabled(false);
+    AdvancedTimer::clearTrace();
+    recordSteps("TraceMain");
+
+    std::ostringstream out;
+    AdvancedTimer::writeChromeTrace(out);
+    EXPECT_EQ(0u, count(out.str(), "TraceOuter"));
+}
+
+TEST(AdvancedTimer_test, traceThreadName)
+{
+    AdvancedTimer::setTraceEnabled(false);
+    AdvancedTimer::clearTrace();
+
+    // a thread named while the trace is disabled is not registered
+    std::thread idle([]() { AdvancedTimer::setTraceThreadName("TraceIdle"); });
+    idle.join();
+
+    // the name given before the first event is used once the thread records
+    std::atomic<bool> named(false), enabled(false);
+    std::thread worker([&named, &enabled]()
+    {
+        AdvancedTimer::setTraceThreadName("TraceNamed");
+        named = true;
+        while (!enabled)
+            std::this_thread::yield();
+        AdvancedTimer::stepBegin("TraceOuter");
+        AdvancedTimer::stepEnd("TraceOuter");
+    });
+    while (!named)
+        std::this_thread::yield();
+    AdvancedTimer::setTraceEnabled(true);
+    enabled = true;
+    worker.join();
+    AdvancedTimer::setTraceEnabled(false);
+
+    std::ostringstream out;
+    AdvancedTimer::writeChromeTrace(out);
+    const std::string json = out.str();
+    EXPECT_EQ(0u, count(json, "TraceIdle"));
+    EXPECT_EQ(1u, count(json, "\"args\":{\"name\":\"TraceNamed\"}"));
+}
+
+TEST(AdvancedTimer_test, traceOverflow)
+{
+    AdvancedTimer::setTraceCapacity(16);
+    AdvancedTimer::setTraceEnabled(true);
+    std::thread worker([]()
+    {
+        AdvancedTimer::stepBegin("TraceRoot");
+        for (int i=0; i<100; ++i)
+        {
+            AdvancedTimer::stepBegin("TraceLoop");
+            AdvancedTimer::stepEnd("TraceLoop");
+        }
+        AdvancedTimer::stepEnd("TraceRoot");
+    });
+    worker.join();
+    AdvancedTimer::setTraceEnabled(false);
+    AdvancedTimer::setTraceCapacity(1 << 16);
+
+    std::ostringstream out;
+    AdvancedTimer::writeChromeTrace(out);
+    const std::string json = out.str();
+    // only the last events are kept, and the end of the root step has no begin anymore
+    EXPECT_EQ(0u, count(json, "\"TraceRoot\""));
+    EXPECT_GE(8u, count(json, "{\"name\":\"TraceLoop\",\"cat\":\"sofa\",\"ph\":\"B\""));
+    EXPECT_EQ(count(json, "{\"name\":\"TraceLoop\",\"cat\":\"sofa\",\"ph\":\"B\""),
+              count(json, "{\"name\":\"TraceLoop\",\"cat\":\"sofa\",\"ph\":\"E\""));
+}
+
+TEST(AdvancedTimer_test, traceWhileRecording)
+{
+    const int nbSteps = 20000;
+    AdvancedTimer::setTraceEnabled(true);
+    AdvancedTimer::clearTrace();
+    std::atomic<bool> done(false);
+    std::thread worker([&done, nbSteps]()
+    {
+        for (int i=0; i<nbSteps; ++i)
+        {
+            AdvancedTimer::stepBegin(SOFA_TRACE_ID("TraceConcurrent"));
+            AdvancedTimer::stepEnd(SOFA_TRACE_ID("TraceConcurrent"));
+        }
+        done = true;
+    });
+
+    // the buffers are swapped while the worker records: each begin event is written exactly once
+    std::size_t nbBegin = 0;
+    bool finished = false;
+    while (!finished)
+    {
+        finished = done;
+        std::ostringstream out;
+        AdvancedTimer::writeChromeTrace(out);
+        nbBegin += count(out.str(), "{\"name\":\"TraceConcurrent\",\"cat\":\"sofa\",\"ph\":\"B\"");
+    }
+    worker.join();
+    AdvancedTimer::setTraceEnabled(false);
+    EXPECT_EQ((std::size_t)nbSteps, nbBegin);
+}
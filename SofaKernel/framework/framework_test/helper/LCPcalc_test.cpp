@@ -0,0 +1,152 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/LCPcalc.h>
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <cmath>
+#include <vector>
+
+namespace sofa {
+
+using helper::LocalBlock33;
+
+/// The previous version of nlcp_gaussseidel, which accumulated the rows of a contact with a single sum each
+/// (without the minW and maxF options)
+int referenceGaussSeidel(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF)
+{
+    const int numContacts = dim/3;
+    if (!useInitialF)
+        for (int i=0; i<dim; i++) f[i] = 0;
+    std::vector<LocalBlock33> W33(numContacts);
+
+    for (int it=0; it<numItMax; it++)
+    {
+        double error = 0;
+        for (int c=0; c<numContacts; c++)
+        {
+            const double f_1[3] = { f[3*c], f[3*c+1], f[3*c+2] };
+            helper::set3Dof(f,c,0.0,0.0,0.0);
+
+            double dn=dfree[3*c], dt=dfree[3*c+1], ds=dfree[3*c+2];
+            for (int i=0; i<dim; i++)
+            {
+                dn += W[3*c  ][i]*f[i];
+                dt += W[3*c+1][i]*f[i];
+                ds += W[3*c+2][i]*f[i];
+            }
+            double d_1[3];
+            for (int k=0; k<3; k++)
+                d_1[k] = (k==0 ? dn : k==1 ? dt : ds) + W[3*c+k][3*c]*f_1[0] + W[3*c+k][3*c+1]*f_1[1] + W[3*c+k][3*c+2]*f_1[2];
+
+            if (!W33[c].computed)
+                W33[c].compute(W[3*c][3*c],W[3*c][3*c+1],W[3*c][3*c+2],W[3*c+1][3*c+1],W[3*c+1][3*c+2],W[3*c+2][3*c+2]);
+            double fn=f_1[0], ft=f_1[1], fs=f_1[2];
+            W33[c].GS_State(mu,dn,dt,ds,fn,ft,fs);
+            error += helper::absError(dn,dt,ds,d_1[0],d_1[1],d_1[2]);
+            helper::set3Dof(f,c,fn,ft,fs);
+        }
+        if (error < tol*(numContacts+1))
+            return 1;
+    }
+    return 0;
+}
+
+/** Test suite for the Gauss-Seidel friction contact solver: the current kernel must give the result of the
+ *  previous one on a dense symmetric positive definite compliance.
+ */
+struct LCPcalc_test: public BaseTest
+{
+    int dim;
+    std::vector<double> dfree;
+    std::vector< std::vector<double> > Wvalues;
+    std::vector<double*> W;
+
+    /// W = A A^T + I / 2 with coupled contacts, and half of the contacts interpenetrating.
+    /// An odd number of contacts exercises the remainder of the unrolled products.
+    void createProblem(int numContacts)
+    {
+        dim = 3*numContacts;
+        std::vector<double> A(dim*dim);
+        for (int i=0; i<dim; i++)
+            for (int j=0; j<dim; j++)
+                A[i*dim+j] = 0.3*std::sin(1.3*i + 0.7*j*j + 0.1) / std::sqrt((double)dim);
+        Wvalues.assign(dim, std::vector<double>(dim, 0.0));
+        W.resize(dim);
+        for (int i=0; i<dim; i++)
+        {
+            for (int j=0; j<dim; j++)
+                for (int k=0; k<dim; k++)
+                    Wvalues[i][j] += A[i*dim+k]*A[j*dim+k];
+            Wvalues[i][i] += 0.5;
+            W[i] = Wvalues[i].data();
+        }
+        dfree.resize(dim);
+        for (int c=0; c<numContacts; c++)
+        {
+            dfree[3*c] = (c%2 ? 0.1 : -1.0) * (1.0 + 0.5*std::sin((double)c));
+            dfree[3*c+1] = 0.3*std::cos(2.0*c);
+            dfree[3*c+2] = 0.2*std::sin(3.0*c+1);
+        }
+    }
+
+    void compareWithReference(int numContacts, double mu, int numItMax, bool useInitialF, bool converged)
+    {
+        createProblem(numContacts);
+        std::vector<double> expected(dim), f(dim);
+        if (useInitialF)
+        {
+            for (int i=0; i<dim; i++)
+                expected[i] = f[i] = (i%3 == 0) ? 0.5 : 0.01*i;
+        }
+
+        const int expectedResult = referenceGaussSeidel(dim, dfree.data(), W.data(), expected.data(), mu, 1e-12, numItMax, useInitialF);
+        const int result = helper::nlcp_gaussseidel(dim, dfree.data(), W.data(), f.data(), mu, 1e-12, numItMax, useInitialF);
+        EXPECT_EQ(converged ? 1 : 0, expectedResult);
+        EXPECT_EQ(expectedResult, result);
+
+        double maxForce = 0;
+        for (int i=0; i<dim; i++)
+            maxForce = std::max(maxForce, std::fabs(expected[i]));
+        EXPECT_LT(0.0, maxForce);
+        for (int i=0; i<dim; i++)
+            EXPECT_NEAR(expected[i], f[i], 1e-10*maxForce) << "row " << i;
+    }
+};
+
+TEST_F(LCPcalc_test, gaussSeidelConverged)
+{
+    this->compareWithReference(25, 0.6, 1000, false, true);
+}
+
+TEST_F(LCPcalc_test, gaussSeidelFewIterations)
+{
+    this->compareWithReference(25, 0.6, 3, false, false);
+}
+
+TEST_F(LCPcalc_test, gaussSeidelInitialForce)
+{
+    this->compareWithReference(24, 0.3, 1000, true, true);
+}
+
+} // namespace sofa
@@ -0,0 +1,172 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/BinaryMatrixFile.h>
+#include <sofa/helper/vector.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+
+using sofa::helper::io::BinaryMatrixFile;
+using sofa::helper::vector;
+
+namespace
+{
+
+const char* filename = "BinaryMatrixFile_test.bin";
+const std::size_t n = 37;
+const std::uint64_t key = BinaryMatrixFile::hash(std::string("BinaryMatrixFile_test"));
+
+vector<double> makeMatrix()
+{
+    vector<double> m(n*n);
+    for (std::size_t i=0; i<n; ++i)
+        for (std::size_t j=0; j<n; ++j)
+            m[i*n+j] = (i==j) ? 100.0 + i : std::sin(0.1*(i+j)) * 1e-3 * (i+1);
+    return m;
+}
+
+void checkMatrix(const vector<double>& expected, const vector<double>& values, double tolerance)
+{
+    ASSERT_EQ(expected.size(), values.size());
+    for (std::size_t i=0; i<n; ++i)
+    {
+        double rowMax = 0;
+        for (std::size_t j=0; j<n; ++j)
+            rowMax = std::max(rowMax, std::fabs(expected[i*n+j]));
+        for (std::size_t j=0; j<n; ++j)
+            EXPECT_NEAR(expected[i*n+j], values[i*n+j], tolerance * rowMax);
+    }
+}
+
+TEST(BinaryMatrixFile, double)
+{
+    const vector<double> m = makeMatrix();
+    ASSERT_TRUE(BinaryMatrixFile::write(filename, key, &m[0], n, BinaryMatrixFile::ENCODING_DOUBLE));
+    BinaryMatrixFile file;
+    ASSERT_TRUE(file.open(filename, key, n));
+    EXPECT_EQ(BinaryMatrixFile::ENCODING_DOUBLE, file.getEncoding());
+    EXPECT_FALSE(file.isSymmetric());
+    // used in place
+    const double* values = file.getDoubleValues();
+    ASSERT_TRUE(values != NULL);
+    EXPECT_EQ(0u, (std::size_t)values % 64);
+    EXPECT_TRUE(file.getFloatValues() == NULL);
+    for (std::size_t i=0; i<n*n; ++i)
+        EXPECT_EQ(m[i], values[i]);
+    file.close();
+    std::remove(filename);
+}
+
+TEST(BinaryMatrixFile, float)
+{
+    const vector<double> m = makeMatrix();
+    ASSERT_TRUE(BinaryMatrixFile::write(filename, key, &m[0], n, BinaryMatrixFile::ENCODING_FLOAT));
+    BinaryMatrixFile file;
+    ASSERT_TRUE(file.open(filename, key, n));
+    EXPECT_TRUE(file.getDoubleValues() == NULL);
+    ASSERT_TRUE(file.getFloatValues() != NULL);
+    vector<double> values(n*n);
+    file.read(&values[0]);
+    checkMatrix(m, values, 1e-7);
+    file.close();
+    std::remove(filename);
+}
+
+TEST(BinaryMatrixFile, half)
+{
+    const vector<double> m = makeMatrix();
+    ASSERT_TRUE(BinaryMatrixFile::write(filename, key, &m[0], n, BinaryMatrixFile::ENCODING_HALF));
+    BinaryMatrixFile file;
+    ASSERT_TRUE(file.open(filename, key, n));
+    EXPECT_EQ(BinaryMatrixFile::ENCODING_HALF, file.getEncoding());
+    EXPECT_TRUE(file.getDoubleValues() == NULL);
+    vector<double> values(n*n);
+    file.read(&values[0]);
+    checkMatrix(m, values, 1e-3);
+    vector<float> floatValues(n*n);
+    file.read(&floatValues[0]);
+    for (std::size_t i=0; i<n*n; ++i)
+        EXPECT_FLOAT_EQ((float)values[i], floatValues[i]);
+    file.close();
+    std::remove(filename);
+}
+
+TEST(BinaryMatrixFile, symmetric)
+{
+    vector<double> m = makeMatrix();
+    for (std::size_t i=0; i<n; ++i)
+        for (std::size_t j=0; j<i; ++j)
+            m[i*n+j] = m[j*n+i];
+    ASSERT_TRUE(BinaryMatrixFile::write(filename, key, &m[0], n, BinaryMatrixFile::ENCODING_DOUBLE, true));
+    BinaryMatrixFile file;
+    ASSERT_TRUE(file.open(filename, key, n));
+    EXPECT_TRUE(file.isSymmetric());
+    EXPECT_TRUE(file.getDoubleValues() == NULL);
+    vector<double> values(n*n);
+    file.read(&values[0]);
+    for (std::size_t i=0; i<n*n; ++i)
+        EXPECT_EQ(m[i], values[i]);
+    file.close();
+    std::remove(filename);
+}
+
+TEST(BinaryMatrixFile, staleFile)
+{
+    const vector<double> m = makeMatrix();
+    ASSERT_TRUE(BinaryMatrixFile::write(filename, key, &m[0], n, BinaryMatrixFile::ENCODING_DOUBLE));
+    BinaryMatrixFile file;
+    EXPECT_FALSE(file.open(filename, key+1, n));
+    EXPECT_FALSE(file.isOpen());
+    EXPECT_FALSE(file.open(filename, key, n+1));
+    EXPECT_FALSE(file.open("BinaryMatrixFile_test_missing.bin", key, n));
+    std::remove(filename);
+}
+
+TEST(BinaryMatrixFile, rewriteWhileMapped)
+{
+    const vector<double> m = makeMatrix();
+    ASSERT_TRUE(BinaryMatrixFile::write(filename, key, &m[0], n, BinaryMatrixFile::ENCODING_DOUBLE));
+    BinaryMatrixFile file;
+    ASSERT_TRUE(file.open(filename, key, n));
+    const double* values = file.getDoubleValues();
+    ASSERT_TRUE(values != NULL);
+
+    // the new version replaces the file, the mapping of the previous one stays valid
+    vector<double> m2(m);
+    for (std::size_t i=0; i<n*n; ++i)
+        m2[i] *= 2;
+    ASSERT_TRUE(BinaryMatrixFile::write(filename, key+1, &m2[0], n, BinaryMatrixFile::ENCODING_DOUBLE));
+    for (std::size_t i=0; i<n*n; ++i)
+        EXPECT_EQ(m[i], values[i]);
+
+    BinaryMatrixFile file2;
+    EXPECT_FALSE(file2.open(filename, key, n));
+    ASSERT_TRUE(file2.open(filename, key+1, n));
+    for (std::size_t i=0; i<n*n; ++i)
+        EXPECT_EQ(m2[i], file2.getDoubleValues()[i]);
+    file.close();
+    file2.close();
+    std::remove(filename);
+}
+
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/BinaryStateFile.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using sofa::helper::io::BinaryStateFile;
+using sofa::helper::io::BinaryStateWriter;
+using sofa::helper::io::BinaryStateReader;
+using sofa::helper::vector;
+
+namespace
+{
+
+const char* filename = "BinaryStateFile_test.bin";
+const std::size_t nbFrames = 25;
+const std::size_t nbValues = 300;
+
+double position(std::size_t frame, std::size_t i)
+{
+    return std::sin(0.1*i) * 10 + 0.01*frame*std::cos(0.3*i);
+}
+
+void writeFile(BinaryStateFile::Encoding encoding)
+{
+    BinaryStateWriter writer;
+    ASSERT_TRUE(writer.open(filename, encoding, 10));
+    vector<double> x(nbValues), v(nbValues/3);
+    for (std::size_t f=0; f<nbFrames; ++f)
+    {
+        for (std::size_t i=0; i<nbValues; ++i)
+            x[i] = position(f, i);
+        for (std::size_t i=0; i<v.size(); ++i)
+            v[i] = (double)(f*i);
+        writer.beginFrame(0.5*f);
+        writer.addVector('X', &x[0], x.size());
+        writer.addVector('V', &v[0], v.size());
+        writer.endFrame();
+    }
+    writer.close();
+}
+
+void checkFile(double tolerance)
+{
+    BinaryStateReader reader;
+    ASSERT_TRUE(reader.open(filename));
+    ASSERT_EQ(nbFrames, reader.getNbFrames());
+    ASSERT_EQ(nbFrames, reader.findFrame(-1.0));
+    ASSERT_EQ(3u, reader.findFrame(1.7));
+    ASSERT_EQ(nbFrames-1, reader.findFrame(1000.0));
+
+    vector<double> x;
+    // random access, including frames stored as a difference to a keyframe
+    const std::size_t frames[] = { 17, 3, 24, 0, 11 };
+    for (std::size_t f : frames)
+    {
+        ASSERT_EQ(0.5*f, reader.getTime(f));
+        ASSERT_TRUE(reader.readVector(f, 'X', x));
+        ASSERT_EQ(nbValues, x.size());
+        for (std::size_t i=0; i<nbValues; ++i)
+            ASSERT_NEAR(position(f, i), x[i], tolerance);
+        ASSERT_TRUE(reader.readVector(f, 'V', x));
+        ASSERT_EQ(nbValues/3, x.size());
+        ASSERT_FALSE(reader.readVector(f, 'F', x));
+    }
+}
+
+}
+
+TEST(BinaryStateFile_test, double)
+{
+    writeFile(BinaryStateFile::ENCODING_DOUBLE);
+    checkFile(0.0);
+    std::remove(filename);
+}
+
+TEST(BinaryStateFile_test, float)
+{
+    writeFile(BinaryStateFile::ENCODING_FLOAT);
+    checkFile(1e-5);
+    std::remove(filename);
+}
+
+TEST(BinaryStateFile_test, delta16)
+{
+    writeFile(BinaryStateFile::ENCODING_DELTA16);
+    // largest difference to the keyframe: 9 frames * 0.01, quantized on 16 bits
+    checkFile(0.09 / 32767);
+    std::remove(filename);
+}
+
+TEST(BinaryStateFile_test, notClosed)
+{
+    writeFile(BinaryStateFile::ENCODING_DOUBLE);
+    // remove the index, as if the simulation was interrupted
+    std::string content;
+    {
+        std::ifstream in(filename, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    content.resize(content.size() - nbFrames*sizeof(BinaryStateFile::IndexEntry) - 24);
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out.write(content.data(), content.size());
+    }
+    checkFile(0.0);
+    std::remove(filename);
+}
@@ -2,8 +2,15 @@
 
 #include <sofa/simulation/TaskScheduler.h>
 #include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/simulation/WorkStealingQueue.h>
 #include <sofa/helper/testing/BaseTest.h>
 
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
 namespace sofa
 {
 
@@ -99,4 +106,136 @@ namespace sofa
 	}
 
 
+	// fill a vector with parallel_for and sum it with parallel_reduce
+	static int64_t ParallelSum1ToN(const int64_t N, int nbThread = 0)
+	{
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        scheduler->init(nbThread);
+
+        std::vector<int64_t> values(N);
+        scheduler->parallel_for(int64_t(0), N, [&values](int64_t begin, int64_t end)
+        {
+            for (int64_t i = begin; i < end; ++i)
+                values[i] = i + 1;
+        });
+
+        const int64_t result = scheduler->parallel_reduce(int64_t(0), N, int64_t(0),
+            [&values](int64_t begin, int64_t end)
+            {
+                int64_t sum = 0;
+                for (int64_t i = begin; i < end; ++i)
+                    sum += values[i];
+                return sum;
+            },
+            [](int64_t a, int64_t b) { return a + b; });
+
+        scheduler->stop();
+		return result;
+	}
+
+	// compute the sum of integers from 1 to N with the parallel loops single thread
+	TEST(TaskSchedulerTests, ParallelForReduceSingle)
+	{
+        const int64_t N = 1 << 20;
+        int64_t res = ParallelSum1ToN(N, 1);
+		EXPECT_EQ(res, (N)*(N + 1) / 2);
+	}
+
+	// compute the sum of integers from 1 to N with the parallel loops multi thread
+	TEST(TaskSchedulerTests, ParallelForReduceMulti)
+	{
+        const int64_t N = 1 << 20;
+        int64_t res = ParallelSum1ToN(N, 4);
+		EXPECT_EQ(res, (N)*(N + 1) / 2);
+	}
+
+	// threads running the chunks of a parallel_for called from a thread the scheduler does not own
+	static std::size_t ParallelForFromExternalThread(simulation::TaskScheduler* scheduler, bool attach)
+	{
+        std::set<std::thread::id> threads;
+        std::mutex mutex;
+        std::thread external([&]()
+        {
+            if (attach)
+                EXPECT_TRUE(scheduler->attachCurrentThread("Simulation"));
+            scheduler->parallel_for(0, 64, [&](int begin, int end)
+            {
+                for (int i = begin; i < end; ++i)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }, 1);
+            if (attach)
+                scheduler->detachCurrentThread();
+        });
+        external.join();
+        return threads.size();
+	}
+
+	// an attached thread has its tasks stolen by the workers, the others run them inline
+	TEST(TaskSchedulerTests, AttachCurrentThread)
+	{
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        scheduler->init(4);
+        EXPECT_EQ(1u, ParallelForFromExternalThread(scheduler, false));
+        EXPECT_LT(1u, ParallelForFromExternalThread(scheduler, true));
+        // the slot is free again
+        EXPECT_LT(1u, ParallelForFromExternalThread(scheduler, true));
+        scheduler->stop();
+	}
+
+	// every index is visited exactly once, whatever the grain size
+	TEST(TaskSchedulerTests, ParallelForGrainSize)
+	{
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        scheduler->init(4);
+
+        const unsigned int N = 1000;
+        for (unsigned int grainSize : { 1u, 7u, 64u, 2000u })
+        {
+            std::vector<int> visits(N, 0);
+            scheduler->parallel_for(0u, N, [&visits](unsigned int begin, unsigned int end)
+            {
+                for (unsigned int i = begin; i < end; ++i)
+                    ++visits[i];
+            }, grainSize);
+
+            for (unsigned int i = 0; i < N; ++i)
+                EXPECT_EQ(visits[i], 1);
+        }
+
+        scheduler->stop();
+	}
+
+	// owner pops from the bottom, thieves steal from the top
+	TEST(TaskSchedulerTests, WorkStealingQueue)
+	{
+        simulation::WorkStealingQueue<int*, 4> queue;
+        int values[5] = { 0, 1, 2, 3, 4 };
+
+        for (int i = 0; i < 4; ++i)
+            EXPECT_TRUE(queue.push(&values[i]));
+        EXPECT_FALSE(queue.push(&values[4]));
+        EXPECT_EQ(queue.size(), 4u);
+
+        int* item = nullptr;
+        EXPECT_TRUE(queue.pop(item));
+        EXPECT_EQ(item, &values[3]);
+        EXPECT_TRUE(queue.steal(item));
+        EXPECT_EQ(item, &values[0]);
+
+        // wrap around the ring buffer
+        EXPECT_TRUE(queue.push(&values[4]));
+        EXPECT_TRUE(queue.steal(item));
+        EXPECT_EQ(item, &values[1]);
+        EXPECT_TRUE(queue.pop(item));
+        EXPECT_EQ(item, &values[4]);
+        EXPECT_TRUE(queue.pop(item));
+        EXPECT_EQ(item, &values[2]);
+        EXPECT_FALSE(queue.pop(item));
+        EXPECT_FALSE(queue.steal(item));
+        EXPECT_TRUE(queue.empty());
+	}
+
+
 } // namespace sofa
@@ -193,6 +193,16 @@ void Base::copyAspect(int destAspect, int srcAspect)
     }
 }
 
+/// Copy the source aspect to the destination aspect for each visual Data in the component.
+void Base::copyVisualAspect(int destAspect, int srcAspect)
+{
+    for(VecData::const_iterator iData = m_vecData.begin(); iData != m_vecData.end(); ++iData)
+    {
+        if ((*iData)->isVisual())
+            (*iData)->copyAspectIfModified(destAspect, srcAspect);
+    }
+}
+
 /// Release memory allocated for the specified aspect.
 void Base::releaseAspect(int aspect)
 {
@@ -306,6 +306,10 @@ public:
 
     virtual void copyAspect(int destAspect, int srcAspect);
 
+    /// Copy the Data read by the rendering (see BaseData::isVisual) from an aspect into another one.
+    /// Data which were not modified since the last copy, or not computed yet, are skipped, links are not copied.
+    void copyVisualAspect(int destAspect, int srcAspect);
+
     virtual void releaseAspect(int aspect);
     /// @}
 
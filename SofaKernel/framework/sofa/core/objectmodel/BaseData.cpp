@@ -326,6 +326,19 @@ void BaseData::copyAspect(int destAspect, int srcAspect)
     }
 }
 
+bool BaseData::copyAspectIfModified(int destAspect, int srcAspect)
+{
+    // a dirty value is not computed yet: the previous copy is kept, so that reading it never runs the engines
+    if (isDirtyAspect(srcAspect))
+        return false;
+    // the counters of both aspects match right after a copy, and only increase when the value is edited
+    if (m_counters[destAspect] == m_counters[srcAspect] && !isDirtyAspect(destAspect))
+        return false;
+    copyAspect(destAspect, srcAspect);
+    cleanDirtyAspect(destAspect);
+    return true;
+}
+
 void BaseData::releaseAspect(int aspect)
 {
     for(VecLink::const_iterator iLink = m_vecLink.begin(); iLink != m_vecLink.end(); ++iLink)
@@ -45,7 +45,7 @@ class SOFA_CORE_API BaseData : public DDGNode
 {
 public:
     /// Flags that describe some properties of a Data, and that can be OR'd together.
-    /// \todo Probably remove FLAG_PERSISTENT, FLAG_ANIMATION_INSTANCE, FLAG_VISUAL_INSTANCE and FLAG_HAPTICS_INSTANCE, it looks like they are not used anywhere.
+    /// \todo Probably remove FLAG_PERSISTENT, FLAG_ANIMATION_INSTANCE and FLAG_HAPTICS_INSTANCE, it looks like they are not used anywhere.
     enum DataFlagsEnum
     {
         FLAG_NONE       = 0,      ///< Means "no flag" when a value is required.
@@ -55,7 +55,7 @@ public:
         FLAG_AUTOLINK   = 1 << 3, ///< The Data should be autolinked when using the src="..." syntax.
         FLAG_REQUIRED = 1 << 4, ///< True if the Data has to be set for the owner component to be valid (a warning is displayed at init otherwise) 
         FLAG_ANIMATION_INSTANCE = 1 << 10,
-        FLAG_VISUAL_INSTANCE = 1 << 11,
+        FLAG_VISUAL_INSTANCE = 1 << 11, ///< The Data is read by the rendering, and copied to the aspects used by the visual loop.
         FLAG_HAPTICS_INSTANCE = 1 << 12,
     };
     /// Bit field that holds flags value.
@@ -156,6 +156,11 @@ public:
     /// Release memory allocated for the specified aspect.
     virtual void releaseAspect(int aspect) = 0;
 
+    /// Copy the value of an aspect into another one, unless it was not modified since the last copy or it is
+    /// dirty in the source aspect. The copy is clean in the destination aspect.
+    /// @return true if the value was copied.
+    bool copyAspectIfModified(int destAspect, int srcAspect);
+
     /// Get a help message that describes this %Data.
     const char* getHelp() const { return help; }
 
@@ -213,6 +218,8 @@ public:
     bool isAutoLink() const { return getFlag(FLAG_AUTOLINK); }
     /// Return whether the Data has to be set by the user for the owner component to be valid
     bool isRequired() const { return getFlag(FLAG_REQUIRED); }
+    /// Return whether this %Data is read by the rendering.
+    bool isVisual() const { return getFlag(FLAG_VISUAL_INSTANCE); }
 
     /// Set whether this %Data should be displayed in GUIs.
     void setDisplayed(bool b)  { setFlag(FLAG_DISPLAYED,b); }
@@ -224,6 +231,8 @@ public:
     void setAutoLink(bool b) { setFlag(FLAG_AUTOLINK,b); }
     /// Set whether the Data has to be set by the user for the owner component to be valid.
     void setRequired(bool b) { setFlag(FLAG_REQUIRED,b); }
+    /// Set whether this %Data is read by the rendering, and has to be copied to the aspects used by the visual loop.
+    void setVisual(bool b) { setFlag(FLAG_VISUAL_INSTANCE,b); }
     /// @}
 
     /// If we use the Data as a link and not as value directly
@@ -51,7 +51,10 @@ Context::Context()
     setVelocityInWorld(objectmodel::BaseContext::getVelocityInWorld());
     setVelocityBasedLinearAccelerationInWorld(objectmodel::BaseContext::getVelocityBasedLinearAccelerationInWorld());
 #endif
-
+    // the time and the sleeping state are read by the GUIs and the visitors while rendering
+    time_.setVisual(true);
+    is_activated.setVisual(true);
+    d_isSleeping.setVisual(true);
 }
 
 /// The Context is active
@@ -23,6 +23,10 @@
 #include <sofa/core/objectmodel/BaseData.h>
 #include <sofa/core/objectmodel/Base.h>
 #include <sofa/core/DataEngine.h>
+#include <sofa/helper/system/thread/thread_specific_ptr.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
 
 //#define SOFA_DDG_TRACE
 
@@ -35,10 +39,27 @@ namespace core
 namespace objectmodel
 {
 
+namespace
+{
+
+/// Nodes left to set dirty by the propagation running in the current thread
+struct DirtyPropagation
+{
+    int aspect;
+    helper::vector<DDGNode*> pending;
+};
+
+SOFA_THREAD_SPECIFIC_PTR(DirtyPropagation, currentPropagation);
+
+std::mutex levelMutex;
+
+} // namespace
+
 /// Constructor
 DDGNode::DDGNode()
     : inputs(initLink("inputs", "Links to inputs Data"))
     , outputs(initLink("outputs", "Links to outputs Data"))
+    , level(0)
 {
 }
 
@@ -79,15 +100,135 @@ void DDGNode::setDirtyValue(const core::ExecParams* params)
 
 void DDGNode::setDirtyOutputs(const core::ExecParams* params)
 {
-    bool& dirtyOutputs = dirtyFlags[currentAspect(params)].dirtyOutputs;
-    if (!dirtyOutputs)
+    const int aspect = currentAspect(params);
+    bool& dirtyOutputs = dirtyFlags[aspect].dirtyOutputs;
+    if (dirtyOutputs)
+        return;
+    dirtyOutputs = true;
+    if (outputs.empty(params))
+        return;
+
+    DirtyPropagation* propagation = currentPropagation;
+    if (propagation && propagation->aspect == aspect)
+    {
+        // called by the setDirtyValue of a node reached by the propagation running in this thread
+        propagation->pending.insert(propagation->pending.end(), outputs.rbegin(params), outputs.rend(params));
+        return;
+    }
+
+    // Same setDirtyValue calls as the recursion, in the same order, but with an explicit stack: the virtual
+    // setDirtyValue of each reached node is called, and its outputs are pushed here instead of being set dirty
+    // before it returns.
+    DirtyPropagation local;
+    local.aspect = aspect;
+    local.pending.assign(outputs.rbegin(params), outputs.rend(params));
+    currentPropagation = &local;
+    try
+    {
+        while (!local.pending.empty())
+        {
+            DDGNode* node = local.pending.back();
+            local.pending.pop_back();
+            node->setDirtyValue(params);
+        }
+    }
+    catch (...)
+    {
+        currentPropagation = propagation;
+        throw;
+    }
+    currentPropagation = propagation;
+}
+
+void DDGNode::updateLevels(DDGNode* output)
+{
+    std::lock_guard<std::mutex> lock(levelMutex);
+    const unsigned int base = level; // this node is raised too if the link closes a cycle
+    if (output->level > base)
+        return;
+
+    // Raise the levels downstream of the new link. In a graph without cycle, a level reached from this node
+    // cannot exceed its level plus the number of nodes reached: beyond that, the link closed a cycle.
+    std::unordered_set<DDGNode*> reached;
+    helper::vector<DDGNode*> stack(1, output);
+    output->level = base + 1;
+    reached.insert(output);
+    while (!stack.empty())
+    {
+        DDGNode* node = stack.back();
+        stack.pop_back();
+        const unsigned int next = node->level + 1;
+        if (next > base + reached.size() + 1)
+            return;
+        for(DDGLinkIterator it=node->outputs.begin(), itend=node->outputs.end(); it != itend; ++it)
+        {
+            if ((*it)->level < next)
+            {
+                (*it)->level = next;
+                reached.insert(*it);
+                stack.push_back(*it);
+            }
+        }
+    }
+}
+
+bool DDGNode::getDependencyLevels(const helper::vector<DDGNode*>& sources, helper::vector< helper::vector<DDGNode*> >& levels)
+{
+    levels.clear();
+
+    // nodes depending on the sources, checking that each link goes to a greater level
+    std::unordered_set<DDGNode*> reached;
+    helper::vector<DDGNode*> stack;
+    helper::vector< std::pair<unsigned int, DDGNode*> > nodes;
+    bool acyclic = false;
+    for (int pass=0; pass<2 && !acyclic; ++pass)
     {
-        dirtyOutputs = true;
-        for(DDGLinkIterator it=outputs.begin(params), itend=outputs.end(params); it != itend; ++it)
+        reached.clear();
+        reached.insert(sources.begin(), sources.end());
+        stack.assign(sources.begin(), sources.end());
+        nodes.clear();
+        acyclic = true;
+        while (!stack.empty())
         {
-            (*it)->setDirtyValue(params);
+            DDGNode* node = stack.back();
+            stack.pop_back();
+            for(DDGLinkIterator it=node->outputs.begin(), itend=node->outputs.end(); it != itend; ++it)
+            {
+                if ((*it)->level <= node->level)
+                {
+                    // the levels are not lowered when a link is removed: after a cycle was broken, raising them again fixes them
+                    acyclic = false;
+                    if (pass == 0)
+                        node->updateLevels(*it);
+                }
+                if (reached.insert(*it).second)
+                {
+                    nodes.push_back(std::make_pair((unsigned int)(*it)->level, *it));
+                    stack.push_back(*it);
+                }
+            }
         }
     }
+
+    if (!acyclic)
+    {
+        levels.resize(nodes.empty() ? 0 : 1);
+        for (std::size_t i=0; i<nodes.size(); ++i)
+            levels[0].push_back(nodes[i].second);
+        return false;
+    }
+
+    // the nodes of a same level are not linked to each other, whatever the sources
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [](const std::pair<unsigned int, DDGNode*>& a, const std::pair<unsigned int, DDGNode*>& b)
+                     { return a.first < b.first; });
+    for (std::size_t i=0; i<nodes.size(); ++i)
+    {
+        if (i == 0 || nodes[i].first != nodes[i-1].first)
+            levels.push_back(helper::vector<DDGNode*>());
+        levels.back().push_back(nodes[i].second);
+    }
+    return true;
 }
 
 void DDGNode::cleanDirty(const core::ExecParams* params)
@@ -124,6 +265,7 @@ void DDGNode::addInput(DDGNode* n)
 {
     doAddInput(n);
     n->doAddOutput(this);
+    n->updateLevels(this);
     setDirtyValue();
 }
 
@@ -137,6 +279,7 @@ void DDGNode::addOutput(DDGNode* n)
 {
     doAddOutput(n);
     n->doAddInput(this);
+    updateLevels(n);
     n->setDirtyValue();
 }
 
@@ -25,6 +25,8 @@
 #include <sofa/core/core.h>
 #include <sofa/core/objectmodel/Link.h>
 #include <sofa/core/objectmodel/BaseClass.h>
+#include <sofa/helper/vector.h>
+#include <atomic>
 #include <list>
 
 namespace sofa
@@ -173,6 +175,9 @@ public:
     virtual void setDirtyValue(const core::ExecParams* params = 0);
 
     /// Indicate the outputs needs to be updated. This method must be called after changing the value of this node.
+    ///
+    /// The nodes depending on this one are reached with an explicit stack rather than by recursion, calling
+    /// their setDirtyValue in the same order, so that long chains of engines do not grow the call stack.
     virtual void setDirtyOutputs(const core::ExecParams* params = 0);
 
     /// Set dirty flag to false
@@ -190,6 +195,19 @@ public:
     /// Copy the value of an aspect into another one.
     virtual void copyAspect(int destAspect, int srcAspect);
 
+    /// Returns true if the DDGNode needs to be updated in the given aspect
+    bool isDirtyAspect(int aspect) const
+    {
+        return dirtyFlags[aspect].dirtyValue;
+    }
+
+    /// Set the dirty flags of the given aspect to false, without updating the value nor cleaning the inputs
+    void cleanDirtyAspect(int aspect)
+    {
+        dirtyFlags[aspect].dirtyValue = false;
+        dirtyFlags[aspect].dirtyOutputs = false;
+    }
+
     static int currentAspect()
     {
         return core::ExecParams::currentAspect();
@@ -209,6 +227,12 @@ public:
 
     void addLink(BaseLink* l);
 
+    /// Compute the nodes depending on the given sources (excluding them), sorted by dependency level:
+    /// the inputs of the nodes of a level are either in the previous levels or independent of the sources,
+    /// so the nodes of a same level can be updated concurrently. The levels are maintained on link changes.
+    /// Returns false if the dependencies contain a cycle, all the nodes being then put in a single level.
+    static bool getDependencyLevels(const helper::vector<DDGNode*>& sources, helper::vector< helper::vector<DDGNode*> >& levels);
+
 protected:
 
     BaseLink::InitLink<DDGNode>
@@ -255,6 +279,13 @@ private:
         bool dirtyOutputs;
     };
     helper::fixed_array<DirtyFlags, SOFA_DATA_MAX_ASPECTS> dirtyFlags;
+
+    /// Dependency level, greater than the levels of the inputs in a graph without cycle.
+    /// It is raised downstream when a link is added, and kept when a link is removed.
+    std::atomic<unsigned int> level;
+
+    /// Raise the levels of the given output and of the nodes depending on it above the level of this node
+    void updateLevels(DDGNode* output);
 };
 
 } // namespace objectmodel
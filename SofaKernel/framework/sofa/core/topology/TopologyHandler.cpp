@@ -47,64 +47,67 @@ void TopologyHandler::ApplyTopologyChanges(const std::list<const core::topology:
 
     for (changeIt=_changeList.begin(); changeIt!=_changeList.end(); ++changeIt)
     {
-        core::topology::TopologyChangeType changeType = (*changeIt)->getChangeType();
+        this->dispatchTopologyChange(*changeIt);
+    }
+}
+
+void TopologyHandler::dispatchTopologyChange(const core::topology::TopologyChange* change)
+{
+    core::topology::TopologyChangeType changeType = change->getChangeType();
 
-        switch( changeType )
-        {
+    switch( changeType )
+    {
 #define SOFA_CASE_EVENT(name,type) \
-        case core::topology::name: \
-            this->ApplyTopologyChange(static_cast< const type* >( *changeIt ) ); \
-            break
-
-        SOFA_CASE_EVENT(ENDING_EVENT,EndingEvent);
-
-        SOFA_CASE_EVENT(POINTSINDICESSWAP,PointsIndicesSwap);
-        SOFA_CASE_EVENT(POINTSADDED,PointsAdded);
-        SOFA_CASE_EVENT(POINTSREMOVED,PointsRemoved);
-        SOFA_CASE_EVENT(POINTSMOVED,PointsMoved);
-        SOFA_CASE_EVENT(POINTSRENUMBERING,PointsRenumbering);
-
-        SOFA_CASE_EVENT(EDGESINDICESSWAP,EdgesIndicesSwap);
-        SOFA_CASE_EVENT(EDGESADDED,EdgesAdded);
-        SOFA_CASE_EVENT(EDGESREMOVED,EdgesRemoved);
-        SOFA_CASE_EVENT(EDGESMOVED_REMOVING,EdgesMoved_Removing);
-        SOFA_CASE_EVENT(EDGESMOVED_ADDING,EdgesMoved_Adding);
-        SOFA_CASE_EVENT(EDGESRENUMBERING,EdgesRenumbering);
-
-        SOFA_CASE_EVENT(TRIANGLESINDICESSWAP,TrianglesIndicesSwap);
-        SOFA_CASE_EVENT(TRIANGLESADDED,TrianglesAdded);
-        SOFA_CASE_EVENT(TRIANGLESREMOVED,TrianglesRemoved);
-        SOFA_CASE_EVENT(TRIANGLESMOVED_REMOVING,TrianglesMoved_Removing);
-        SOFA_CASE_EVENT(TRIANGLESMOVED_ADDING,TrianglesMoved_Adding);
-        SOFA_CASE_EVENT(TRIANGLESRENUMBERING,TrianglesRenumbering);
-
-        SOFA_CASE_EVENT(TETRAHEDRAINDICESSWAP,TetrahedraIndicesSwap);
-        SOFA_CASE_EVENT(TETRAHEDRAADDED,TetrahedraAdded);
-        SOFA_CASE_EVENT(TETRAHEDRAREMOVED,TetrahedraRemoved);
-        SOFA_CASE_EVENT(TETRAHEDRAMOVED_REMOVING,TetrahedraMoved_Removing);
-        SOFA_CASE_EVENT(TETRAHEDRAMOVED_ADDING,TetrahedraMoved_Adding);
-        SOFA_CASE_EVENT(TETRAHEDRARENUMBERING,TetrahedraRenumbering);
-
-        SOFA_CASE_EVENT(QUADSINDICESSWAP,QuadsIndicesSwap);
-        SOFA_CASE_EVENT(QUADSADDED,QuadsAdded);
-        SOFA_CASE_EVENT(QUADSREMOVED,QuadsRemoved);
-        SOFA_CASE_EVENT(QUADSMOVED_REMOVING,QuadsMoved_Removing);
-        SOFA_CASE_EVENT(QUADSMOVED_ADDING,QuadsMoved_Adding);
-        SOFA_CASE_EVENT(QUADSRENUMBERING,QuadsRenumbering);
-
-        SOFA_CASE_EVENT(HEXAHEDRAINDICESSWAP,HexahedraIndicesSwap);
-        SOFA_CASE_EVENT(HEXAHEDRAADDED,HexahedraAdded);
-        SOFA_CASE_EVENT(HEXAHEDRAREMOVED,HexahedraRemoved);
-        SOFA_CASE_EVENT(HEXAHEDRAMOVED_REMOVING,HexahedraMoved_Removing);
-        SOFA_CASE_EVENT(HEXAHEDRAMOVED_ADDING,HexahedraMoved_Adding);
-        SOFA_CASE_EVENT(HEXAHEDRARENUMBERING,HexahedraRenumbering);
+    case core::topology::name: \
+        this->ApplyTopologyChange(static_cast< const type* >( change ) ); \
+        break
+
+    SOFA_CASE_EVENT(ENDING_EVENT,EndingEvent);
+
+    SOFA_CASE_EVENT(POINTSINDICESSWAP,PointsIndicesSwap);
+    SOFA_CASE_EVENT(POINTSADDED,PointsAdded);
+    SOFA_CASE_EVENT(POINTSREMOVED,PointsRemoved);
+    SOFA_CASE_EVENT(POINTSMOVED,PointsMoved);
+    SOFA_CASE_EVENT(POINTSRENUMBERING,PointsRenumbering);
+
+    SOFA_CASE_EVENT(EDGESINDICESSWAP,EdgesIndicesSwap);
+    SOFA_CASE_EVENT(EDGESADDED,EdgesAdded);
+    SOFA_CASE_EVENT(EDGESREMOVED,EdgesRemoved);
+    SOFA_CASE_EVENT(EDGESMOVED_REMOVING,EdgesMoved_Removing);
+    SOFA_CASE_EVENT(EDGESMOVED_ADDING,EdgesMoved_Adding);
+    SOFA_CASE_EVENT(EDGESRENUMBERING,EdgesRenumbering);
+
+    SOFA_CASE_EVENT(TRIANGLESINDICESSWAP,TrianglesIndicesSwap);
+    SOFA_CASE_EVENT(TRIANGLESADDED,TrianglesAdded);
+    SOFA_CASE_EVENT(TRIANGLESREMOVED,TrianglesRemoved);
+    SOFA_CASE_EVENT(TRIANGLESMOVED_REMOVING,TrianglesMoved_Removing);
+    SOFA_CASE_EVENT(TRIANGLESMOVED_ADDING,TrianglesMoved_Adding);
+    SOFA_CASE_EVENT(TRIANGLESRENUMBERING,TrianglesRenumbering);
+
+    SOFA_CASE_EVENT(TETRAHEDRAINDICESSWAP,TetrahedraIndicesSwap);
+    SOFA_CASE_EVENT(TETRAHEDRAADDED,TetrahedraAdded);
+    SOFA_CASE_EVENT(TETRAHEDRAREMOVED,TetrahedraRemoved);
+    SOFA_CASE_EVENT(TETRAHEDRAMOVED_REMOVING,TetrahedraMoved_Removing);
+    SOFA_CASE_EVENT(TETRAHEDRAMOVED_ADDING,TetrahedraMoved_Adding);
+    SOFA_CASE_EVENT(TETRAHEDRARENUMBERING,TetrahedraRenumbering);
+
+    SOFA_CASE_EVENT(QUADSINDICESSWAP,QuadsIndicesSwap);
+    SOFA_CASE_EVENT(QUADSADDED,QuadsAdded);
+    SOFA_CASE_EVENT(QUADSREMOVED,QuadsRemoved);
+    SOFA_CASE_EVENT(QUADSMOVED_REMOVING,QuadsMoved_Removing);
+    SOFA_CASE_EVENT(QUADSMOVED_ADDING,QuadsMoved_Adding);
+    SOFA_CASE_EVENT(QUADSRENUMBERING,QuadsRenumbering);
+
+    SOFA_CASE_EVENT(HEXAHEDRAINDICESSWAP,HexahedraIndicesSwap);
+    SOFA_CASE_EVENT(HEXAHEDRAADDED,HexahedraAdded);
+    SOFA_CASE_EVENT(HEXAHEDRAREMOVED,HexahedraRemoved);
+    SOFA_CASE_EVENT(HEXAHEDRAMOVED_REMOVING,HexahedraMoved_Removing);
+    SOFA_CASE_EVENT(HEXAHEDRAMOVED_ADDING,HexahedraMoved_Adding);
+    SOFA_CASE_EVENT(HEXAHEDRARENUMBERING,HexahedraRenumbering);
 #undef SOFA_CASE_EVENT
-        default:
-            break;
-        }; // switch( changeType )
-
-        //++changeIt;
-    }
+    default:
+        break;
+    }; // switch( changeType )
 }
 
 } // namespace topology
@@ -148,6 +148,9 @@ public:
     virtual void renumber( const sofa::helper::vector<unsigned int> &/*index*/ ) {}
 
 protected:
+    /// Call the ApplyTopologyChange overload matching the type of the given event
+    void dispatchTopologyChange(const core::topology::TopologyChange* change);
+
     /// to handle PointSubsetData
     void setDataSetArraySize(const unsigned int s) { lastElementIndex = s-1; }
 
@@ -34,6 +34,13 @@
 #include <stack>
 #include <algorithm>
 #include <cctype>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #define DEFAULT_INTERVAL 100
 
@@ -181,6 +188,351 @@ std::pair<AdvancedTimer::SyncCallBack,void*> AdvancedTimer::setSyncCallBack(Sync
     return old;
 }
 
+// -------------------------------
+// Trace of the steps
+
+class AdvancedTimer::TraceName
+{
+public:
+    const std::string name;
+    TraceName(const std::string& name) : name(name) {}
+};
+
+class TraceEvent
+{
+public:
+    std::uint64_t time;
+    AdvancedTimer::IdTrace id;
+    AdvancedTimer::IdTrace obj;
+    char type; ///< 'B' (begin), 'E' (end) or 'i' (instant), as in the Chrome trace format
+};
+
+/// Ring buffer of the events of a thread
+class TraceBuffer
+{
+public:
+    helper::vector<TraceEvent> events; ///< allocated at the first event
+    std::size_t capacity;
+    std::uint64_t head; ///< number of events recorded in this buffer
+
+    TraceBuffer(std::size_t capacity) : capacity(capacity), head(0) {}
+
+    void record(char type, AdvancedTimer::IdTrace id, AdvancedTimer::IdTrace obj)
+    {
+        if (events.empty())
+            events.resize(capacity);
+        TraceEvent& e = events[head & (capacity-1)];
+        e.time = AdvancedTimer::getTimeNs();
+        e.id = id;
+        e.obj = obj;
+        e.type = type;
+        ++head;
+    }
+};
+
+/// Events of a single thread, registered once under the lock.
+/// The thread takes its buffer while it records an event, and the buffer is swapped
+/// with an empty one to be written or cleared, so recording takes no lock.
+class ThreadTrace
+{
+public:
+    std::atomic<TraceBuffer*> buffer;
+    std::string name;
+    unsigned int index;
+
+    /// interned names of the ids of this thread (the IdFactory instances are thread specific)
+    helper::vector<AdvancedTimer::IdTrace> stepNames, objNames, timerNames;
+    /// last strings interned by this thread, checked by content as the pointers may be reused
+    enum { CACHE_SIZE = 64 };
+    std::pair<const char*, AdvancedTimer::IdTrace> stringCache[CACHE_SIZE];
+
+    ThreadTrace(std::size_t capacity, unsigned int index) : buffer(new TraceBuffer(capacity)), index(index)
+    {
+        for (int i=0; i<CACHE_SIZE; ++i)
+            stringCache[i] = std::make_pair((const char*)NULL, (AdvancedTimer::IdTrace)NULL);
+    }
+
+    void record(char type, AdvancedTimer::IdTrace id, AdvancedTimer::IdTrace obj)
+    {
+        // only this thread empties the slot, so the buffer is always there
+        TraceBuffer* b = buffer.exchange(NULL, std::memory_order_acquire);
+        b->record(type, id, obj);
+        buffer.store(b, std::memory_order_release);
+    }
+
+    /// Replace the buffer, waiting for the thread to finish the event it is recording. Return the previous one.
+    TraceBuffer* swap(TraceBuffer* newBuffer)
+    {
+        TraceBuffer* b = buffer.load(std::memory_order_relaxed);
+        while (!b || !buffer.compare_exchange_weak(b, newBuffer, std::memory_order_acq_rel))
+        {
+            std::this_thread::yield();
+            b = buffer.load(std::memory_order_relaxed);
+        }
+        return b;
+    }
+
+    AdvancedTimer::IdTrace getName(const char* str)
+    {
+        if (!str || !*str) return NULL;
+        std::pair<const char*, AdvancedTimer::IdTrace>& entry = stringCache[(reinterpret_cast<std::uintptr_t>(str) >> 3) & (CACHE_SIZE-1)];
+        if (entry.first != str || entry.second->name != str)
+        {
+            entry.first = str;
+            entry.second = AdvancedTimer::getTraceId(str);
+        }
+        return entry.second;
+    }
+
+    template<class T>
+    AdvancedTimer::IdTrace getName(const AdvancedTimer::Id<T>& id, helper::vector<AdvancedTimer::IdTrace>& names)
+    {
+        const unsigned int i = id;
+        if (i == 0) return NULL;
+        if (i >= names.size()) names.resize(i+1, NULL);
+        if (!names[i]) names[i] = AdvancedTimer::getTraceId(((std::string)id).c_str());
+        return names[i];
+    }
+};
+
+std::atomic<bool> traceEnabled(getenv("SOFA_TIMER_TRACE") != NULL && *getenv("SOFA_TIMER_TRACE"));
+std::mutex traceMutex;
+std::unordered_map<std::string, AdvancedTimer::TraceName*> traceNames;
+helper::vector<ThreadTrace*> traceThreads;
+std::unordered_map<std::thread::id, std::string> traceThreadNames; ///< names given to the threads which did not record any event yet
+std::size_t traceCapacity = 1 << 16;
+const std::chrono::steady_clock::time_point traceOrigin = std::chrono::steady_clock::now();
+SOFA_THREAD_SPECIFIC_PTR(ThreadTrace, curTraceThread);
+
+ThreadTrace* getTraceThread()
+{
+    ThreadTrace* trace = curTraceThread;
+    if (!trace)
+    {
+        // registered at the first event of the thread, and kept to be written after the thread ended
+        std::lock_guard<std::mutex> lock(traceMutex);
+        trace = new ThreadTrace(traceCapacity, (unsigned int)traceThreads.size());
+        std::unordered_map<std::thread::id, std::string>::iterator name = traceThreadNames.find(std::this_thread::get_id());
+        if (name != traceThreadNames.end())
+        {
+            trace->name = name->second;
+            traceThreadNames.erase(name);
+        }
+        else
+            trace->name = std::string("Thread ") + std::to_string(trace->index);
+        traceThreads.push_back(trace);
+        curTraceThread = trace;
+    }
+    return trace;
+}
+
+/// Take the events of all the threads, leaving them empty buffers. Must be called with traceMutex locked.
+helper::vector<TraceBuffer*> swapTraceBuffers()
+{
+    helper::vector<TraceBuffer*> buffers;
+    for (std::size_t i=0; i<traceThreads.size(); ++i)
+        buffers.push_back(traceThreads[i]->swap(new TraceBuffer(traceCapacity)));
+    return buffers;
+}
+
+inline void traceStep(char type, const char* idStr, const char* objStr = NULL)
+{
+    if (!traceEnabled.load(std::memory_order_relaxed)) return;
+    ThreadTrace* trace = getTraceThread();
+    trace->record(type, trace->getName(idStr), trace->getName(objStr));
+}
+
+inline void traceStep(char type, AdvancedTimer::IdStep id, AdvancedTimer::IdObj obj = AdvancedTimer::IdObj())
+{
+    if (!traceEnabled.load(std::memory_order_relaxed)) return;
+    ThreadTrace* trace = getTraceThread();
+    trace->record(type, trace->getName(id, trace->stepNames), trace->getName(obj, trace->objNames));
+}
+
+inline void traceTimer(char type, AdvancedTimer::IdTimer id)
+{
+    if (!traceEnabled.load(std::memory_order_relaxed)) return;
+    ThreadTrace* trace = getTraceThread();
+    trace->record(type, trace->getName(id, trace->timerNames), NULL);
+}
+
+AdvancedTimer::IdTrace AdvancedTimer::getTraceId(const char* name)
+{
+    if (!name || !*name) return NULL;
+    std::lock_guard<std::mutex> lock(traceMutex);
+    TraceName*& traceName = traceNames[std::string(name)];
+    if (!traceName)
+        traceName = new TraceName(name);
+    return traceName;
+}
+
+void AdvancedTimer::setTraceEnabled(bool enabled)
+{
+    traceEnabled = enabled;
+}
+
+bool AdvancedTimer::isTraceEnabled()
+{
+    return traceEnabled;
+}
+
+void AdvancedTimer::setTraceCapacity(std::size_t nbEvents)
+{
+    std::size_t capacity = 2;
+    while (capacity < nbEvents)
+        capacity *= 2;
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceCapacity = capacity;
+}
+
+void AdvancedTimer::setTraceThreadName(const std::string& name)
+{
+    // the name is kept until the thread records an event, so that the threads which never
+    // record, e.g. while the trace is disabled, do not allocate a trace
+    ThreadTrace* trace = curTraceThread;
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (trace)
+        trace->name = name;
+    else
+        traceThreadNames[std::this_thread::get_id()] = name;
+}
+
+void AdvancedTimer::clearTrace()
+{
+    helper::vector<TraceBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        buffers = swapTraceBuffers();
+    }
+    for (std::size_t i=0; i<buffers.size(); ++i)
+        delete buffers[i];
+}
+
+static void writeJsonString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (std::size_t i=0; i<str.size(); ++i)
+    {
+        const char c = str[i];
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+void AdvancedTimer::writeChromeTrace(std::ostream& out)
+{
+    helper::vector<TraceBuffer*> buffers;
+    helper::vector<unsigned int> indices;
+    helper::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        buffers = swapTraceBuffers();
+        for (std::size_t t=0; t<traceThreads.size(); ++t)
+        {
+            indices.push_back(traceThreads[t]->index);
+            names.push_back(traceThreads[t]->name);
+        }
+    }
+
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (std::size_t t=0; t<buffers.size(); ++t)
+    {
+        const TraceBuffer* buffer = buffers[t];
+        out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << indices[t] << ",\"args\":{\"name\":";
+        writeJsonString(out, names[t]);
+        out << "}}";
+        first = false;
+
+        // the buffer is not used by its thread anymore: only its last events are kept
+        const std::uint64_t capacity = buffer->capacity;
+        const std::uint64_t end = buffer->head;
+        const std::uint64_t begin = (end > capacity) ? end - capacity : 0;
+
+        // the events ending a step begun before the oldest kept event are dropped
+        int depth = 0;
+        for (std::uint64_t i=begin; i<end; ++i)
+        {
+            const TraceEvent& e = buffer->events[i & (capacity-1)];
+            if (e.type == 'E')
+            {
+                if (depth == 0) continue;
+                --depth;
+            }
+            else if (e.type == 'B')
+                ++depth;
+
+            out << ",\n{\"name\":";
+            writeJsonString(out, e.id ? e.id->name : std::string());
+            out << ",\"cat\":\"sofa\",\"ph\":\"" << e.type << "\",\"ts\":" << e.time*1e-3 << ",\"pid\":0,\"tid\":" << indices[t];
+            if (e.type == 'i')
+                out << ",\"s\":\"t\"";
+            if (e.obj)
+            {
+                out << ",\"args\":{\"object\":";
+                writeJsonString(out, e.obj->name);
+                out << "}";
+            }
+            out << "}";
+        }
+        delete buffer;
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool AdvancedTimer::writeChromeTrace(const std::string& filename)
+{
+    std::ofstream out(filename.c_str());
+    if (!out.good())
+    {
+        msg_error("AdvancedTimer") << "Unable to write the trace in " << filename;
+        return false;
+    }
+    writeChromeTrace(out);
+    return true;
+}
+
+std::uint64_t AdvancedTimer::getTimeNs()
+{
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceOrigin).count();
+}
+
+void AdvancedTimer::stepBegin(IdTrace id)
+{
+    helper::vector<Record>* curRecords = getCurRecords();
+    if (!curRecords) { traceBegin(id); return; }
+    stepBegin(IdStep(id->name));
+}
+
+void AdvancedTimer::stepEnd  (IdTrace id)
+{
+    helper::vector<Record>* curRecords = getCurRecords();
+    if (!curRecords) { traceEnd(id); return; }
+    stepEnd  (IdStep(id->name));
+}
+
+void AdvancedTimer::traceBegin(IdTrace id)
+{
+    if (!traceEnabled.load(std::memory_order_relaxed)) return;
+    getTraceThread()->record('B', id, NULL);
+}
+
+void AdvancedTimer::traceEnd  (IdTrace id)
+{
+    if (!traceEnabled.load(std::memory_order_relaxed)) return;
+    getTraceThread()->record('E', id, NULL);
+}
+
 void AdvancedTimer::clear()
 {
     setCurRecords(NULL);
@@ -238,6 +590,7 @@ void AdvancedTimer::setInterval(IdTimer id, int val)
 
 void AdvancedTimer::begin(IdTimer id)
 {
+    traceTimer('B', id);
     std::stack<AdvancedTimer::IdTimer>& curTimer = getCurTimer();
     curTimer.push(id);
     TimerData& data = timers[curTimer.top()];
@@ -263,6 +616,7 @@ void AdvancedTimer::begin(IdTimer id)
 
 void AdvancedTimer::end(IdTimer id, std::ostream& result)
 {
+    traceTimer('E', id);
     std::stack<AdvancedTimer::IdTimer>& curTimer = getCurTimer();
 
     if (curTimer.empty())
@@ -307,6 +661,7 @@ void AdvancedTimer::end(IdTimer id, std::ostream& result)
 
 void AdvancedTimer::end(IdTimer id)
 {
+    traceTimer('E', id);
     std::stack<AdvancedTimer::IdTimer>& curTimer = getCurTimer();
 
     if (curTimer.empty())
@@ -377,6 +732,7 @@ bool AdvancedTimer::isActive()
 
 void AdvancedTimer::stepBegin(IdStep id)
 {
+    traceStep('B', id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -388,6 +744,7 @@ void AdvancedTimer::stepBegin(IdStep id)
 
 void AdvancedTimer::stepBegin(IdStep id, IdObj obj)
 {
+    traceStep('B', id, obj);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -400,6 +757,7 @@ void AdvancedTimer::stepBegin(IdStep id, IdObj obj)
 
 void AdvancedTimer::stepEnd  (IdStep id)
 {
+    traceStep('E', id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -412,6 +770,7 @@ void AdvancedTimer::stepEnd  (IdStep id)
 
 void AdvancedTimer::stepEnd  (IdStep id, IdObj obj)
 {
+    traceStep('E', id, obj);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -424,6 +783,8 @@ void AdvancedTimer::stepEnd  (IdStep id, IdObj obj)
 
 void AdvancedTimer::stepNext (IdStep prevId, IdStep nextId)
 {
+    traceStep('E', prevId);
+    traceStep('B', nextId);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -439,6 +800,7 @@ void AdvancedTimer::stepNext (IdStep prevId, IdStep nextId)
 
 void AdvancedTimer::step     (IdStep id)
 {
+    traceStep('i', id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -451,6 +813,7 @@ void AdvancedTimer::step     (IdStep id)
 
 void AdvancedTimer::step     (IdStep id, IdObj obj)
 {
+    traceStep('i', id, obj);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -491,70 +854,70 @@ void AdvancedTimer::valAdd(IdVal id, double val)
 void AdvancedTimer::stepBegin(const char* idStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('B', idStr); return; }
     stepBegin(IdStep(idStr));
 }
 
 void AdvancedTimer::stepBegin(const char* idStr, const char* objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('B', idStr, objStr); return; }
     stepBegin(IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepBegin(const char* idStr, const std::string& objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('B', idStr, objStr.c_str()); return; }
     stepBegin(IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('E', idStr); return; }
     stepEnd  (IdStep(idStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr, const char* objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('E', idStr, objStr); return; }
     stepEnd  (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr, const std::string& objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('E', idStr, objStr.c_str()); return; }
     stepEnd  (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepNext (const char* prevIdStr, const char* nextIdStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('E', prevIdStr); traceStep('B', nextIdStr); return; }
     stepNext (IdStep(prevIdStr), IdStep(nextIdStr));
 }
 
 void AdvancedTimer::step     (const char* idStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('i', idStr); return; }
     step     (IdStep(idStr));
 }
 
 void AdvancedTimer::step     (const char* idStr, const char* objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('i', idStr, objStr); return; }
     step     (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::step     (const char* idStr, const std::string& objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords) { traceStep('i', idStr, objStr.c_str()); return; }
     step     (IdStep(idStr), IdObj(objStr));
 }
 
@@ -1406,6 +1769,7 @@ std::string AdvancedTimer::getTimeAnalysis(IdTimer id, simulation::Node* node)
     stepNumber = tempStepNumber.str();
 
     // Get the timer result and create the JSON
+    traceTimer('E', id);
     std::stack<AdvancedTimer::IdTimer>& curTimer = getCurTimer();
 
     if (curTimer.empty())
@@ -25,6 +25,7 @@
 #include <sofa/simulation/Simulation.h>
 #include <sofa/helper/system/thread/thread_specific_ptr.h>
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -119,6 +120,18 @@ namespace helper
 
   ==== END ====
 
+
+  Independently of the timers, the steps of all the threads can be traced on a timeline:
+
+  * At startup (or with the SOFA_TIMER_TRACE environment variable):
+    AdvancedTimer::setTraceEnabled(true);
+
+  * Names interned once per call site, for the most frequent steps:
+    AdvancedTimer::stepBegin(SOFA_TRACE_ID("addDForce"));
+
+  * To open the last events of each thread in chrome://tracing or https://ui.perfetto.dev :
+    AdvancedTimer::writeChromeTrace("trace.json");
+
  */
 
 class SOFA_HELPER_API AdvancedTimer
@@ -441,8 +454,48 @@ public:
     typedef void (*SyncCallBack)(void* userData);
     static std::pair<SyncCallBack,void*> setSyncCallBack(SyncCallBack cb, void* userData = NULL);
 
+
+    /// @name Trace of the steps
+    /// When the trace is enabled, the begin / end of the timers and the steps of every thread are recorded, whether
+    /// a timer is active or not, in a ring buffer owned by the thread: recording takes no lock, and the events are
+    /// timestamped with a monotonic nanosecond clock. Only the last events of each thread are kept.
+    /// @{
+
+    /// Interned name, stable for the whole execution
+    class TraceName;
+    typedef const TraceName* IdTrace;
+
+    /// Return the interned name. Use SOFA_TRACE_ID to intern a literal only once per call site.
+    static IdTrace getTraceId(const char* name);
+
+    static void setTraceEnabled(bool enabled);
+    static bool isTraceEnabled();
+    /// Number of events kept by each thread, rounded up to a power of two. Only affects the buffers given to the threads
+    /// from now on, by their registration or by the next clearTrace / writeChromeTrace.
+    static void setTraceCapacity(std::size_t nbEvents);
+    /// Name of the calling thread in the trace
+    static void setTraceThreadName(const std::string& name);
+    /// Forget the recorded events. The other threads may keep recording.
+    static void clearTrace();
+    /// Write the recorded events of all the threads in the Chrome trace event format, and forget them.
+    /// The other threads may keep recording: their buffers are swapped with empty ones.
+    static void writeChromeTrace(std::ostream& out);
+    static bool writeChromeTrace(const std::string& filename);
+
+    /// Nanoseconds elapsed on a monotonic clock
+    static std::uint64_t getTimeNs();
+
+    static void stepBegin(IdTrace id);
+    static void stepEnd  (IdTrace id);
+    /// Record in the trace only, not in the timers
+    static void traceBegin(IdTrace id);
+    static void traceEnd  (IdTrace id);
+    /// @}
 };
 
+/// Intern a literal step name the first time this line is executed
+#define SOFA_TRACE_ID(name) ([]() -> sofa::helper::AdvancedTimer::IdTrace { static const sofa::helper::AdvancedTimer::IdTrace id = sofa::helper::AdvancedTimer::getTraceId(name); return id; }())
+
 #if  !defined(SOFA_HELPER_ADVANCEDTIMER_CPP)
 extern template class SOFA_HELPER_API AdvancedTimer::Id<AdvancedTimer::Timer>;
 extern template class SOFA_HELPER_API AdvancedTimer::Id<AdvancedTimer::Step>;
@@ -1564,6 +1564,30 @@ int nlcp_multiGrid(int dim, double *dfree, double**W, double *f, double mu, doub
 
 }
 
+/// Add the product of the three rows of a contact in W by f to (d0, d1, d2).
+/// Independent partial sums break the dependency chain of the accumulation, so that the
+/// loop is pipelined and vectorized (the rows are the largest part of the cost of an iteration).
+static inline void addContactRowsProduct(const double* w0, const double* w1, const double* w2, const double* f, int dim, double& d0, double& d1, double& d2)
+{
+    double s0[2] = { 0, 0 }, s1[2] = { 0, 0 }, s2[2] = { 0, 0 };
+    int i = 0;
+    for (; i+1 < dim; i += 2)
+    {
+        s0[0] += w0[i]*f[i]; s0[1] += w0[i+1]*f[i+1];
+        s1[0] += w1[i]*f[i]; s1[1] += w1[i+1]*f[i+1];
+        s2[0] += w2[i]*f[i]; s2[1] += w2[i+1]*f[i+1];
+    }
+    for (; i < dim; ++i)
+    {
+        s0[0] += w0[i]*f[i];
+        s1[0] += w1[i]*f[i];
+        s2[0] += w2[i]*f[i];
+    }
+    d0 += s0[0] + s0[1];
+    d1 += s1[0] + s1[1];
+    d2 += s2[0] + s2[1];
+}
+
 int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose, double minW, double maxF, std::vector<double>* residuals, std::vector<double>* violations)
 
 {
@@ -1575,11 +1599,7 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
         return 0;
     }
     // iterators
-    int it,c1,i;
-
-    // memory allocation of vector d
-    double *d;
-    d = (double*)malloc(dim*sizeof(double));
+    int it,c1;
 
     // put the vector force to zero
     if (!useInitialF)
@@ -1590,10 +1610,7 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
     double d_1[3];
 
     // allocation of the inverted system 3x3
-    LocalBlock33 **W33;
-    W33 = (LocalBlock33 **) malloc (dim*sizeof(LocalBlock33));
-    for (c1=0; c1<numContacts; c1++)
-        W33[c1] = new LocalBlock33();
+    std::vector<LocalBlock33> W33(numContacts);
 
     //////////////
     // Beginning of iterative computations
@@ -1615,12 +1632,7 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
 
             // computation of actual d due to contribution of other contacts
             dn=dfree[3*index1]; dt=dfree[3*index1+1]; ds=dfree[3*index1+2];
-            for (i=0; i<dim; i++)
-            {
-                dn += W[3*index1  ][i]*f[i];
-                dt += W[3*index1+1][i]*f[i];
-                ds += W[3*index1+2][i]*f[i];
-            }
+            addContactRowsProduct(W[3*index1], W[3*index1+1], W[3*index1+2], f, dim, dn, dt, ds);
             d_1[0] = dn + W[3*index1  ][3*index1  ]*f_1[0]+W[3*index1  ][3*index1+1]*f_1[1]+W[3*index1  ][3*index1+2]*f_1[2];
             d_1[1] = dt + W[3*index1+1][3*index1  ]*f_1[0]+W[3*index1+1][3*index1+1]*f_1[1]+W[3*index1+1][3*index1+2]*f_1[2];
             d_1[2] = ds + W[3*index1+2][3*index1  ]*f_1[0]+W[3*index1+2][3*index1+1]*f_1[1]+W[3*index1+2][3*index1+2]*f_1[2];
@@ -1637,14 +1649,14 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
             }
             else
             {
-                if(W33[index1]->computed==false)
+                if(W33[index1].computed==false)
                 {
-                    W33[index1]->compute(W[3*index1][3*index1],W[3*index1][3*index1+1],W[3*index1][3*index1+2],
+                    W33[index1].compute(W[3*index1][3*index1],W[3*index1][3*index1+1],W[3*index1][3*index1+2],
                             W[3*index1+1][3*index1+1], W[3*index1+1][3*index1+2],W[3*index1+2][3*index1+2]);
                 }
 
                 fn=f_1[0]; ft=f_1[1]; fs=f_1[2];
-                W33[index1]->GS_State(mu,dn,dt,ds,fn,ft,fs);
+                W33[index1].GS_State(mu,dn,dt,ds,fn,ft,fs);
            }
             error += absError(dn,dt,ds,d_1[0],d_1[1],d_1[2]);
             set3Dof(f,index1,fn,ft,fs);
@@ -1687,11 +1699,6 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
                 }
             }
 
-            free(d);
-            for (int i = 0; i < numContacts; i++)
-                delete W33[i];
-            free(W33);
-
             if (verbose){
                 dmsg_info("LCPcalc") << "Convergence after "<< it <<" iteration(s) with tolerance : "<< tol <<" and error : "<< error <<" with dim : " <<  dim ;
             }
@@ -1701,11 +1708,6 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
     }
     sofa::helper::AdvancedTimer::valSet("GS iterations", it);
 
-    free(d);
-    for (int i = 0; i < numContacts; i++)
-        delete W33[i];
-    free(W33);
-
     if (verbose)
     {
         msg_warning("LCPcalc")<<"No convergence in  nlcp_gaussseidel function : error ="<<error <<" after"<< it<<" iterations";
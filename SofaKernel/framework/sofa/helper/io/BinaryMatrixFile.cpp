@@ -0,0 +1,360 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/BinaryMatrixFile.h>
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+const char BinaryMatrixFile::Magic[8] = { 'S','O','F','A','M','A','T','X' };
+const std::uint32_t BinaryMatrixFile::Version;
+const std::uint64_t BinaryMatrixFile::HashSeed;
+
+// magic, version, encoding, key, size, symmetric, reserved, values offset, scales offset, padding
+static const std::size_t HeaderSize = 64;
+static const std::size_t ValuesAlignment = 64;
+
+static std::size_t encodingSize(BinaryMatrixFile::Encoding encoding)
+{
+    switch (encoding)
+    {
+    case BinaryMatrixFile::ENCODING_DOUBLE: return sizeof(double);
+    case BinaryMatrixFile::ENCODING_FLOAT: return sizeof(float);
+    case BinaryMatrixFile::ENCODING_HALF: return sizeof(std::uint16_t);
+    }
+    return 0;
+}
+
+/// index of the first stored value of a row
+static std::size_t rowBegin(std::size_t i, std::size_t n, bool symmetric)
+{
+    return symmetric ? i*n - i*(i-1)/2 : i*n;
+}
+
+static std::size_t storedSize(std::size_t n, bool symmetric)
+{
+    return symmetric ? n*(n+1)/2 : n*n;
+}
+
+static std::uint16_t floatToHalf(float f)
+{
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const std::uint16_t sign = (std::uint16_t)((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+    if (x >= 0x7f800000) // inf or nan
+        return sign | 0x7c00 | (x > 0x7f800000 ? 0x200 : 0);
+    if (x >= 0x477ff000) // rounded above the largest half
+        return sign | 0x7c00;
+    if (x < 0x38800000) // subnormal half
+    {
+        if (x < 0x33000000)
+            return sign;
+        const std::uint32_t m = (x & 0x7fffff) | 0x800000;
+        const unsigned int shift = 126 - (x >> 23);
+        std::uint32_t h = m >> shift;
+        const std::uint32_t rem = m & ((1u << shift) - 1);
+        const std::uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (h & 1)))
+            ++h;
+        return sign | (std::uint16_t)h;
+    }
+    std::uint32_t h = (x - 0x38000000) >> 13;
+    const std::uint32_t rem = x & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+        ++h;
+    return sign | (std::uint16_t)h;
+}
+
+static float halfToFloat(std::uint16_t h)
+{
+    const std::uint32_t sign = (std::uint32_t)(h & 0x8000) << 16;
+    const std::uint32_t e = (h >> 10) & 0x1f;
+    const std::uint32_t m = h & 0x3ff;
+    if (e == 0)
+    {
+        const float f = std::ldexp((float)m, -24);
+        return sign ? -f : f;
+    }
+    const std::uint32_t x = (e == 31) ? (sign | 0x7f800000 | (m << 13)) : (sign | ((e + 112) << 23) | (m << 13));
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+template<class T>
+static void append(helper::vector<char>& buffer, const T& value)
+{
+    const std::size_t pos = buffer.size();
+    buffer.resize(pos + sizeof(T));
+    std::memcpy(&buffer[pos], &value, sizeof(T));
+}
+
+template<class T>
+static T extract(const char* ptr)
+{
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    return value;
+}
+
+BinaryMatrixFile::BinaryMatrixFile()
+    : encoding(ENCODING_DOUBLE)
+    , symmetric(false)
+    , size(0)
+    , values(NULL)
+    , scales(NULL)
+{
+}
+
+bool BinaryMatrixFile::write(const std::string& filename, std::uint64_t key, const double* values, std::size_t n, Encoding encoding, bool symmetric)
+{
+    return writeT(filename, key, values, n, encoding, symmetric);
+}
+
+bool BinaryMatrixFile::write(const std::string& filename, std::uint64_t key, const float* values, std::size_t n, Encoding encoding, bool symmetric)
+{
+    return writeT(filename, key, values, n, encoding, symmetric);
+}
+
+template<class Real>
+bool BinaryMatrixFile::writeT(const std::string& filename, std::uint64_t key, const Real* values, std::size_t n, Encoding encoding, bool symmetric)
+{
+    // values of the rows as they are stored, before the encoding
+    helper::vector<double> row(n);
+    auto storedRow = [&](std::size_t i) -> std::size_t
+    {
+        const std::size_t j0 = symmetric ? i : 0;
+        for (std::size_t j=j0; j<n; ++j)
+            row[j-j0] = symmetric ? 0.5 * ((double)values[i*n+j] + (double)values[j*n+i]) : (double)values[i*n+j];
+        return n - j0;
+    };
+
+    helper::vector<double> rowScales;
+    if (encoding == ENCODING_HALF)
+    {
+        rowScales.resize(n);
+        for (std::size_t i=0; i<n; ++i)
+        {
+            const std::size_t count = storedRow(i);
+            double scale = 0;
+            for (std::size_t j=0; j<count; ++j)
+                scale = std::max(scale, std::fabs(row[j]));
+            rowScales[i] = (scale > 0) ? scale : 1.0;
+        }
+    }
+
+    const std::uint64_t scalesOffset = rowScales.empty() ? 0 : HeaderSize;
+    const std::uint64_t valuesOffset = (HeaderSize + rowScales.size()*sizeof(double) + ValuesAlignment-1) & ~(std::uint64_t)(ValuesAlignment-1);
+
+    helper::vector<char> header;
+    header.insert(header.end(), Magic, Magic+8);
+    append(header, Version);
+    append(header, (std::uint32_t)encoding);
+    append(header, key);
+    append(header, (std::uint64_t)n);
+    append(header, (std::uint32_t)(symmetric ? 1 : 0));
+    append(header, (std::uint32_t)0);
+    append(header, valuesOffset);
+    append(header, scalesOffset);
+    if (!rowScales.empty())
+    {
+        header.resize(HeaderSize, 0);
+        const std::size_t pos = header.size();
+        header.resize(pos + rowScales.size()*sizeof(double));
+        std::memcpy(&header[pos], &rowScales[0], rowScales.size()*sizeof(double));
+    }
+    header.resize(valuesOffset, 0);
+
+    // the previous file may be mapped, by this process or another one: it is replaced, not rewritten
+    const std::string tmpFilename = MappedFile::getTemporaryFileName(filename);
+    std::FILE* file = std::fopen(tmpFilename.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = std::fwrite(&header[0], 1, header.size(), file) == header.size();
+
+    helper::vector<char> encoded(n * encodingSize(encoding));
+    for (std::size_t i=0; ok && i<n; ++i)
+    {
+        const std::size_t count = storedRow(i);
+        for (std::size_t j=0; j<count; ++j)
+        {
+            switch (encoding)
+            {
+            case ENCODING_DOUBLE:
+                std::memcpy(&encoded[j*sizeof(double)], &row[j], sizeof(double));
+                break;
+            case ENCODING_FLOAT:
+            {
+                const float v = (float)row[j];
+                std::memcpy(&encoded[j*sizeof(float)], &v, sizeof(float));
+                break;
+            }
+            case ENCODING_HALF:
+            {
+                const std::uint16_t v = floatToHalf((float)(row[j] / rowScales[i]));
+                std::memcpy(&encoded[j*sizeof(std::uint16_t)], &v, sizeof(std::uint16_t));
+                break;
+            }
+            }
+        }
+        const std::size_t bytes = count * encodingSize(encoding);
+        ok = bytes == 0 || std::fwrite(&encoded[0], 1, bytes, file) == bytes;
+    }
+    if (std::fclose(file) != 0)
+        ok = false;
+    if (!ok)
+    {
+        std::remove(tmpFilename.c_str());
+        return false;
+    }
+    return MappedFile::replaceFile(tmpFilename, filename);
+}
+
+bool BinaryMatrixFile::open(const std::string& filename, std::uint64_t key, std::size_t n)
+{
+    close();
+    if (!file.open(filename))
+        return false;
+    const char* data = file.getData();
+    const std::size_t dataSize = file.getSize();
+    if (dataSize < HeaderSize || std::memcmp(data, Magic, 8) != 0
+        || extract<std::uint32_t>(data+8) != Version
+        || extract<std::uint64_t>(data+16) != key
+        || extract<std::uint64_t>(data+24) != n)
+    {
+        close();
+        return false;
+    }
+    const std::uint32_t fileEncoding = extract<std::uint32_t>(data+12);
+    const bool fileSymmetric = extract<std::uint32_t>(data+32) != 0;
+    const std::uint64_t valuesOffset = extract<std::uint64_t>(data+40);
+    const std::uint64_t scalesOffset = extract<std::uint64_t>(data+48);
+    if (fileEncoding > ENCODING_HALF || valuesOffset % ValuesAlignment != 0
+        || valuesOffset + storedSize(n, fileSymmetric) * encodingSize((Encoding)fileEncoding) > dataSize
+        || (fileEncoding == ENCODING_HALF && (scalesOffset < HeaderSize || scalesOffset + n*sizeof(double) > valuesOffset)))
+    {
+        close();
+        return false;
+    }
+    encoding = (Encoding)fileEncoding;
+    symmetric = fileSymmetric;
+    size = n;
+    values = data + valuesOffset;
+    scales = (encoding == ENCODING_HALF) ? reinterpret_cast<const double*>(data + scalesOffset) : NULL;
+    return true;
+}
+
+void BinaryMatrixFile::close()
+{
+    file.close();
+    encoding = ENCODING_DOUBLE;
+    symmetric = false;
+    size = 0;
+    values = NULL;
+    scales = NULL;
+}
+
+const double* BinaryMatrixFile::getDoubleValues() const
+{
+    if (!isOpen() || symmetric || encoding != ENCODING_DOUBLE)
+        return NULL;
+    return reinterpret_cast<const double*>(values);
+}
+
+const float* BinaryMatrixFile::getFloatValues() const
+{
+    if (!isOpen() || symmetric || encoding != ENCODING_FLOAT)
+        return NULL;
+    return reinterpret_cast<const float*>(values);
+}
+
+void BinaryMatrixFile::read(double* values) const
+{
+    readT(values);
+}
+
+void BinaryMatrixFile::read(float* values) const
+{
+    readT(values);
+}
+
+template<class Real>
+void BinaryMatrixFile::readT(Real* dest) const
+{
+    const std::size_t n = size;
+    const double* doubleValues = reinterpret_cast<const double*>(values);
+    const float* floatValues = reinterpret_cast<const float*>(values);
+    const std::uint16_t* halfValues = reinterpret_cast<const std::uint16_t*>(values);
+    for (std::size_t i=0; i<n; ++i)
+    {
+        const std::size_t begin = rowBegin(i, n, symmetric);
+        const std::size_t j0 = symmetric ? i : 0;
+        for (std::size_t j=j0; j<n; ++j)
+        {
+            const std::size_t k = begin + j - j0;
+            Real v = 0;
+            switch (encoding)
+            {
+            case ENCODING_DOUBLE: v = (Real)doubleValues[k]; break;
+            case ENCODING_FLOAT: v = (Real)floatValues[k]; break;
+            case ENCODING_HALF: v = (Real)(halfToFloat(halfValues[k]) * scales[i]); break;
+            }
+            dest[i*n+j] = v;
+            if (symmetric)
+                dest[j*n+i] = v;
+        }
+    }
+}
+
+std::uint64_t BinaryMatrixFile::hash(const void* data, std::size_t size, std::uint64_t h)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i=0; i<size; ++i)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::uint64_t BinaryMatrixFile::hash(const std::string& s, std::uint64_t h)
+{
+    return hash(s.data(), s.size(), h);
+}
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
@@ -0,0 +1,112 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_BINARYMATRIXFILE_H
+#define SOFA_HELPER_IO_BINARYMATRIXFILE_H
+
+#include <sofa/helper/helper.h>
+#include <sofa/helper/io/MappedFile.h>
+
+#include <cstdint>
+#include <string>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/** Binary file of a dense square matrix, used as a cache of precomputed matrices.
+ *
+ *  The file stores a key, a hash of everything the matrix was computed from, so that a stale
+ *  file is never used. The values are stored in row-major order:
+ *  - as doubles,
+ *  - as floats,
+ *  - or as half floats, scaled by the largest absolute value of their row,
+ *  either all of them or only the upper triangle of a symmetric matrix.
+ *
+ *  The values start on a 64 bytes boundary, so that a full matrix stored with the scalar type
+ *  of the reader is used in place from the mapping of the file, which is shared by all the
+ *  processes reading it. The values are stored in the native byte order.
+ */
+class SOFA_HELPER_API BinaryMatrixFile
+{
+public:
+    enum Encoding { ENCODING_DOUBLE=0, ENCODING_FLOAT=1, ENCODING_HALF=2 };
+
+    static const char Magic[8];
+    static const std::uint32_t Version = 1;
+    static const std::uint64_t HashSeed = 14695981039346656037ULL;
+
+    BinaryMatrixFile();
+
+    /// Write the n x n matrix given in row-major order. If symmetric, only the upper triangle of
+    /// the mean of the matrix and its transpose is stored.
+    static bool write(const std::string& filename, std::uint64_t key, const double* values, std::size_t n, Encoding encoding, bool symmetric = false);
+    static bool write(const std::string& filename, std::uint64_t key, const float* values, std::size_t n, Encoding encoding, bool symmetric = false);
+
+    /// Map the file, returning false if it is not a matrix file of the given key and size
+    bool open(const std::string& filename, std::uint64_t key, std::size_t n);
+    bool isOpen() const { return file.isOpen(); }
+    void close();
+
+    Encoding getEncoding() const { return encoding; }
+    bool isSymmetric() const { return symmetric; }
+    std::size_t getSize() const { return size; }
+
+    /// Values of a full matrix stored as doubles, in the mapping of the file, or NULL
+    const double* getDoubleValues() const;
+    /// Values of a full matrix stored as floats, in the mapping of the file, or NULL
+    const float* getFloatValues() const;
+
+    /// Decode the full matrix, in row-major order
+    void read(double* values) const;
+    void read(float* values) const;
+
+    /// 64 bits FNV-1a hash, to build the keys
+    static std::uint64_t hash(const void* data, std::size_t size, std::uint64_t h = HashSeed);
+    static std::uint64_t hash(const std::string& s, std::uint64_t h = HashSeed);
+
+protected:
+    template<class Real>
+    static bool writeT(const std::string& filename, std::uint64_t key, const Real* values, std::size_t n, Encoding encoding, bool symmetric);
+
+    template<class Real>
+    void readT(Real* values) const;
+
+    MappedFile file;
+    Encoding encoding;
+    bool symmetric;
+    std::size_t size;
+    const char* values; ///< first stored value in the mapping
+    const double* scales; ///< scale of each row of half floats
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_IO_BINARYMATRIXFILE_H
@@ -0,0 +1,422 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/BinaryStateFile.h>
+#include <sofa/helper/logging/Messaging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+const char BinaryStateFile::Magic[8] = { 'S','O','F','A','S','T','A','T' };
+const char BinaryStateFile::IndexMagic[8] = { 'S','O','F','A','I','N','D','X' };
+const std::uint32_t BinaryStateFile::FrameMagic;
+const std::uint32_t BinaryStateFile::Version;
+
+// Sizes of the headers in the file
+static const std::size_t FileHeaderSize = 16;   // magic, version, reserved
+static const std::size_t FrameHeaderSize = 24;  // magic, nbVectors, time, payload size
+static const std::size_t VectorHeaderSize = 8;  // name, encoding, reserved, nbScalars
+static const std::size_t DeltaHeaderSize = 16;  // keyframe, reserved, step
+static const std::size_t FooterSize = 24;       // nbFrames, index offset, magic
+static const std::size_t MaxPendingFrames = 16;
+
+bool BinaryStateFile::isBinaryStateFile(const std::string& filename)
+{
+    return filename.size() >= 4 && filename.substr(filename.size()-4) == ".bin";
+}
+
+template<class T>
+static void append(helper::vector<char>& buffer, const T& value)
+{
+    const std::size_t pos = buffer.size();
+    buffer.resize(pos + sizeof(T));
+    std::memcpy(&buffer[pos], &value, sizeof(T));
+}
+
+static void appendPadding(helper::vector<char>& buffer)
+{
+    buffer.resize((buffer.size() + 7) & ~(std::size_t)7, 0);
+}
+
+template<class T>
+static T extract(const char* ptr)
+{
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    return value;
+}
+
+// -------------------------------
+// BinaryStateWriter
+
+BinaryStateWriter::BinaryStateWriter()
+    : file(NULL)
+    , encoding(ENCODING_DOUBLE)
+    , keyframeInterval(10)
+    , nbFrames(0)
+    , frameVectors(0)
+    , closing(false)
+    , writeError(false)
+    , writtenBytes(0)
+{
+}
+
+BinaryStateWriter::~BinaryStateWriter()
+{
+    close();
+}
+
+bool BinaryStateWriter::open(const std::string& filename, Encoding encoding, unsigned int keyframeInterval)
+{
+    close();
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+    this->encoding = encoding;
+    this->keyframeInterval = std::max(keyframeInterval, 1u);
+    nbFrames = 0;
+    keyframes.clear();
+    index.clear();
+    writtenBytes = 0;
+    closing = false;
+    writeError = false;
+
+    helper::vector<char> header;
+    header.insert(header.end(), Magic, Magic+8);
+    append(header, Version);
+    append(header, (std::uint32_t)0);
+    pending.push_back(header);
+    thread = std::thread(&BinaryStateWriter::run, this);
+    return true;
+}
+
+void BinaryStateWriter::close()
+{
+    if (!file)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    condition.notify_all();
+    thread.join();
+
+    // the index is written after the frames, so that a file which was not closed is still readable
+    const std::uint64_t indexOffset = writtenBytes;
+    if (!index.empty() && std::fwrite(&index[0], sizeof(IndexEntry), index.size(), file) != index.size())
+        writeError = true;
+    helper::vector<char> footer;
+    append(footer, (std::uint64_t)index.size());
+    append(footer, indexOffset);
+    footer.insert(footer.end(), IndexMagic, IndexMagic+8);
+    if (std::fwrite(&footer[0], 1, footer.size(), file) != footer.size())
+        writeError = true;
+    if (std::fclose(file) != 0)
+        writeError = true;
+    file = NULL;
+    if (writeError)
+        msg_error("BinaryStateWriter") << "Error while writing the state file";
+}
+
+void BinaryStateWriter::beginFrame(double time)
+{
+    frame.clear();
+    append(frame, FrameMagic);
+    append(frame, (std::uint32_t)0);
+    append(frame, time);
+    append(frame, (std::uint64_t)0);
+    frameVectors = 0;
+}
+
+void BinaryStateWriter::addVector(char name, const double* values, std::size_t size)
+{
+    Encoding vectorEncoding = encoding;
+    double step = 0;
+    Keyframe* keyframe = NULL;
+    if (encoding == ENCODING_DELTA16)
+    {
+        std::map<char, Keyframe>::iterator it = keyframes.find(name);
+        if (it != keyframes.end() && it->second.values.size() == size && nbFrames - it->second.frame < keyframeInterval)
+        {
+            keyframe = &it->second;
+            double maxDelta = 0;
+            for (std::size_t i=0; i<size; ++i)
+                maxDelta = std::max(maxDelta, std::fabs(values[i] - keyframe->values[i]));
+            if (!(maxDelta <= std::numeric_limits<double>::max()))
+                keyframe = NULL; // not finite
+            else
+                step = maxDelta / 32767;
+        }
+        if (!keyframe)
+        {
+            // this frame becomes the keyframe of the vector
+            vectorEncoding = ENCODING_DOUBLE;
+            Keyframe& k = keyframes[name];
+            k.frame = (std::uint32_t)nbFrames;
+            k.values.assign(values, values+size);
+        }
+    }
+
+    append(frame, name);
+    append(frame, (std::uint8_t)vectorEncoding);
+    append(frame, (std::uint16_t)0);
+    append(frame, (std::uint32_t)size);
+    std::size_t pos = frame.size();
+    switch (vectorEncoding)
+    {
+    case ENCODING_DOUBLE:
+        frame.resize(pos + size*sizeof(double));
+        if (size) std::memcpy(&frame[pos], values, size*sizeof(double));
+        break;
+    case ENCODING_FLOAT:
+        frame.resize(pos + size*sizeof(float));
+        for (std::size_t i=0; i<size; ++i)
+        {
+            const float v = (float)values[i];
+            std::memcpy(&frame[pos + i*sizeof(float)], &v, sizeof(float));
+        }
+        break;
+    case ENCODING_DELTA16:
+        append(frame, keyframe->frame);
+        append(frame, (std::uint32_t)0);
+        append(frame, step);
+        pos = frame.size();
+        frame.resize(pos + size*sizeof(std::int16_t));
+        for (std::size_t i=0; i<size; ++i)
+        {
+            const std::int16_t q = (step > 0) ? (std::int16_t)std::floor((values[i] - keyframe->values[i]) / step + 0.5) : 0;
+            std::memcpy(&frame[pos + i*sizeof(std::int16_t)], &q, sizeof(std::int16_t));
+        }
+        break;
+    }
+    appendPadding(frame);
+    ++frameVectors;
+}
+
+void BinaryStateWriter::endFrame()
+{
+    if (!file)
+        return;
+    std::memcpy(&frame[4], &frameVectors, sizeof(std::uint32_t));
+    const std::uint64_t payloadSize = frame.size() - FrameHeaderSize;
+    std::memcpy(&frame[16], &payloadSize, sizeof(std::uint64_t));
+    ++nbFrames;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // limit the memory used if the disk is slower than the simulation
+        condition.wait(lock, [this]() { return pending.size() < MaxPendingFrames; });
+        pending.push_back(helper::vector<char>());
+        pending.back().swap(frame);
+    }
+    condition.notify_all();
+}
+
+void BinaryStateWriter::run()
+{
+    helper::vector<char> buffer;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return closing || !pending.empty(); });
+            if (pending.empty())
+                return;
+            buffer.swap(pending.front());
+            pending.pop_front();
+        }
+        condition.notify_all();
+
+        if (writtenBytes > 0)
+        {
+            IndexEntry entry;
+            entry.time = extract<double>(&buffer[8]);
+            entry.offset = writtenBytes;
+            index.push_back(entry);
+        }
+        if (std::fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+            writeError = true;
+        writtenBytes += buffer.size();
+    }
+}
+
+// -------------------------------
+// BinaryStateReader
+
+BinaryStateReader::BinaryStateReader()
+    : data(NULL)
+    , dataSize(0)
+{
+}
+
+BinaryStateReader::~BinaryStateReader()
+{
+    close();
+}
+
+bool BinaryStateReader::open(const std::string& filename)
+{
+    close();
+    if (!file.open(filename))
+        return false;
+    data = file.getData();
+    dataSize = file.getSize();
+
+    if (dataSize < FileHeaderSize || std::memcmp(data, Magic, 8) != 0 || extract<std::uint32_t>(data+8) != Version)
+    {
+        msg_error("BinaryStateReader") << filename << " is not a binary state file";
+        close();
+        return false;
+    }
+
+    index.clear();
+    bool indexed = false;
+    if (dataSize >= FileHeaderSize + FooterSize && std::memcmp(data + dataSize - 8, IndexMagic, 8) == 0)
+    {
+        const std::uint64_t nbFrames = extract<std::uint64_t>(data + dataSize - FooterSize);
+        const std::uint64_t indexOffset = extract<std::uint64_t>(data + dataSize - FooterSize + 8);
+        if (indexOffset + nbFrames*sizeof(IndexEntry) + FooterSize == dataSize)
+        {
+            index.resize((std::size_t)nbFrames);
+            if (nbFrames)
+                std::memcpy(&index[0], data + indexOffset, (std::size_t)nbFrames*sizeof(IndexEntry));
+            indexed = true;
+        }
+    }
+    if (!indexed)
+    {
+        msg_warning("BinaryStateReader") << filename << " has no index (it was not closed), scanning its frames";
+        scanFrames();
+    }
+    return true;
+}
+
+void BinaryStateReader::close()
+{
+    file.close();
+    data = NULL;
+    dataSize = 0;
+    index.clear();
+}
+
+void BinaryStateReader::scanFrames()
+{
+    std::size_t offset = FileHeaderSize;
+    while (offset + FrameHeaderSize <= dataSize && extract<std::uint32_t>(data + offset) == FrameMagic)
+    {
+        const std::uint64_t payloadSize = extract<std::uint64_t>(data + offset + 16);
+        if (payloadSize > dataSize - offset - FrameHeaderSize)
+            break; // truncated frame
+        IndexEntry entry;
+        entry.time = extract<double>(data + offset + 8);
+        entry.offset = offset;
+        index.push_back(entry);
+        offset += FrameHeaderSize + (std::size_t)payloadSize;
+    }
+}
+
+std::size_t BinaryStateReader::findFrame(double time) const
+{
+    helper::vector<IndexEntry>::const_iterator it = std::upper_bound(index.begin(), index.end(), time,
+        [](double t, const IndexEntry& e) { return t < e.time; });
+    if (it == index.begin())
+        return index.size();
+    return (std::size_t)(it - index.begin()) - 1;
+}
+
+const char* BinaryStateReader::findVector(std::size_t frame, char name) const
+{
+    if (frame >= index.size())
+        return NULL;
+    const char* ptr = data + index[frame].offset;
+    const std::uint32_t nbVectors = extract<std::uint32_t>(ptr + 4);
+    ptr += FrameHeaderSize;
+    for (std::uint32_t v=0; v<nbVectors; ++v)
+    {
+        const std::uint8_t encoding = extract<std::uint8_t>(ptr + 1);
+        const std::size_t size = extract<std::uint32_t>(ptr + 4);
+        if (ptr[0] == name)
+            return ptr;
+        std::size_t bytes = VectorHeaderSize;
+        switch (encoding)
+        {
+        case ENCODING_DOUBLE: bytes += size*sizeof(double); break;
+        case ENCODING_FLOAT: bytes += size*sizeof(float); break;
+        case ENCODING_DELTA16: bytes += DeltaHeaderSize + size*sizeof(std::int16_t); break;
+        default: return NULL;
+        }
+        ptr += (bytes + 7) & ~(std::size_t)7;
+    }
+    return NULL;
+}
+
+bool BinaryStateReader::readVector(std::size_t frame, char name, helper::vector<double>& values) const
+{
+    const char* ptr = findVector(frame, name);
+    if (!ptr)
+        return false;
+    const std::uint8_t encoding = extract<std::uint8_t>(ptr + 1);
+    const std::size_t size = extract<std::uint32_t>(ptr + 4);
+    ptr += VectorHeaderSize;
+    values.resize(size);
+    switch (encoding)
+    {
+    case ENCODING_DOUBLE:
+        if (size) std::memcpy(&values[0], ptr, size*sizeof(double));
+        break;
+    case ENCODING_FLOAT:
+        for (std::size_t i=0; i<size; ++i)
+            values[i] = extract<float>(ptr + i*sizeof(float));
+        break;
+    case ENCODING_DELTA16:
+    {
+        const std::uint32_t keyframe = extract<std::uint32_t>(ptr);
+        const double step = extract<double>(ptr + 8);
+        ptr += DeltaHeaderSize;
+        const char* key = findVector(keyframe, name);
+        if (!key || extract<std::uint8_t>(key + 1) != ENCODING_DOUBLE || extract<std::uint32_t>(key + 4) != size)
+            return false;
+        key += VectorHeaderSize;
+        for (std::size_t i=0; i<size; ++i)
+            values[i] = extract<double>(key + i*sizeof(double)) + step * extract<std::int16_t>(ptr + i*sizeof(std::int16_t));
+        break;
+    }
+    default:
+        return false;
+    }
+    return true;
+}
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
@@ -0,0 +1,170 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_BINARYSTATEFILE_H
+#define SOFA_HELPER_IO_BINARYSTATEFILE_H
+
+#include <sofa/helper/helper.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/vector.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/** Binary file of state vectors recorded at successive times.
+ *
+ *  The file is a header followed by one chunk per frame, and ends with an index of the frames,
+ *  so that any frame can be read without parsing the previous ones. The vectors of a frame are
+ *  identified by a character ('X', 'V', ...) and stored as arrays of scalars:
+ *  - as doubles,
+ *  - as floats,
+ *  - or as 16 bits integers quantizing the difference with the last frame storing the vector as
+ *    doubles (a keyframe), the error being less than half of the largest difference / 32767.
+ *
+ *  The values are stored in the native byte order.
+ */
+class SOFA_HELPER_API BinaryStateFile
+{
+public:
+    enum Encoding { ENCODING_DOUBLE=0, ENCODING_FLOAT=1, ENCODING_DELTA16=2 };
+
+    static const char Magic[8];
+    static const char IndexMagic[8];
+    static const std::uint32_t FrameMagic = 0x4d415246; // "FRAM"
+    static const std::uint32_t Version = 1;
+
+    struct IndexEntry
+    {
+        double time;
+        std::uint64_t offset;
+    };
+
+    /// Returns true if the file name has the extension of the binary state files (".bin")
+    static bool isBinaryStateFile(const std::string& filename);
+};
+
+/** Write a binary state file.
+ *
+ *  The frames are encoded by the calling thread, and written by a background thread.
+ */
+class SOFA_HELPER_API BinaryStateWriter : public BinaryStateFile
+{
+public:
+    BinaryStateWriter();
+    ~BinaryStateWriter();
+
+    /// Open the file, keyframeInterval being the maximum number of frames between two keyframes with ENCODING_DELTA16
+    bool open(const std::string& filename, Encoding encoding = ENCODING_DOUBLE, unsigned int keyframeInterval = 10);
+    bool isOpen() const { return file != NULL; }
+
+    /// Wait for the pending frames and write the index
+    void close();
+
+    void beginFrame(double time);
+    void addVector(char name, const double* values, std::size_t size);
+    /// Queue the frame to be written
+    void endFrame();
+
+    std::size_t getNbFrames() const { return nbFrames; }
+
+protected:
+    void run();
+
+    std::FILE* file;
+    Encoding encoding;
+    unsigned int keyframeInterval;
+    std::size_t nbFrames;
+
+    helper::vector<char> frame; ///< frame being encoded
+    std::uint32_t frameVectors;
+
+    struct Keyframe
+    {
+        std::uint32_t frame;
+        helper::vector<double> values;
+    };
+    std::map<char, Keyframe> keyframes;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque< helper::vector<char> > pending; ///< frames to write
+    bool closing;
+    bool writeError;
+    helper::vector<IndexEntry> index; ///< written frames, only accessed by the writing thread until close
+    std::uint64_t writtenBytes; ///< only accessed by the writing thread until close
+};
+
+/** Read a binary state file, mapping it in memory.
+ */
+class SOFA_HELPER_API BinaryStateReader : public BinaryStateFile
+{
+public:
+    BinaryStateReader();
+    ~BinaryStateReader();
+
+    bool open(const std::string& filename);
+    bool isOpen() const { return data != NULL; }
+    void close();
+
+    std::size_t getNbFrames() const { return index.size(); }
+    double getTime(std::size_t frame) const { return index[frame].time; }
+
+    /// Index of the last frame whose time is not after the given time, or getNbFrames() if there is none
+    std::size_t findFrame(double time) const;
+
+    /// Decode a vector of a frame, returning false if the frame does not contain it
+    bool readVector(std::size_t frame, char name, helper::vector<double>& values) const;
+
+protected:
+    /// Returns the position of the vector in the frame, or NULL
+    const char* findVector(std::size_t frame, char name) const;
+    /// Rebuild the index of a file which was not closed
+    void scanFrames();
+
+    MappedFile file;
+    const char* data;
+    std::size_t dataSize;
+    helper::vector<IndexEntry> index;
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_IO_BINARYSTATEFILE_H
@@ -0,0 +1,157 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/MappedFile.h>
+
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+MappedFile::MappedFile()
+    : data(NULL)
+    , dataSize(0)
+#ifdef WIN32
+    , fileHandle(NULL)
+    , mappingHandle(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+#ifdef WIN32
+    HANDLE f = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(f);
+        return false;
+    }
+    HANDLE m = CreateFileMapping(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m)
+    {
+        CloseHandle(f);
+        return false;
+    }
+    data = (const char*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+    fileHandle = f;
+    mappingHandle = m;
+    dataSize = (std::size_t)size.QuadPart;
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* ptr = mmap(NULL, (std::size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED)
+        return false;
+    data = (const char*)ptr;
+    dataSize = (std::size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!data)
+        return;
+#ifdef WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    fileHandle = NULL;
+    mappingHandle = NULL;
+#else
+    munmap((void*)data, dataSize);
+#endif
+    data = NULL;
+    dataSize = 0;
+}
+
+std::string MappedFile::getTemporaryFileName(const std::string& filename)
+{
+    static std::atomic<unsigned int> counter(0);
+    std::ostringstream ss;
+#ifdef WIN32
+    ss << filename << "." << GetCurrentProcessId();
+#else
+    ss << filename << "." << getpid();
+#endif
+    ss << "." << counter++ << ".tmp";
+    return ss.str();
+}
+
+bool MappedFile::replaceFile(const std::string& tmpFilename, const std::string& filename)
+{
+#ifdef WIN32
+    // fails if filename is mapped by another process, which then keeps using the previous version
+    const bool ok = MoveFileExA(tmpFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    const bool ok = std::rename(tmpFilename.c_str(), filename.c_str()) == 0;
+#endif
+    if (!ok)
+        std::remove(tmpFilename.c_str());
+    return ok;
+}
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
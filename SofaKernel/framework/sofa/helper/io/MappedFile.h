@@ -0,0 +1,84 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_MAPPEDFILE_H
+#define SOFA_HELPER_IO_MAPPEDFILE_H
+
+#include <sofa/helper/helper.h>
+
+#include <cstddef>
+#include <string>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/** Read-only mapping of a whole file in memory.
+ *
+ *  The pages are shared with the other processes mapping the same file, and are only loaded
+ *  from the disk when accessed.
+ */
+class SOFA_HELPER_API MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filename);
+    bool isOpen() const { return data != NULL; }
+    void close();
+
+    const char* getData() const { return data; }
+    std::size_t getSize() const { return dataSize; }
+
+    /// Name of a temporary file next to filename, unique to the calling process, in which to write
+    /// a new version of filename before moving it with replaceFile.
+    static std::string getTemporaryFileName(const std::string& filename);
+
+    /// Move tmpFilename over filename in a single step: the processes which mapped the previous
+    /// version keep reading it, instead of seeing a truncated file.
+    static bool replaceFile(const std::string& tmpFilename, const std::string& filename);
+
+protected:
+    const char* data;
+    std::size_t dataSize;
+#ifdef WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_IO_MAPPEDFILE_H
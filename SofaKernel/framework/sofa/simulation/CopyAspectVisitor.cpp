@@ -28,8 +28,8 @@ namespace sofa
 namespace simulation
 {
 
-CopyAspectVisitor::CopyAspectVisitor(const core::ExecParams* params, int destAspect, int srcAspect)
-    : Visitor(params), destAspect(destAspect), srcAspect(srcAspect)
+CopyAspectVisitor::CopyAspectVisitor(const core::ExecParams* params, int destAspect, int srcAspect, bool visualOnly)
+    : Visitor(params), destAspect(destAspect), srcAspect(srcAspect), visualOnly(visualOnly)
 {
 }
 
@@ -39,7 +39,10 @@ CopyAspectVisitor::~CopyAspectVisitor()
 
 void CopyAspectVisitor::processObject(sofa::core::objectmodel::BaseObject* obj)
 {
-    obj->copyAspect(destAspect, srcAspect);
+    if (visualOnly)
+        obj->copyVisualAspect(destAspect, srcAspect);
+    else
+        obj->copyAspect(destAspect, srcAspect);
     const sofa::core::objectmodel::BaseObject::VecSlaves& slaves = obj->getSlaves();
 
     for(sofa::core::objectmodel::BaseObject::VecSlaves::const_iterator iObj = slaves.begin(), endObj = slaves.end(); iObj != endObj; ++iObj)
@@ -50,7 +53,10 @@ void CopyAspectVisitor::processObject(sofa::core::objectmodel::BaseObject* obj)
 
 CopyAspectVisitor::Result CopyAspectVisitor::processNodeTopDown(Node* node)
 {
-    node->copyAspect(destAspect, srcAspect);
+    if (visualOnly)
+        node->copyVisualAspect(destAspect, srcAspect);
+    else
+        node->copyAspect(destAspect, srcAspect);
     for(Node::ObjectIterator iObj = node->object.begin(), endObj = node->object.end(); iObj != endObj; ++iObj)
     {
         processObject(iObj->get());
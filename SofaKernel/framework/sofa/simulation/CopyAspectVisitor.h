@@ -32,10 +32,12 @@ namespace sofa
 namespace simulation
 {
 
+/// Copy the Data and links of a whole graph from an aspect into another one.
+/// If visualOnly is true, only the modified Data read by the rendering are copied (see Base::copyVisualAspect).
 class SOFA_SIMULATION_CORE_API CopyAspectVisitor : public Visitor
 {
 public:
-    CopyAspectVisitor(const core::ExecParams* params, int destAspect, int srcAspect);
+    CopyAspectVisitor(const core::ExecParams* params, int destAspect, int srcAspect, bool visualOnly = false);
     ~CopyAspectVisitor();
 
     Result processNodeTopDown(Node* node);
@@ -45,6 +47,7 @@ protected:
 
     int destAspect;
     int srcAspect;
+    bool visualOnly;
 };
 
 } // namespace sofa
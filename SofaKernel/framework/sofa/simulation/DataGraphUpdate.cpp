@@ -0,0 +1,157 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/DataGraphUpdate.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <unordered_set>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+using core::objectmodel::DDGNode;
+
+namespace
+{
+
+/// Split the dirty nodes of a level in batches whose updates write disjoint dirty flags.
+/// Updating a node cleans the flags of its inputs and may propagate to all the nodes depending on it,
+/// so two nodes sharing an input or a downstream node are put in different batches.
+void getIndependentBatches(const helper::vector<DDGNode*>& level, helper::vector< helper::vector<DDGNode*> >& batches,
+                           const core::ExecParams* params)
+{
+    helper::vector< std::unordered_set<DDGNode*> > written;
+    helper::vector<DDGNode*> nodes, stack;
+    std::unordered_set<DDGNode*> visited;
+    for (std::size_t i=0; i<level.size(); ++i)
+    {
+        DDGNode* node = level[i];
+        if (!node->isDirty(params))
+            continue;
+
+        // the node, its inputs and the nodes reachable from it
+        nodes.assign(node->getInputs().begin(), node->getInputs().end());
+        visited.clear();
+        stack.assign(1, node);
+        visited.insert(node);
+        while (!stack.empty())
+        {
+            DDGNode* n = stack.back();
+            stack.pop_back();
+            nodes.push_back(n);
+            const DDGNode::DDGLinkContainer& outputs = n->getOutputs();
+            for (DDGNode::DDGLinkIterator it=outputs.begin(), itend=outputs.end(); it != itend; ++it)
+                if (visited.insert(*it).second)
+                    stack.push_back(*it);
+        }
+
+        std::size_t b = 0;
+        for (; b<batches.size(); ++b)
+        {
+            bool disjoint = true;
+            for (std::size_t j=0; j<nodes.size() && disjoint; ++j)
+                disjoint = (written[b].find(nodes[j]) == written[b].end());
+            if (disjoint)
+                break;
+        }
+        if (b == batches.size())
+        {
+            batches.resize(b+1);
+            written.resize(b+1);
+        }
+        batches[b].push_back(node);
+        written[b].insert(nodes.begin(), nodes.end());
+    }
+}
+
+} // namespace
+
+bool updateDirtyDependencies(const helper::vector<DDGNode*>& sources, bool parallel, const core::ExecParams* params)
+{
+    for (std::size_t i=0; i<sources.size(); ++i)
+        sources[i]->updateIfDirty(params);
+
+    helper::vector< helper::vector<DDGNode*> > levels;
+    if (!DDGNode::getDependencyLevels(sources, levels))
+    {
+        for (std::size_t l=0; l<levels.size(); ++l)
+            for (std::size_t i=0; i<levels[l].size(); ++i)
+                levels[l][i]->updateIfDirty(params);
+        return false;
+    }
+
+    // the inputs independent of the sources are updated first, so that the updates of a level only read clean inputs
+    std::unordered_set<DDGNode*> graph(sources.begin(), sources.end());
+    for (std::size_t l=0; l<levels.size(); ++l)
+        graph.insert(levels[l].begin(), levels[l].end());
+    for (std::size_t l=0; l<levels.size(); ++l)
+    {
+        for (std::size_t i=0; i<levels[l].size(); ++i)
+        {
+            DDGNode* node = levels[l][i];
+            if (!node->isDirty(params))
+                continue;
+            const DDGNode::DDGLinkContainer& inputs = node->getInputs();
+            for (DDGNode::DDGLinkIterator it=inputs.begin(), itend=inputs.end(); it != itend; ++it)
+            {
+                if (graph.find(*it) == graph.end())
+                    (*it)->updateIfDirty(params);
+            }
+        }
+    }
+
+    TaskScheduler* scheduler = TaskScheduler::getInstance();
+    for (std::size_t l=0; l<levels.size(); ++l)
+    {
+        const helper::vector<DDGNode*>& level = levels[l];
+        if (!parallel || level.size() < 2)
+        {
+            for (std::size_t i=0; i<level.size(); ++i)
+                level[i]->updateIfDirty(params);
+            continue;
+        }
+
+        helper::vector< helper::vector<DDGNode*> > batches;
+        getIndependentBatches(level, batches, params);
+        for (std::size_t b=0; b<batches.size(); ++b)
+        {
+            const helper::vector<DDGNode*>& batch = batches[b];
+            if (batch.size() < 2)
+            {
+                for (std::size_t i=0; i<batch.size(); ++i)
+                    batch[i]->updateIfDirty(params);
+                continue;
+            }
+            scheduler->parallel_for(std::size_t(0), batch.size(), [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t i=first; i<last; ++i)
+                    batch[i]->updateIfDirty(params);
+            });
+        }
+    }
+    return true;
+}
+
+} // namespace simulation
+
+} // namespace sofa
@@ -0,0 +1,49 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_DATAGRAPHUPDATE_H
+#define SOFA_SIMULATION_DATAGRAPHUPDATE_H
+
+#include <sofa/simulation/simulationcore.h>
+#include <sofa/core/objectmodel/DDGNode.h>
+#include <sofa/core/ExecParams.h>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+/// Update the dirty nodes depending on the given sources, one dependency level at a time.
+///
+/// With parallel, the nodes of a level are updated concurrently by the TaskScheduler, except the nodes
+/// sharing an input or a downstream node, whose updates would write the same dirty flags: the nodes of
+/// a level are split in batches without such nodes in common, updated one after the other. The engines
+/// of a level must then be thread-safe, and must not write Data shared with other engines of the level.
+/// Returns false if the dependencies contain a cycle, in which case the nodes are updated sequentially.
+SOFA_SIMULATION_CORE_API bool updateDirtyDependencies(const helper::vector<core::objectmodel::DDGNode*>& sources, bool parallel,
+                                                      const core::ExecParams* params = core::ExecParams::defaultInstance());
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif
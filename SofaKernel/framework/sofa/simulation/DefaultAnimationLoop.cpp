@@ -31,6 +31,8 @@
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/simulation/UpdateMappingEndEvent.h>
 #include <sofa/simulation/UpdateBoundingBoxVisitor.h>
+#include <sofa/simulation/DataGraphUpdate.h>
+#include <sofa/core/DataEngine.h>
 
 #include <sofa/helper/system/SetDirectory.h>
 #include <sofa/helper/AdvancedTimer.h>
@@ -40,6 +42,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <algorithm>
+#include <unordered_set>
 
 namespace sofa
 {
@@ -54,10 +57,12 @@ This loop do the following steps:
 - build and solve all linear systems in the scene : collision and time integration to compute the new values of the dofs
 - update the context (dt++)
 - update the mappings
+- optionally update the dirty engines, in parallel (parallelDataUpdate)
 - update the bounding box (volume covering all objects of the scene))");
 
 DefaultAnimationLoop::DefaultAnimationLoop(simulation::Node* _gnode)
     : Inherit()
+    , d_parallelDataUpdate(initData(&d_parallelDataUpdate, false, "parallelDataUpdate", "update the dirty engines at the end of each step, one dependency level at a time, the engines of a level being updated in parallel on the task scheduler (they must then be thread-safe)"))
     , gnode(_gnode)
 {
     //assert(gnode);
@@ -131,6 +136,12 @@ void DefaultAnimationLoop::step(const core::ExecParams* params, SReal dt)
     }
     sofa::helper::AdvancedTimer::stepEnd("UpdateMapping");
 
+    if (d_parallelDataUpdate.getValue())
+    {
+        sofa::helper::ScopedAdvancedTimer timer("UpdateDataDependencies");
+        updateDataDependencies(params);
+    }
+
     if (!SOFA_NO_UPDATE_BBOX)
     {
         sofa::helper::ScopedAdvancedTimer timer("UpdateBBox");
@@ -144,6 +155,39 @@ void DefaultAnimationLoop::step(const core::ExecParams* params, SReal dt)
 
 }
 
+void DefaultAnimationLoop::updateDataDependencies(const core::ExecParams* params)
+{
+    using core::objectmodel::DDGNode;
+
+    helper::vector<core::DataEngine*> engines;
+    gnode->getTreeObjects<core::DataEngine>(&engines);
+
+    // the sources are the nodes without input upstream of the engines
+    helper::vector<DDGNode*> sources, stack;
+    std::unordered_set<DDGNode*> visited;
+    for (std::size_t i=0; i<engines.size(); ++i)
+    {
+        stack.push_back(engines[i]);
+        visited.insert(engines[i]);
+    }
+    while (!stack.empty())
+    {
+        DDGNode* node = stack.back();
+        stack.pop_back();
+        const DDGNode::DDGLinkContainer& inputs = node->getInputs();
+        if (inputs.empty())
+            sources.push_back(node);
+        for (DDGNode::DDGLinkIterator it=inputs.begin(), itend=inputs.end(); it != itend; ++it)
+        {
+            if (visited.insert(*it).second)
+                stack.push_back(*it);
+        }
+    }
+
+    if (!updateDirtyDependencies(sources, true, params))
+        msg_warning() << "The engines depend on each other through a cycle: they were updated sequentially.";
+}
+
 
 } // namespace simulation
 
@@ -68,6 +68,8 @@ public:
     /// perform one animation step
     virtual void step(const sofa::core::ExecParams* params, SReal dt) override;
 
+    Data<bool> d_parallelDataUpdate; ///< update the dirty engines at the end of each step, one dependency level at a time, in parallel
+
 
     /// Construction method called by ObjectFactory.
     template<class T>
@@ -82,6 +84,10 @@ public:
 
 protected :
 
+    /// Update the dirty engines of the scene and the Data depending on them, the engines of a same
+    /// dependency level being updated concurrently by the TaskScheduler
+    void updateDataDependencies(const sofa::core::ExecParams* params);
+
     simulation::Node* gnode;  ///< the node controlled by the loop
 
 };
@@ -1,6 +1,7 @@
 #include "DefaultTaskScheduler.h"
 
 #include <sofa/helper/system/thread/thread_specific_ptr.h>
+#include <sofa/helper/AdvancedTimer.h>
 
 #include <assert.h>
 
@@ -29,6 +30,9 @@ namespace sofa
 
         DefaultTaskScheduler::DefaultTaskScheduler()
             : TaskScheduler()
+            , _sleepingWorkerCount(0)
+            , _idleSpinCount(2048)
+            , _idleYieldCount(64)
 		{
 			_isInitialized = false;
 			_threadCount = 0;
@@ -37,7 +41,14 @@ namespace sofa
             // init global static thread local var
             workerThreadIndex = new WorkerThread(this, 0, "Main  ");
             _threads[std::this_thread::get_id()] = workerThreadIndex;// new WorkerThread(this, 0, "Main  ");
-           
+            _workers.push_back(workerThreadIndex);
+
+            for (unsigned int i = 0; i < MAX_EXTERNAL_THREADS; ++i)
+            {
+                _externalThreads.push_back(new WorkerThread(this, i, "External"));
+                _externalUsed[i] = false;
+            }
+            addExternalWorkers();
 		}
 
         DefaultTaskScheduler::~DefaultTaskScheduler()
@@ -46,12 +57,18 @@ namespace sofa
 			{
 				stop();
 			}
+
+            for (WorkerThread* thread : _externalThreads)
+            {
+                delete thread;
+            }
 		}
 
 
 		unsigned DefaultTaskScheduler::GetHardwareThreadsCount()
 		{
-			return std::thread::hardware_concurrency() / 2;
+			const unsigned physicalCores = std::thread::hardware_concurrency() / 2;
+			return physicalCores > 0 ? physicalCores : 1;
 		}
 
 
@@ -84,8 +101,6 @@ namespace sofa
 			stop();
 
             _isClosing = false;
-            _workerThreadsIdle = true;
-            _mainTaskStatus	= nullptr;          
 
             // default number of thread: only physicsal cores. no advantage from hyperthreading.
             _threadCount = GetHardwareThreadsCount();
@@ -95,17 +110,20 @@ namespace sofa
                 _threadCount = NbThread;
             }
 
-            /* start worker threads */
+            /* start worker threads: they wait for _isInitialized before looking at the other queues */
             for( unsigned int i=1; i<_threadCount; ++i)
             {
                 WorkerThread* thread = new WorkerThread(this, i);
+				thread->start(this);
 				thread->create_and_attach(this);
 				_threads[thread->getId()] = thread;
-				thread->start(this);
+				_workers.push_back(thread);
             }
             
+            addExternalWorkers();
+
             _workerThreadCount = _threadCount;
-            _isInitialized = true;
+            _isInitialized.store(true, std::memory_order_release);
             return;
 		}
 
@@ -117,11 +135,10 @@ namespace sofa
 
 			if ( _isInitialized ) 
 			{
-				// wait for all
-				WaitForWorkersToBeReady();
-				wakeUpWorkers();
+				wakeUpAllWorkers();
                 _isInitialized = false;
                 
+				// join all the threads before freeing any of them: a worker may still be looking into the queue of another one
 				for (auto it : _threads)
 				{
 					// if this is the main thread continue
@@ -130,15 +147,19 @@ namespace sofa
 						continue;
 					}
 
-					// cpu busy wait
-					while (!it.second->isFinished())
+					if (it.second->_stdThread.joinable())
 					{
-						std::this_thread::yield();
-						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						it.second->_stdThread.join();
+					}
+				}
+
+				for (auto it : _threads)
+				{
+					if (std::this_thread::get_id() == it.first)
+					{
+						continue;
 					}
 
-					// free memory
-					// cpu busy wait: thread.joint call
 					delete it.second;
 					it.second = nullptr;
 				}
@@ -150,6 +171,9 @@ namespace sofa
 				WorkerThread* mainThread = mainThreadIt->second;
 				_threads.clear();
 				_threads[std::this_thread::get_id()] = mainThread;
+				_workers.clear();
+				_workers.push_back(mainThread);
+				addExternalWorkers();
 			}
 
 			return;
@@ -158,18 +182,83 @@ namespace sofa
         const char* DefaultTaskScheduler::getCurrentThreadName()
         {
             WorkerThread* thread = WorkerThread::getCurrent();
-            return thread->getName();
+            return thread ? thread->getName() : "External";
+        }
+
+        void DefaultTaskScheduler::addExternalWorkers()
+        {
+            // the external slots follow the worker threads, their index being their position for the thieves
+            for (WorkerThread* thread : _externalThreads)
+            {
+                thread->_index = _workers.size();
+                _workers.push_back(thread);
+            }
+        }
+
+        bool DefaultTaskScheduler::attachCurrentThread(const char* name)
+        {
+            if (WorkerThread::getCurrent())
+            {
+                return true;
+            }
+            for (unsigned int i = 0; i < _externalThreads.size(); ++i)
+            {
+                bool used = false;
+                if (_externalUsed[i].compare_exchange_strong(used, true))
+                {
+                    workerThreadIndex = _externalThreads[i];
+                    helper::AdvancedTimer::setTraceThreadName(name);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void DefaultTaskScheduler::detachCurrentThread()
+        {
+            WorkerThread* thread = workerThreadIndex;
+            for (unsigned int i = 0; i < _externalThreads.size(); ++i)
+            {
+                if (_externalThreads[i] == thread)
+                {
+                    assert(!thread->hasTasks());
+                    workerThreadIndex = nullptr;
+                    _externalUsed[i] = false;
+                    return;
+                }
+            }
         }
 
         bool DefaultTaskScheduler::addTask(Task* task)
         {
             WorkerThread* thread = WorkerThread::getCurrent();
+            if (!thread)
+            {
+                // called from a thread which is not attached (see attachCurrentThread):
+                // its tasks can't be queued, run them now
+                task->getStatus()->setBusy(true);
+                const bool deleteTask = task->run();
+                task->getStatus()->setBusy(false);
+                if (deleteTask)
+                {
+                    delete task;
+                }
+                return false;
+            }
             return thread->addTask(task);
         }
 
         void DefaultTaskScheduler::workUntilDone(Task::Status* status)
         {
             WorkerThread* thread = WorkerThread::getCurrent();
+            if (!thread)
+            {
+                while (status->isBusy())
+                {
+                    std::this_thread::yield();
+                }
+                return;
+            }
             thread->workUntilDone(status);
         }
 
@@ -183,34 +272,55 @@ namespace sofa
             delete task;
         }
 
+        void DefaultTaskScheduler::setIdlePolicy(const unsigned int spinCount, const unsigned int yieldCount)
+        {
+            _idleSpinCount.store(spinCount, std::memory_order_relaxed);
+            _idleYieldCount.store(yieldCount, std::memory_order_relaxed);
+        }
+
+        bool DefaultTaskScheduler::hasPendingTasks() const
+        {
+            for (const WorkerThread* thread : _workers)
+            {
+                if (thread->hasTasks())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
 
 
 		void DefaultTaskScheduler::wakeUpWorkers()
 		{
-			{
-				std::lock_guard<std::mutex> guard(_wakeUpMutex);
-				_workerThreadsIdle = false;
-			}								
-			_wakeUpEvent.notify_all();
+            // pairs with the fence in WorkerThread::Idle: either the sleeping worker
+            // sees the queued task or we see the sleeping worker
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_sleepingWorkerCount.load(std::memory_order_relaxed) == 0)
+            {
+                return;
+            }
+            {
+                // the worker may be between its last check and the wait
+                std::lock_guard<std::mutex> guard(_wakeUpMutex);
+            }
+            _wakeUpEvent.notify_one();
 		}
 
-		void DefaultTaskScheduler::WaitForWorkersToBeReady()
+		void DefaultTaskScheduler::wakeUpAllWorkers()
 		{
-			_workerThreadsIdle = true;
+			{
+				std::lock_guard<std::mutex> guard(_wakeUpMutex);
+			}
+			_wakeUpEvent.notify_all();
 		}
 
 
-		//unsigned TaskSchedulerDefault::size()	const
-		//{
-		//	return _workerThreadCount;
-		//}
-
-
 
         WorkerThread::WorkerThread(DefaultTaskScheduler* const& pScheduler, const int index, const std::string& name)
-            : _tasks()
+            : _name(name + std::to_string(index))
             , _index(index)
-            , _name(name + std::to_string(index))
+            , _tasks()
             , _taskScheduler(pScheduler)
 		{
 			assert(pScheduler);
@@ -250,7 +360,11 @@ namespace sofa
 
         WorkerThread* WorkerThread::getCurrent()
         {
-            //return workerThreadIndex;
+            // the main thread and the attached external threads
+            if (workerThreadIndex)
+            {
+                return workerThreadIndex;
+            }
             auto thread = DefaultTaskScheduler::_threads.find(std::this_thread::get_id());
             if (thread == DefaultTaskScheduler::_threads.end())
             {
@@ -261,26 +375,20 @@ namespace sofa
 
 		void WorkerThread::run(void)
 		{
-            
-            //workerThreadIndex = this;
-            //TaskSchedulerDefault::_threads[std::this_thread::get_id()] = this;
+            // wait for the scheduler to register all the workers
+            while (!_taskScheduler->isInitialized() && !_taskScheduler->isClosing())
+            {
+                std::this_thread::yield();
+            }
+
+            helper::AdvancedTimer::setTraceThreadName(_name);
 
 			// main loop
             while ( !_taskScheduler->isClosing() )
 			{
+				doWork(nullptr);
+
 				Idle();
-                
-                while ( _taskScheduler->_mainTaskStatus != nullptr)
-				{
-				
-					doWork(0);
-
-				
-					if (_taskScheduler->isClosing() )
-                    {
-                        break;
-                    }
-				}
 			}
 
 			_finished = true;
@@ -294,14 +402,36 @@ namespace sofa
 
         void WorkerThread::Idle()
         {
+            DefaultTaskScheduler* const scheduler = _taskScheduler;
+
+            // spin: lowest latency when tasks come in short bursts, as in a simulation step
+            const unsigned int spinCount = scheduler->getIdleSpinCount();
+            for (unsigned int i = 0; i < spinCount; ++i)
             {
-                std::unique_lock<std::mutex> lock( _taskScheduler->_wakeUpMutex );
-				//if (!_taskScheduler->_workerThreadsIdle)
-				//{
-				//	return;
-				//}
-                // cpu free wait
-                _taskScheduler->_wakeUpEvent.wait(lock, [&] {return !_taskScheduler->_workerThreadsIdle; });
+                if (scheduler->hasPendingTasks() || scheduler->isClosing())
+                {
+                    return;
+                }
+            }
+
+            // yield: give the core to other processes
+            const unsigned int yieldCount = scheduler->getIdleYieldCount();
+            for (unsigned int i = 0; i < yieldCount; ++i)
+            {
+                if (scheduler->hasPendingTasks() || scheduler->isClosing())
+                {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+
+            // park: cpu free wait until a task is queued
+            {
+                std::unique_lock<std::mutex> lock( scheduler->_wakeUpMutex );
+                scheduler->_sleepingWorkerCount.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                scheduler->_wakeUpEvent.wait(lock, [&] {return scheduler->isClosing() || scheduler->hasPendingTasks(); });
+                scheduler->_sleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
             }
             return;
         }
@@ -323,16 +453,15 @@ namespace sofa
                         return;
                 }
 
-                // check if main work is finished 
-                if (_taskScheduler->_mainTaskStatus == nullptr)
-                    return;
-
                 if (!stealTask(&task))
                     return;
 
                 // run the stolen task
                 runTask(task);
 
+                if (status && !status->isBusy())
+                    return;
+
             } //;;while (stealTasks());	
 
 		
@@ -346,7 +475,10 @@ namespace sofa
             _currentStatus = task->getStatus();
 
             {
-                if (task->run())
+                helper::AdvancedTimer::traceBegin(SOFA_TRACE_ID("Task"));
+                const bool deleteTask = task->run();
+                helper::AdvancedTimer::traceEnd(SOFA_TRACE_ID("Task"));
+                if (deleteTask)
                 {
                     // pooled memory: call destructor and free
                     //task->~Task();
@@ -364,11 +496,6 @@ namespace sofa
 			{
 				doWork(status);
 			}
-
-			if (_taskScheduler->_mainTaskStatus == status)
-			{
-				_taskScheduler->_mainTaskStatus = nullptr;
-			}
 		}
 
 
@@ -376,11 +503,8 @@ namespace sofa
 		{
             TASK_SCHEDULER_PROFILER(Pop);
 
-            simulation::ScopedLock lock( _taskMutex );
-            if (!_tasks.empty() )
+            if (_tasks.pop(*task))
             {
-                *task = _tasks.back();
-                _tasks.pop_back();
                 return true;
             }
             *task = nullptr;
@@ -399,30 +523,29 @@ namespace sofa
             {
                 TASK_SCHEDULER_PROFILER(Push);
 
-                simulation::ScopedLock lock(_taskMutex);
-                int taskId = task->getStatus()->setBusy(true);
-                task->_id = taskId;
-                _tasks.push_back(task);
+                // queue is full: the caller runs the task
+                if (!_tasks.push(task))
+                {
+                    return false;
+                }
             }
             
-            
-            if (!_taskScheduler->_mainTaskStatus)
-            {
-                _taskScheduler->_mainTaskStatus = task->getStatus();
-                _taskScheduler->wakeUpWorkers();
-            }
+            _taskScheduler->wakeUpWorkers();
             
             return true;
 		}
 
 		bool WorkerThread::addTask(Task* task)
 		{
+            // the status must be busy before any other thread can run the task
+            task->_id = task->getStatus()->setBusy(true);
+
 			if (pushTask(task))
             {
                 return true;
             }
 			
-            // we are single thread: run the task
+            // we are single thread or our queue is full: run the task
             runTask(task);
 
 			return false;
@@ -430,31 +553,19 @@ namespace sofa
 
         bool WorkerThread::stealTask(Task** task)
         {
+            const std::vector<WorkerThread*>& workers = _taskScheduler->_workers;
+            const size_t nbWorkers = workers.size();
+
+            // start with the next thread so that the thieves don't all hit the same victim
+            for (size_t i = 1; i < nbWorkers; ++i)
             {
-                //TASK_SCHEDULER_PROFILER(StealTask);
+                WorkerThread* otherThread = workers[(_index + i) % nbWorkers];
 
-                for (auto it : _taskScheduler->_threads)
-                {
-                    // if this is the main thread continue
-                    if (std::this_thread::get_id() == it.first)
-                    {
-                        continue;
-                    }
-
-                    WorkerThread* otherThread = it.second;
-
-                    {
-                        TASK_SCHEDULER_PROFILER(Steal);
-
-                        simulation::ScopedLock lock(otherThread->_taskMutex);
-                        if (!otherThread->_tasks.empty())
-                        {
-                            *task = otherThread->_tasks.front();
-                            otherThread->_tasks.pop_front();
-                            return true;
-                        }
-                    }
+                TASK_SCHEDULER_PROFILER(Steal);
 
+                if (otherThread->_tasks.steal(*task))
+                {
+                    return true;
                 }
             }
 
@@ -33,13 +33,14 @@
 #include <condition_variable>
 #include <memory>
 #include <map>
-#include <deque>
+#include <vector>
 #include <string> 
 #include <mutex>
 
 
 // workerthread
 #include "Locks.h"
+#include "WorkStealingQueue.h"
 
 
 namespace sofa  {
@@ -91,9 +92,9 @@ namespace sofa  {
 
             const std::thread::id getId();
 
-            const std::deque<Task*>* getTasksQueue() { return &_tasks; }
+            std::uint64_t getTaskCount() const { return _tasks.size(); }
 
-            std::uint64_t getTaskCount() { return _tasks.size(); }
+            bool hasTasks() const { return !_tasks.empty(); }
 
             int GetWorkerIndex();
 
@@ -116,15 +117,15 @@ namespace sofa  {
             // pop task from queue
             bool popTask(Task** ppTask);
 
-            // steal and queue some task from another thread 
+            // steal a task from the queue of another thread
             bool stealTask(Task** task);
 
             void doWork(Task::Status* status);
 
-            // boost thread main loop
+            // thread main loop
             void run(void);
 
-            //void	ThreadProc(void);
+            // spin, then yield, then sleep until some task is queued
             void	Idle(void);
 
             bool isFinished();
@@ -138,11 +139,10 @@ namespace sofa  {
 
             const std::string _name;
 
-            const size_t _index;
+            size_t _index;
 
-            simulation::SpinLock _taskMutex;
-
-            std::deque<Task*> _tasks;
+            // lock-free: pushed and popped by this thread, stolen by the others
+            WorkStealingQueue<Task*, Max_TasksPerThread> _tasks;
 
             std::thread  _stdThread;
 
@@ -163,6 +163,7 @@ namespace sofa  {
             enum
             {
                 MAX_THREADS = 16,
+                MAX_EXTERNAL_THREADS = 4,
                 STACKSIZE = 64 * 1024 /* 64K */,
             };
 
@@ -178,6 +179,16 @@ namespace sofa  {
             virtual void workUntilDone(Task::Status* status) final;
             virtual void* allocateTask(size_t size) final;
             virtual void releaseTask(Task*) final;
+            virtual bool attachCurrentThread(const char* name) final;
+            virtual void detachCurrentThread() final;
+
+            // idle policy of the worker threads: a worker which runs out of tasks
+            // first polls the queues spinCount times, then yields yieldCount times,
+            // and only then sleeps until a new task is queued.
+            // Higher values lower the wake-up latency at the cost of cpu usage.
+            void setIdlePolicy(const unsigned int spinCount, const unsigned int yieldCount);
+            unsigned int getIdleSpinCount() const { return _idleSpinCount.load(std::memory_order_relaxed); }
+            unsigned int getIdleYieldCount() const { return _idleYieldCount.load(std::memory_order_relaxed); }
 
         public:
 
@@ -190,14 +201,18 @@ namespace sofa  {
 
         private:
 
-            bool isInitialized() { return _isInitialized; }
+            bool isInitialized() { return _isInitialized.load(std::memory_order_acquire); }
 
-            bool isClosing(void) const { return _isClosing; }
+            bool isClosing(void) const { return _isClosing.load(std::memory_order_acquire); }
 
-            void	WaitForWorkersToBeReady();
+            // true if any thread has a task waiting in its queue
+            bool hasPendingTasks() const;
 
+            // wake up a sleeping worker, if any, after a task was queued
             void	wakeUpWorkers();
 
+            void	wakeUpAllWorkers();
+
             static unsigned GetHardwareThreadsCount();
 
             WorkerThread* getCurrentThread();
@@ -213,12 +228,25 @@ namespace sofa  {
             //static thread_local WorkerThread* _workerThreadIndex;
             static std::map< std::thread::id, WorkerThread*> _threads;
 
-            Task::Status*	_mainTaskStatus;
+            // all the threads indexed by WorkerThread::getIndex(), the main thread is the first one
+            // and the slots of the external threads the last ones
+            std::vector<WorkerThread*> _workers;
+
+            // slots given to the threads attached by attachCurrentThread, kept for the scheduler lifetime
+            std::vector<WorkerThread*> _externalThreads;
+
+            std::atomic<bool> _externalUsed[MAX_EXTERNAL_THREADS];
 
             std::mutex  _wakeUpMutex;
 
             std::condition_variable _wakeUpEvent;
 
+            std::atomic<int> _sleepingWorkerCount;
+
+            std::atomic<unsigned int> _idleSpinCount;
+
+            std::atomic<unsigned int> _idleYieldCount;
+
         private:
 
             DefaultTaskScheduler();
@@ -229,13 +257,14 @@ namespace sofa  {
 
             void start(unsigned int NbThread);
 
-            bool _isInitialized;
+            // append the slots of the external threads to _workers
+            void addExternalWorkers();
 
-            unsigned _workerThreadCount;
+            std::atomic<bool> _isInitialized;
 
-            bool _workerThreadsIdle;
+            unsigned _workerThreadCount;
 
-            bool _isClosing;
+            std::atomic<bool> _isClosing;
 
             unsigned _threadCount;
 
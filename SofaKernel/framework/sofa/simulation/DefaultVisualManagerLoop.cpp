@@ -28,6 +28,7 @@
 #include <sofa/simulation/UpdateMappingVisitor.h>
 #include <sofa/simulation/UpdateMappingEndEvent.h>
 #include <sofa/simulation/PropagateEventVisitor.h>
+#include <sofa/simulation/VisualAspectBuffer.h>
 
 
 #include <sofa/helper/AdvancedTimer.h>
@@ -45,13 +46,14 @@ int DefaultVisualManagerLoopClass = core::RegisterObject("The simplest Visual Lo
 DefaultVisualManagerLoop::DefaultVisualManagerLoop(simulation::Node* _gnode)
     : Inherit()
     , gRoot(_gnode)
+    , m_aspectBuffer(NULL)
 {
     //assert(gRoot);
 }
 
 DefaultVisualManagerLoop::~DefaultVisualManagerLoop()
 {
-
+    delete m_aspectBuffer;
 }
 
 void DefaultVisualManagerLoop::init()
@@ -79,6 +81,8 @@ void DefaultVisualManagerLoop::updateStep(sofa::core::ExecParams* params)
     sofa::helper::AdvancedTimer::begin("UpdateVisual");
 
     gRoot->execute<VisualUpdateVisitor>(params);
+    if (m_aspectBuffer)
+        m_aspectBuffer->publish(params);
     sofa::helper::AdvancedTimer::end("UpdateVisual");
 #ifdef SOFA_DUMP_VISITOR_INFO
     simulation::Visitor::printCloseNode("UpdateVisual");
@@ -95,6 +99,7 @@ void DefaultVisualManagerLoop::updateContextStep(sofa::core::visual::VisualParam
 void DefaultVisualManagerLoop::drawStep(sofa::core::visual::VisualParams* vparams)
 {
     if ( !gRoot ) return;
+    RenderScope renderScope(this);
     if (gRoot->visualManager.empty())
     {
         vparams->pass() = sofa::core::visual::VisualParams::Std;
@@ -140,7 +145,10 @@ void DefaultVisualManagerLoop::computeBBoxStep(sofa::core::visual::VisualParams*
 {
     VisualComputeBBoxVisitor act(vparams);
     if ( gRoot )
+    {
+        RenderScope renderScope(this);
         gRoot->execute ( act );
+    }
 //    cerr<<"DefaultVisualManagerLoop::computeBBoxStep, xm= " << act.minBBox[0] <<", xM= " << act.maxBBox[0] << endl;
     if (init)
     {
@@ -162,7 +170,33 @@ void DefaultVisualManagerLoop::computeBBoxStep(sofa::core::visual::VisualParams*
     }
 }
 
+bool DefaultVisualManagerLoop::setAsyncRendering(bool enable)
+{
+    if (enable == isAsyncRendering())
+        return true;
+    if (!enable)
+    {
+        delete m_aspectBuffer;
+        m_aspectBuffer = NULL;
+        return true;
+    }
+    if (!gRoot || !VisualAspectBuffer::isSupported())
+        return false;
+    m_aspectBuffer = new VisualAspectBuffer(gRoot);
+    return true;
+}
+
+void DefaultVisualManagerLoop::beginRender()
+{
+    if (m_aspectBuffer)
+        m_aspectBuffer->beginRender();
+}
 
+void DefaultVisualManagerLoop::endRender()
+{
+    if (m_aspectBuffer)
+        m_aspectBuffer->endRender();
+}
 
 } // namespace simulation
 
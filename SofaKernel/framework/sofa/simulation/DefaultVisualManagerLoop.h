@@ -40,10 +40,14 @@ namespace sofa
 namespace simulation
 {
 
+class VisualAspectBuffer;
+
 /**
  *  \brief Default VisualManager Loop to be created when no VisualManager found on simulation::node.
  *
- *
+ *  With asynchronous rendering enabled (see setAsyncRendering), the simulation and the rendering can run
+ *  in different threads: updateStep publishes the visual state in a separate aspect, which drawStep and
+ *  computeBBoxStep read while the simulation keeps going.
  */
 
 class SOFA_SIMULATION_CORE_API DefaultVisualManagerLoop : public sofa::core::visual::VisualLoop
@@ -75,6 +79,27 @@ public:
     /// Compute the bounding box of the scene. If init is set to "true", then minBBox and maxBBox will be initialised to a default value
     virtual void computeBBoxStep(sofa::core::visual::VisualParams* vparams, SReal* minBBox, SReal* maxBBox, bool init) override;
 
+    /// Enable or disable the rendering from another thread than the simulation.
+    /// Must be called while neither the simulation nor the rendering is running.
+    /// @return false if SOFA was compiled without enough aspects (see VisualAspectBuffer).
+    bool setAsyncRendering(bool enable);
+    bool isAsyncRendering() const { return m_aspectBuffer != NULL; }
+
+    /// Rendering thread: read the latest published visual state until endRender().
+    /// Nothing is done if the asynchronous rendering is disabled.
+    void beginRender();
+    void endRender();
+
+    /// Read the latest published visual state in the current scope
+    class RenderScope
+    {
+    public:
+        RenderScope(DefaultVisualManagerLoop* loop) : loop(loop) { loop->beginRender(); }
+        ~RenderScope() { loop->endRender(); }
+    protected:
+        DefaultVisualManagerLoop* loop;
+    };
+
 
     /// Construction method called by ObjectFactory.
     template<class T>
@@ -90,6 +115,7 @@ public:
 protected:
 
     simulation::Node* gRoot;
+    VisualAspectBuffer* m_aspectBuffer;
 };
 
 } // namespace simulation
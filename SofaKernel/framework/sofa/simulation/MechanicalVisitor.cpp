@@ -680,6 +680,13 @@ Visitor::Result MechanicalVMultiOpVisitor::fwdMappedMechanicalState(VisitorConte
 }
 
 
+Visitor::Result MechanicalVMultiOpDotVisitor::fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm)
+{
+    mm->vMultiOp(this->params, ops );
+    *ctx->nodeData += mm->vDot(this->params, a.getId(mm),b.getId(mm) );
+    return RESULT_CONTINUE;
+}
+
 Visitor::Result MechanicalVDotVisitor::fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm)
 {
     *ctx->nodeData += mm->vDot(this->params, a.getId(mm),b.getId(mm) );
@@ -802,6 +802,54 @@ protected:
     VMultiOp ops;
 };
 
+/** Perform a sequence of linear vector accumulation operations, then compute the dot product of two vectors,
+ *  in a single traversal of the graph.
+ *
+ *  Each mechanical state applies the operations and immediately computes its contribution to the dot product,
+ *  while its vectors are still in cache. This saves one full pass over all the states compared to
+ *  a MechanicalVMultiOpVisitor followed by a MechanicalVDotVisitor.
+ *  The dot product is computed after the operations, so it can involve any of their results.
+ *  Mapped states are ignored, as in MechanicalVDotVisitor.
+ */
+class SOFA_SIMULATION_CORE_API MechanicalVMultiOpDotVisitor : public MechanicalVMultiOpVisitor
+{
+public:
+    sofa::core::ConstMultiVecId a;
+    sofa::core::ConstMultiVecId b;
+    MechanicalVMultiOpDotVisitor(const sofa::core::ExecParams* params, const VMultiOp& o, sofa::core::ConstMultiVecId a, sofa::core::ConstMultiVecId b, SReal* t)
+        : MechanicalVMultiOpVisitor(params, o), a(a), b(b)
+    {
+#ifdef SOFA_DUMP_VISITOR_INFO
+        addReadVector(a);
+        addReadVector(b);
+#endif
+        rootData = t;
+    }
+
+    virtual Result fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm);
+    virtual Result fwdMappedMechanicalState(VisitorContext* /*ctx*/, core::behavior::BaseMechanicalState* /*mm*/)
+    {
+        return RESULT_CONTINUE;
+    }
+
+    virtual const char* getClassName() const { return "MechanicalVMultiOpDotVisitor"; }
+    virtual std::string getInfos() const
+    {
+        std::string name = MechanicalVMultiOpVisitor::getInfos();
+        name += " ;   v= a*b with a[" + a.getName() + "] and b[" + b.getName() + "]";
+        return name;
+    }
+
+    virtual bool readNodeData() const
+    {
+        return false;
+    }
+    virtual bool writeNodeData() const
+    {
+        return true;
+    }
+};
+
 /** Compute the dot product of two vectors */
 class SOFA_SIMULATION_CORE_API MechanicalVDotVisitor : public BaseMechanicalVisitor
 {
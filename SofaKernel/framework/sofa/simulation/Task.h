@@ -45,9 +45,10 @@ namespace sofa
             public:
                 Status() : _busy(0) {}
 
+                // acquire: once the status is idle, the results of its tasks are visible
                 bool isBusy() const
                 {
-                    return (_busy.load(std::memory_order_relaxed) > 0);
+                    return (_busy.load(std::memory_order_acquire) > 0);
                 }
 
                 int setBusy(bool busy)
@@ -58,7 +59,7 @@ namespace sofa
                     }
                     else
                     {
-                        return _busy.fetch_sub(1, std::memory_order_relaxed);
+                        return _busy.fetch_sub(1, std::memory_order_release);
                     }
                 }
 
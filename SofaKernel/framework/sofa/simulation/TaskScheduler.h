@@ -78,8 +78,35 @@ namespace sofa
 
             virtual void releaseTask(Task*) = 0;
 
+            // give worker status to the calling thread, which the scheduler does not own (e.g. a simulation
+            // thread started by a GUI): its tasks are then queued and stolen by the other threads.
+            // Returns false if no slot is free, its tasks are then run inline.
+            virtual bool attachCurrentThread(const char* name) = 0;
+
+            // to be called by an attached thread before it ends, once its tasks are done
+            virtual void detachCurrentThread() = 0;
+
+            // parallel loops
+            // The range [first, last) is recursively split in halves until the chunks
+            // hold no more than grainSize indices, and body(begin, end) is called once
+            // per chunk. The halves are queued as tasks so that idle threads steal the
+            // largest remaining ranges first. With grainSize == 0 the grain is derived
+            // from the range size and the number of threads.
+            template<class Index, class Body>
+            void parallel_for(const Index first, const Index last, const Body& body, const Index grainSize = 0);
+
+            // body(begin, end) returns the partial result of a chunk, and reduction(a, b)
+            // combines two partial results. identity is returned for an empty range.
+            // For a given thread count the reduction tree is always the same, so
+            // floating point sums are reproducible from one call to the next.
+            template<class Index, class Value, class Body, class Reduction>
+            Value parallel_reduce(const Index first, const Index last, const Value& identity, const Body& body, const Reduction& reduction, const Index grainSize = 0);
+
         protected:
 
+            template<class Index>
+            Index computeGrainSize(const Index first, const Index last) const;
+
             // factory map: registered schedulers: name, creation function
             static std::map<std::string, std::function<TaskScheduler*()> > _schedulers;
 
@@ -96,6 +123,163 @@ namespace sofa
         SOFA_SIMULATION_CORE_API bool runThreadSpecificTask(const Task *pTask );
 
 
+
+        // splits its range and queues the upper halves, then runs the body on what is left
+        template<class Index, class Body>
+        class ParallelForTask : public Task
+        {
+        public:
+
+            ParallelForTask(TaskScheduler* scheduler, const Index first, const Index last, const Index grainSize, const Body* body, const Task::Status* status)
+                : Task(status)
+                , _scheduler(scheduler)
+                , _first(first)
+                , _last(last)
+                , _grainSize(grainSize)
+                , _body(body)
+            {}
+
+            virtual ~ParallelForTask() {}
+
+            virtual bool run() final
+            {
+                while (_last - _first > _grainSize)
+                {
+                    const Index middle = _first + (_last - _first) / 2;
+                    _scheduler->addTask(new ParallelForTask(_scheduler, middle, _last, _grainSize, _body, _status));
+                    _last = middle;
+                }
+
+                (*_body)(_first, _last);
+
+                // allocated by the parent: delete
+                return true;
+            }
+
+        private:
+
+            TaskScheduler* _scheduler;
+            const Index _first;
+            Index _last;
+            const Index _grainSize;
+            const Body* _body;
+        };
+
+
+        // computes its range as the reduction of its two halves
+        template<class Index, class Value, class Body, class Reduction>
+        class ParallelReduceTask : public Task
+        {
+        public:
+
+            ParallelReduceTask(TaskScheduler* scheduler, const Index first, const Index last, const Index grainSize,
+                const Value* identity, const Body* body, const Reduction* reduction, Value* result, const Task::Status* status)
+                : Task(status)
+                , _scheduler(scheduler)
+                , _first(first)
+                , _last(last)
+                , _grainSize(grainSize)
+                , _identity(identity)
+                , _body(body)
+                , _reduction(reduction)
+                , _result(result)
+            {}
+
+            virtual ~ParallelReduceTask() {}
+
+            virtual bool run() final
+            {
+                if (_last - _first <= _grainSize)
+                {
+                    *_result = (*_body)(_first, _last);
+                    return false;
+                }
+
+                const Index middle = _first + (_last - _first) / 2;
+
+                Task::Status status;
+                Value left(*_identity);
+                Value right(*_identity);
+
+                ParallelReduceTask leftTask(_scheduler, _first, middle, _grainSize, _identity, _body, _reduction, &left, &status);
+                ParallelReduceTask rightTask(_scheduler, middle, _last, _grainSize, _identity, _body, _reduction, &right, &status);
+
+                // the left half is queued last: it is popped back by this thread first
+                _scheduler->addTask(&rightTask);
+                _scheduler->addTask(&leftTask);
+                _scheduler->workUntilDone(&status);
+
+                *_result = (*_reduction)(left, right);
+
+                // allocated on the stack of the parent
+                return false;
+            }
+
+        private:
+
+            TaskScheduler* _scheduler;
+            const Index _first;
+            const Index _last;
+            const Index _grainSize;
+            const Value* _identity;
+            const Body* _body;
+            const Reduction* _reduction;
+            Value* _result;
+        };
+
+
+        template<class Index>
+        Index TaskScheduler::computeGrainSize(const Index first, const Index last) const
+        {
+            // a few chunks per thread: enough slack for the load balancing by stealing
+            const Index chunkCount = static_cast<Index>(8 * getThreadCount());
+            const Index grainSize = chunkCount > 0 ? (last - first) / chunkCount : (last - first);
+            return grainSize > 0 ? grainSize : 1;
+        }
+
+        template<class Index, class Body>
+        void TaskScheduler::parallel_for(const Index first, const Index last, const Body& body, const Index grainSize)
+        {
+            if (!(first < last))
+            {
+                return;
+            }
+
+            const Index grain = grainSize > 0 ? grainSize : computeGrainSize(first, last);
+            if (getThreadCount() < 2 || last - first <= grain)
+            {
+                body(first, last);
+                return;
+            }
+
+            Task::Status status;
+            addTask(new ParallelForTask<Index, Body>(this, first, last, grain, &body, &status));
+            workUntilDone(&status);
+        }
+
+        template<class Index, class Value, class Body, class Reduction>
+        Value TaskScheduler::parallel_reduce(const Index first, const Index last, const Value& identity, const Body& body, const Reduction& reduction, const Index grainSize)
+        {
+            if (!(first < last))
+            {
+                return identity;
+            }
+
+            const Index grain = grainSize > 0 ? grainSize : computeGrainSize(first, last);
+            if (getThreadCount() < 2 || last - first <= grain)
+            {
+                return body(first, last);
+            }
+
+            Task::Status status;
+            Value result(identity);
+            ParallelReduceTask<Index, Value, Body, Reduction> task(this, first, last, grain, &identity, &body, &reduction, &result, &status);
+            addTask(&task);
+            workUntilDone(&status);
+            return result;
+        }
+
+
 	} // namespace simulation
 
 } // namespace sofa
@@ -0,0 +1,166 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/VisualAspectBuffer.h>
+#include <sofa/simulation/CopyAspectVisitor.h>
+#include <sofa/simulation/ReleaseAspectVisitor.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/helper/logging/Messaging.h>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+namespace
+{
+
+/// Clean the dirty flags of all the Data of a graph in an aspect, so that reading them never runs the engines
+class CleanDirtyAspectVisitor : public Visitor
+{
+public:
+    CleanDirtyAspectVisitor(const core::ExecParams* params, int aspect) : Visitor(params), aspect(aspect) {}
+
+    Result processNodeTopDown(Node* node) override
+    {
+        processBase(node);
+        for(Node::ObjectIterator iObj = node->object.begin(), endObj = node->object.end(); iObj != endObj; ++iObj)
+            processObject(iObj->get());
+        return RESULT_CONTINUE;
+    }
+
+    const char* getClassName() const override { return "CleanDirtyAspectVisitor"; }
+
+protected:
+    void processObject(core::objectmodel::BaseObject* obj)
+    {
+        processBase(obj);
+        const core::objectmodel::BaseObject::VecSlaves& slaves = obj->getSlaves();
+        for(core::objectmodel::BaseObject::VecSlaves::const_iterator iObj = slaves.begin(), endObj = slaves.end(); iObj != endObj; ++iObj)
+            processObject(iObj->get());
+    }
+
+    void processBase(core::objectmodel::Base* base)
+    {
+        const core::objectmodel::Base::VecData& data = base->getDataFields();
+        for (core::objectmodel::Base::VecData::const_iterator it = data.begin(); it != data.end(); ++it)
+            (*it)->cleanDirtyAspect(aspect);
+    }
+
+    int aspect;
+};
+
+} // namespace
+
+VisualAspectBuffer::VisualAspectBuffer(Node* root)
+    : root(root)
+    , buffer(pool)
+    , generation(0)
+    , renderDepth(0)
+    , previousAspect(0)
+{
+    copiedGeneration.assign(-1);
+
+    // the pool hands out the aspects in order: the simulation keeps aspect 0
+    simulationAspect = pool.allocate();
+    if (!isSupported() || !simulationAspect || simulationAspect->aspectID() != 0)
+    {
+        msg_error("VisualAspectBuffer") << "Not enough aspects to buffer the visual state, SOFA must be compiled with SOFA_MAX_THREADS >= 2.";
+    }
+}
+
+VisualAspectBuffer::~VisualAspectBuffer()
+{
+    buffer.clear();
+    renderAspect.reset();
+
+    // free the memory used by the copies
+    for (int id = 0; id < core::SOFA_DATA_MAX_ASPECTS; ++id)
+    {
+        if (copiedGeneration[id] < 0 || (simulationAspect && id == simulationAspect->aspectID()))
+            continue;
+        ReleaseAspectVisitor release(core::ExecParams::defaultInstance(), id);
+        root->execute(release);
+    }
+    simulationAspect.reset();
+}
+
+bool VisualAspectBuffer::isSupported()
+{
+    // one aspect for the simulation, the latest published one, the one being rendered and a free one
+    return core::SOFA_DATA_MAX_ASPECTS >= 4;
+}
+
+void VisualAspectBuffer::publish(const core::ExecParams* params)
+{
+    if (!simulationAspect || simulationAspect->aspectID() != 0)
+        return;
+
+    core::objectmodel::AspectRef aspect = buffer.allocate();
+    if (!aspect)
+        return; // every aspect is in use, the rendering will use the previous version
+
+    helper::AdvancedTimer::stepBegin("PublishVisualAspect");
+    const int id = aspect->aspectID();
+    const int currentGeneration = generation;
+    const bool fullCopy = (copiedGeneration[id] != currentGeneration);
+    CopyAspectVisitor copy(params, id, simulationAspect->aspectID(), !fullCopy);
+    root->execute(copy);
+    if (fullCopy)
+    {
+        // the Data not computed yet are copied dirty, the rendering thread must not update them
+        CleanDirtyAspectVisitor clean(params, id);
+        root->execute(clean);
+    }
+    copiedGeneration[id] = currentGeneration;
+    buffer.push(aspect);
+    helper::AdvancedTimer::stepEnd("PublishVisualAspect");
+}
+
+void VisualAspectBuffer::invalidate()
+{
+    generation.inc();
+}
+
+int VisualAspectBuffer::beginRender()
+{
+    core::ExecParams* params = core::ExecParams::defaultInstance();
+    if (renderDepth++ > 0)
+        return params->aspectID();
+
+    previousAspect = params->aspectID();
+    buffer.pop(renderAspect);
+    if (renderAspect)
+        params->setAspectID(renderAspect->aspectID());
+    return params->aspectID();
+}
+
+void VisualAspectBuffer::endRender()
+{
+    if (renderDepth == 0 || --renderDepth > 0)
+        return;
+    core::ExecParams::defaultInstance()->setAspectID(previousAspect);
+}
+
+} // namespace simulation
+
+} // namespace sofa
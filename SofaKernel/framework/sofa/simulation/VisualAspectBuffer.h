@@ -0,0 +1,99 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_VISUALASPECTBUFFER_H
+#define SOFA_SIMULATION_VISUALASPECTBUFFER_H
+
+#include <sofa/simulation/simulationcore.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/core/objectmodel/AspectPool.h>
+#include <sofa/helper/fixed_array.h>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+/**
+ * Triple buffering of the visual state of a scene, used to render it in another thread than the simulation.
+ *
+ * The simulation keeps writing aspect 0, which is the default aspect of every thread (including the
+ * TaskScheduler workers). After each visual update, the simulation thread calls publish() to copy the
+ * Data flagged as visual (see BaseData::isVisual) into a free aspect, and hands it over through an
+ * AspectBuffer. The rendering thread calls beginRender() / endRender() around its drawing to switch
+ * to the latest published aspect, which is never written while it is in use.
+ * Both sides only exchange aspect numbers through atomic operations, no lock is ever taken.
+ *
+ * The first publication into a given aspect copies all the Data, as do the publications following
+ * invalidate(). The later ones only copy the visual Data modified and computed since (a visual Data dirty
+ * in the simulation aspect keeps its previous value). The dirty flags are always clean in the published
+ * aspects, so that the rendering never runs an engine: the Data which are not visual keep the value of the
+ * last full copy there. The scene graph itself is not buffered: nodes and objects must not be added or
+ * removed while the rendering thread is drawing.
+ *
+ * This requires SOFA to be compiled with SOFA_MAX_THREADS >= 2 (see isSupported()).
+ */
+class SOFA_SIMULATION_CORE_API VisualAspectBuffer
+{
+public:
+    VisualAspectBuffer(Node* root);
+    ~VisualAspectBuffer();
+
+    /// True if the Data store enough aspects to buffer the visual state.
+    static bool isSupported();
+
+    /// Simulation thread: copy the visual state of the simulation aspect into a free aspect and make it
+    /// available to the rendering thread.
+    void publish(const core::ExecParams* params);
+
+    /// Copy all the Data in the next publications, to be called when the scene graph was modified.
+    void invalidate();
+
+    /// Rendering thread: switch the current thread to the latest published aspect.
+    /// Return the aspect used for rendering, or the current one if nothing was published yet.
+    /// Calls can be nested, only the outermost one switches the aspect.
+    int beginRender();
+
+    /// Rendering thread: restore the aspect used before the matching beginRender().
+    void endRender();
+
+protected:
+    Node* root;
+    core::objectmodel::AspectPool pool;
+    core::objectmodel::AspectBuffer buffer;
+    core::objectmodel::AspectRef simulationAspect;
+    core::objectmodel::AspectRef renderAspect;
+
+    /// Incremented by invalidate(), an aspect is fully copied if its generation is older.
+    helper::system::atomic<int> generation;
+    /// Generation of the last full copy into each aspect, only accessed by the simulation thread.
+    helper::fixed_array<int, core::SOFA_DATA_MAX_ASPECTS> copiedGeneration;
+
+    int renderDepth;
+    int previousAspect;
+};
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif /* SOFA_SIMULATION_VISUALASPECTBUFFER_H */
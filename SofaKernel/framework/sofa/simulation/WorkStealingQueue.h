@@ -0,0 +1,166 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2017 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef MultiThreadingWorkStealingQueue_h__
+#define MultiThreadingWorkStealingQueue_h__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace sofa
+{
+
+	namespace simulation
+	{
+
+
+        // Bounded lock-free work-stealing deque (Chase-Lev).
+        // Only the owner thread may call push() and pop(), which work on the
+        // bottom end of the queue; any thread may call steal(), which takes
+        // from the top end. The memory orderings follow Le, Pop, Cohen and
+        // Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak
+        // Memory Models" (PPoPP 2013).
+        template<class T, std::size_t Capacity>
+        class WorkStealingQueue
+        {
+            static_assert((Capacity & (Capacity - 1)) == 0, "WorkStealingQueue capacity must be a power of two");
+
+            enum
+            {
+                CACHE_LINE = 64
+            };
+
+        public:
+
+            WorkStealingQueue()
+                : _top(0)
+                , _bottom(0)
+            {
+                for (std::size_t i = 0; i < Capacity; ++i)
+                {
+                    _items[i].store(T(), std::memory_order_relaxed);
+                }
+            }
+
+            WorkStealingQueue(const WorkStealingQueue&) = delete;
+            WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+            // owner only: returns false if the queue is full
+            bool push(T item)
+            {
+                const std::int64_t b = _bottom.load(std::memory_order_relaxed);
+                const std::int64_t t = _top.load(std::memory_order_acquire);
+                if (b - t >= static_cast<std::int64_t>(Capacity))
+                {
+                    return false;
+                }
+                _items[b & Mask].store(item, std::memory_order_relaxed);
+                // publishes the item to the thieves
+                _bottom.store(b + 1, std::memory_order_release);
+                return true;
+            }
+
+            // owner only: LIFO end
+            bool pop(T& item)
+            {
+                const std::int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+                _bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t t = _top.load(std::memory_order_relaxed);
+
+                if (t > b)
+                {
+                    // empty queue
+                    _bottom.store(b + 1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                item = _items[b & Mask].load(std::memory_order_relaxed);
+                if (t != b)
+                {
+                    // more than one item left: no concurrent thief can reach this one
+                    return true;
+                }
+
+                // last item: race against the thieves
+                const bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+            // any thread: FIFO end
+            bool steal(T& item)
+            {
+                std::int64_t t = _top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const std::int64_t b = _bottom.load(std::memory_order_acquire);
+
+                if (t >= b)
+                {
+                    return false;
+                }
+
+                T stolen = _items[t & Mask].load(std::memory_order_relaxed);
+                if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    // lost the race against the owner or another thief
+                    return false;
+                }
+                item = stolen;
+                return true;
+            }
+
+            // approximate number of queued items, exact only when called by the owner
+            std::size_t size() const
+            {
+                const std::int64_t b = _bottom.load(std::memory_order_relaxed);
+                const std::int64_t t = _top.load(std::memory_order_relaxed);
+                return b > t ? static_cast<std::size_t>(b - t) : 0;
+            }
+
+            bool empty() const { return size() == 0; }
+
+            static std::size_t capacity() { return Capacity; }
+
+        private:
+
+            enum : std::int64_t
+            {
+                Mask = static_cast<std::int64_t>(Capacity) - 1
+            };
+
+            // top and bottom are written by different threads: keep them on separate cache lines
+            std::atomic<std::int64_t> _top;
+            char _padTop[CACHE_LINE - sizeof(std::atomic<std::int64_t>)];
+
+            std::atomic<std::int64_t> _bottom;
+            char _padBottom[CACHE_LINE - sizeof(std::atomic<std::int64_t>)];
+
+            std::atomic<T> _items[Capacity];
+        };
+
+	} // namespace simulation
+
+} // namespace sofa
+
+
+#endif // MultiThreadingWorkStealingQueue_h__
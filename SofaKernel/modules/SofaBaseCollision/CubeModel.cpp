@@ -24,6 +24,7 @@
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/simulation/Simulation.h>
 #include <sofa/core/ObjectFactory.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <algorithm>
 #include <math.h>
 
@@ -44,8 +45,17 @@ int CubeModelClass = core::RegisterObject("Collision model representing a cube")
         ;
 
 CubeModel::CubeModel()
+    : builtCost(0)
+    , d_rebuildThreshold(initData(&d_rebuildThreshold, (SReal)2.0, "rebuildThreshold", "Rebuild the hierarchy when its cost (sum of the areas of its cubes relative to the root) exceeds this factor of its cost when last built (0 to only refit it)"))
+    , d_nbRefits(initData(&d_nbRefits, 0, "nbRefits", "OUTPUT: number of times the hierarchy was refitted"))
+    , d_nbRebuilds(initData(&d_nbRebuilds, 0, "nbRebuilds", "OUTPUT: number of times the hierarchy was rebuilt"))
 {
     enum_type = AABB_TYPE;
+
+    d_nbRefits.setReadOnly(true);
+    d_nbRefits.setGroup("Stats");
+    d_nbRebuilds.setReadOnly(true);
+    d_nbRebuilds.setGroup("Stats");
 }
 
 void CubeModel::resize(int size)
@@ -108,6 +118,20 @@ int CubeModel::addCube(Cube subcellsBegin, Cube subcellsEnd)
     return i;
 }
 
+int CubeModel::addCube(Cube subcellsBegin, Cube subcellsEnd, const Vector3& min, const Vector3& max)
+{
+    int i = size;
+    this->core::CollisionModel::resize(size+1);
+    elems.resize(size+1);
+    elems[i].subcells.first = subcellsBegin;
+    elems[i].subcells.second = subcellsEnd;
+    elems[i].children.first = core::CollisionElementIterator();
+    elems[i].children.second = core::CollisionElementIterator();
+    elems[i].minBBox = min;
+    elems[i].maxBBox = max;
+    return i;
+}
+
 void CubeModel::updateCube(int index)
 {
     const std::pair<Cube,Cube>& subcells = elems[index].subcells;
@@ -135,8 +159,171 @@ void CubeModel::updateCube(int index)
 
 void CubeModel::updateCubes()
 {
-    for (int i=0; i<size; i++)
-        updateCube(i);
+    // each cube only reads the cubes of the level below
+    simulation::TaskScheduler::getInstance()->parallel_for(0, size, [this](int first, int last)
+    {
+        for (int i=first; i<last; i++)
+            updateCube(i);
+    }, 64);
+}
+
+static SReal cubeArea(const Vector3& min, const Vector3& max)
+{
+    const Vector3 l = max-min;
+    return 2*(l[0]*l[1] + l[1]*l[2] + l[2]*l[0]);
+}
+
+SReal CubeModel::getHierarchyCost(const std::list<CubeModel*>& levels)
+{
+    const CubeModel* root = levels.front();
+    if (root->empty())
+        return 0;
+    const SReal rootArea = cubeArea(root->elems[0].minBBox, root->elems[0].maxBBox);
+    if (rootArea <= 0)
+        return 0;
+
+    SReal cost = 0;
+    for (std::list<CubeModel*>::const_iterator it = levels.begin(); it != levels.end(); ++it)
+    {
+        const CubeModel* level = *it;
+        for (int i=0; i<level->size; i++)
+            cost += cubeArea(level->elems[i].minBBox, level->elems[i].maxBBox);
+    }
+    return cost / rootArea;
+}
+
+int CubeModel::splitCubes(int first, int last, Vector3 bounds[4])
+{
+    enum { NBINS = 16 };
+    const int ncubes = last - first;
+
+    // bounds of the centers (times two, as in CubeSortPredicate)
+    Vector3 cmin = elems[first].minBBox + elems[first].maxBBox;
+    Vector3 cmax = cmin;
+    for (int i=first+1; i<last; i++)
+    {
+        const Vector3 c = elems[i].minBBox + elems[i].maxBBox;
+        for (int j=0; j<3; j++)
+        {
+            if (c[j] < cmin[j]) cmin[j] = c[j];
+            if (c[j] > cmax[j]) cmax[j] = c[j];
+        }
+    }
+    const Vector3 l = cmax-cmin;
+    const int axis = (l[0]>l[1]) ? ((l[0]>l[2]) ? 0 : 2) : ((l[1]>l[2]) ? 1 : 2);
+
+    int middle = first+(ncubes+1)/2;
+    if (l[axis] > 0)
+    {
+        const SReal scale = NBINS / l[axis];
+        const SReal offset = cmin[axis];
+        auto binOf = [axis, scale, offset](const CubeData& cube)
+        {
+            return std::min((int)((cube.minBBox[axis]+cube.maxBBox[axis]-offset)*scale), (int)NBINS-1);
+        };
+
+        int count[NBINS];
+        Vector3 bmin[NBINS], bmax[NBINS];
+        for (int b=0; b<NBINS; b++)
+            count[b] = 0;
+
+        for (int i=first; i<last; i++)
+        {
+            const CubeData& cube = elems[i];
+            const int b = binOf(cube);
+            if (count[b]++ == 0)
+            {
+                bmin[b] = cube.minBBox;
+                bmax[b] = cube.maxBBox;
+            }
+            else for (int j=0; j<3; j++)
+            {
+                if (cube.minBBox[j] < bmin[b][j]) bmin[b][j] = cube.minBBox[j];
+                if (cube.maxBBox[j] > bmax[b][j]) bmax[b][j] = cube.maxBBox[j];
+            }
+        }
+
+        // area of the bins on the right of each split, sweeping from the last bin
+        SReal rightArea[NBINS];
+        int rightCount[NBINS];
+        Vector3 rmin, rmax;
+        int n = 0;
+        for (int b=NBINS-1; b>0; b--)
+        {
+            if (count[b])
+            {
+                if (n == 0) { rmin = bmin[b]; rmax = bmax[b]; }
+                else for (int j=0; j<3; j++)
+                {
+                    if (bmin[b][j] < rmin[j]) rmin[j] = bmin[b][j];
+                    if (bmax[b][j] > rmax[j]) rmax[j] = bmax[b][j];
+                }
+                n += count[b];
+            }
+            rightCount[b] = n;
+            rightArea[b] = n ? cubeArea(rmin, rmax) : 0;
+        }
+
+        // each side keeps at least a quarter of the cubes, as the depth of the hierarchy is limited
+        const int minCount = ncubes/4;
+        int bestSplit = -1;
+        SReal bestCost = 0;
+        Vector3 lmin, lmax;
+        n = 0;
+        for (int b=0; b<NBINS-1; b++)
+        {
+            if (count[b])
+            {
+                if (n == 0) { lmin = bmin[b]; lmax = bmax[b]; }
+                else for (int j=0; j<3; j++)
+                {
+                    if (bmin[b][j] < lmin[j]) lmin[j] = bmin[b][j];
+                    if (bmax[b][j] > lmax[j]) lmax[j] = bmax[b][j];
+                }
+                n += count[b];
+            }
+            if (n < minCount || rightCount[b+1] < minCount || n == 0 || rightCount[b+1] == 0)
+                continue;
+            const SReal cost = cubeArea(lmin, lmax)*n + rightArea[b+1]*rightCount[b+1];
+            if (bestSplit < 0 || cost < bestCost)
+            {
+                bestSplit = b;
+                bestCost = cost;
+            }
+        }
+
+        if (bestSplit >= 0)
+        {
+            middle = (int)(std::partition(elems.begin()+first, elems.begin()+last, [&binOf, bestSplit](const CubeData& cube)
+            {
+                return binOf(cube) <= bestSplit;
+            }) - elems.begin());
+        }
+        else
+        {
+            std::nth_element(elems.begin()+first, elems.begin()+middle, elems.begin()+last, CubeSortPredicate(axis));
+        }
+    }
+
+    // bounds of both sides
+    for (int side=0; side<2; side++)
+    {
+        const int begin = side ? middle : first;
+        const int end = side ? last : middle;
+        Vector3& smin = bounds[2*side];
+        Vector3& smax = bounds[2*side+1];
+        smin = elems[begin].minBBox;
+        smax = elems[begin].maxBBox;
+        for (int i=begin+1; i<end; i++)
+        {
+            for (int j=0; j<3; j++)
+            {
+                if (elems[i].minBBox[j] < smin[j]) smin[j] = elems[i].minBBox[j];
+                if (elems[i].maxBBox[j] > smax[j]) smax[j] = elems[i].maxBBox[j];
+            }
+        }
+    }
+    return middle;
 }
 
 void CubeModel::draw(const core::visual::VisualParams* vparams)
@@ -239,7 +426,23 @@ void CubeModel::computeBoundingTree(int maxDepth)
     CubeModel* root = levels.front();
     //if (isStatic() && root->getPrevious() == NULL && !root->empty()) return; // No need to recompute BBox if immobile
 
-    if (root->empty() || root->getPrevious() != NULL)
+    bool rebuild = root->empty() || root->getPrevious() != NULL;
+
+    if (!rebuild)
+    {
+        // Simply update the existing tree, starting from the bottom
+        for (std::list<CubeModel*>::reverse_iterator it = levels.rbegin(); it != levels.rend(); ++it)
+            (*it)->updateCubes();
+
+        // unless the refitted cubes became too loose since the tree was built
+        const SReal threshold = d_rebuildThreshold.getValue();
+        if (threshold > 0 && builtCost > 0 && getHierarchyCost(levels) > threshold*builtCost)
+            rebuild = true;
+        else
+            d_nbRefits.setValue(d_nbRefits.getValue()+1);
+    }
+
+    if (rebuild)
     {
         // Tree must be reconstructed
         //sout << "Building Tree with depth "<<maxDepth<<" from "<<size<<" elements."<<sendl;
@@ -260,68 +463,47 @@ void CubeModel::computeBoundingTree(int maxDepth)
         // Then build root cell
         //sout << "CubeModel: add root cube"<<sendl;
         root->addCube(Cube(this,0),Cube(this,size));
-        // Construct tree by splitting cells along their biggest dimension
+        // Construct tree by splitting cells, all the cells of a level in parallel
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        std::vector<int> middles;
+        std::vector<Vector3> bounds;
         std::list<CubeModel*>::iterator it = levels.begin();
         CubeModel* level = *it;
         ++it;
-        int lvl = 0;
         while(it != levels.end())
         {
-            //sout << "CubeModel: split level "<<lvl<<sendl;
             CubeModel* clevel = *it;
-            clevel->elems.reserve(level->size*2);
-            for(Cube cell = Cube(level->begin()); level->end() != cell; ++cell)
+            const int ncells = level->size;
+            middles.assign(ncells, -1);
+            bounds.resize(4*ncells);
+
+            // the cells own disjoint ranges of leaf cubes, which are reordered in place
+            scheduler->parallel_for(0, ncells, [&](int first, int last)
             {
-                const std::pair<Cube,Cube>& subcells = cell.subcells();
-                int ncells = subcells.second.getIndex() - subcells.first.getIndex();
-                //sout << "CubeModel: level "<<lvl<<" cell "<<cell.getIndex()<<": current subcells "<<subcells.first.getIndex() << " - "<<subcells.second.getIndex()<<sendl;
-                if (ncells > 4)
+                for (int c=first; c<last; c++)
                 {
+                    const std::pair<Cube,Cube>& subcells = level->elems[c].subcells;
                     // Only split cells with more than 4 childs
-                    // Find the biggest dimension
-                    int splitAxis;
-                    Vector3 l = cell.maxVect()-cell.minVect();
-                    int middle = subcells.first.getIndex()+(ncells+1)/2;
-                    if(l[0]>l[1])
-                        if (l[0]>l[2])
-                            splitAxis = 0;
-                        else
-                            splitAxis = 2;
-                    else if (l[1]>l[2])
-                        splitAxis = 1;
-                    else
-                        splitAxis = 2;
-
-                    // Separate cells on each side of the median cell
-
-#if defined(__GNUC__) && (__GNUC__ == 4)
-// && (__GNUC_MINOR__ == 1) && (__GNUC_PATCHLEVEL__ == 1)
-                    // there is apparently a bug in std::sort with GCC 4.x
-                    if (splitAxis == 0)
-                        qsort(&(elems[subcells.first.getIndex()]), subcells.second.getIndex()-subcells.first.getIndex(), sizeof(elems[0]), CubeSortPredicate::sortCube<0>);
-                    else if (splitAxis == 1)
-                        qsort(&(elems[subcells.first.getIndex()]), subcells.second.getIndex()-subcells.first.getIndex(), sizeof(elems[0]), CubeSortPredicate::sortCube<1>);
-                    else
-                        qsort(&(elems[subcells.first.getIndex()]), subcells.second.getIndex()-subcells.first.getIndex(), sizeof(elems[0]), CubeSortPredicate::sortCube<2>);
-#else
-                    CubeSortPredicate sortpred(splitAxis);
-                    //std::nth_element(elems.begin()+subcells.first.getIndex(),elems.begin()+middle,elems.begin()+subcells.second.getIndex(), sortpred);
-                    std::sort(elems.begin()+subcells.first.getIndex(),elems.begin()+subcells.second.getIndex(), sortpred);
-#endif
-
-                    // Create the two new subcells
-                    Cube cmiddle(this, middle);
-                    int c1 = clevel->addCube(subcells.first, cmiddle);
-                    int c2 = clevel->addCube(cmiddle, subcells.second);
-                    //sout << "L"<<lvl<<" cell "<<cell.getIndex()<<" split along "<<(splitAxis==0?'X':splitAxis==1?'Y':'Z')<<" in cell "<<c1<<" size "<<middle-subcells.first.getIndex()<<" and cell "<<c2<<" size "<<subcells.second.getIndex()-middle<<"."<<sendl;
-                    //level->elems[cell.getIndex()].subcells = std::make_pair(Cube(clevel,c1),Cube(clevel,c2+1));
-                    level->elems[cell.getIndex()].subcells.first = Cube(clevel,c1);
-                    level->elems[cell.getIndex()].subcells.second = Cube(clevel,c2+1);
+                    if (subcells.second.getIndex() - subcells.first.getIndex() > 4)
+                        middles[c] = splitCubes(subcells.first.getIndex(), subcells.second.getIndex(), &bounds[4*c]);
                 }
+            });
+
+            // Create the two new subcells of each split cell
+            clevel->elems.reserve(level->size*2);
+            for (int c=0; c<ncells; c++)
+            {
+                if (middles[c] < 0)
+                    continue;
+                const std::pair<Cube,Cube> subcells = level->elems[c].subcells;
+                Cube cmiddle(this, middles[c]);
+                int c1 = clevel->addCube(subcells.first, cmiddle, bounds[4*c], bounds[4*c+1]);
+                int c2 = clevel->addCube(cmiddle, subcells.second, bounds[4*c+2], bounds[4*c+3]);
+                level->elems[c].subcells.first = Cube(clevel,c1);
+                level->elems[c].subcells.second = Cube(clevel,c2+1);
             }
             ++it;
             level = clevel;
-            ++lvl;
         }
         if (!parentOf.empty())
         {
@@ -329,17 +511,9 @@ void CubeModel::computeBoundingTree(int maxDepth)
             for (int i=0; i<size; i++)
                 parentOf[elems[i].children.first.getIndex()] = i;
         }
-    }
-    else
-    {
-        // Simply update the existing tree, starting from the bottom
-        int lvl = 0;
-        for (std::list<CubeModel*>::reverse_iterator it = levels.rbegin(); it != levels.rend(); ++it)
-        {
-            //sout << "CubeModel: update level "<<lvl<<sendl;
-            (*it)->updateCubes();
-            ++lvl;
-        }
+
+        builtCost = getHierarchyCost(levels);
+        d_nbRebuilds.setValue(d_nbRebuilds.getValue()+1);
     }
     //sout << "<CubeModel::computeBoundingTree("<<maxDepth<<")"<<sendl;
 }
@@ -26,6 +26,7 @@
 #include <sofa/core/CollisionModel.h>
 #include <SofaBaseMechanics/MechanicalObject.h>
 #include <sofa/defaulttype/Vec3Types.h>
+#include <list>
 
 namespace sofa
 {
@@ -99,6 +100,20 @@ protected:
     sofa::helper::vector<CubeData> elems;
     sofa::helper::vector<int> parentOf; ///< Given the index of a child leaf element, store the index of the parent cube
 
+    SReal builtCost; ///< cost of the hierarchy when it was last built, see getHierarchyCost
+
+    /// Split the cubes [first,last) with a binned surface area heuristic, reordering them so that each side is contiguous.
+    /// Returns the index of the first cube of the second side (or first if the range is not split), and fills the bounds of both sides.
+    int splitCubes(int first, int last, sofa::defaulttype::Vector3 bounds[4]);
+
+    /// Sum of the areas of the cubes of the given levels, relative to the area of the root cube
+    static SReal getHierarchyCost(const std::list<CubeModel*>& levels);
+
+public:
+    Data<SReal> d_rebuildThreshold; ///< Rebuild the hierarchy when its cost exceeds this factor of its cost when last built (0 to only refit it)
+    Data<int> d_nbRefits; ///< OUTPUT: number of times the hierarchy was refitted
+    Data<int> d_nbRebuilds; ///< OUTPUT: number of times the hierarchy was rebuilt
+
 public:
     typedef core::CollisionElementIterator ChildIterator;
     typedef sofa::defaulttype::Vec3Types DataTypes;
@@ -145,7 +160,10 @@ public:
       *to compute a bounding box containing all CollisionElements, then we divide this big bounding box into two boxes.
       *These new two boxes inherit from the root box and have depth 1. Then we can do the same operation for the new boxes.
       *The division is done only if the box contains more than 4 final CollisionElements and if the depth doesn't exceed
-      *the max depth. The division is made along an axis. This axis corresponds to the biggest dimension of the current bounding box.
+      *the max depth. The division is made along the biggest dimension of the centers of the contained boxes, at the position minimizing
+      *the surface area heuristic among a few bins, each side keeping at least a quarter of the boxes. The cells of a level are split in parallel.
+      *Once built, the hierarchy is only refitted from the bottom to the top, until its cost grows beyond rebuildThreshold times its cost
+      *when it was built.
       *Note : a bounding box is a Cube here.
       */
     virtual void computeBoundingTree(int maxDepth=0) override;
@@ -159,6 +177,7 @@ public:
     void draw(const core::visual::VisualParams* vparams) override;
 
     int addCube(Cube subcellsBegin, Cube subcellsEnd);
+    int addCube(Cube subcellsBegin, Cube subcellsEnd, const sofa::defaulttype::Vector3& min, const sofa::defaulttype::Vector3& max);
     void updateCube(int index);
     void updateCubes();
 };
@@ -29,7 +29,10 @@ TEST_F(Brut, rand_dense_test ) { ASSERT_TRUE( randDense()); }
 typedef BroadPhaseTest<sofa::component::collision::IncrSAP> IncrSAPTest;
 TEST_F(IncrSAPTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
 TEST_F(IncrSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+TEST_F(IncrSAPTest, rand_large_test ) { ASSERT_TRUE( randLarge()); }
 
 typedef BroadPhaseTest<sofa::component::collision::DirectSAP> DirectSAPTest;
 TEST_F(DirectSAPTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
 TEST_F(DirectSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+TEST_F(DirectSAPTest, rand_large_test ) { ASSERT_TRUE( randLarge()); }
+TEST_F(DirectSAPTest, rand_filter_test ) { ASSERT_TRUE( randFilter()); }
@@ -26,8 +26,11 @@
 #include <SofaGeneralMeshCollision/IncrSAP.h>
 #include <SofaBaseCollision/NewProximityIntersection.h>
 #include <SofaSimulationTree/GNode.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
 
 using sofa::core::objectmodel::New;
 using sofa::core::objectmodel::Data;
@@ -87,8 +90,10 @@ struct BroadPhaseTest: public ::testing::Test{
     static bool randSparse();
     static bool randDense();
     static bool randTest3();
+    static bool randLarge();
+    static bool randFilter();
 
-    static bool randTest(int seed,int nb1,int nb2,const Vector3 & min,const Vector3 & max);
+    static bool randTest(int seed,int nb1,int nb2,const Vector3 & min,const Vector3 & max,const MyBox * filter = 0x0);
 };
 
 struct InitIntersection{
@@ -235,8 +240,9 @@ struct CItCompare{
     }
 };
 
+//if filter is given, the boxes that do not intersect it must be ignored by the detection
 template<class Detection>
-bool GENTest(sofa::core::CollisionModel * cm1,sofa::core::CollisionModel * cm2,Detection & col_detection){
+bool GENTest(sofa::core::CollisionModel * cm1,sofa::core::CollisionModel * cm2,Detection & col_detection,const MyBox * filter = 0x0){
 //    assert(goodBoundingTree((cm1)));
 //    assert(goodBoundingTree((cm2)));
     cm1->setSelfCollision(true);
@@ -255,6 +261,9 @@ bool GENTest(sofa::core::CollisionModel * cm1,sofa::core::CollisionModel * cm2,D
     if(cm2 != 0x0)
         getMyBoxes(cm2,boxes);
 
+    if(filter)
+        boxes.erase(std::remove_if(boxes.begin(),boxes.end(),[filter](const MyBox & b){return b.squaredDistance(*filter) > 0;}),boxes.end());
+
     //cm1 self intersections
     for(unsigned int i = 0 ; i < boxes.size() ; ++i){
         for(unsigned int j = i + 1 ; j < boxes.size() ; ++j){
@@ -445,7 +454,7 @@ Vector3 randVect(const Vector3 & min, const Vector3& max) {
 
 
 template <class BroadPhase>
-bool BroadPhaseTest<BroadPhase>::randTest(int seed,int nb1,int nb2,const Vector3 & min,const Vector3 & max){
+bool BroadPhaseTest<BroadPhase>::randTest(int seed,int nb1,int nb2,const Vector3 & min,const Vector3 & max,const MyBox * filter){
 
     sofa::helper::srand(seed);
 
@@ -468,9 +477,15 @@ bool BroadPhaseTest<BroadPhase>::randTest(int seed,int nb1,int nb2,const Vector3
 
     typename BroadPhase::SPtr pbroadphase = New<BroadPhase>();
     BroadPhase & broadphase = *pbroadphase;
+    if(filter){
+        std::ostringstream box;
+        box<<filter->cube.minVect()<<" "<<filter->cube.maxVect();
+        broadphase.findData("box")->read(box.str());
+        broadphase.init();
+    }
 
     for(int i = 0 ; i < 2 ; ++i){
-        if(!GENTest(obbm1.get(),obbm2.get(),broadphase))
+        if(!GENTest(obbm1.get(),obbm2.get(),broadphase,filter))
             return false;
 
         randMoving(obbm1.get(),min,max);
@@ -508,4 +523,39 @@ bool BroadPhaseTest<BroadPhase>::randSparse(){
     return true;
 }
 
+template <class BroadPhase>
+bool BroadPhaseTest<BroadPhase>::randLarge(){
+    //enough boxes for the sort and the sweep to be split between the worker threads
+    sofa::simulation::TaskScheduler* scheduler = sofa::simulation::TaskScheduler::getInstance();
+    scheduler->init(4);
+
+    bool ok = true;
+    for(int i = 0 ; i < 2 && ok ; ++i){
+        if(!randTest(i,6000,4000,Vector3(-40,-40,-40),Vector3(40,40,40))){
+            ADD_FAILURE() <<"FAIL seed number "<<i<< std::endl;
+            ok = false;
+        }
+    }
+
+    scheduler->stop();
+    return ok;
+}
+
+template <class BroadPhase>
+bool BroadPhaseTest<BroadPhase>::randFilter(){
+    sofa::component::collision::CubeModel::SPtr filterModel = New<sofa::component::collision::CubeModel>();
+    filterModel->resize(1);
+    filterModel->setParentOf(0,Vector3(-2,-3,-1),Vector3(3,1,2));
+    const MyBox filter(sofa::component::collision::Cube(filterModel.get(),0));
+
+    for(int i = 0 ; i < 100 ; ++i){
+        if(!randTest(i,40,20,Vector3(-5,-5,-5),Vector3(5,5,5),&filter)){
+            ADD_FAILURE() <<"FAIL seed number "<<i<< std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
 #endif
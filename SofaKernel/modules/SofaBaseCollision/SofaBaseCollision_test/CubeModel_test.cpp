@@ -0,0 +1,136 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+#include <SofaBaseCollision/CubeModel.h>
+
+#include <random>
+
+namespace sofa
+{
+
+using sofa::component::collision::Cube;
+using sofa::component::collision::CubeModel;
+using sofa::defaulttype::Vector3;
+
+struct CubeModel_test : public Sofa_test<>
+{
+    CubeModel::SPtr leaves;
+    std::mt19937 rng;
+
+    void setBoxes(unsigned int n, double extent)
+    {
+        std::uniform_real_distribution<double> uniform(0.0, extent);
+        leaves->resize(n);
+        for (unsigned int i=0; i<n; i++)
+        {
+            const Vector3 center(uniform(rng), uniform(rng), uniform(rng));
+            leaves->setParentOf(i, center - Vector3(0.01,0.01,0.01), center + Vector3(0.01,0.01,0.01));
+        }
+    }
+
+    static bool contains(const Vector3& min, const Vector3& max, const Vector3& cmin, const Vector3& cmax)
+    {
+        for (int j=0; j<3; j++)
+            if (cmin[j] < min[j] || cmax[j] > max[j])
+                return false;
+        return true;
+    }
+
+    /// Check that each cube contains its subcells, and count the leaf elements below it
+    unsigned int checkCube(const Cube& cube, std::vector<int>& visited)
+    {
+        const std::pair<Cube,Cube>& subcells = cube.subcells();
+        unsigned int count = 0;
+        for (Cube c = subcells.first; c != subcells.second; ++c)
+        {
+            EXPECT_TRUE(contains(cube.minVect(), cube.maxVect(), c.minVect(), c.maxVect()));
+            if (c.getCollisionModel() == leaves.get())
+            {
+                ++visited[leaves->getLeafIndex(c.getIndex())];
+                ++count;
+            }
+            else
+                count += checkCube(c, visited);
+        }
+        return count;
+    }
+
+    void checkHierarchy()
+    {
+        sofa::core::CollisionModel* root = leaves.get();
+        while (root->getPrevious() != NULL)
+            root = root->getPrevious();
+        ASSERT_NE(root, leaves.get());
+
+        std::vector<int> visited(leaves->getSize(), 0);
+        EXPECT_EQ(checkCube(Cube(static_cast<CubeModel*>(root), 0), visited), (unsigned int)leaves->getSize());
+        for (unsigned int i=0; i<visited.size(); i++)
+            EXPECT_EQ(visited[i], 1);
+    }
+
+    void SetUp()
+    {
+        leaves = sofa::core::objectmodel::New<CubeModel>();
+        rng.seed(42);
+    }
+};
+
+TEST_F(CubeModel_test, refitThenRebuild)
+{
+    setBoxes(1000, 1.0);
+    leaves->computeBoundingTree(6);
+    checkHierarchy();
+    EXPECT_EQ(leaves->d_nbRebuilds.getValue(), 1);
+    EXPECT_EQ(leaves->d_nbRefits.getValue(), 0);
+
+    // a small motion only refits the hierarchy
+    for (int i=0; i<leaves->getSize(); i++)
+    {
+        const CubeModel::CubeData& data = leaves->getCubeData(i);
+        leaves->setParentOf(leaves->getLeafIndex(i), data.minBBox + Vector3(0.001,0.0,0.0), data.maxBBox + Vector3(0.001,0.0,0.0));
+    }
+    leaves->computeBoundingTree(6);
+    checkHierarchy();
+    EXPECT_EQ(leaves->d_nbRebuilds.getValue(), 1);
+    EXPECT_EQ(leaves->d_nbRefits.getValue(), 1);
+
+    // scattering the boxes makes the refitted cubes too loose: the hierarchy is rebuilt
+    setBoxes(1000, 1.0);
+    leaves->computeBoundingTree(6);
+    checkHierarchy();
+    EXPECT_EQ(leaves->d_nbRebuilds.getValue(), 2);
+    EXPECT_EQ(leaves->d_nbRefits.getValue(), 1);
+}
+
+TEST_F(CubeModel_test, refitOnly)
+{
+    leaves->d_rebuildThreshold.setValue(0);
+    setBoxes(500, 1.0);
+    leaves->computeBoundingTree(4);
+    setBoxes(500, 1.0);
+    leaves->computeBoundingTree(4);
+    checkHierarchy();
+    EXPECT_EQ(leaves->d_nbRebuilds.getValue(), 1);
+    EXPECT_EQ(leaves->d_nbRefits.getValue(), 1);
+}
+
+} // namespace sofa
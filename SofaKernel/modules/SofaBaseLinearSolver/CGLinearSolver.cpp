@@ -24,7 +24,9 @@
 #include <SofaBaseLinearSolver/CGLinearSolver.inl>
 
 #include <sofa/core/ObjectFactory.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <iostream>
+#include <map>
 
 namespace sofa
 {
@@ -64,6 +66,124 @@ inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,compone
 #endif
 }
 
+template<> SOFA_BASE_LINEAR_SOLVER_API
+inline SReal CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha_dot(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
+{
+#ifdef SOFA_NO_VMULTIOP // unoptimized version
+    cgstep_alpha(params, x,r,p,q,alpha);
+    return r.dot(r);
+#else // single-traversal optimization: each state updates x and r, then adds its part of r.r
+    typedef sofa::core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
+    VMultiOp ops;
+    ops.resize(2);
+    ops[0].first = (MultiVecDerivId)x;
+    ops[0].second.push_back(std::make_pair((MultiVecDerivId)x,1.0));
+    ops[0].second.push_back(std::make_pair((MultiVecDerivId)p,alpha));
+    ops[1].first = (MultiVecDerivId)r;
+    ops[1].second.push_back(std::make_pair((MultiVecDerivId)r,1.0));
+    ops[1].second.push_back(std::make_pair((MultiVecDerivId)q,-alpha));
+    SReal rho = 0.0;
+    this->executeVisitor(simulation::MechanicalVMultiOpDotVisitor(params, ops, (MultiVecDerivId)r, (MultiVecDerivId)r, &rho));
+    return rho;
+#endif
+}
+
+template<> SOFA_BASE_LINEAR_SOLVER_API
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_product(const core::ExecParams* /*params*/, Matrix& M, Vector& p, Vector& q)
+{
+    if (independentNodes.size() < 2)
+    {
+        q = M*p;
+        return;
+    }
+
+    // the product of each independent subtree only reads and writes its own states
+    const core::MechanicalParams* mparams = &M.parent->mparams;
+    simulation::TaskScheduler::getInstance()->parallel_for(std::size_t(0), independentNodes.size(), [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i=first; i<last; ++i)
+        {
+            simulation::common::MechanicalOperations mop(mparams, independentNodes[i]);
+            mop.propagateDxAndResetDf(p, q);
+            mop.addMBKdx(q, mparams->mFactor(), mparams->bFactor(), mparams->kFactor(), false); // df = (m M + b B + k K) dx
+            mop.projectResponse(q);
+        }
+    }, std::size_t(1));
+}
+
+template<> SOFA_BASE_LINEAR_SOLVER_API
+void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::updateIndependentNodes()
+{
+    independentNodes.clear();
+
+    simulation::Node* root = this->currentNode;
+    if (!root)
+        root = dynamic_cast<simulation::Node*>(this->getContext());
+    if (!root)
+        return;
+
+    // anything at the root level couples its children
+    if (root->mechanicalState || root->mass || !root->forceField.empty() || !root->interactionForceField.empty()
+        || root->mechanicalMapping || !root->projectiveConstraintSet.empty())
+        return;
+
+    typedef core::behavior::BaseMechanicalState State;
+    std::map<const State*, std::size_t> owner;
+    helper::vector<simulation::Node*> candidates;
+
+    for (simulation::Node::ChildIterator it = root->child.begin(), itend = root->child.end(); it != itend; ++it)
+    {
+        simulation::Node* child = it->get();
+        helper::vector<State*> states;
+        child->getTreeObjects<State>(&states);
+
+        const std::size_t index = candidates.size();
+        for (std::size_t i=0; i<states.size(); ++i)
+        {
+            // a state reached from two children (multiple parents) is shared
+            std::pair<std::map<const State*, std::size_t>::iterator, bool> inserted = owner.insert(std::make_pair(states[i], index));
+            if (!inserted.second && inserted.first->second != index)
+                return;
+        }
+        candidates.push_back(child);
+    }
+
+    // every mapping and interaction must stay within the subtree of its child
+    for (std::size_t c=0; c<candidates.size(); ++c)
+    {
+        helper::vector<core::BaseMapping*> mappings;
+        candidates[c]->getTreeObjects<core::BaseMapping>(&mappings);
+        for (std::size_t i=0; i<mappings.size(); ++i)
+        {
+            if (!mappings[i]->isMechanical())
+                continue;
+            const helper::vector<State*> from = mappings[i]->getMechFrom();
+            for (std::size_t j=0; j<from.size(); ++j)
+            {
+                std::map<const State*, std::size_t>::const_iterator o = owner.find(from[j]);
+                if (o == owner.end() || o->second != c)
+                    return;
+            }
+        }
+
+        helper::vector<core::behavior::BaseInteractionForceField*> interactions;
+        candidates[c]->getTreeObjects<core::behavior::BaseInteractionForceField>(&interactions);
+        for (std::size_t i=0; i<interactions.size(); ++i)
+        {
+            const State* models[2] = { interactions[i]->getMechModel1(), interactions[i]->getMechModel2() };
+            for (int j=0; j<2; ++j)
+            {
+                std::map<const State*, std::size_t>::const_iterator o = owner.find(models[j]);
+                if (o == owner.end() || o->second != c)
+                    return;
+            }
+        }
+    }
+
+    independentNodes = candidates;
+    msg_info_when(f_verbose.getValue()) << independentNodes.size() << " independent nodes";
+}
+
 int CGLinearSolverClass = core::RegisterObject("Linear system solver using the conjugate gradient iterative algorithm")
         .add< CGLinearSolver< GraphScatteredMatrix, GraphScatteredVector > >(true)
 #ifndef SOFA_FLOAT
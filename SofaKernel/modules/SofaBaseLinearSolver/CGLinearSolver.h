@@ -57,6 +57,7 @@ public:
     Data<bool> f_warmStart; ///< Use previous solution as initial solution
     Data<bool> f_verbose; ///< Dump system state at each iteration
     Data<std::map < std::string, sofa::helper::vector<SReal> > > f_graph; ///< Graph of residuals at each iteration
+    Data<bool> d_parallelNodes; ///< Compute the matrix-vector products of independent child nodes in parallel
 #ifdef DISPLAY_TIME
     SReal time1;
     SReal time2;
@@ -72,6 +73,18 @@ protected:
     /// This method is separated from the rest to be able to use custom/optimized versions depending on the types of vectors.
     /// It computes: x += p*alpha, r -= q*alpha
     inline void cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
+    /// This method is separated from the rest to be able to use custom/optimized versions depending on the types of vectors.
+    /// It computes: x += p*alpha, r -= q*alpha, and returns the new r.r
+    inline SReal cgstep_alpha_dot(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
+    /// This method is separated from the rest to be able to use custom/optimized versions depending on the types of vectors.
+    /// It computes: q = M*p
+    inline void cgstep_product(const core::ExecParams* params, Matrix& M, Vector& p, Vector& q);
+
+    /// Find the child nodes whose products can be computed independently (see d_parallelNodes)
+    void updateIndependentNodes();
+
+    /// Children of the current node that share no mechanical state, mapping or interaction with each other
+    helper::vector<simulation::Node*> independentNodes;
 
     int timeStepCount;
     bool equilibriumReached;
@@ -95,6 +108,15 @@ inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,compone
 template<>
 inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
 
+template<>
+inline SReal CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha_dot(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
+
+template<>
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_product(const core::ExecParams* params, Matrix& M, Vector& p, Vector& q);
+
+template<>
+void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::updateIndependentNodes();
+
 #if  !defined(SOFA_COMPONENT_LINEARSOLVER_CGLINEARSOLVER_CPP)
 extern template class SOFA_BASE_LINEAR_SOLVER_API CGLinearSolver< GraphScatteredMatrix, GraphScatteredVector >;
 #ifndef SOFA_FLOAT
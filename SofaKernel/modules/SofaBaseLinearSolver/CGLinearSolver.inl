@@ -52,6 +52,7 @@ CGLinearSolver<TMatrix,TVector>::CGLinearSolver()
     , f_warmStart( initData(&f_warmStart,false,"warmStart","Use previous solution as initial solution") )
     , f_verbose( initData(&f_verbose,false,"verbose","Dump system state at each iteration") )
     , f_graph( initData(&f_graph,"graph","Graph of residuals at each iteration") )
+    , d_parallelNodes( initData(&d_parallelNodes,false,"parallelNodes","Compute the matrix-vector products of independent child nodes in parallel (only when they share no mechanical state, mapping or interaction)") )
 {
     f_graph.setWidget("graph");
 #ifdef DISPLAY_TIME
@@ -187,10 +188,18 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
     simulation::Visitor::printCloseNode("VectorAllocation");
 #endif
 
+    if( d_parallelNodes.getValue() )
+        updateIndependentNodes();
+
     if(normb != 0.0)
     {
+        /// Compute ρ = r^2 (then updated at the end of each step, together with x and r)
+        rho = r.dot(r);
+
         for( nb_iter=1; nb_iter<=f_maxIter.getValue(); nb_iter++ )
         {
+            sofa::helper::AdvancedTimer::StepVar iterationTimer("CG iteration");
+
 #ifdef SOFA_DUMP_VISITOR_INFO
             std::ostringstream comment;
             if (simulation::Visitor::isPrintActivated())
@@ -200,9 +209,6 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
             }
 #endif
 
-            /// Compute p = r^2
-            rho = r.dot(r);
-
             /// Compute the error from the norm of ρ and b
             double normr = sqrt(rho);
             double err = normr/normb;
@@ -263,7 +269,7 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
             }
 
             /// Compute the matrix-vector product : M p
-            q = M*p;
+            cgstep_product(params, M, p, q);
 
             if( verbose )
             {
@@ -316,8 +322,10 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
                 /// Compute the coefficient α for the conjugate direction
                 alpha = rho/den;
 
-                /// End of the CG step : update x and r
-                cgstep_alpha(params, x,r,p,q,alpha);
+                rho_1 = rho;
+
+                /// End of the CG step : update x and r, and compute the new ρ = r^2
+                rho = cgstep_alpha_dot(params, x,r,p,q,alpha);
 
                 if( verbose )
                 {
@@ -330,8 +338,6 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
                 break;
             }
 
-            rho_1 = rho;
-
 #ifdef SOFA_DUMP_VISITOR_INFO
             if (simulation::Visitor::isPrintActivated())
                 simulation::Visitor::printCloseNode(comment.str());
@@ -405,6 +411,26 @@ inline void CGLinearSolver<TMatrix,TVector>::cgstep_alpha(const core::ExecParams
     r.peq(q,-alpha);
 }
 
+template<class TMatrix, class TVector>
+inline SReal CGLinearSolver<TMatrix,TVector>::cgstep_alpha_dot(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
+{
+    cgstep_alpha(params, x,r,p,q,alpha);
+    return r.dot(r);
+}
+
+template<class TMatrix, class TVector>
+inline void CGLinearSolver<TMatrix,TVector>::cgstep_product(const core::ExecParams* /*params*/, Matrix& M, Vector& p, Vector& q)
+{
+    q = M*p;
+}
+
+template<class TMatrix, class TVector>
+void CGLinearSolver<TMatrix,TVector>::updateIndependentNodes()
+{
+    // only the graph-scattered products are computed node by node
+    independentNodes.clear();
+}
+
 } // namespace linearsolver
 
 } // namespace component
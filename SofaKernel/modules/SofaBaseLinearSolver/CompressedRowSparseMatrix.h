@@ -169,9 +169,16 @@ public :
     VecIndex oldRowBegin;
     VecIndex oldColsIndex;
     VecBloc  oldColsValue;
+
+    // frozen pattern mode, see setFrozenPattern()
+    bool frozenPattern;   ///< true if the sparsity pattern is kept from one assembly to the next
+    VecIndex slotTrace;   ///< position in colsValue of the bloc accessed by each call to wbloc/blocCreate during the last assembly
+    VecIndex slotTraceRow;///< row of the bloc accessed by each call, to detect a change in the assembly sequence
+    Index slotCursor;     ///< position of the next call in slotTrace
 public:
     CompressedRowSparseMatrix()
         : nRow(0), nCol(0), nBlocRow(0), nBlocCol(0), compressed(true)
+        , frozenPattern(false), slotCursor(0)
     {
     }
 
@@ -179,6 +186,7 @@ public:
         : nRow(nbRow), nCol(nbCol),
           nBlocRow((nbRow + NL-1) / NL), nBlocCol((nbCol + NC-1) / NC),
           compressed(true)
+        , frozenPattern(false), slotCursor(0)
     {
     }
 
@@ -205,6 +213,22 @@ public:
     const VecIndex& getColsIndex() const { return colsIndex; }
     const VecBloc& getColsValue() const { return colsValue; }
 
+    /// Keep the sparsity pattern from one assembly to the next, for matrices whose topology does not change.
+    /// The blocs of the pattern are never removed, even when they become zero. During an assembly, each
+    /// access to a bloc is checked against the same access in the previous assembly, and finds its position
+    /// in O(1) when the assembly sequence is unchanged. compress() is then free: no sort, no allocation.
+    /// A bloc outside of the pattern is stored in btemp as usual, and the next compress() rebuilds the pattern.
+    void setFrozenPattern(bool frozen)
+    {
+        if (frozen == frozenPattern) return;
+        frozenPattern = frozen;
+        slotTrace.clear();
+        slotTraceRow.clear();
+        slotCursor = 0;
+    }
+
+    bool isFrozenPattern() const { return frozenPattern; }
+
     void resizeBloc(Index nbBRow, Index nbBCol)
     {
         if (nBlocRow == nbBRow && nBlocRow == nbBCol)
@@ -214,6 +238,7 @@ public:
                 traits::clear(colsValue[i]);
             compressed = colsValue.empty();
             btemp.clear();
+            slotCursor = 0;
         }
         else
         {
@@ -230,12 +255,24 @@ public:
             colsValue.clear();
             compressed = true;
             btemp.clear();
+            slotTrace.clear();
+            slotTraceRow.clear();
+            slotCursor = 0;
         }
     }
 
     virtual void compress()
     {
         if (compressed && btemp.empty()) return;
+        if (frozenPattern && btemp.empty())
+        {
+            // all the blocs were written in place: the pattern is unchanged
+            compressed = true;
+            return;
+        }
+        // the blocs are about to move: the trace of the previous assembly is obsolete
+        slotTrace.clear();
+        slotTraceRow.clear();
         if (!btemp.empty())
         {
             dmsg_info_when(EMIT_EXTRA_MESSAGE)
@@ -277,7 +314,7 @@ public:
                 Range inRow( oldRowBegin[inRowId], oldRowBegin[inRowId+1] );
                 while (!inRow.empty())
                 {
-                    if (!traits::empty(oldColsValue[inRow.begin()]))
+                    if (frozenPattern || !traits::empty(oldColsValue[inRow.begin()]))
                     {
                         colsIndex.push_back(oldColsIndex[inRow.begin()]);
                         colsValue.push_back(oldColsValue[inRow.begin()]);
@@ -321,7 +358,7 @@ public:
                 {
                     if (inColIndex < bColIndex)
                     {
-                        if (!traits::empty(oldColsValue[inRow.begin()]))
+                        if (frozenPattern || !traits::empty(oldColsValue[inRow.begin()]))
                         {
                             colsIndex.push_back(inColIndex);
                             colsValue.push_back(oldColsValue[inRow.begin()]);
@@ -386,6 +423,10 @@ public:
         colsIndex.swap(m.colsIndex);
         colsValue.swap(m.colsValue);
         btemp.swap(m.btemp);
+        b = frozenPattern; frozenPattern = m.frozenPattern; m.frozenPattern = b;
+        slotTrace.swap(m.slotTrace);
+        slotTraceRow.swap(m.slotTraceRow);
+        t = slotCursor; slotCursor = m.slotCursor; m.slotCursor = t;
     }
 
     /// Make sure all rows have an entry even if they are empty
@@ -643,8 +684,59 @@ public:
         return empty;
     }
 
+    /// Position of the bloc (i,j) in colsValue, or -1 if it is not in the compressed storage.
+    /// In frozen pattern mode, the position found for the same call of the previous assembly is tried first.
+    Index findSlot(Index i, Index j)
+    {
+        const Index cursor = slotCursor++;
+        if (cursor < (Index)slotTrace.size())
+        {
+            const Index slot = slotTrace[cursor];
+            if (slotTraceRow[cursor] == i && slot < (Index)colsIndex.size() && colsIndex[slot] == j)
+                return slot;
+        }
+
+        Index slot = -1;
+        Index rowId = i * (Index)rowIndex.size() / nBlocRow;
+        if (sortedFind(rowIndex, i, rowId))
+        {
+            Range rowRange(rowBegin[rowId], rowBegin[rowId+1]);
+            Index colId = rowRange.begin() + j * rowRange.size() / nBlocCol;
+            if (sortedFind(colsIndex, rowRange, j, colId))
+                slot = colId;
+        }
+
+        if (slot >= 0)
+        {
+            // record the position for the next assembly
+            if (cursor >= (Index)slotTrace.size())
+            {
+                slotTrace.resize(cursor+1);
+                slotTraceRow.resize(cursor+1);
+            }
+            slotTrace[cursor] = slot;
+            slotTraceRow[cursor] = i;
+        }
+        return slot;
+    }
+
     Bloc* wbloc(Index i, Index j, bool create = false)
     {
+        if (frozenPattern)
+        {
+            const Index slot = findSlot(i, j);
+            if (slot >= 0)
+                return &colsValue[slot];
+            if (!create)
+                return NULL;
+            if (btemp.empty() || btemp.back().l != i || btemp.back().c != j)
+            {
+                btemp.push_back(IndexedBloc(i,j));
+                traits::clear(btemp.back().value);
+            }
+            return &btemp.back().value;
+        }
+
         Index rowId = i * (Index)rowIndex.size() / nBlocRow;
         if (sortedFind(rowIndex, i, rowId))
         {
@@ -877,6 +969,7 @@ public:
             traits::clear(colsValue[i]);
         compressed = colsValue.empty();
         btemp.clear();
+        slotCursor = 0;
     }
 
     /// @name Get information about the content and structure of this matrix (diagonal, band, sparse, full, block size, ...)
@@ -1043,6 +1136,19 @@ public:
     /// Get write access to a bloc, possibly creating it
     virtual BlockAccessor blocCreate(Index i, Index j)
     {
+        if (frozenPattern)
+        {
+            const Index slot = findSlot(i, j);
+            if (slot >= 0)
+                return createBlockAccessor(i, j, slot);
+            if (btemp.empty() || btemp.back().l != i || btemp.back().c != j)
+            {
+                btemp.push_back(IndexedBloc(i,j));
+                traits::clear(btemp.back().value);
+            }
+            return createBlockAccessor(i, j, -(Index)btemp.size());
+        }
+
         Index rowId = i * (Index)rowIndex.size() / nBlocRow;
         if (sortedFind(rowIndex, i, rowId))
         {
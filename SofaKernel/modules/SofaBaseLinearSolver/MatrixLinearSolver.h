@@ -36,6 +36,11 @@
 #include <SofaBaseLinearSolver/DiagonalMatrix.h>
 #include <sofa/core/behavior/RotationMatrix.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace sofa
 {
 
@@ -73,6 +78,19 @@ public:
     }
 };
 
+/// Thread manager of the direct solvers refactorizing the system matrix in a background thread,
+/// see MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>
+class AsyncThreadManager
+{
+public:
+    static std::string Name() { return "Async"; }
+
+    static bool isAsyncSolver()
+    {
+        return true;
+    }
+};
+
 template<class TVector>
 class MatrixLinearSolverInternalData
 {
@@ -280,6 +298,9 @@ public:
         return templateName(this);
     }
 
+    /// Nothing runs in the background for the synchronous solvers. The solvers instantiated with
+    /// AsyncThreadManager must call it in their destructor, before destroying what invert() uses.
+    void waitFactorization() {}
 
     virtual void invert(Matrix& /*M*/) override {}
 
@@ -403,6 +424,91 @@ protected:
 
 };
 
+/// Direct solver refactorizing the system matrix in a background thread.
+///
+/// Each call to setSystemMBKMatrix copies the assembled matrix and factorizes it in a dedicated
+/// thread, while solveSystem keeps using the last finished factorization. A new factorization is
+/// only swapped in (and a new one started) by setSystemMBKMatrix, when the previous one is done,
+/// which hasUpdatedMatrix reports. The first factorization, and the one following a change of the
+/// system size, are computed synchronously.
+///
+/// The solution is thus computed with a matrix a few steps old: these solvers are meant to be used
+/// as preconditioners (ShewchukPCGLinearSolver, WarpPreconditioner), not as the main linear solver.
+/// The matrix type must be copyable, and multiGroup is not supported (the system is then factorized
+/// synchronously).
+///
+/// The background thread is started once and reused for all the factorizations. As it calls the
+/// invert() of the derived solver, the derived solvers must call waitFactorization() in their
+/// destructor.
+template<class Matrix, class Vector>
+class MatrixLinearSolver<Matrix,Vector,AsyncThreadManager> : public MatrixLinearSolver<Matrix,Vector,NoThreadManager>
+{
+public:
+    SOFA_ABSTRACT_CLASS(SOFA_TEMPLATE3(MatrixLinearSolver,Matrix,Vector,AsyncThreadManager), SOFA_TEMPLATE3(MatrixLinearSolver,Matrix,Vector,NoThreadManager));
+
+    typedef MatrixLinearSolver<Matrix,Vector,NoThreadManager> Inherit;
+    typedef AsyncThreadManager ThreadManager;
+
+    MatrixLinearSolver();
+    virtual ~MatrixLinearSolver();
+
+    void cleanup() override;
+
+    /// Assemble the system matrix and start its factorization in the background thread
+    void setSystemMBKMatrix(const core::MechanicalParams* mparams) override;
+
+    /// Solve the system with the last finished factorization
+    void solveSystem() override;
+
+    void invertSystem() override;
+
+    /// Indicate if the last call to setSystemMBKMatrix swapped in a new factorization
+    bool hasUpdatedMatrix() override { return asyncUpdated; }
+
+    static std::string templateName(const MatrixLinearSolver<Matrix,Vector,ThreadManager>* = NULL)
+    {
+        return ThreadManager::Name()+Matrix::Name();
+    }
+
+    virtual bool isAsyncSolver() override
+    {
+        return ThreadManager::isAsyncSolver();
+    }
+
+    virtual std::string getTemplateName() const override
+    {
+        return templateName(this);
+    }
+
+    /// The factorization of the matrix factorized in the background thread is kept apart
+    MatrixInvertData * getMatrixInvertData(defaulttype::BaseMatrix * m);
+
+    /// Wait for the end of the running background factorization, if any
+    void waitFactorization();
+
+protected:
+
+    typedef typename Inherit::GroupData GroupData;
+
+    /// main loop of the background thread, factorizing asyncMatrix each time it is requested
+    void asyncLoop();
+
+    void startFactorization();
+
+    void stopThread();
+
+    Matrix* asyncMatrix; ///< copy of the system matrix factorized by the background thread
+    MatrixInvertData* asyncInvertData; ///< factorization computed by the background thread
+    std::thread asyncThread;
+    std::mutex asyncMutex;
+    std::condition_variable asyncCondition;
+    bool asyncRequested; ///< a factorization of asyncMatrix is requested, protected by asyncMutex
+    bool asyncStop; ///< the background thread must exit, protected by asyncMutex
+    std::atomic<bool> asyncRunning; ///< true until the background factorization is finished
+    bool asyncUpdated; ///< a new factorization was swapped in by the last call to setSystemMBKMatrix
+    int factorizedSize; ///< size of the system of the current factorization, -1 if none
+};
+
 //////////////////////////////////////////////////////////////
 //Specialization for GraphScatteredTypes
 //////////////////////////////////////////////////////////////
@@ -518,6 +624,11 @@ extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< DiagonalMa
 extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< BlockDiagonalMatrix<3,double>, FullVector<double>, NoThreadManager >;
 extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< RotationMatrix<double>, FullVector<double>, NoThreadManager >;
 extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< RotationMatrix<float>, FullVector<float>, NoThreadManager >;
+
+extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< CompressedRowSparseMatrix<double>, FullVector<double>, AsyncThreadManager >;
+extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< CompressedRowSparseMatrix<float>, FullVector<float>, AsyncThreadManager >;
+extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> >, FullVector<double>, AsyncThreadManager >;
+extern template class SOFA_BASE_LINEAR_SOLVER_API MatrixLinearSolver< CompressedRowSparseMatrix<defaulttype::Mat<3,3,float> >, FullVector<float>, AsyncThreadManager >;
 #endif
 
 
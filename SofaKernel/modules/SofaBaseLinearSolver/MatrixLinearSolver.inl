@@ -448,6 +448,153 @@ void MatrixLinearSolver<Matrix,Vector>::computeResidual(const core::ExecParams*
 
 
 
+template<class Matrix, class Vector>
+MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::MatrixLinearSolver()
+    : Inherit()
+    , asyncMatrix(NULL)
+    , asyncInvertData(NULL)
+    , asyncRequested(false)
+    , asyncStop(false)
+    , asyncRunning(false)
+    , asyncUpdated(false)
+    , factorizedSize(-1)
+{
+}
+
+template<class Matrix, class Vector>
+MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::~MatrixLinearSolver()
+{
+    // the derived solvers already waited for the factorization: the thread is idle
+    stopThread();
+    if (asyncMatrix) this->deleteMatrix(asyncMatrix);
+    if (asyncInvertData) delete asyncInvertData;
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::cleanup()
+{
+    stopThread();
+    Inherit::cleanup();
+}
+
+template<class Matrix, class Vector>
+MatrixInvertData * MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::getMatrixInvertData(defaulttype::BaseMatrix * m)
+{
+    if (m != NULL && m == asyncMatrix)
+    {
+        if (asyncInvertData==NULL) asyncInvertData=this->createInvertData();
+        return asyncInvertData;
+    }
+    return Inherit::getMatrixInvertData(m);
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::waitFactorization()
+{
+    std::unique_lock<std::mutex> lock(asyncMutex);
+    asyncCondition.wait(lock, [this] { return !asyncRunning.load(std::memory_order_relaxed); });
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::asyncLoop()
+{
+    std::unique_lock<std::mutex> lock(asyncMutex);
+    for (;;)
+    {
+        asyncCondition.wait(lock, [this] { return asyncRequested || asyncStop; });
+        if (!asyncRequested) return;
+        asyncRequested = false;
+        lock.unlock();
+        this->invert(*asyncMatrix);
+        lock.lock();
+        asyncRunning.store(false, std::memory_order_release);
+        asyncCondition.notify_all();
+    }
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::startFactorization()
+{
+    std::lock_guard<std::mutex> lock(asyncMutex);
+    if (!asyncThread.joinable())
+    {
+        asyncStop = false;
+        asyncThread = std::thread(&MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::asyncLoop, this);
+    }
+    asyncRunning.store(true, std::memory_order_release);
+    asyncRequested = true;
+    asyncCondition.notify_all();
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::stopThread()
+{
+    waitFactorization();
+    if (!asyncThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncStop = true;
+        asyncCondition.notify_all();
+    }
+    asyncThread.join();
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::setSystemMBKMatrix(const core::MechanicalParams* mparams)
+{
+    Inherit::setSystemMBKMatrix(mparams);
+    asyncUpdated = false;
+    if (this->frozen || this->isMultiGroup()) return;
+
+    this->setGroup(0);
+    Matrix* M = this->currentGroup->systemMatrix;
+    const int size = (int)M->rowSize();
+
+    if (size != factorizedSize)
+    {
+        // nothing to solve with yet: factorize synchronously
+        waitFactorization();
+        this->invert(*M);
+        factorizedSize = size;
+    }
+    else if (asyncRunning.load(std::memory_order_acquire))
+    {
+        // keep solving with the current factorization until the running one is done
+        this->currentGroup->needInvert = false;
+        return;
+    }
+    else
+    {
+        waitFactorization();
+        if (asyncInvertData) std::swap(this->invertData, asyncInvertData);
+    }
+    this->currentGroup->needInvert = false;
+    asyncUpdated = true;
+
+    // start the factorization of the new matrix, a copy is kept as the next assembly overwrites the system matrix
+    if (!asyncMatrix) asyncMatrix = this->createMatrix();
+    *asyncMatrix = *M;
+    startFactorization();
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::solveSystem()
+{
+    // the factorization is only updated by setSystemMBKMatrix
+    if (factorizedSize >= 0 && !this->isMultiGroup())
+        this->defaultGroup.needInvert = false;
+    Inherit::solveSystem();
+}
+
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector,AsyncThreadManager>::invertSystem()
+{
+    if (factorizedSize >= 0 && !this->isMultiGroup())
+        this->defaultGroup.needInvert = false;
+    Inherit::invertSystem();
+}
+
+
 } // namespace linearsolver
 
 } // namespace component
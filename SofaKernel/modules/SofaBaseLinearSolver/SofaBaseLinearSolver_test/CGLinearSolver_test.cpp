@@ -0,0 +1,244 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaBaseLinearSolver/CGLinearSolver.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+#include <sofa/simulation/MechanicalVisitor.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <cmath>
+
+namespace sofa {
+
+using simulation::Node;
+using simulation::SceneLoaderXML;
+using component::linearsolver::CGLinearSolver;
+using component::linearsolver::GraphScatteredMatrix;
+using component::linearsolver::GraphScatteredVector;
+
+/// Exposes the child nodes whose products CGLinearSolver computes in parallel
+class IndependentNodesCGLinearSolver : public CGLinearSolver<GraphScatteredMatrix, GraphScatteredVector>
+{
+public:
+    SOFA_CLASS(IndependentNodesCGLinearSolver, SOFA_TEMPLATE2(CGLinearSolver, GraphScatteredMatrix, GraphScatteredVector));
+
+    std::size_t getNbIndependentNodes() const { return this->independentNodes.size(); }
+};
+
+/** Test the fused vector operations and dot product of the graph-scattered CGLinearSolver, and the parallel
+ *  products of its independent child nodes, against the separate visitors and the sequential products.
+ */
+struct CGLinearSolver_test : public Sofa_test<SReal>
+{
+    typedef component::container::MechanicalObject<defaulttype::Vec3Types> MechanicalObject3;
+    typedef core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
+
+    CGLinearSolver_test()
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+    }
+
+    /// Three beams of springs in their own child nodes, the last one with a mapped state. When coupled is set,
+    /// an interaction at the root level links the first two beams.
+    Node::SPtr createScene(bool parallel, bool coupled, IndependentNodesCGLinearSolver::SPtr& solver)
+    {
+        std::ostringstream scene;
+        scene << "<?xml version='1.0'?>"
+                 "<Node name='root' dt='0.01' gravity='0 -9.81 0'>"
+                 "   <EulerImplicitSolver rayleighStiffness='0.1' rayleighMass='0.1'/>";
+        for (int k=0; k<3; ++k)
+        {
+            scene << "   <Node name='beam" << k << "'>"
+                     "       <RegularGridTopology n='5 3 3' min='" << 2*k << " 0 0' max='" << 2*k+1 << " 0.4 0.4'/>"
+                     "       <MechanicalObject name='dofs'/>"
+                     "       <UniformMass totalMass='" << 1+k << "'/>"
+                     "       <MeshSpringForceField stiffness='" << 300+100*k << "' damping='1'/>"
+                     "       <FixedConstraint indices='0 5 10 15 20 25 30 35 40'/>";
+            if (k == 2)
+                scene << "       <Node name='mapped'>"
+                         "           <MechanicalObject name='mappedDofs'/>"
+                         "           <IdentityMapping/>"
+                         "       </Node>";
+            scene << "   </Node>";
+        }
+        if (coupled)
+            scene << "   <StiffSpringForceField object1='@beam0/dofs' object2='@beam1/dofs' spring='4 0 100 0.5 1'/>";
+        scene << "</Node>";
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory("testscene", scene.str().c_str(), scene.str().size());
+        if (!root)
+            return root;
+        solver = core::objectmodel::New<IndependentNodesCGLinearSolver>();
+        solver->f_maxIter.setValue(100);
+        solver->f_tolerance.setValue(1e-12);
+        solver->f_smallDenominatorThreshold.setValue(1e-30);
+        solver->d_parallelNodes.setValue(parallel);
+        root->addObject(solver);
+        sofa::simulation::getSimulation()->init(root.get());
+        return root;
+    }
+
+    static helper::vector<MechanicalObject3*> getStates(Node* root)
+    {
+        helper::vector<MechanicalObject3*> states;
+        root->getTreeObjects<MechanicalObject3>(&states);
+        return states;
+    }
+
+    /// deterministic values in the velocity, force and dx vectors of all the states, the mapped one included
+    static void fillVectors(Node* root)
+    {
+        const core::VecDerivId ids[3] = { core::VecDerivId::velocity(), core::VecDerivId::force(), core::VecDerivId::dx() };
+        helper::vector<MechanicalObject3*> states = getStates(root);
+        for (std::size_t s=0; s<states.size(); ++s)
+        {
+            for (int v=0; v<3; ++v)
+            {
+                states[s]->vAlloc(core::ExecParams::defaultInstance(), ids[v]);
+                helper::WriteAccessor< Data<MechanicalObject3::VecDeriv> > vec = *states[s]->write(ids[v]);
+                vec.resize(states[s]->getSize());
+                for (std::size_t i=0; i<vec.size(); ++i)
+                    vec[i] = defaulttype::Vec3d(std::sin(0.3*i + v + s), std::cos(0.7*i + 2*v), std::sin(1.1*i + s));
+            }
+        }
+    }
+
+    /// concatenation of a vector of all the states
+    static helper::vector<SReal> getVector(Node* root, core::VecDerivId id)
+    {
+        helper::vector<SReal> values;
+        helper::vector<MechanicalObject3*> states = getStates(root);
+        for (std::size_t s=0; s<states.size(); ++s)
+        {
+            const MechanicalObject3::VecDeriv& vec = states[s]->read(core::ConstVecDerivId(id))->getValue();
+            for (std::size_t i=0; i<vec.size(); ++i)
+                for (int c=0; c<3; ++c)
+                    values.push_back(vec[i][c]);
+        }
+        return values;
+    }
+
+    static helper::vector<SReal> getPositions(Node* root)
+    {
+        helper::vector<SReal> values;
+        helper::vector<MechanicalObject3*> states = getStates(root);
+        for (std::size_t s=0; s<states.size(); ++s)
+        {
+            const MechanicalObject3::VecCoord& x = states[s]->readPositions().ref();
+            for (std::size_t i=0; i<x.size(); ++i)
+                for (int c=0; c<3; ++c)
+                    values.push_back(x[i][c]);
+        }
+        return values;
+    }
+
+    /// v += 0.5 f and dx -= 2 f, then v.dx: in a single traversal, or with separate VOp and VDot visitors
+    void multiOpDot()
+    {
+        IndependentNodesCGLinearSolver::SPtr solver;
+        Node::SPtr root = createScene(false, false, solver);
+        ASSERT_NE(nullptr, root);
+        const core::ExecParams* params = core::ExecParams::defaultInstance();
+        const core::MultiVecDerivId v(core::VecDerivId::velocity()), f(core::VecDerivId::force()), dx(core::VecDerivId::dx());
+
+        fillVectors(root.get());
+        simulation::MechanicalVOpVisitor(params, v, v, f, 0.5).execute(root.get());
+        simulation::MechanicalVOpVisitor(params, dx, dx, f, -2.0).execute(root.get());
+        SReal expectedDot = 0;
+        simulation::MechanicalVDotVisitor(params, v, dx, &expectedDot).execute(root.get());
+        const helper::vector<SReal> expectedV = getVector(root.get(), core::VecDerivId::velocity());
+        const helper::vector<SReal> expectedDx = getVector(root.get(), core::VecDerivId::dx());
+
+        fillVectors(root.get());
+        VMultiOp ops(2);
+        ops[0].first = v;
+        ops[0].second.push_back(std::make_pair(v, 1.0));
+        ops[0].second.push_back(std::make_pair(f, 0.5));
+        ops[1].first = dx;
+        ops[1].second.push_back(std::make_pair(dx, 1.0));
+        ops[1].second.push_back(std::make_pair(f, -2.0));
+        SReal dot = 0;
+        simulation::MechanicalVMultiOpDotVisitor(params, ops, v, dx, &dot).execute(root.get());
+
+        EXPECT_NEAR(expectedDot, dot, 1e-12 * std::max((SReal)1, std::fabs(expectedDot)));
+        EXPECT_LT(this->vectorMaxDiff(expectedV, getVector(root.get(), core::VecDerivId::velocity())), 1e-14);
+        EXPECT_LT(this->vectorMaxDiff(expectedDx, getVector(root.get(), core::VecDerivId::dx())), 1e-14);
+
+        sofa::simulation::getSimulation()->unload(root);
+    }
+
+    /// the simulation with the parallel products of the independent nodes is the one with the sequential products
+    void parallelNodes(bool coupled)
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const unsigned int threadCount = scheduler->getThreadCount();
+        scheduler->init(4);
+
+        IndependentNodesCGLinearSolver::SPtr sequentialSolver, parallelSolver;
+        Node::SPtr sequential = createScene(false, coupled, sequentialSolver);
+        Node::SPtr parallel = createScene(true, coupled, parallelSolver);
+        ASSERT_NE(nullptr, sequential);
+        ASSERT_NE(nullptr, parallel);
+        const helper::vector<SReal> initial = getPositions(sequential.get());
+
+        for (int step=0; step<10; ++step)
+        {
+            sofa::simulation::getSimulation()->animate(sequential.get(), 0.01);
+            sofa::simulation::getSimulation()->animate(parallel.get(), 0.01);
+        }
+
+        // the interaction at the root level couples the beams: the products stay sequential
+        EXPECT_EQ(0u, sequentialSolver->getNbIndependentNodes());
+        EXPECT_EQ(coupled ? 0u : 3u, parallelSolver->getNbIndependentNodes());
+
+        const helper::vector<SReal> expected = getPositions(sequential.get());
+        const helper::vector<SReal> positions = getPositions(parallel.get());
+        ASSERT_EQ(expected.size(), positions.size());
+        EXPECT_LT(this->vectorMaxDiff(expected, positions), 1e-10);
+        // the beams moved
+        EXPECT_LT(1e-6, this->vectorMaxDiff(initial, expected));
+
+        sofa::simulation::getSimulation()->unload(sequential);
+        sofa::simulation::getSimulation()->unload(parallel);
+        scheduler->init(threadCount);
+    }
+};
+
+TEST_F(CGLinearSolver_test, multiOpDot)
+{
+    this->multiOpDot();
+}
+
+TEST_F(CGLinearSolver_test, parallelNodes)
+{
+    this->parallelNodes(false);
+}
+
+TEST_F(CGLinearSolver_test, parallelNodesCoupled)
+{
+    this->parallelNodes(true);
+}
+
+} // namespace sofa
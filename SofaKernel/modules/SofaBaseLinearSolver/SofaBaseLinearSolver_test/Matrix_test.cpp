@@ -459,6 +459,51 @@ typedef TestSparseMatrices<double,4,8,2,2> Ts4822;
 //#undef TestMatrix
 
 
+/// frozen pattern: the structure is kept between assemblies, and rebuilt only when a new bloc appears
+TEST(CompressedRowSparseMatrix, frozenPattern)
+{
+    typedef component::linearsolver::CompressedRowSparseMatrix<double> CRS;
+    CRS m;
+    m.setFrozenPattern(true);
+    m.resize(4,4);
+
+    // first assembly: builds the pattern
+    m.add(0,0,1.0); m.add(1,1,2.0); m.add(1,3,3.0); m.add(3,1,4.0);
+    m.compress();
+    ASSERT_EQ(4u, m.getColsIndex().size());
+
+    // same assembly sequence with other values: written in place
+    const double* values = &m.getColsValue()[0];
+    m.clear();
+    m.add(0,0,5.0); m.add(1,1,6.0); m.add(1,3,7.0); m.add(3,1,8.0);
+    m.compress();
+    ASSERT_EQ(4u, m.getColsIndex().size());
+    EXPECT_EQ(values, &m.getColsValue()[0]);
+    EXPECT_EQ(5.0, m.element(0,0));
+    EXPECT_EQ(6.0, m.element(1,1));
+    EXPECT_EQ(7.0, m.element(1,3));
+    EXPECT_EQ(8.0, m.element(3,1));
+
+    // a bloc outside of the pattern: rebuilt, and the blocs which are not written are kept
+    m.clear();
+    m.add(0,0,1.0); m.add(2,2,9.0);
+    m.compress();
+    ASSERT_EQ(5u, m.getColsIndex().size());
+    EXPECT_EQ(1.0, m.element(0,0));
+    EXPECT_EQ(9.0, m.element(2,2));
+    EXPECT_EQ(0.0, m.element(1,3));
+
+    // the assembly sequence changed: the blocs are still found
+    m.clear();
+    m.add(3,1,1.0); m.add(2,2,2.0); m.add(0,0,3.0);
+    m.compress();
+    ASSERT_EQ(5u, m.getColsIndex().size());
+    EXPECT_EQ(1.0, m.element(3,1));
+    EXPECT_EQ(2.0, m.element(2,2));
+    EXPECT_EQ(3.0, m.element(0,0));
+}
+
+
 #if BENCHMARK_MATRIX_PRODUCT
 ///// product timing
 typedef TestSparseMatrices<double,360,300,3,3> TsProductTimings;
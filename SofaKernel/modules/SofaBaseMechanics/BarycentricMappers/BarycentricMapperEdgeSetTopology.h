@@ -69,7 +69,7 @@ protected:
 
     virtual ~BarycentricMapperEdgeSetTopology() override {}
 
-    virtual helper::vector<Edge> getElements() override;
+    virtual const helper::vector<Edge>& getElements() override;
     virtual helper::vector<SReal> getBaryCoef(const Real* f) override;
     helper::vector<SReal> getBaryCoef(const Real fx);
     virtual void computeBase(Mat3x3d& base, const typename In::VecCoord& in, const Edge& element) override;
@@ -66,7 +66,7 @@ int BarycentricMapperEdgeSetTopology<In,Out>::createPointInLine ( const typename
 }
 
 template <class In, class Out>
-helper::vector<Edge> BarycentricMapperEdgeSetTopology<In,Out>::getElements()
+const helper::vector<Edge>& BarycentricMapperEdgeSetTopology<In,Out>::getElements()
 {
     return this->m_fromTopology->getEdges();
 }
@@ -56,7 +56,7 @@ public:
     typedef typename Inherit1::Real Real;
 
     virtual ~BarycentricMapperHexahedronSetTopology() override ;
-    virtual helper::vector<Hexahedron> getElements() override;
+    virtual const helper::vector<Hexahedron>& getElements() override;
     virtual helper::vector<SReal> getBaryCoef(const Real* f) override;
     helper::vector<SReal> getBaryCoef(const Real fx, const Real fy, const Real fz);
     virtual void computeBase(Mat3x3d& base, const typename In::VecCoord& in, const Hexahedron& element) override;
@@ -99,7 +99,7 @@ int BarycentricMapperHexahedronSetTopology<In,Out>::setPointInCube ( const int p
 
 
 template <class In, class Out>
-helper::vector<Hexahedron> BarycentricMapperHexahedronSetTopology<In,Out>::getElements()
+const helper::vector<Hexahedron>& BarycentricMapperHexahedronSetTopology<In,Out>::getElements()
 {
     return this->m_fromTopology->getHexahedra();
 }
@@ -115,14 +115,15 @@ helper::vector<SReal> BarycentricMapperHexahedronSetTopology<In,Out>::getBaryCoe
 template <class In, class Out>
 helper::vector<SReal> BarycentricMapperHexahedronSetTopology<In,Out>::getBaryCoef(const Real fx, const Real fy, const Real fz)
 {
+    // coefficients given in the vertex order of the hexahedron (vertices 2 and 3, 6 and 7 are at fy=1)
     helper::vector<SReal> hexahedronCoef{(1-fx)*(1-fy)*(1-fz),
                 (fx)*(1-fy)*(1-fz),
-                (1-fx)*(fy)*(1-fz),
                 (fx)*(fy)*(1-fz),
+                (1-fx)*(fy)*(1-fz),
                 (1-fx)*(1-fy)*(fz),
                 (fx)*(1-fy)*(fz),
-                (1-fx)*(fy)*(fz),
-                (fx)*(fy)*(fz)};
+                (fx)*(fy)*(fz),
+                (1-fx)*(fy)*(fz)};
     return hexahedronCoef;
 }
 
@@ -61,7 +61,7 @@ protected:
     BarycentricMapperQuadSetTopology(topology::QuadSetTopologyContainer* fromTopology,
                                      topology::PointSetTopologyContainer* toTopology);
 
-    virtual helper::vector<Quad> getElements() override;
+    virtual const helper::vector<Quad>& getElements() override;
     virtual helper::vector<SReal> getBaryCoef(const Real* f) override;
     helper::vector<SReal> getBaryCoef(const Real fx, const Real fy);
     virtual void computeBase(Mat3x3d& base, const typename In::VecCoord& in, const Quad& element) override;
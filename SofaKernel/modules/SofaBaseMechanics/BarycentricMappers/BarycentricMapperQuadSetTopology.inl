@@ -83,7 +83,7 @@ int BarycentricMapperQuadSetTopology<In,Out>::createPointInQuad ( const typename
 }
 
 template <class In, class Out>
-helper::vector<Quad> BarycentricMapperQuadSetTopology<In,Out>::getElements()
+const helper::vector<Quad>& BarycentricMapperQuadSetTopology<In,Out>::getElements()
 {
     return this->m_fromTopology->getQuads();
 }
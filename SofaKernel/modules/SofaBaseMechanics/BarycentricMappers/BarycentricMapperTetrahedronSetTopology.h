@@ -61,7 +61,7 @@ protected:
                                             topology::PointSetTopologyContainer* toTopology);
     virtual ~BarycentricMapperTetrahedronSetTopology() override {}
 
-    virtual helper::vector<Tetrahedron> getElements() override;
+    virtual const helper::vector<Tetrahedron>& getElements() override;
     virtual helper::vector<SReal> getBaryCoef(const Real* f) override;
     helper::vector<SReal> getBaryCoef(const Real fx, const Real fy, const Real fz);
     virtual void computeBase(Mat3x3d& base, const typename In::VecCoord& in, const Tetrahedron& element) override;
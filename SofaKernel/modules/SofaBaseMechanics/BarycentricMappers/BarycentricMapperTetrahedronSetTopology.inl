@@ -56,7 +56,7 @@ int BarycentricMapperTetrahedronSetTopology<In,Out>::addPointInTetra ( const int
 }
 
 template <class In, class Out>
-helper::vector<Tetrahedron> BarycentricMapperTetrahedronSetTopology<In,Out>::getElements()
+const helper::vector<Tetrahedron>& BarycentricMapperTetrahedronSetTopology<In,Out>::getElements()
 {
     return this->m_fromTopology->getTetrahedra();
 }
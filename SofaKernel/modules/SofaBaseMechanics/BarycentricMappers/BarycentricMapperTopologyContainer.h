@@ -68,6 +68,7 @@ public:
     typedef typename MatrixType::Index MatrixTypeIndex;
     enum { NIn = Inherit1::NIn };
     enum { NOut = Inherit1::NOut };
+    enum { NbVertices = Element::static_size };
 
 public:
 
@@ -102,17 +103,35 @@ protected:
     unsigned int m_hashTableSize;
     helper::vector<helper::vector<unsigned int>> m_hashTable;
 
+    // Compact copy of d_map used by apply, applyJ and applyJT, rebuilt when the mapping changes.
+    // One entry per mapped point, sorted by parent element, with the element vertices and the
+    // barycentric weights inlined. The transposed CSR lists for each input vertex the entry slots
+    // contributing to it, so that applyJT can run in parallel without write conflicts.
+    helper::vector<unsigned int> m_compactPoints;    ///< mapped point of each entry
+    helper::vector<int> m_compactEntry;              ///< entry of each mapped point, -1 if not mapped
+    helper::vector<unsigned int> m_compactVertices;  ///< NbVertices input indices per entry
+    helper::vector<Real> m_compactWeights;           ///< NbVertices weights per entry
+    helper::vector<unsigned int> m_compactInBegin;   ///< CSR row offsets, one row per input vertex
+    helper::vector<unsigned int> m_compactInSlots;   ///< CSR columns, as entry*NbVertices+vertex
+    int m_compactCounter {-1};
+    int m_compactRevision {-1};
+    const helper::vector<Element>* m_compactElements {nullptr};
+    std::size_t m_compactNbElements {0};
+
     BarycentricMapperTopologyContainer(core::topology::BaseMeshTopology* fromTopology, topology::PointSetTopologyContainer* toTopology);
 
     virtual ~BarycentricMapperTopologyContainer() override {}
 
-    virtual helper::vector<Element> getElements()=0;
+    virtual const helper::vector<Element>& getElements()=0;
     virtual helper::vector<SReal> getBaryCoef(const Real* f)=0;
     virtual void computeBase(Mat3x3d& base, const typename In::VecCoord& in, const Element& element)=0;
     virtual void computeCenter(Vector3& center, const typename In::VecCoord& in, const Element& element)=0;
     virtual void addPointInElement(const int elementIndex, const SReal* baryCoords)=0;
     virtual void computeDistance(double& d, const Vector3& v)=0;
 
+    /// Rebuild the compact map if d_map or the topology changed since the last call
+    void updateCompactMap();
+
     void exhaustiveSearch ( defaulttype::Vec3d outPos,
                             const typename In::VecCoord& in,
                             const helper::vector<Mat3x3d>& bases,
@@ -22,6 +22,7 @@
 #ifndef SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPERTOPOLOGYCONTAINER_INL
 #define SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPERTOPOLOGYCONTAINER_INL
 #include <sofa/core/visual/VisualParams.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include "BarycentricMapperTopologyContainer.h"
 
@@ -234,11 +235,90 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::exhaust
 }
 
 
+template <class In, class Out, class MappingDataType, class Element>
+void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::updateCompactMap()
+{
+    const helper::vector<MappingDataType>& map = d_map.getValue();
+    const helper::vector<Element>& elements = getElements();
+    const int revision = m_fromTopology->getRevision();
+
+    if (m_compactCounter == d_map.getCounter() && m_compactRevision == revision
+            && m_compactElements == &elements && m_compactNbElements == elements.size())
+        return;
+
+    m_compactCounter = d_map.getCounter();
+    m_compactRevision = revision;
+    m_compactElements = &elements;
+    m_compactNbElements = elements.size();
+
+    // Counting sort of the mapped points by parent element, points outside of any element are skipped
+    const unsigned int nbPoints = (unsigned int)map.size();
+    helper::vector<unsigned int> elementBegin(elements.size()+1, 0);
+    for (unsigned int i=0; i<nbPoints; ++i)
+    {
+        const int index = map[i].in_index;
+        if (index >= 0 && (std::size_t)index < elements.size())
+            ++elementBegin[index+1];
+    }
+    for (std::size_t e=0; e<elements.size(); ++e)
+        elementBegin[e+1] += elementBegin[e];
+
+    const unsigned int nbEntries = elementBegin.back();
+    m_compactPoints.resize(nbEntries);
+    m_compactEntry.assign(nbPoints, -1);
+    m_compactVertices.resize(nbEntries*NbVertices);
+    m_compactWeights.resize(nbEntries*NbVertices);
+
+    unsigned int nbIn = 0;
+    for (unsigned int i=0; i<nbPoints; ++i)
+    {
+        const int index = map[i].in_index;
+        if (index < 0 || (std::size_t)index >= elements.size())
+            continue;
+
+        const unsigned int k = elementBegin[index]++;
+        m_compactPoints[k] = i;
+        m_compactEntry[i] = int(k);
+
+        const Element& element = elements[index];
+        helper::vector<SReal> baryCoef = getBaryCoef(map[i].baryCoords);
+        for (unsigned int j=0; j<NbVertices; j++)
+        {
+            m_compactVertices[k*NbVertices+j] = element[j];
+            m_compactWeights[k*NbVertices+j] = Real(baryCoef[j]);
+            nbIn = std::max(nbIn, (unsigned int)element[j]+1);
+        }
+    }
+
+    // Transposed CSR, filled in point order so that applyJT sums the contributions of each
+    // input vertex in the same order as a serial loop over the mapped points
+    m_compactInBegin.assign(nbIn+1, 0);
+    for (unsigned int s=0; s<m_compactVertices.size(); ++s)
+        ++m_compactInBegin[m_compactVertices[s]+1];
+    for (unsigned int v=0; v<nbIn; ++v)
+        m_compactInBegin[v+1] += m_compactInBegin[v];
+
+    helper::vector<unsigned int> inPos(m_compactInBegin.begin(), m_compactInBegin.end()-1);
+    m_compactInSlots.resize(m_compactVertices.size());
+    for (unsigned int i=0; i<nbPoints; ++i)
+    {
+        if (m_compactEntry[i] < 0)
+            continue;
+        for (unsigned int j=0; j<NbVertices; j++)
+        {
+            const unsigned int slot = m_compactEntry[i]*NbVertices+j;
+            m_compactInSlots[inPos[m_compactVertices[slot]]++] = slot;
+        }
+    }
+}
+
+
 template <class In, class Out, class MappingDataType, class Element>
 void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJT ( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in )
 {
+    updateCompactMap();
+
     typename Out::MatrixDeriv::RowConstIterator rowItEnd = in.end();
-    const helper::vector< Element >& elements = getElements();
 
     for (typename Out::MatrixDeriv::RowConstIterator rowIt = in.begin(); rowIt != rowItEnd; ++rowIt)
     {
@@ -252,13 +332,15 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJT
             for ( ; colIt != colItEnd; ++colIt)
             {
                 unsigned indexIn = colIt.index();
-                InDeriv data = (InDeriv) Out::getDPos(colIt.val());
+                if (indexIn >= m_compactEntry.size() || m_compactEntry[indexIn] < 0)
+                    continue;
 
-                const Element& element = elements[d_map.getValue()[indexIn].in_index];
+                InDeriv data = (InDeriv) Out::getDPos(colIt.val());
 
-                helper::vector<SReal> baryCoef = getBaryCoef(d_map.getValue()[indexIn].baryCoords);
-                for (unsigned int j=0; j<element.size(); j++)
-                    o.addCol(element[j], data*baryCoef[j]);
+                const unsigned int* vertices = &m_compactVertices[m_compactEntry[indexIn]*NbVertices];
+                const Real* weights = &m_compactWeights[m_compactEntry[indexIn]*NbVertices];
+                for (unsigned int j=0; j<NbVertices; j++)
+                    o.addCol(vertices[j], data*weights[j]);
             }
         }
     }
@@ -302,23 +384,36 @@ const sofa::defaulttype::BaseMatrix* BarycentricMapperTopologyContainer<In,Out,M
 template <class In, class Out, class MappingDataType, class Element>
 void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJT ( typename In::VecDeriv& out, const typename Out::VecDeriv& in )
 {
-    const helper::vector<Element>& elements = getElements();
+    updateCompactMap();
 
-    ForceMask& mask = *this->maskFrom;
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
-    {
-        if( !this->maskTo->getEntry(i) ) continue;
+    const ForceMask& maskTo = *this->maskTo;
+    const unsigned int nbIn = (unsigned int)std::min(out.size(), m_compactInBegin.size()-1);
 
-        int index = d_map.getValue()[i].in_index;
-        const Element& element = elements[index];
-
-        const typename Out::DPos inPos = Out::getDPos(in[i]);
-        helper::vector<SReal> baryCoef = getBaryCoef(d_map.getValue()[i].baryCoords);
-        for (unsigned int j=0; j<element.size(); j++)
+    // each task owns a range of input vertices and gathers their contributions from the transposed CSR
+    simulation::TaskScheduler::getInstance()->parallel_for(0u, nbIn, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int v=first; v<last; ++v)
         {
-            out[element[j]] += inPos * baryCoef[j];
-            mask.insertEntry(element[j]);
+            for (unsigned int c=m_compactInBegin[v]; c<m_compactInBegin[v+1]; ++c)
+            {
+                const unsigned int slot = m_compactInSlots[c];
+                const unsigned int i = m_compactPoints[slot/NbVertices];
+                if (i >= maskTo.size() || !maskTo.getEntry(i))
+                    continue;
+
+                out[v] += Out::getDPos(in[i]) * m_compactWeights[slot];
+            }
         }
+    }, 1024u);
+
+    // the mask storage is not safe to write concurrently
+    ForceMask& mask = *this->maskFrom;
+    for (unsigned int k=0; k<m_compactPoints.size(); ++k)
+    {
+        if (m_compactPoints[k] >= maskTo.size() || !maskTo.getEntry(m_compactPoints[k]))
+            continue;
+        for (unsigned int j=0; j<NbVertices; j++)
+            mask.insertEntry(m_compactVertices[k*NbVertices+j]);
     }
 }
 
@@ -327,22 +422,26 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJ
 {
     out.resize( d_map.getValue().size() );
 
-    const helper::vector<Element>& elements = getElements();
+    updateCompactMap();
 
-    for( size_t i=0 ; i<this->maskTo->size() ; ++i)
+    const ForceMask& maskTo = *this->maskTo;
+    simulation::TaskScheduler::getInstance()->parallel_for(0u, (unsigned int)m_compactPoints.size(), [&](unsigned int first, unsigned int last)
     {
-        if( this->maskTo->isActivated() && !this->maskTo->getEntry(i) ) continue;
-
-        int index = d_map.getValue()[i].in_index;
-        const Element& element = elements[index];
+        for (unsigned int k=first; k<last; ++k)
+        {
+            const unsigned int i = m_compactPoints[k];
+            if (i >= maskTo.size() || (maskTo.isActivated() && !maskTo.getEntry(i)))
+                continue;
 
-        helper::vector<SReal> baryCoef = getBaryCoef(d_map.getValue()[i].baryCoords);
-        InDeriv inPos{0.,0.,0.};
-        for (unsigned int j=0; j<element.size(); j++)
-            inPos += in[element[j]] * baryCoef[j];
+            const unsigned int* vertices = &m_compactVertices[k*NbVertices];
+            const Real* weights = &m_compactWeights[k*NbVertices];
+            InDeriv inPos = in[vertices[0]] * weights[0];
+            for (unsigned int j=1; j<NbVertices; j++)
+                inPos += in[vertices[j]] * weights[j];
 
-        Out::setDPos(out[i] , inPos);
-    }
+            Out::setDPos(out[i] , inPos);
+        }
+    }, 1024u);
 }
 
 
@@ -365,19 +464,22 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::apply (
 {
     out.resize( d_map.getValue().size() );
 
-    const helper::vector<Element>& elements = getElements();
-    for ( unsigned int i=0; i<d_map.getValue().size(); i++ )
-    {
-        int index = d_map.getValue()[i].in_index;
-        const Element& element = elements[index];
+    updateCompactMap();
 
-        helper::vector<SReal> baryCoef = getBaryCoef(d_map.getValue()[i].baryCoords);
-        InDeriv inPos{0.,0.,0.};
-        for (unsigned int j=0; j<element.size(); j++)
-            inPos += in[element[j]] * baryCoef[j];
+    // entries are sorted by element, so consecutive points read the same input vertices
+    simulation::TaskScheduler::getInstance()->parallel_for(0u, (unsigned int)m_compactPoints.size(), [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int k=first; k<last; ++k)
+        {
+            const unsigned int* vertices = &m_compactVertices[k*NbVertices];
+            const Real* weights = &m_compactWeights[k*NbVertices];
+            InDeriv inPos = in[vertices[0]] * weights[0];
+            for (unsigned int j=1; j<NbVertices; j++)
+                inPos += in[vertices[j]] * weights[j];
 
-        Out::setCPos(out[i] , inPos);
-    }
+            Out::setCPos(out[m_compactPoints[k]] , inPos);
+        }
+    }, 1024u);
 }
 
 
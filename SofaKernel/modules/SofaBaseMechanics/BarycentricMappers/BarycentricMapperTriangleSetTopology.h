@@ -66,7 +66,7 @@ protected:
     topology::TriangleSetTopologyContainer*			m_fromContainer;
     topology::TriangleSetGeometryAlgorithms<In>*	m_fromGeomAlgo;
 
-    virtual helper::vector<Triangle> getElements() override;
+    virtual const helper::vector<Triangle>& getElements() override;
     virtual helper::vector<SReal> getBaryCoef(const Real* f) override;
     helper::vector<SReal> getBaryCoef(const Real fx, const Real fy);
     virtual void computeBase(Mat3x3d& base, const typename In::VecCoord& in, const Triangle& element) override;
@@ -82,7 +82,7 @@ int BarycentricMapperTriangleSetTopology<In,Out>::createPointInTriangle ( const
 
 
 template <class In, class Out>
-helper::vector<Triangle> BarycentricMapperTriangleSetTopology<In,Out>::getElements()
+const helper::vector<Triangle>& BarycentricMapperTriangleSetTopology<In,Out>::getElements()
 {
     return this->m_fromTopology->getTriangles();
 }
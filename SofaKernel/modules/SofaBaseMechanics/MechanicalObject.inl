@@ -155,6 +155,9 @@ MechanicalObject<DataTypes>::MechanicalObject()
     f               .forceSet();
     externalForces  .forceSet();
 
+    // the positions are drawn by most components, they are copied to the aspects used by an asynchronous visual loop
+    x.setVisual(true);
+
     // there is no need for a common user to watch at these vectors
 //    dx.setDisplayed( false );
 //    freePosition.setDisplayed( false );
@@ -21,14 +21,20 @@
 ******************************************************************************/
 #include <SofaBaseMechanics/BarycentricMapping.h>
 #include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperTriangleSetTopology.h>
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperTetrahedronSetTopology.h>
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperHexahedronSetTopology.h>
 using sofa::component::mapping::BarycentricMapperTriangleSetTopology;
+using sofa::component::mapping::BarycentricMapperTetrahedronSetTopology;
+using sofa::component::mapping::BarycentricMapperHexahedronSetTopology;
 using sofa::component::mapping::BarycentricMapping;
 
 #include <SofaBaseTopology/TriangleSetTopologyContainer.h>
 #include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/HexahedronSetTopologyContainer.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 using sofa::component::topology::TriangleSetTopologyContainer;
 using sofa::component::topology::TetrahedronSetTopologyContainer;
+using sofa::component::topology::HexahedronSetTopologyContainer;
 using sofa::core::topology::BaseMeshTopology;
 
 #include <gtest/gtest.h>
@@ -176,3 +182,143 @@ TEST_F(BarycentricMapperTriangleSetTopologyTest_d, addToHashTable)
 }*/
 
 
+
+
+/// Checks the compact apply, applyJ and applyJT kernels on volumetric mappers:
+/// mapped rest positions are reproduced, and applyJT is the transpose of applyJ.
+template <class In, class Out, template<class,class> class MapperType, class Container>
+struct BarycentricMapperVolumeTest :  public Test, public MapperType<In,Out>
+{
+    typedef MapperType<In,Out> Mapper;
+    typedef typename In::Real Real;
+    typedef typename Mapper::ForceMask ForceMask;
+
+    using Mapper::m_fromTopology;
+    using Mapper::d_map;
+    using Mapper::init;
+    using Mapper::apply;
+    using Mapper::applyJ;
+    using Mapper::applyJT;
+
+    typename In::VecCoord m_in;
+    typename Out::VecCoord m_out;
+    typename Container::SPtr m_topology;
+    ForceMask m_maskFrom;
+    ForceMask m_maskTo;
+
+    void SetUp()
+    {
+        // two unit cubes along x, split in tetrahedra for the tetrahedron mapper
+        for (int z=0; z<2; ++z)
+            for (int y=0; y<2; ++y)
+                for (int x=0; x<3; ++x)
+                    m_in.push_back(Vector3(x, y, z));
+
+        for (int i=0; i<40; ++i)
+            m_out.push_back(Vector3(0.05*(i%37), 0.023*(i%41), 0.97-0.021*i));
+
+        m_topology = New<Container>();
+        m_fromTopology = m_topology.get();
+        addElements(m_topology.get());
+
+        init(m_out, m_in);
+
+        m_maskFrom.assign(m_in.size(), true);
+        m_maskTo.assign(m_out.size(), true);
+        this->maskFrom = &m_maskFrom;
+        this->maskTo = &m_maskTo;
+    }
+
+    static int v(int x, int y, int z) { return x + 3*y + 6*z; }
+
+    void addElements(HexahedronSetTopologyContainer* topology)
+    {
+        for (int x=0; x<2; ++x)
+            topology->addHexa(v(x,0,0), v(x+1,0,0), v(x+1,1,0), v(x,1,0),
+                              v(x,0,1), v(x+1,0,1), v(x+1,1,1), v(x,1,1));
+    }
+
+    void addElements(TetrahedronSetTopologyContainer* topology)
+    {
+        for (int x=0; x<2; ++x)
+        {
+            topology->addTetra(v(x,0,0), v(x+1,0,0), v(x,1,0), v(x,0,1));
+            topology->addTetra(v(x+1,0,0), v(x+1,1,0), v(x,1,0), v(x+1,1,1));
+            topology->addTetra(v(x,0,1), v(x+1,0,1), v(x+1,0,0), v(x+1,1,1));
+            topology->addTetra(v(x,0,1), v(x,1,1), v(x+1,1,1), v(x,1,0));
+            topology->addTetra(v(x,0,1), v(x+1,0,0), v(x,1,0), v(x+1,1,1));
+        }
+    }
+
+    void apply_test()
+    {
+        EXPECT_EQ(d_map.getValue().size(), m_out.size());
+
+        typename Out::VecCoord out;
+        apply(out, m_in);
+        ASSERT_EQ(out.size(), m_out.size());
+        for (unsigned int i=0; i<out.size(); ++i)
+            for (int c=0; c<3; ++c)
+                EXPECT_NEAR(out[i][c], m_out[i][c], 1e-10);
+    }
+
+    void applyJT_test()
+    {
+        typename In::VecDeriv dx(m_in.size());
+        for (unsigned int i=0; i<dx.size(); ++i)
+            dx[i] = Vector3(0.1*i, 1.0-0.05*i, 0.3);
+
+        typename Out::VecDeriv f(m_out.size());
+        for (unsigned int i=0; i<f.size(); ++i)
+            f[i] = Vector3(0.2, -0.01*i, 0.5+0.02*i);
+
+        typename Out::VecDeriv dy;
+        applyJ(dy, dx);
+        ASSERT_EQ(dy.size(), m_out.size());
+
+        typename In::VecDeriv g(m_in.size(), Vector3(0,0,0));
+        applyJT(g, f);
+
+        // <J dx, f> == <dx, J^T f>
+        Real dyf = 0, dxg = 0;
+        for (unsigned int i=0; i<f.size(); ++i)
+            dyf += dy[i]*f[i];
+        for (unsigned int i=0; i<g.size(); ++i)
+            dxg += dx[i]*g[i];
+        EXPECT_NEAR(dyf, dxg, 1e-10);
+
+        // the compact map follows the changes of the mapping
+        applyJ(dy, dx);
+        typename Out::VecDeriv dyBefore = dy;
+        this->clear(0);
+        init(m_out, m_in);
+        applyJ(dy, dx);
+        for (unsigned int i=0; i<dy.size(); ++i)
+            EXPECT_EQ(dy[i], dyBefore[i]);
+    }
+};
+
+typedef BarycentricMapperVolumeTest< Vec3dTypes, Vec3dTypes, BarycentricMapperHexahedronSetTopology,
+                                     HexahedronSetTopologyContainer > BarycentricMapperHexahedronSetTopologyTest_d;
+typedef BarycentricMapperVolumeTest< Vec3dTypes, Vec3dTypes, BarycentricMapperTetrahedronSetTopology,
+                                     TetrahedronSetTopologyContainer > BarycentricMapperTetrahedronSetTopologyTest_d;
+
+TEST_F(BarycentricMapperHexahedronSetTopologyTest_d, apply)
+{
+    apply_test();
+}
+
+TEST_F(BarycentricMapperHexahedronSetTopologyTest_d, applyJT)
+{
+    applyJT_test();
+}
+
+TEST_F(BarycentricMapperTetrahedronSetTopologyTest_d, apply)
+{
+    apply_test();
+}
+
+TEST_F(BarycentricMapperTetrahedronSetTopologyTest_d, applyJT)
+{
+    applyJT_test();
+}
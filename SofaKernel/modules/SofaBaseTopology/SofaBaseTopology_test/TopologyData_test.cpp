@@ -0,0 +1,116 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <gtest/gtest.h>
+#include <SofaBaseTopology/TopologyData.inl>
+
+using namespace sofa::component::topology;
+using sofa::core::topology::BaseMeshTopology;
+using sofa::helper::vector;
+
+
+namespace
+{
+
+typedef vector<int> VecInt;
+
+/// Records the destroyed values, and gives each created value its index at creation time
+class RecordingPointHandler : public TopologyDataHandler<BaseMeshTopology::Point, VecInt>
+{
+public:
+    RecordingPointHandler(PointData<VecInt>* data)
+        : TopologyDataHandler<BaseMeshTopology::Point, VecInt>(data)
+    {}
+
+    virtual void applyCreateFunction(unsigned int i, int& t, const BaseMeshTopology::Point&,
+            const vector< unsigned int >& ancestors, const vector< double >&) override
+    {
+        t = 1000 + 10*(int)i + (int)ancestors.size();
+    }
+
+    virtual void applyDestroyFunction(unsigned int i, int& t) override
+    {
+        destroyed.push_back(std::make_pair(i, t));
+    }
+
+    vector< std::pair<unsigned int, int> > destroyed;
+};
+
+void applyChanges(bool batch, VecInt& values, vector< std::pair<unsigned int, int> >& destroyed)
+{
+    PointData<VecInt> data((sofa::core::topology::BaseTopologyData<VecInt>::InitData()));
+    VecInt initValues;
+    for (int i = 0; i < 10; ++i)
+        initValues.push_back(i);
+    data.setValue(initValues);
+
+    RecordingPointHandler handler(&data);
+    handler.setBatchTopologyChanges(batch);
+
+    vector<unsigned int> removed1 = {2, 5};
+    vector<unsigned int> added1 = {8, 9, 10};
+    vector< vector<unsigned int> > ancestors1 = {{0}, {1, 3}, {4}};
+    vector< vector<double> > coefs1 = {{1.0}, {0.5, 0.5}, {1.0}};
+    vector<unsigned int> removed2 = {9, 1};
+    vector<unsigned int> renumbering, invRenumbering;
+    for (unsigned int i = 0; i < 9; ++i)
+    {
+        renumbering.push_back((i*4)%9);
+        invRenumbering.push_back((i*7)%9);
+    }
+    vector<unsigned int> added2 = {9};
+
+    sofa::core::topology::PointsRemoved pointsRemoved1(removed1);
+    sofa::core::topology::PointsAdded pointsAdded1(added1.size(), added1, ancestors1, coefs1);
+    sofa::core::topology::PointsIndicesSwap pointsSwap(0, 9);
+    sofa::core::topology::EndingEvent ending;
+    sofa::core::topology::PointsRemoved pointsRemoved2(removed2);
+    sofa::core::topology::PointsRenumbering pointsRenumbering(renumbering, invRenumbering);
+    sofa::core::topology::PointsAdded pointsAdded2(added2.size(), added2);
+
+    std::list< const sofa::core::topology::TopologyChange* > changes;
+    changes.push_back(&pointsRemoved1);
+    changes.push_back(&pointsAdded1);
+    changes.push_back(&pointsSwap);
+    changes.push_back(&ending);
+    changes.push_back(&pointsRemoved2);
+    changes.push_back(&pointsRenumbering);
+    changes.push_back(&pointsAdded2);
+
+    handler.ApplyTopologyChanges(changes, 10);
+
+    values = data.getValue();
+    destroyed = handler.destroyed;
+}
+
+TEST( TopologyData_test, checkBatchedChangesMatchTheChangesAppliedOneByOne )
+{
+    VecInt expectedValues, values;
+    vector< std::pair<unsigned int, int> > expectedDestroyed, destroyed;
+    applyChanges(false, expectedValues, expectedDestroyed);
+    applyChanges(true, values, destroyed);
+
+    ASSERT_EQ(10u, expectedValues.size());
+    EXPECT_EQ(expectedValues, values);
+    EXPECT_EQ(expectedDestroyed, destroyed);
+}
+
+} // namespace
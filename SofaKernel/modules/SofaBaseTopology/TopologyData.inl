@@ -78,6 +78,7 @@ template <typename TopologyElementType, typename VecT>
 void TopologyDataImpl <TopologyElementType, VecT>::createTopologicalEngine(sofa::core::topology::BaseMeshTopology *_topology)
 {
     this->m_topologyHandler = new TopologyDataHandler<TopologyElementType, VecT>(this);
+    this->m_topologyHandler->setBatchTopologyChanges(true);
     createTopologicalEngine(_topology, this->m_topologyHandler);
 }
 
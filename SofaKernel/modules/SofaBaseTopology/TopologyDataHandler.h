@@ -65,17 +65,32 @@ public:
 
     typedef sofa::core::topology::TopologyElementHandler< TopologyElementType > Inherit;
     typedef typename Inherit::AncestorElem AncestorElem;
+    typedef typename Inherit::EIndicesSwap EIndicesSwap;
+    typedef typename Inherit::ERenumbering ERenumbering;
+    typedef typename Inherit::EAdded EAdded;
+    typedef typename Inherit::ERemoved ERemoved;
 
 protected:
     sofa::core::topology::BaseTopologyData <VecT>* m_topologyData;
 	value_type m_defaultValue; // default value when adding an element (by set as value_type() by default)
 
+    /// True if the consecutive additions, removals, swaps and renumberings are applied as one batch
+    bool m_batchTopologyChanges;
+    /// Origin of each value while a batch is pending: its index in the data before the batch,
+    /// or -1-k for the k-th value of m_batchCreated
+    sofa::helper::vector<int> m_batchSource;
+    /// Values created while a batch is pending
+    sofa::helper::vector<value_type> m_batchCreated;
+    /// Data being edited while a batch is pending, NULL otherwise
+    container_type* m_batchData;
+
 public:
     // constructor
     TopologyDataHandler(sofa::core::topology::BaseTopologyData <VecT>* _topologyData,
                         value_type defaultValue=value_type())
         :sofa::core::topology::TopologyElementHandler < TopologyElementType >()
-        , m_topologyData(_topologyData), m_defaultValue(defaultValue) {}
+        , m_topologyData(_topologyData), m_defaultValue(defaultValue)
+        , m_batchTopologyChanges(false), m_batchData(NULL) {}
 
     bool isTopologyDataRegistered()
     {
@@ -113,6 +128,18 @@ public:
 		m_defaultValue=v;
 	}
 
+    /// Apply the list of changes. If batching is enabled, each run of consecutive additions, removals,
+    /// swaps and renumberings of this element type is coalesced into one permutation of the existing
+    /// values plus a list of created values, which are then moved into the data in a single pass.
+    virtual void ApplyTopologyChanges(const std::list< const core::topology::TopologyChange *>& _topologyChangeEvents, const unsigned int _dataSize) override;
+
+    /// Enable the batched application of the changes.
+    /// The creation and destruction functions are still called once per element and in the order of
+    /// the events, but only on the value given as parameter: they must not access the other values of
+    /// the data by index, as they are only moved to their final position at the end of the batch.
+    void setBatchTopologyChanges(bool b) { m_batchTopologyChanges = b; }
+    bool getBatchTopologyChanges() const { return m_batchTopologyChanges; }
+
 protected:
     /// Swaps values at indices i1 and i2.
     virtual void swap( unsigned int i1, unsigned int i2 );
@@ -143,6 +170,19 @@ protected:
     /// Remove Element after a displacement of vertices, ie. add element based on previous position topology revision.
     virtual void removeOnMovedPosition(const sofa::helper::vector<unsigned int> &indices);
 
+    /// Same as add, remove, swap and renumber, but only updating the pending batch
+    void batchAdd(const EAdded* event);
+    void batchRemove(const sofa::helper::vector<unsigned int> &index);
+    void batchSwap(unsigned int i1, unsigned int i2);
+    void batchRenumber(const sofa::helper::vector<unsigned int> &index);
+
+    /// Start a batch if none is pending
+    void openBatch();
+    /// Value of the pending batch stored at the given origin
+    value_type& batchValue(int source);
+    /// Move the values of the pending batch to their final position
+    void flushBatch();
+
 
 };
 
@@ -172,6 +172,179 @@ void TopologyDataHandler <TopologyElementType, VecT>::removeOnMovedPosition(cons
 }
 
 
+///////////////////// Batched topological changes /////////////////////////////
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::ApplyTopologyChanges(const std::list< const core::topology::TopologyChange *>& _topologyChangeEvents, const unsigned int _dataSize)
+{
+    if (!m_batchTopologyChanges)
+    {
+        Inherit::ApplyTopologyChanges(_topologyChangeEvents, _dataSize);
+        return;
+    }
+
+    if(!this->isTopologyDataRegistered())
+        return;
+
+    this->setDataSetArraySize(_dataSize);
+
+    std::list<const core::topology::TopologyChange *>::const_iterator changeIt;
+    for (changeIt=_topologyChangeEvents.begin(); changeIt!=_topologyChangeEvents.end(); ++changeIt)
+    {
+        const core::topology::TopologyChange* change = *changeIt;
+        if (const EAdded* added = dynamic_cast<const EAdded*>(change))
+            batchAdd(added);
+        else if (const ERemoved* removed = dynamic_cast<const ERemoved*>(change))
+            batchRemove(removed->getArray());
+        else if (const EIndicesSwap* swapped = dynamic_cast<const EIndicesSwap*>(change))
+            batchSwap(swapped->index[0], swapped->index[1]);
+        else if (const ERenumbering* renumbered = dynamic_cast<const ERenumbering*>(change))
+            batchRenumber(renumbered->getIndexArray());
+        else
+        {
+            // any other event may rely on the current numbering of the data
+            flushBatch();
+            this->dispatchTopologyChange(change);
+        }
+    }
+    flushBatch();
+}
+
+
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::openBatch()
+{
+    if (m_batchData)
+        return;
+
+    m_batchData = m_topologyData->beginEdit();
+    m_batchSource.resize(m_batchData->size());
+    for (unsigned int i = 0; i < m_batchSource.size(); ++i)
+        m_batchSource[i] = (int)i;
+    m_batchCreated.clear();
+}
+
+
+template <typename TopologyElementType, typename VecT>
+typename TopologyDataHandler <TopologyElementType, VecT>::value_type& TopologyDataHandler <TopologyElementType, VecT>::batchValue(int source)
+{
+    return (source >= 0) ? (*m_batchData)[source] : m_batchCreated[-1-source];
+}
+
+
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::batchAdd(const EAdded* event)
+{
+    const sofa::helper::vector<unsigned int>& index = event->getIndexArray();
+    const sofa::helper::vector< TopologyElementType >& elems = event->getElementArray();
+    const sofa::helper::vector< sofa::helper::vector< unsigned int > >& ancestors = event->ancestorsList;
+    const sofa::helper::vector< sofa::helper::vector< double > >& coefs = event->coefs;
+    const sofa::helper::vector< AncestorElem >& ancestorElems = event->ancestorElems;
+
+    unsigned int nbElements = (unsigned)index.size();
+    if (nbElements == 0) return;
+    openBatch();
+    unsigned int i0 = (unsigned)m_batchSource.size();
+    if (i0 != index[0])
+    {
+        this->m_topologyData->getOwner()->serr << "TopologyDataHandler SIZE MISMATCH in Data "
+            << this->m_topologyData->getName() << ": " << nbElements << " "
+            << core::topology::TopologyElementInfo<TopologyElementType>::name()
+            << " ADDED starting from index " << index[0]
+            << " while vector size is " << i0 << this->m_topologyData->getOwner()->sendl;
+        i0 = index[0];
+    }
+    while (m_batchSource.size() < i0)
+    {
+        m_batchCreated.push_back(value_type());
+        m_batchSource.push_back(-(int)m_batchCreated.size());
+    }
+    m_batchSource.resize(i0);
+
+    const sofa::helper::vector< unsigned int > empty_vecint;
+    const sofa::helper::vector< double > empty_vecdouble;
+
+    for (unsigned int i = 0; i < nbElements; ++i)
+    {
+        m_batchCreated.push_back(value_type());
+        m_batchSource.push_back(-(int)m_batchCreated.size());
+        this->applyCreateFunction(i0+i, m_batchCreated.back(), elems[i],
+            (ancestors.empty() || coefs.empty()) ? empty_vecint : ancestors[i],
+            (ancestors.empty() || coefs.empty()) ? empty_vecdouble : coefs[i],
+            (ancestorElems.empty()             ) ? NULL : &ancestorElems[i]);
+    }
+}
+
+
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::batchRemove(const sofa::helper::vector<unsigned int> &index)
+{
+    openBatch();
+    if (m_batchSource.empty())
+        return;
+
+    unsigned int last = (unsigned)m_batchSource.size() -1;
+    for (unsigned int i = 0; i < index.size(); ++i)
+    {
+        this->applyDestroyFunction( index[i], batchValue(m_batchSource[index[i]]) );
+        std::swap(m_batchSource[index[i]], m_batchSource[last]);
+        --last;
+    }
+    m_batchSource.resize( m_batchSource.size() - index.size() );
+}
+
+
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::batchSwap(unsigned int i1, unsigned int i2)
+{
+    openBatch();
+    std::swap(m_batchSource[i1], m_batchSource[i2]);
+}
+
+
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::batchRenumber(const sofa::helper::vector<unsigned int> &index)
+{
+    openBatch();
+    const sofa::helper::vector<int> copy = m_batchSource;
+    for (unsigned int i = 0; i < index.size(); ++i)
+        m_batchSource[i] = copy[ index[i] ];
+}
+
+
+template <typename TopologyElementType, typename VecT>
+void TopologyDataHandler <TopologyElementType, VecT>::flushBatch()
+{
+    if (!m_batchData)
+        return;
+
+    container_type& data = *m_batchData;
+    const unsigned int nbValues = (unsigned)m_batchSource.size();
+
+    // the values before the first moved one stay in place
+    unsigned int first = 0;
+    while (first < nbValues && first < data.size() && m_batchSource[first] == (int)first)
+        ++first;
+
+    if (first < nbValues || nbValues < data.size())
+    {
+        // each value of the data appears at most once in the batch, so it can be moved
+        sofa::helper::vector<value_type> tail;
+        tail.reserve(nbValues - first);
+        for (unsigned int i = first; i < nbValues; ++i)
+            tail.push_back(std::move(batchValue(m_batchSource[i])));
+
+        data.resize(nbValues);
+        for (unsigned int i = first; i < nbValues; ++i)
+            data[i] = std::move(tail[i-first]);
+    }
+
+    m_topologyData->endEdit();
+    m_batchData = NULL;
+    m_batchSource.clear();
+    m_batchCreated.clear();
+}
+
+
 } // namespace topology
 
 } // namespace component
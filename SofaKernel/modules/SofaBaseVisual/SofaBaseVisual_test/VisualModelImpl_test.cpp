@@ -74,6 +74,7 @@ TEST( VisualModelImpl_test , checkThatMembersAreCorrectlyConstructed )
     ASSERT_EQ(true_var,  visualModel.m_updateNormals.getValue());
     ASSERT_EQ(false_var, visualModel.m_computeTangents.getValue());
     ASSERT_EQ(true_var,  visualModel.m_updateTangents.getValue());
+    ASSERT_EQ(false_var, visualModel.m_incrementalNormals.getValue());
     ASSERT_EQ(true_var,  visualModel.m_handleDynamicTopology.getValue());
     ASSERT_EQ(true_var,  visualModel.m_fixMergedUVSeams.getValue());
 
@@ -121,4 +122,94 @@ TEST( VisualModelImpl_test , checkThatMembersAreCorrectlyConstructed )
     ASSERT_EQ(1u, visualModel.xforms.size());
 }
 
+/// Grid of nx*ny vertices, the first row of cells split into triangles and the others kept as quads
+void createGridMesh(StubVisualModelImpl& visualModel, unsigned int nx, unsigned int ny)
+{
+    typedef component::visualmodel::VisualModelImpl VisualModelImpl;
+
+    VisualModelImpl::VecCoord& positions = *visualModel.m_positions.beginEdit();
+    VisualModelImpl::VecTexCoord& texcoords = *visualModel.m_vtexcoords.beginEdit();
+    for (unsigned int j = 0; j < ny; j++)
+        for (unsigned int i = 0; i < nx; i++)
+        {
+            positions.push_back(VisualModelImpl::Coord((float)i, (float)j, 0.1f*(float)((i*7+j*3)%5)));
+            texcoords.push_back(VisualModelImpl::TexCoord((float)i/(nx-1), (float)j/(ny-1)));
+        }
+    visualModel.m_positions.endEdit();
+    visualModel.m_vtexcoords.endEdit();
+
+    defaulttype::ResizableExtVector<VisualModelImpl::Triangle>& triangles = *visualModel.m_triangles.beginEdit();
+    defaulttype::ResizableExtVector<VisualModelImpl::Quad>& quads = *visualModel.m_quads.beginEdit();
+    for (unsigned int j = 0; j+1 < ny; j++)
+        for (unsigned int i = 0; i+1 < nx; i++)
+        {
+            const int p = j*nx+i;
+            if (j == 0)
+            {
+                triangles.push_back(VisualModelImpl::Triangle(p, p+1, p+nx+1));
+                triangles.push_back(VisualModelImpl::Triangle(p, p+nx+1, p+nx));
+            }
+            else
+                quads.push_back(VisualModelImpl::Quad(p, p+1, p+nx+1, p+nx));
+        }
+    visualModel.m_triangles.endEdit();
+    visualModel.m_quads.endEdit();
+
+    visualModel.m_computeTangents.setValue(true);
+}
+
+void moveVertex(StubVisualModelImpl& visualModel, unsigned int i, const component::visualmodel::VisualModelImpl::Coord& offset)
+{
+    (*visualModel.m_positions.beginEdit())[i] += offset;
+    visualModel.m_positions.endEdit();
+}
+
+template <class T>
+void expectVectorsNear(const defaulttype::ResizableExtVector< T >& expected, const defaulttype::ResizableExtVector< T >& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (unsigned int i = 0; i < expected.size(); i++)
+        for (unsigned int c = 0; c < expected[i].size(); c++)
+            EXPECT_NEAR(expected[i][c], actual[i][c], 1e-6) << "index " << i;
+}
+
+TEST( VisualModelImpl_test , checkThatIncrementalNormalsMatchTheFullUpdate )
+{
+    typedef component::visualmodel::VisualModelImpl VisualModelImpl;
+    StubVisualModelImpl incremental, reference;
+    createGridMesh(incremental, 6, 5);
+    createGridMesh(reference, 6, 5);
+    incremental.m_incrementalNormals.setValue(true);
+
+    incremental.computeNormals();
+    incremental.computeTangents();
+    reference.computeNormals();
+    reference.computeTangents();
+    expectVectorsNear(reference.m_vnormals.getValue(), incremental.m_vnormals.getValue());
+    expectVectorsNear(reference.m_vtangents.getValue(), incremental.m_vtangents.getValue());
+
+    // nothing moved: the normals and tangents are left untouched
+    const int normalsCounter = incremental.m_vnormals.getCounter();
+    const int tangentsCounter = incremental.m_vtangents.getCounter();
+    incremental.computeNormals();
+    incremental.computeTangents();
+    EXPECT_EQ(normalsCounter, incremental.m_vnormals.getCounter());
+    EXPECT_EQ(tangentsCounter, incremental.m_vtangents.getCounter());
+
+    // one vertex in the triangles and one in the quads
+    const VisualModelImpl::Coord offset(0.2f, -0.1f, 0.7f);
+    moveVertex(incremental, 3, offset);
+    moveVertex(reference, 3, offset);
+    moveVertex(incremental, 20, offset);
+    moveVertex(reference, 20, offset);
+
+    incremental.computeNormals();
+    incremental.computeTangents();
+    reference.computeNormals();
+    reference.computeTangents();
+    expectVectorsNear(reference.m_vnormals.getValue(), incremental.m_vnormals.getValue());
+    expectVectorsNear(reference.m_vtangents.getValue(), incremental.m_vtangents.getValue());
+    expectVectorsNear(reference.m_vbitangents.getValue(), incremental.m_vbitangents.getValue());
+}
+
 } //sofa
@@ -42,6 +42,7 @@
 #include <sofa/helper/io/MeshOBJ.h>
 #include <sofa/helper/rmath.h>
 #include <sofa/helper/accessor.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <sstream>
 #include <map>
 #include <memory>
@@ -190,6 +191,7 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
     , m_updateNormals   (initData   (&m_updateNormals, true, "updateNormals", "True if normals should be updated at each iteration"))
     , m_computeTangents (initData   (&m_computeTangents, false, "computeTangents", "True if tangents should be computed at startup"))
     , m_updateTangents  (initData   (&m_updateTangents, true, "updateTangents", "True if tangents should be updated at each iteration"))
+    , m_incrementalNormals (initData   (&m_incrementalNormals, false, "incrementalNormals", "True if only the normals and tangents around the vertices which moved since the last update should be updated"))
     , m_handleDynamicTopology (initData   (&m_handleDynamicTopology, true, "handleDynamicTopology", "True if topological changes should be handled"))
     , m_fixMergedUVSeams (initData   (&m_fixMergedUVSeams, true, "fixMergedUVSeams", "True if UV seams should be handled even when duplicate UVs are merged"))
     , m_keepLines (initData   (&m_keepLines, false, "keepLines", "keep and draw lines (false by default)"))
@@ -218,6 +220,11 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
 {
     m_topology = 0;
 
+    m_slotsTrianglesRevision = m_slotsQuadsRevision = m_slotsNormIdxRevision = -1;
+    m_slotsNbVertices = m_slotsNbTriangles = m_slotsNbQuads = 0;
+    m_normalsUpdatedIncrementally = false;
+    m_normalsRevision = m_tangentsRevision = m_tangentsTexCoordsRevision = -1;
+
     //material.setDisplayed(false);
     addAlias(&fileMesh, "filename");
 
@@ -236,6 +243,20 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
 
     m_edges.setAutoLink(false); // disable linking of edges by default
 
+    // read by the rendering, copied to the aspects used by an asynchronous visual loop
+    m_positions     .setVisual(true);
+    m_vnormals      .setVisual(true);
+    m_vertices2     .setVisual(true);
+    m_vtexcoords    .setVisual(true);
+    m_vtangents     .setVisual(true);
+    m_vbitangents   .setVisual(true);
+    m_edges         .setVisual(true);
+    m_triangles     .setVisual(true);
+    m_quads         .setVisual(true);
+    material        .setVisual(true);
+    materials       .setVisual(true);
+    groups          .setVisual(true);
+
     // add one identity matrix
     xforms.resize(1);
 }
@@ -908,116 +929,263 @@ void VisualModelImpl::init()
     updateVisual();
 }
 
-void VisualModelImpl::computeNormals()
+namespace
 {
-    const VecCoord& vertices = getVertices();
-    //const VecCoord& vertices = m_vertices2.getValue();
-    if (vertices.empty() || (!m_updateNormals.getValue() && (m_vnormals.getValue()).size() == (vertices).size())) return;
 
-    const ResizableExtVector<Triangle>& triangles = m_triangles.getValue();
-    const ResizableExtVector<Quad>& quads = m_quads.getValue();
-    const ResizableExtVector<int> &vertNormIdx = m_vertNormIdx.getValue();
+/// Number of vertices or faces processed by a task
+const unsigned int NormalsGrainSize = 1024;
 
-    if (vertNormIdx.empty())
-    {
-        int nbn = (vertices).size();
+/// List the slots of each key in compressed rows, in the order of the faces
+template<class KeyOf>
+void buildSlotAdjacency(helper::vector<unsigned int>& begin, helper::vector<unsigned int>& slots, std::size_t nbKeys, const KeyOf& keyOf,
+                        const ResizableExtVector<VisualModelImpl::Triangle>& triangles, const ResizableExtVector<VisualModelImpl::Quad>& quads)
+{
+    const unsigned int nbTriangles = (unsigned int)triangles.size();
+    begin.assign(nbKeys+1, 0);
+    for (unsigned int i = 0; i < triangles.size(); i++)
+        for (unsigned int j = 0; j < 3; j++)
+            ++begin[keyOf(triangles[i][j])+1];
+    for (unsigned int i = 0; i < quads.size(); i++)
+        for (unsigned int j = 0; j < 4; j++)
+            ++begin[keyOf(quads[i][j])+1];
+    for (std::size_t k = 0; k < nbKeys; k++)
+        begin[k+1] += begin[k];
+
+    slots.resize(begin[nbKeys]);
+    helper::vector<unsigned int> next(begin.begin(), begin.end()-1);
+    for (unsigned int i = 0; i < triangles.size(); i++)
+        for (unsigned int j = 0; j < 3; j++)
+            slots[next[keyOf(triangles[i][j])]++] = i;
+    for (unsigned int i = 0; i < quads.size(); i++)
+        for (unsigned int j = 0; j < 4; j++)
+            slots[next[keyOf(quads[i][j])]++] = nbTriangles + 4*i + j;
+}
 
-        ResizableExtVector<Deriv>& normals = *(m_vnormals.beginEdit());
+/// Face of a slot: the triangles have one slot, the quads four
+inline unsigned int slotFace(unsigned int slot, unsigned int nbTriangles)
+{
+    return slot < nbTriangles ? slot : nbTriangles + (slot - nbTriangles) / 4;
+}
 
-        normals.resize(nbn);
-        for (int i = 0; i < nbn; i++)
-            normals[i].clear();
+/// Returns true if one of the slots belongs to a moved face
+inline bool hasMovedFace(const unsigned int* slot, const unsigned int* end, const helper::vector<char>& movedFaces, unsigned int nbTriangles)
+{
+    for (; slot != end; ++slot)
+        if (movedFaces[slotFace(*slot, nbTriangles)])
+            return true;
+    return false;
+}
 
-        for (unsigned int i = 0; i < triangles.size(); i++)
-        {
-            const Coord& v1 = vertices[triangles[i][0]];
-            const Coord& v2 = vertices[triangles[i][1]];
-            const Coord& v3 = vertices[triangles[i][2]];
-            Coord n = cross(v2-v1, v3-v1);
-
-            normals[triangles[i][0]] += n;
-            normals[triangles[i][1]] += n;
-            normals[triangles[i][2]] += n;
-        }
+} // namespace
 
-        for (unsigned int i = 0; i < quads.size(); i++)
-        {
-            const Coord & v1 = vertices[quads[i][0]];
-            const Coord & v2 = vertices[quads[i][1]];
-            const Coord & v3 = vertices[quads[i][2]];
-            const Coord & v4 = vertices[quads[i][3]];
-            Coord n1 = cross(v2-v1, v4-v1);
-            Coord n2 = cross(v3-v2, v1-v2);
-            Coord n3 = cross(v4-v3, v2-v3);
-            Coord n4 = cross(v1-v4, v3-v4);
-
-            normals[quads[i][0]] += n1;
-            normals[quads[i][1]] += n2;
-            normals[quads[i][2]] += n3;
-            normals[quads[i][3]] += n4;
-        }
+bool VisualModelImpl::updateSlotAdjacency()
+{
+    const ResizableExtVector<Triangle>& triangles = m_triangles.getValue();
+    const ResizableExtVector<Quad>& quads = m_quads.getValue();
+    const ResizableExtVector<int>& vertNormIdx = m_vertNormIdx.getValue();
+    const std::size_t nbVertices = getVertices().size();
 
-        for (unsigned int i = 0; i < normals.size(); i++)
-            normals[i].normalize();
+    if (m_slotsTrianglesRevision == m_triangles.getCounter() && m_slotsQuadsRevision == m_quads.getCounter()
+            && m_slotsNormIdxRevision == m_vertNormIdx.getCounter() && m_slotsNbVertices == nbVertices
+            && m_slotsNbTriangles == triangles.size() && m_slotsNbQuads == quads.size())
+        return false;
 
-        m_vnormals.endEdit();
-    }
-    else
+    buildSlotAdjacency(m_vertexSlots.begin, m_vertexSlots.slots, nbVertices,
+                       [](unsigned int v) { return v; }, triangles, quads);
+    if (!vertNormIdx.empty())
     {
-        vector<Coord> normals;
         int nbn = 0;
         for (unsigned int i = 0; i < vertNormIdx.size(); i++)
         {
             if (vertNormIdx[i] >= nbn)
                 nbn = vertNormIdx[i]+1;
         }
+        buildSlotAdjacency(m_normalSlots.begin, m_normalSlots.slots, nbn,
+                           [&vertNormIdx](unsigned int v) { return (unsigned int)vertNormIdx[v]; }, triangles, quads);
+    }
+    else
+    {
+        m_normalSlots.begin.clear();
+        m_normalSlots.slots.clear();
+    }
 
-        normals.resize(nbn);
-        for (int i = 0; i < nbn; i++)
-            normals[i].clear();
+    m_slotsTrianglesRevision = m_triangles.getCounter();
+    m_slotsQuadsRevision = m_quads.getCounter();
+    m_slotsNormIdxRevision = m_vertNormIdx.getCounter();
+    m_slotsNbVertices = nbVertices;
+    m_slotsNbTriangles = triangles.size();
+    m_slotsNbQuads = quads.size();
+    return true;
+}
 
-        for (unsigned int i = 0; i < triangles.size() ; i++)
+bool VisualModelImpl::findMovedFaces(const VecCoord& vertices)
+{
+    const ResizableExtVector<Triangle>& triangles = m_triangles.getValue();
+    const ResizableExtVector<Quad>& quads = m_quads.getValue();
+    const unsigned int nbTriangles = (unsigned int)triangles.size();
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+
+    m_movedVertices.resize(vertices.size());
+    const unsigned int nbMoved = scheduler->parallel_reduce(0u, (unsigned int)vertices.size(), 0u, [&](unsigned int first, unsigned int last)
+    {
+        unsigned int moved = 0;
+        for (unsigned int i = first; i < last; i++)
         {
-            const Coord & v1 = vertices[triangles[i][0]];
-            const Coord & v2 = vertices[triangles[i][1]];
-            const Coord & v3 = vertices[triangles[i][2]];
-            Coord n = cross(v2-v1, v3-v1);
-
-            normals[vertNormIdx[triangles[i][0]]] += n;
-            normals[vertNormIdx[triangles[i][1]]] += n;
-            normals[vertNormIdx[triangles[i][2]]] += n;
+            m_movedVertices[i] = (vertices[i] != m_normalsLastVertices[i]);
+            if (m_movedVertices[i])
+            {
+                m_normalsLastVertices[i] = vertices[i];
+                ++moved;
+            }
         }
+        return moved;
+    }, [](unsigned int a, unsigned int b) { return a + b; }, NormalsGrainSize);
+    if (!nbMoved)
+        return false;
 
-        for (unsigned int i = 0; i < quads.size() ; i++)
+    m_movedFaces.resize(triangles.size() + quads.size());
+    scheduler->parallel_for(0u, (unsigned int)m_movedFaces.size(), [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i = first; i < last; i++)
         {
-            const Coord & v1 = vertices[quads[i][0]];
-            const Coord & v2 = vertices[quads[i][1]];
-            const Coord & v3 = vertices[quads[i][2]];
-            const Coord & v4 = vertices[quads[i][3]];
-            Coord n1 = cross(v2-v1, v4-v1);
-            Coord n2 = cross(v3-v2, v1-v2);
-            Coord n3 = cross(v4-v3, v2-v3);
-            Coord n4 = cross(v1-v4, v3-v4);
-
-            normals[vertNormIdx[quads[i][0]]] += n1;
-            normals[vertNormIdx[quads[i][1]]] += n2;
-            normals[vertNormIdx[quads[i][2]]] += n3;
-            normals[vertNormIdx[quads[i][3]]] += n4;
+            if (i < nbTriangles)
+            {
+                const Triangle& t = triangles[i];
+                m_movedFaces[i] = m_movedVertices[t[0]] || m_movedVertices[t[1]] || m_movedVertices[t[2]];
+            }
+            else
+            {
+                const Quad& q = quads[i-nbTriangles];
+                m_movedFaces[i] = m_movedVertices[q[0]] || m_movedVertices[q[1]] || m_movedVertices[q[2]] || m_movedVertices[q[3]];
+            }
         }
+    }, NormalsGrainSize);
+    return true;
+}
+
+void VisualModelImpl::computeNormals()
+{
+    m_normalsUpdatedIncrementally = false;
+    const VecCoord& vertices = getVertices();
+    //const VecCoord& vertices = m_vertices2.getValue();
+    if (vertices.empty() || (!m_updateNormals.getValue() && (m_vnormals.getValue()).size() == (vertices).size())) return;
 
-        for (unsigned int i = 0; i < normals.size(); i++)
+    const ResizableExtVector<Triangle>& triangles = m_triangles.getValue();
+    const ResizableExtVector<Quad>& quads = m_quads.getValue();
+    const ResizableExtVector<int> &vertNormIdx = m_vertNormIdx.getValue();
+    const unsigned int nbTriangles = (unsigned int)triangles.size();
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+
+    // the normals can only be updated around the moved vertices if nothing else changed since the last update
+    const bool rebuilt = updateSlotAdjacency();
+    const bool incremental = m_incrementalNormals.getValue() && !rebuilt
+            && m_normalsLastVertices.size() == vertices.size()
+            && m_vnormals.getValue().size() == vertices.size()
+            && m_vnormals.getCounter() == m_normalsRevision;
+    if (incremental)
+    {
+        if (!findMovedFaces(vertices))
         {
-            normals[i].normalize();
+            m_movedNormals.assign(vertices.size(), 0);
+            m_normalsUpdatedIncrementally = true;
+            return;
         }
+    }
+    else if (m_incrementalNormals.getValue())
+    {
+        m_normalsLastVertices.assign(vertices.begin(), vertices.end());
+    }
+    else
+    {
+        m_normalsLastVertices.clear();
+    }
 
-        ResizableExtVector<Deriv>& vnormals = *(m_vnormals.beginEdit());
-        vnormals.resize(vertices.size());
-        for (unsigned int i = 0; i < vertices.size(); i++)
+    // normals of the face corners
+    m_slotNormals.resize(triangles.size() + 4*quads.size());
+    scheduler->parallel_for(0u, (unsigned int)(triangles.size() + quads.size()), [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i = first; i < last; i++)
         {
-            vnormals[i] = normals[vertNormIdx[i]];
+            if (incremental && !m_movedFaces[i])
+                continue;
+            if (i < nbTriangles)
+            {
+                const Coord& v1 = vertices[triangles[i][0]];
+                const Coord& v2 = vertices[triangles[i][1]];
+                const Coord& v3 = vertices[triangles[i][2]];
+                m_slotNormals[i] = cross(v2-v1, v3-v1);
+            }
+            else
+            {
+                const Quad& q = quads[i-nbTriangles];
+                const Coord & v1 = vertices[q[0]];
+                const Coord & v2 = vertices[q[1]];
+                const Coord & v3 = vertices[q[2]];
+                const Coord & v4 = vertices[q[3]];
+                Coord* n = &m_slotNormals[nbTriangles + 4*(i-nbTriangles)];
+                n[0] = cross(v2-v1, v4-v1);
+                n[1] = cross(v3-v2, v1-v2);
+                n[2] = cross(v4-v3, v2-v3);
+                n[3] = cross(v1-v4, v3-v4);
+            }
         }
-        m_vnormals.endEdit();
+    }, NormalsGrainSize);
+
+    // sum the corners of each vertex (or normal index), only the ones around a moved face if incremental
+    const SlotAdjacency& adjacency = vertNormIdx.empty() ? m_vertexSlots : m_normalSlots;
+    const unsigned int nbn = (unsigned int)adjacency.begin.size() - 1;
+    ResizableExtVector<Deriv>& normals = *(m_vnormals.beginEdit());
+    normals.resize(vertices.size());
+    if (!vertNormIdx.empty())
+        m_normalSums.resize(nbn);
+    Coord* sums = vertNormIdx.empty() ? normals.getData() : m_normalSums.data();
+    if (incremental)
+        m_movedNormals.assign(vertNormIdx.empty() ? vertices.size() : nbn, 0);
+
+    scheduler->parallel_for(0u, nbn, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int k = first; k < last; k++)
+        {
+            const unsigned int* slot = adjacency.slots.data() + adjacency.begin[k];
+            const unsigned int* end = adjacency.slots.data() + adjacency.begin[k+1];
+            if (incremental)
+            {
+                if (!hasMovedFace(slot, end, m_movedFaces, nbTriangles))
+                    continue;
+                m_movedNormals[k] = 1;
+            }
+            Coord n;
+            for (; slot != end; ++slot)
+                n += m_slotNormals[*slot];
+            n.normalize();
+            sums[k] = n;
+        }
+    }, NormalsGrainSize);
+
+    if (!vertNormIdx.empty())
+    {
+        helper::vector<char> movedIndices;
+        if (incremental)
+            movedIndices.swap(m_movedNormals);
+        m_movedNormals.assign(incremental ? vertices.size() : 0, 0);
+        scheduler->parallel_for(0u, (unsigned int)vertices.size(), [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int i = first; i < last; i++)
+            {
+                if (incremental)
+                {
+                    if (!movedIndices[vertNormIdx[i]])
+                        continue;
+                    m_movedNormals[i] = 1;
+                }
+                normals[i] = m_normalSums[vertNormIdx[i]];
+            }
+        }, NormalsGrainSize);
     }
+
+    m_vnormals.endEdit();
+    m_normalsRevision = m_vnormals.getCounter();
+    m_normalsUpdatedIncrementally = incremental;
 }
 
 VisualModelImpl::Coord VisualModelImpl::computeTangent(const Coord &v1, const Coord &v2, const Coord &v3,
@@ -1044,90 +1212,122 @@ void VisualModelImpl::computeTangents()
     const ResizableExtVector<Quad>& quads = m_quads.getValue();
     const VecCoord& vertices = getVertices();
     const VecTexCoord& texcoords = m_vtexcoords.getValue();
-    VecCoord& normals = *(m_vnormals.beginEdit());
+    const VecCoord& normals = m_vnormals.getValue();
+    const unsigned int nbTriangles = (unsigned int)triangles.size();
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+
+    updateSlotAdjacency();
+
+    // only the tangents of the vertices whose normal changed are updated if the normals were
+    // updated incrementally and nothing else changed since the last update
+    const bool incremental = m_normalsUpdatedIncrementally
+            && m_vtexcoords.getCounter() == m_tangentsTexCoordsRevision
+            && m_vtangents.getCounter() == m_tangentsRevision
+            && m_vtangents.getValue().size() == vertices.size()
+            && m_vbitangents.getValue().size() == vertices.size()
+            && m_movedNormals.size() == vertices.size();
+    if (incremental && std::find(m_movedNormals.begin(), m_movedNormals.end(), 1) == m_movedNormals.end())
+        return;
+
     VecCoord& tangents = *(m_vtangents.beginEdit());
     VecCoord& bitangents = *(m_vbitangents.beginEdit());
 
     tangents.resize(vertices.size());
     bitangents.resize(vertices.size());
 
-    for (unsigned i = 0; i < vertices.size(); i++)
-    {
-        tangents[i].clear();
-        bitangents[i].clear();
-    }
+    // tangents of the face corners
+    m_slotTangents.resize(triangles.size() + 4*quads.size());
+    m_slotBitangents.resize(m_slotTangents.size());
     const bool fixMergedUVSeams = m_fixMergedUVSeams.getValue();
-    for (unsigned int i = 0; i < triangles.size() ; i++)
+    scheduler->parallel_for(0u, (unsigned int)(triangles.size() + quads.size()), [&](unsigned int first, unsigned int last)
     {
-        const Coord v1 = vertices[triangles[i][0]];
-        const Coord v2 = vertices[triangles[i][1]];
-        const Coord v3 = vertices[triangles[i][2]];
-        TexCoord t1 = texcoords[triangles[i][0]];
-        TexCoord t2 = texcoords[triangles[i][1]];
-        TexCoord t3 = texcoords[triangles[i][2]];
-        if (fixMergedUVSeams)
+        for (unsigned int i = first; i < last; i++)
         {
-            for (unsigned int j=0; j<t1.size(); ++j)
+            if (incremental && !m_movedFaces[i])
+                continue;
+            if (i < nbTriangles)
             {
-                t2[j] += helper::rnear(t1[j]-t2[j]);
-                t3[j] += helper::rnear(t1[j]-t3[j]);
+                const Coord v1 = vertices[triangles[i][0]];
+                const Coord v2 = vertices[triangles[i][1]];
+                const Coord v3 = vertices[triangles[i][2]];
+                TexCoord t1 = texcoords[triangles[i][0]];
+                TexCoord t2 = texcoords[triangles[i][1]];
+                TexCoord t3 = texcoords[triangles[i][2]];
+                if (fixMergedUVSeams)
+                {
+                    for (unsigned int j=0; j<t1.size(); ++j)
+                    {
+                        t2[j] += helper::rnear(t1[j]-t2[j]);
+                        t3[j] += helper::rnear(t1[j]-t3[j]);
+                    }
+                }
+                m_slotTangents[i] = computeTangent(v1, v2, v3, t1, t2, t3);
+                m_slotBitangents[i] = computeBitangent(v1, v2, v3, t1, t2, t3);
+            }
+            else
+            {
+                const Quad& q = quads[i-nbTriangles];
+                const Coord & v1 = vertices[q[0]];
+                const Coord & v2 = vertices[q[1]];
+                const Coord & v3 = vertices[q[2]];
+                const Coord & v4 = vertices[q[3]];
+                const TexCoord t1 = texcoords[q[0]];
+                const TexCoord t2 = texcoords[q[1]];
+                const TexCoord t3 = texcoords[q[2]];
+                const TexCoord t4 = texcoords[q[3]];
+
+                // Too many options how to split a quad into two triangles...
+                Coord t123 = computeTangent  (v1, v2, v3, t1, t2, t3);
+                Coord b123 = computeBitangent(v1, v2, v2, t1, t2, t3);
+
+                Coord t234 = computeTangent  (v2, v3, v4, t2, t3, t4);
+                Coord b234 = computeBitangent(v2, v3, v4, t2, t3, t4);
+
+                Coord t341 = computeTangent  (v3, v4, v1, t3, t4, t1);
+                Coord b341 = computeBitangent(v3, v4, v1, t3, t4, t1);
+
+                Coord t412 = computeTangent  (v4, v1, v2, t4, t1, t2);
+                Coord b412 = computeBitangent(v4, v1, v2, t4, t1, t2);
+
+                Coord* t = &m_slotTangents[nbTriangles + 4*(i-nbTriangles)];
+                Coord* b = &m_slotBitangents[nbTriangles + 4*(i-nbTriangles)];
+                t[0] = t123        + t341 + t412;
+                b[0] = b123        + b341 + b412;
+                t[1] = t123 + t234        + t412;
+                b[1] = b123 + b234        + b412;
+                t[2] = t123 + t234 + t341;
+                b[2] = b123 + b234 + b341;
+                t[3] =        t234 + t341 + t412;
+                b[3] =        b234 + b341 + b412;
             }
         }
-        Coord t = computeTangent(v1, v2, v3, t1, t2, t3);
-        Coord b = computeBitangent(v1, v2, v3, t1, t2, t3);
-
-        tangents[triangles[i][0]] += t;
-        tangents[triangles[i][1]] += t;
-        tangents[triangles[i][2]] += t;
-        bitangents[triangles[i][0]] += b;
-        bitangents[triangles[i][1]] += b;
-        bitangents[triangles[i][2]] += b;
-    }
+    }, NormalsGrainSize);
 
-    for (unsigned int i = 0; i < quads.size() ; i++)
-    {
-        const Coord & v1 = vertices[quads[i][0]];
-        const Coord & v2 = vertices[quads[i][1]];
-        const Coord & v3 = vertices[quads[i][2]];
-        const Coord & v4 = vertices[quads[i][3]];
-        const TexCoord t1 = texcoords[quads[i][0]];
-        const TexCoord t2 = texcoords[quads[i][1]];
-        const TexCoord t3 = texcoords[quads[i][2]];
-        const TexCoord t4 = texcoords[quads[i][3]];
-
-        // Too many options how to split a quad into two triangles...
-        Coord t123 = computeTangent  (v1, v2, v3, t1, t2, t3);
-        Coord b123 = computeBitangent(v1, v2, v2, t1, t2, t3);
-
-        Coord t234 = computeTangent  (v2, v3, v4, t2, t3, t4);
-        Coord b234 = computeBitangent(v2, v3, v4, t2, t3, t4);
-
-        Coord t341 = computeTangent  (v3, v4, v1, t3, t4, t1);
-        Coord b341 = computeBitangent(v3, v4, v1, t3, t4, t1);
-
-        Coord t412 = computeTangent  (v4, v1, v2, t4, t1, t2);
-        Coord b412 = computeBitangent(v4, v1, v2, t4, t1, t2);
-
-        tangents  [quads[i][0]] += t123        + t341 + t412;
-        bitangents[quads[i][0]] += b123        + b341 + b412;
-        tangents  [quads[i][1]] += t123 + t234        + t412;
-        bitangents[quads[i][1]] += b123 + b234        + b412;
-        tangents  [quads[i][2]] += t123 + t234 + t341;
-        bitangents[quads[i][2]] += b123 + b234 + b341;
-        tangents  [quads[i][3]] +=        t234 + t341 + t412;
-        bitangents[quads[i][3]] +=        b234 + b341 + b412;
-    }
-    for (unsigned int i = 0; i < vertices.size(); i++)
+    // sum the corners of each vertex and orthogonalize them with its normal
+    scheduler->parallel_for(0u, (unsigned int)vertices.size(), [&](unsigned int first, unsigned int last)
     {
-        Coord n = normals[i];
-        Coord& t = tangents[i];
-        Coord& b = bitangents[i];
+        for (unsigned int i = first; i < last; i++)
+        {
+            if (incremental && !m_movedNormals[i])
+                continue;
+            Coord t, b;
+            for (unsigned int s = m_vertexSlots.begin[i]; s < m_vertexSlots.begin[i+1]; s++)
+            {
+                t += m_slotTangents[m_vertexSlots.slots[s]];
+                b += m_slotBitangents[m_vertexSlots.slots[s]];
+            }
+            const Coord& n = normals[i];
+            b = sofa::defaulttype::cross(n, t.normalized());
+            t = sofa::defaulttype::cross(b, n);
+            tangents[i] = t;
+            bitangents[i] = b;
+        }
+    }, NormalsGrainSize);
 
-        b = sofa::defaulttype::cross(n, t.normalized());
-        t = sofa::defaulttype::cross(b, n);
-    }
     m_vtangents.endEdit();
     m_vbitangents.endEdit();
+    m_tangentsRevision = m_vtangents.getCounter();
+    m_tangentsTexCoordsRevision = m_vtexcoords.getCounter();
 }
 
 void VisualModelImpl::computeBBox(const core::ExecParams* params, bool)
@@ -1270,8 +1470,11 @@ void VisualModelImpl::computePositions()
         VecCoord& vertices = *(m_vertices2.beginEdit());
         const VecCoord& positions = this->m_positions.getValue();
 
-        for (unsigned int i=0 ; i < vertices.size(); ++i)
-            vertices[i] = positions[vertPosIdx[i]];
+        simulation::TaskScheduler::getInstance()->parallel_for(0u, (unsigned int)vertices.size(), [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int i = first; i < last; ++i)
+                vertices[i] = positions[vertPosIdx[i]];
+        }, NormalsGrainSize);
 
         m_vertices2.endEdit();
     }
@@ -111,6 +111,7 @@ public:
     Data<bool> m_updateNormals; ///< True if normals should be updated at each iteration
     Data<bool> m_computeTangents; ///< True if tangents should be computed at startup
     Data<bool> m_updateTangents; ///< True if tangents should be updated at each iteration
+    Data<bool> m_incrementalNormals; ///< True if only the normals and tangents around the vertices which moved should be updated
     Data<bool> m_handleDynamicTopology; ///< True if topological changes should be handled
     Data<bool> m_fixMergedUVSeams; ///< True if UV seams should be handled even when duplicate UVs are merged
     Data<bool> m_keepLines; ///< keep and draw lines (false by default)
@@ -138,6 +139,44 @@ public:
     template<class VecType>
     void addTopoHandler(topology::PointData<VecType>* data, int algo = 0);
 
+    /// @name Normals and tangents update
+    /// The faces give one value per corner (slot): a triangle has one slot shared by its 3 corners, a quad
+    /// has 4 slots. The slots of each vertex (and of each normal index with m_vertNormIdx) are listed in
+    /// compressed rows, in the order of the faces. The slots are computed face by face, then summed vertex
+    /// by vertex, both in parallel and in the order of a face by face accumulation.
+    /// @{
+
+    /// Slots of each key (vertex or normal index): slots[begin[k]] to slots[begin[k+1]-1]
+    struct SlotAdjacency
+    {
+        helper::vector<unsigned int> begin;
+        helper::vector<unsigned int> slots;
+    };
+    SlotAdjacency m_vertexSlots;
+    SlotAdjacency m_normalSlots; ///< only with m_vertNormIdx
+    /// Revisions of the faces the adjacency was built from
+    int m_slotsTrianglesRevision, m_slotsQuadsRevision, m_slotsNormIdxRevision;
+    std::size_t m_slotsNbVertices, m_slotsNbTriangles, m_slotsNbQuads;
+
+    helper::vector<Coord> m_slotNormals;
+    helper::vector<Coord> m_slotTangents;
+    helper::vector<Coord> m_slotBitangents;
+    helper::vector<Coord> m_normalSums; ///< normals per normal index, with m_vertNormIdx
+
+    /// With m_incrementalNormals: the vertices of the last update, and the faces and normals changed by it
+    helper::vector<Coord> m_normalsLastVertices;
+    helper::vector<char> m_movedVertices;
+    helper::vector<char> m_movedFaces;
+    helper::vector<char> m_movedNormals;
+    bool m_normalsUpdatedIncrementally; ///< true if the last computeNormals only updated the vertices in m_movedNormals
+    int m_normalsRevision, m_tangentsRevision, m_tangentsTexCoordsRevision;
+
+    /// Build the slot adjacency if the faces changed since the last call, returning true if it did
+    bool updateSlotAdjacency();
+    /// Flag the moved vertices and their faces, returning false if no vertex moved since the last update
+    bool findMovedFaces(const VecCoord& vertices);
+    /// @}
+
 public:
 
     sofa::core::objectmodel::DataFileName fileMesh;
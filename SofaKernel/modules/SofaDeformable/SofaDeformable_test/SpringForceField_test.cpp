@@ -0,0 +1,239 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaDeformable/SpringForceField.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaTest/Sofa_test.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <set>
+
+namespace sofa {
+
+/// Exposes the structure-of-arrays storage of SpringForceField used by the parallel mode
+template<class DataTypes>
+class ColoredSpringForceField : public component::interactionforcefield::SpringForceField<DataTypes>
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(ColoredSpringForceField, DataTypes), SOFA_TEMPLATE(component::interactionforcefield::SpringForceField, DataTypes));
+    typedef typename Inherit1::MechanicalState MechanicalState;
+    typedef typename Inherit1::Real Real;
+
+    using Inherit1::updateSpringStorage;
+    const helper::vector<unsigned int>& getColorBegin() const { return this->m_soaColorBegin; }
+    const helper::vector<unsigned int>& getSortedSprings() const { return this->m_soaSpring; }
+    Real getStoredPotentialEnergy() const { return this->m_potentialEnergy; }
+    bool checkStoredSpring(unsigned int s) const
+    {
+        const typename Inherit1::Spring& spring = this->springs.getValue()[this->m_soaSpring[s]];
+        return this->m_soaM1[s] == (unsigned int)spring.m1 && this->m_soaM2[s] == (unsigned int)spring.m2
+                && this->m_soaKs[s] == spring.ks && this->m_soaKd[s] == spring.kd && this->m_soaRestLength[s] == spring.initpos
+                && ((this->m_soaFlags[s] & Inherit1::SpringEnabled) != 0) == spring.enabled
+                && ((this->m_soaFlags[s] & Inherit1::SpringElongationOnly) != 0) == spring.elongationOnly;
+    }
+
+protected:
+    ColoredSpringForceField(MechanicalState* object1, MechanicalState* object2) : Inherit1(object1, object2) {}
+};
+
+/**  Test suite for the parallel mode of SpringForceField: the colored structure-of-arrays storage
+  *  built by updateSpringStorage, and the colored addForce compared to the sequential one.
+  */
+template <typename _DataTypes>
+struct SpringForceField_test : public Sofa_test<typename _DataTypes::Real>
+{
+    typedef _DataTypes DataTypes;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef typename DataTypes::Real Real;
+    typedef ColoredSpringForceField<DataTypes> Spring;
+    typedef component::container::MechanicalObject<DataTypes> DOF;
+
+    typename DOF::SPtr dof1, dof2;
+    VecCoord x1, x2;
+    VecDeriv v1, v2;
+
+    SpringForceField_test()
+    {
+        dof1 = core::objectmodel::New<DOF>();
+        dof2 = core::objectmodel::New<DOF>();
+    }
+
+    /// n^3 particles (n^2 in dimension 2), deformed, with a velocity
+    static void createGrid( int n, Real shift, VecCoord& x, VecDeriv& v )
+    {
+        const int nz = DataTypes::spatial_dimensions > 2 ? n : 1;
+        const int nbParticles = n*n*nz;
+        x.resize(nbParticles);
+        v.resize(nbParticles);
+        for (int i=0; i<nbParticles; ++i)
+        {
+            const int px = i%n, py = (i/n)%n, pz = i/(n*n);
+            DataTypes::set( x[i], px+shift+0.1*std::sin(1.7*i), py+0.1*std::cos(2.3*i), pz+0.1*std::sin(0.3*i+1) );
+            DataTypes::set( v[i], 0.2*std::cos(0.7*i+shift), 0.1*std::sin(1.1*i), 0.3*std::cos(0.5*i+2) );
+        }
+    }
+
+    /// Springs between each particle of the first grid and its forward neighbors in the second grid,
+    /// which is the first one itself when sameState is set. A few springs are disabled and a few are
+    /// elongation-only.
+    typename Spring::SPtr createSprings( int n, bool sameState, bool parallel )
+    {
+        createGrid(n, 0, x1, v1);
+        if (sameState)
+        {
+            x2 = x1;
+            v2 = v1;
+        }
+        else
+            createGrid(n, 0.5, x2, v2);
+
+        typename Spring::SPtr spring = core::objectmodel::New<Spring>(dof1.get(), sameState ? dof1.get() : dof2.get());
+        spring->d_parallel.setValue(parallel);
+        const int nz = DataTypes::spatial_dimensions > 2 ? n : 1;
+        const int neighbors[7][3] = { {1,0,0}, {0,1,0}, {1,1,0}, {0,0,1}, {1,0,1}, {0,1,1}, {1,1,1} };
+        for (int i=0; i<(int)x1.size(); ++i)
+        {
+            const int px = i%n, py = (i/n)%n, pz = i/(n*n);
+            for (int k=0; k<7; ++k)
+            {
+                const int qx = px+neighbors[k][0], qy = py+neighbors[k][1], qz = pz+neighbors[k][2];
+                if (qx >= n || qy >= n || qz >= nz) continue;
+                const int j = qx + n*(qy + n*qz);
+                const int springIndex = (int)spring->getSprings().size();
+                const SReal restLength = 0.9*std::sqrt((SReal)(neighbors[k][0]+neighbors[k][1]+neighbors[k][2]));
+                spring->addSpring( typename Spring::Spring(i, j, 100.0+springIndex%5, 0.5, restLength, springIndex%11==0, springIndex%13!=0) );
+            }
+        }
+        return spring;
+    }
+
+    /// the springs of a parallel color share no particle, and the storage holds each spring once
+    void checkColoring( Spring* spring, bool sameState )
+    {
+        spring->updateSpringStorage();
+        const helper::vector<unsigned int>& colorBegin = spring->getColorBegin();
+        const helper::vector<unsigned int>& sorted = spring->getSortedSprings();
+        const std::size_t nbSprings = spring->getSprings().size();
+        ASSERT_EQ(nbSprings, sorted.size());
+        ASSERT_LT(1u, colorBegin.size());
+        ASSERT_EQ(0u, colorBegin.front());
+        ASSERT_LE(colorBegin.back(), nbSprings);
+
+        std::set<unsigned int> springSet(sorted.begin(), sorted.end());
+        EXPECT_EQ(nbSprings, springSet.size());
+        for (unsigned int s=0; s<sorted.size(); ++s)
+            EXPECT_TRUE(spring->checkStoredSpring(s)) << "spring " << s;
+
+        const unsigned int offset2 = sameState ? 0 : (unsigned int)x1.size();
+        for (unsigned int c=0; c+1<colorBegin.size(); ++c)
+        {
+            std::set<unsigned int> particles;
+            for (unsigned int s=colorBegin[c]; s<colorBegin[c+1]; ++s)
+            {
+                const typename Spring::Spring& sp = spring->getSprings()[sorted[s]];
+                EXPECT_TRUE(particles.insert(sp.m1).second) << "color " << c << ", spring " << sorted[s];
+                EXPECT_TRUE(particles.insert(offset2+sp.m2).second) << "color " << c << ", spring " << sorted[s];
+            }
+        }
+    }
+
+    /// the parallel mode gives the same forces and potential energy as the sequential one
+    void checkParallelForces( bool sameState )
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const unsigned int threadCount = scheduler->getThreadCount();
+        scheduler->init(4);
+
+        // large enough for the colors to be processed in parallel
+        const int n = DataTypes::spatial_dimensions > 2 ? 20 : 60;
+        typename Spring::SPtr springs[2];
+        for (int parallel=0; parallel<2; ++parallel)
+            springs[parallel] = createSprings(n, sameState, parallel!=0);
+        checkColoring(springs[1].get(), sameState);
+
+        core::MechanicalParams mparams;
+        VecDeriv force1[2], force2[2];
+        Real energy[2];
+        // twice: the springs added between both evaluations must rebuild the storage
+        for (int pass=0; pass<2; ++pass)
+        {
+            for (int parallel=0; parallel<2; ++parallel)
+            {
+                core::objectmodel::Data<VecCoord> dataX1, dataX2;
+                core::objectmodel::Data<VecDeriv> dataV1, dataV2, dataF1, dataF2;
+                dataX1.setValue(x1);
+                dataX2.setValue(x2);
+                dataV1.setValue(v1);
+                dataV2.setValue(v2);
+                if (sameState)
+                {
+                    springs[parallel]->addForce(&mparams, dataF1, dataF1, dataX1, dataX1, dataV1, dataV1);
+                    dataF2.setValue(dataF1.getValue());
+                }
+                else
+                    springs[parallel]->addForce(&mparams, dataF1, dataF2, dataX1, dataX2, dataV1, dataV2);
+                force1[parallel] = dataF1.getValue();
+                force2[parallel] = dataF2.getValue();
+                energy[parallel] = springs[parallel]->getStoredPotentialEnergy();
+            }
+
+            ASSERT_EQ(force1[0].size(), x1.size());
+            ASSERT_EQ(force1[1].size(), x1.size());
+            ASSERT_EQ(force2[1].size(), x2.size());
+            EXPECT_LT( this->vectorMaxDiff(force1[0],force1[1]), this->epsilon()*1e4 ) << "pass " << pass;
+            EXPECT_LT( this->vectorMaxDiff(force2[0],force2[1]), this->epsilon()*1e4 ) << "pass " << pass;
+            EXPECT_LT( std::abs(energy[0]-energy[1]), this->epsilon()*1e4*std::max((Real)1, std::abs(energy[0])) ) << "pass " << pass;
+
+            for (int parallel=0; parallel<2; ++parallel)
+            {
+                springs[parallel]->addSpring(0, (int)x2.size()-1, 50, 0.2, 1.0);
+                springs[parallel]->addSpring((int)x1.size()-1, 0, 50, 0.2, 1.0);
+            }
+        }
+        checkColoring(springs[1].get(), sameState);
+
+        scheduler->init(threadCount);
+    }
+};
+
+// ========= Define the list of types to instanciate.
+typedef testing::Types<
+defaulttype::Vec2Types,  // 2D
+defaulttype::Vec3Types   // 3D
+> DataTypes; // the types to instanciate.
+
+// ========= Tests to run for each instanciated type
+TYPED_TEST_CASE(SpringForceField_test, DataTypes);
+
+// springs internal to a state
+TYPED_TEST( SpringForceField_test , parallelSameState )
+{
+    this->checkParallelForces(true);
+}
+
+// springs between two states
+TYPED_TEST( SpringForceField_test , parallelTwoStates )
+{
+    this->checkParallelForces(false);
+}
+
+} // namespace sofa
@@ -24,6 +24,8 @@
 #include <sofa/defaulttype/RigidTypes.h>
 #include <SofaImplicitOdeSolver/EulerImplicitSolver.h>
 #include <SofaBaseLinearSolver/CGLinearSolver.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/helper/system/thread/CTime.h>
 
 namespace sofa {
 
@@ -198,6 +200,119 @@ struct StiffSpringForceField_test : public ForceField_test<_StiffSpringForceFiel
         ASSERT_TRUE( this->vectorMaxDiff(fc,actualfc)< this->errorMax*this->epsilon() );
     }
 
+    /** A regular grid of n^3 particles (n^2 in dimension 2), each one linked to its forward neighbors,
+     *  deformed, with a velocity, a few springs disabled and a few elongation-only springs.
+     */
+    typename Spring::SPtr createGridSprings( int n, bool parallel, VecCoord& x, VecDeriv& v, VecDeriv& dx )
+    {
+        const int nz = DataTypes::spatial_dimensions > 2 ? n : 1;
+        const int nbParticles = n*n*nz;
+        x.resize(nbParticles);
+        v.resize(nbParticles);
+        dx.resize(nbParticles);
+        for (int i=0; i<nbParticles; ++i)
+        {
+            const int px = i%n, py = (i/n)%n, pz = i/(n*n);
+            DataTypes::set( x[i], px+0.1*std::sin(1.7*i), py+0.1*std::cos(2.3*i), pz+0.1*std::sin(0.3*i+1) );
+            DataTypes::set( v[i], 0.2*std::cos(0.7*i), 0.1*std::sin(1.1*i), 0.3*std::cos(0.5*i+2) );
+            DataTypes::set( dx[i], 0.01*std::sin(0.9*i+3), 0.02*std::cos(1.3*i), 0.01*std::sin(2.1*i) );
+        }
+
+        typename Spring::SPtr spring = sofa::core::objectmodel::New<Spring>(this->dof.get(), this->dof.get());
+        spring->d_parallel.setValue(parallel);
+        const int neighbors[7][3] = { {1,0,0}, {0,1,0}, {1,1,0}, {0,0,1}, {1,0,1}, {0,1,1}, {1,1,1} };
+        for (int i=0; i<nbParticles; ++i)
+        {
+            const int px = i%n, py = (i/n)%n, pz = i/(n*n);
+            for (int k=0; k<7; ++k)
+            {
+                const int qx = px+neighbors[k][0], qy = py+neighbors[k][1], qz = pz+neighbors[k][2];
+                if (qx >= n || qy >= n || qz >= nz) continue;
+                const int j = qx + n*(qy + n*qz);
+                const int springIndex = (int)spring->getSprings().size();
+                const SReal restLength = 0.9*std::sqrt((SReal)(neighbors[k][0]+neighbors[k][1]+neighbors[k][2]));
+                spring->addSpring( typename Spring::Spring(i, j, 100.0+springIndex%5, 0.5, restLength, springIndex%11==0, springIndex%13!=0) );
+            }
+        }
+        return spring;
+    }
+
+    /// the parallel mode gives the same forces and force changes as the sequential one
+    void checkParallelGrid()
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const unsigned int threadCount = scheduler->getThreadCount();
+        scheduler->init(4);
+
+        VecCoord x;
+        VecDeriv v, dx;
+        typename Spring::SPtr springs[2];
+        for (int parallel=0; parallel<2; ++parallel)
+            springs[parallel] = createGridSprings(20, parallel!=0, x, v, dx);
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+        VecDeriv force[2], dforce[2];
+        for (int parallel=0; parallel<2; ++parallel)
+        {
+            core::objectmodel::Data<VecCoord> dataX;
+            core::objectmodel::Data<VecDeriv> dataV, dataF, dataDx, dataDf;
+            dataX.setValue(x);
+            dataV.setValue(v);
+            dataDx.setValue(dx);
+            springs[parallel]->addForce(&mparams, dataF, dataF, dataX, dataX, dataV, dataV);
+            springs[parallel]->addDForce(&mparams, dataDf, dataDf, dataDx, dataDx);
+            force[parallel] = dataF.getValue();
+            dforce[parallel] = dataDf.getValue();
+        }
+
+        scheduler->init(threadCount);
+
+        ASSERT_EQ(force[0].size(), x.size());
+        ASSERT_EQ(force[1].size(), x.size());
+        EXPECT_LT( this->vectorMaxDiff(force[0],force[1]), this->errorMax*this->epsilon()*100 );
+        EXPECT_LT( this->vectorMaxDiff(dforce[0],dforce[1]), this->errorMax*this->epsilon()*100 );
+    }
+
+    /// compare the sequential and the parallel modes on a regular grid
+    void benchmarkGrid( int n, int nbIterations )
+    {
+        VecCoord x;
+        VecDeriv v, dx;
+        typename Spring::SPtr springs[2];
+        for (int parallel=0; parallel<2; ++parallel)
+            springs[parallel] = createGridSprings(n, parallel!=0, x, v, dx);
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+        core::objectmodel::Data<VecCoord> dataX;
+        core::objectmodel::Data<VecDeriv> dataV, dataF, dataDx, dataDf;
+        dataX.setValue(x);
+        dataV.setValue(v);
+        dataDx.setValue(dx);
+
+        using helper::system::thread::CTime;
+        using helper::system::thread::ctime_t;
+        double time[2];
+        for (int parallel=0; parallel<2; ++parallel)
+        {
+            // the first evaluation builds the structure-of-arrays storage
+            springs[parallel]->addForce(&mparams, dataF, dataF, dataX, dataX, dataV, dataV);
+
+            const ctime_t start = CTime::getRefTime();
+            for (int it=0; it<nbIterations; ++it)
+            {
+                springs[parallel]->addForce(&mparams, dataF, dataF, dataX, dataX, dataV, dataV);
+                springs[parallel]->addDForce(&mparams, dataDf, dataDf, dataDx, dataDx);
+            }
+            time[parallel] = (double)(CTime::getRefTime()-start) / (double)CTime::getRefTicksPerSec() / nbIterations;
+        }
+
+        std::cout << springs[0]->getSprings().size() << " springs on "
+                  << simulation::TaskScheduler::getInstance()->getThreadCount() << " threads, addForce+addDForce: "
+                  << 1000*time[0] << " ms sequential, " << 1000*time[1] << " ms parallel" << std::endl;
+    }
+
     ///@}
 };
 
@@ -286,4 +401,39 @@ TYPED_TEST( StiffSpringForceField_test , extension_in_parent_and_child )
 }
 
 
+// same extension, computed by the parallel mode
+TYPED_TEST( StiffSpringForceField_test , extension_parallel )
+{
+    this->debug = false;
+
+    SReal
+            k = 1.0,  // stiffness
+            d = 0.1,  // damping ratio
+            l0 = 1.0; // rest length
+
+    typename TestFixture::Vec3
+            x0(0,0,0), // position of the first particle
+            v0(0,0,0), // velocity of the first particle
+            x1(2,0,0), // position of the second particle
+            v1(0,0,0), // velocity of the second particle
+            f0(1,0,0); // expected force on the first particle
+
+    this->force->d_parallel.setValue(true);
+    this->test_2particles(k,d,l0, x0,v0, x1,v1, f0);
+}
+
+// parallel and sequential modes on a deformed grid
+TYPED_TEST( StiffSpringForceField_test , parallelGrid )
+{
+    this->checkParallelGrid();
+}
+
+// timings of the parallel and sequential modes on a regular grid: no check, run it explicitly with
+// --gtest_also_run_disabled_tests
+TYPED_TEST( StiffSpringForceField_test , DISABLED_benchmarkGrid )
+{
+    this->benchmarkGrid(20, 10);
+}
+
+
 } // namespace sofa
@@ -118,6 +118,7 @@ public:
     Data<float> showArrowSize; ///< size of the axis
     Data<int> drawMode;             ///Draw Mode: 0=Line - 1=Cylinder - 2=Arrow
     Data<sofa::helper::vector<Spring> > springs; ///< pairs of indices, stiffness, damping, rest length
+    Data<bool> d_parallel; ///< accumulate the spring forces in parallel on the task scheduler, the springs being colored so that springs of the same color share no particle
 
 protected:
     core::objectmodel::DataFileName fileSprings;
@@ -130,6 +131,25 @@ protected:
     SpringForceFieldInternalData<DataTypes> data;
     friend class SpringForceFieldInternalData<DataTypes>;
 
+    /// @name Structure-of-arrays storage of the springs, used by the parallel mode
+    /// The springs are sorted by color: two springs of the same color share no particle, so the forces of
+    /// a color are accumulated concurrently without lock nor per-thread buffer, and the result does not
+    /// depend on the number of threads. The colors holding too few springs to be worth a parallel loop are
+    /// gathered at the end of the storage and processed sequentially.
+    /// @{
+    enum { SpringEnabled=1, SpringElongationOnly=2 };
+    helper::vector<unsigned int> m_soaSpring;         ///< index of the spring in springs
+    helper::vector<unsigned int> m_soaM1, m_soaM2;    ///< extremities of the spring
+    helper::vector<Real> m_soaKs, m_soaKd, m_soaRestLength;
+    helper::vector<unsigned char> m_soaFlags;         ///< SpringEnabled, SpringElongationOnly
+    helper::vector<unsigned int> m_soaColorBegin;     ///< first spring of each parallel color, plus the first sequential spring
+    int m_soaCounter;                                 ///< counter of springs when the storage was built
+    bool m_soaSameState;                              ///< whether the storage was built with mstate1 == mstate2
+
+    /// Rebuild the coloring and the structure-of-arrays storage if springs changed
+    void updateSpringStorage();
+    /// @}
+
     virtual void addSpringForce(Real& potentialEnergy, VecDeriv& f1, const VecCoord& p1, const VecDeriv& v1, VecDeriv& f2, const VecCoord& p2, const VecDeriv& v2, int /*i*/, const Spring& spring);
 
 
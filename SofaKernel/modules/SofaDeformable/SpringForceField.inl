@@ -32,6 +32,7 @@
 #include <sofa/simulation/Simulation.h>
 #include <sofa/helper/io/MassSpringLoader.h>
 #include <sofa/helper/system/config.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <cassert>
 #include <iostream>
 #include <fstream>
@@ -53,7 +54,10 @@ SpringForceField<DataTypes>::SpringForceField(MechanicalState* mstate1, Mechanic
     , showArrowSize(initData(&showArrowSize,0.01f,"showArrowSize","size of the axis"))
     , drawMode(initData(&drawMode,0,"drawMode","The way springs will be drawn:\n- 0: Line\n- 1:Cylinder\n- 2: Arrow"))
     , springs(initData(&springs,"spring","pairs of indices, stiffness, damping, rest length"))
+    , d_parallel(initData(&d_parallel,false,"parallel","accumulate the spring forces in parallel on the task scheduler, the springs being colored so that springs of the same color share no particle"))
     , maskInUse(false)
+    , m_soaCounter(-1)
+    , m_soaSameState(false)
 {
 }
 
@@ -64,8 +68,11 @@ SpringForceField<DataTypes>::SpringForceField(SReal _ks, SReal _kd)
     , showArrowSize(initData(&showArrowSize,0.01f,"showArrowSize","size of the axis"))
     , drawMode(initData(&drawMode,0,"drawMode","The way springs will be drawn:\n- 0: Line\n- 1:Cylinder\n- 2: Arrow"))
     , springs(initData(&springs,"spring","pairs of indices, stiffness, damping, rest length"))
+    , d_parallel(initData(&d_parallel,false,"parallel","accumulate the spring forces in parallel on the task scheduler, the springs being colored so that springs of the same color share no particle"))
     , fileSprings(initData(&fileSprings, "fileSprings", "File describing the springs"))
     , maskInUse(false)
+    , m_soaCounter(-1)
+    , m_soaSameState(false)
 {
     this->addAlias(&fileSprings, "filename");
 }
@@ -119,6 +126,119 @@ void SpringForceField<DataTypes>::init()
     this->Inherit::init();
 }
 
+template <class DataTypes>
+void SpringForceField<DataTypes>::updateSpringStorage()
+{
+    const bool sameState = (this->mstate1 == this->mstate2);
+    if (m_soaCounter == springs.getCounter() && m_soaSameState == sameState)
+        return;
+    m_soaCounter = springs.getCounter();
+    m_soaSameState = sameState;
+
+    const helper::vector<Spring>& springs = this->springs.getValue();
+    const unsigned int nbSprings = springs.size();
+
+    // particles of both states in a single index space, shared when the springs are internal to one state
+    unsigned int nbParticles1 = 0, nbParticles2 = 0;
+    for (unsigned int i=0; i<nbSprings; ++i)
+    {
+        nbParticles1 = std::max(nbParticles1, (unsigned int)springs[i].m1+1);
+        nbParticles2 = std::max(nbParticles2, (unsigned int)springs[i].m2+1);
+    }
+    const unsigned int offset2 = sameState ? 0 : nbParticles1;
+    const unsigned int nbParticles = sameState ? std::max(nbParticles1, nbParticles2) : nbParticles1+nbParticles2;
+
+    // springs of each particle
+    helper::vector<unsigned int> particleBegin, particleSprings;
+    particleBegin.resize(nbParticles+1, 0);
+    for (unsigned int i=0; i<nbSprings; ++i)
+    {
+        ++particleBegin[springs[i].m1+1];
+        ++particleBegin[offset2+springs[i].m2+1];
+    }
+    for (unsigned int p=0; p<nbParticles; ++p)
+        particleBegin[p+1] += particleBegin[p];
+    particleSprings.resize(particleBegin[nbParticles]);
+    {
+        helper::vector<unsigned int> fill(particleBegin.begin(), particleBegin.end()-1);
+        for (unsigned int i=0; i<nbSprings; ++i)
+        {
+            particleSprings[fill[springs[i].m1]++] = i;
+            particleSprings[fill[offset2+springs[i].m2]++] = i;
+        }
+    }
+
+    // greedy coloring: each spring takes the first color not used by the springs sharing one of its particles
+    helper::vector<int> color;
+    color.resize(nbSprings, -1);
+    helper::vector<unsigned int> colorStamp;
+    for (unsigned int i=0; i<nbSprings; ++i)
+    {
+        const unsigned int particles[2] = { (unsigned int)springs[i].m1, offset2+springs[i].m2 };
+        for (unsigned int p=0; p<2; ++p)
+        {
+            for (unsigned int n=particleBegin[particles[p]]; n<particleBegin[particles[p]+1]; ++n)
+            {
+                const int c = color[particleSprings[n]];
+                if (c >= 0) colorStamp[c] = i+1;
+            }
+        }
+        unsigned int c = 0;
+        while (c < colorStamp.size() && colorStamp[c] == i+1) ++c;
+        if (c == colorStamp.size()) colorStamp.push_back(0);
+        color[i] = c;
+    }
+    const unsigned int nbColors = colorStamp.size();
+
+    // the large colors first, then the small ones, which are processed sequentially
+    const unsigned int minParallelColorSize = 256;
+    helper::vector<unsigned int> colorSize;
+    colorSize.resize(nbColors, 0);
+    for (unsigned int i=0; i<nbSprings; ++i)
+        ++colorSize[color[i]];
+    helper::vector<unsigned int> colorFill;
+    colorFill.resize(nbColors, 0);
+    m_soaColorBegin.clear();
+    unsigned int nbSorted = 0;
+    for (unsigned int c=0; c<nbColors; ++c)
+    {
+        if (colorSize[c] < minParallelColorSize) continue;
+        m_soaColorBegin.push_back(nbSorted);
+        colorFill[c] = nbSorted;
+        nbSorted += colorSize[c];
+    }
+    m_soaColorBegin.push_back(nbSorted);
+    for (unsigned int c=0; c<nbColors; ++c)
+    {
+        if (colorSize[c] >= minParallelColorSize) continue;
+        colorFill[c] = nbSorted;
+        nbSorted += colorSize[c];
+    }
+
+    m_soaSpring.resize(nbSprings);
+    m_soaM1.resize(nbSprings);
+    m_soaM2.resize(nbSprings);
+    m_soaKs.resize(nbSprings);
+    m_soaKd.resize(nbSprings);
+    m_soaRestLength.resize(nbSprings);
+    m_soaFlags.resize(nbSprings);
+    for (unsigned int i=0; i<nbSprings; ++i)
+    {
+        const Spring& spring = springs[i];
+        const unsigned int s = colorFill[color[i]]++;
+        m_soaSpring[s] = i;
+        m_soaM1[s] = spring.m1;
+        m_soaM2[s] = spring.m2;
+        m_soaKs[s] = spring.ks;
+        m_soaKd[s] = spring.kd;
+        m_soaRestLength[s] = spring.initpos;
+        m_soaFlags[s] = (spring.enabled ? SpringEnabled : 0) | (spring.elongationOnly ? SpringElongationOnly : 0);
+    }
+
+    msg_info() << nbSprings << " springs in " << nbColors << " colors, "
+               << nbSprings - m_soaColorBegin.back() << " of them processed sequentially";
+}
+
 template<class DataTypes>
 void SpringForceField<DataTypes>::addSpringForce(Real& ener, VecDeriv& f1, const VecCoord& p1, const VecDeriv& v1, VecDeriv& f2, const VecCoord& p2, const VecDeriv& v2, int /*i*/, const Spring& spring)
 {
@@ -160,9 +280,47 @@ void SpringForceField<DataTypes>::addForce(
     f1.resize(x1.size());
     f2.resize(x2.size());
     this->m_potentialEnergy = 0;
-    for (unsigned int i=0; i<this->springs.getValue().size(); i++)
+    if (d_parallel.getValue())
+    {
+        updateSpringStorage();
+
+        // same test and same force as addSpringForce, on the structure-of-arrays storage
+        auto body = [&](unsigned int first, unsigned int last) -> Real
+        {
+            Real ener = 0;
+            for (unsigned int s=first; s<last; ++s)
+            {
+                const unsigned int a = m_soaM1[s];
+                const unsigned int b = m_soaM2[s];
+                Coord u = x2[b]-x1[a];
+                const Real d = u.norm();
+                if( (m_soaFlags[s] & SpringEnabled) && d<1.0e-4 ) // null length => no force
+                    continue;
+                u *= 1.0f/d;
+                const Real elongation = d - m_soaRestLength[s];
+                ener += elongation * elongation * m_soaKs[s] /2;
+                const Real elongationVelocity = dot(u, v2[b]-v1[a]);
+                const Deriv force = u*(m_soaKs[s]*elongation+m_soaKd[s]*elongationVelocity);
+                f1[a]+=force;
+                f2[b]-=force;
+            }
+            return ener;
+        };
+
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        for (unsigned int c=0; c+1<m_soaColorBegin.size(); ++c)
+        {
+            this->m_potentialEnergy += scheduler->parallel_reduce(m_soaColorBegin[c], m_soaColorBegin[c+1], (Real)0, body,
+                                                                  [](Real a, Real b) { return a+b; }, 1024u);
+        }
+        this->m_potentialEnergy += body(m_soaColorBegin.back(), (unsigned int)m_soaSpring.size());
+    }
+    else
     {
-        this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+        for (unsigned int i=0; i<this->springs.getValue().size(); i++)
+        {
+            this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+        }
     }
     data_f1.endEdit();
     data_f2.endEdit();
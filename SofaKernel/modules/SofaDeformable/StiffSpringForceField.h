@@ -72,6 +72,18 @@ public:
 protected:
     sofa::helper::vector<Mat>  dfdx;
 
+    /// @name Stiffness cached by the parallel addForce, in the order of the structure-of-arrays storage
+    /// dF = ((k_s-f/l).U.U^T + f/l.I).dX is applied from the direction U and the tangent stiffness f/l
+    /// of the springs, so addDForce reuses the directions computed by addForce without storing a matrix.
+    /// @{
+    sofa::helper::vector<Deriv> m_soaDirection;
+    sofa::helper::vector<Real>  m_soaTangent;
+    bool m_soaStiffness; ///< true when the last addForce stored the stiffness here rather than in dfdx
+
+    /// Stiffness dF/dX of the spring at position s of the structure-of-arrays storage
+    Mat getSoAStiffness(unsigned int s) const;
+    /// @}
+
     /// Accumulate the spring force and compute and store its stiffness
     virtual void addSpringForce(Real& potentialEnergy, VecDeriv& f1,const  VecCoord& p1,const VecDeriv& v1, VecDeriv& f2,const  VecCoord& p2,const  VecDeriv& v2, int i, const Spring& spring) override;
 
@@ -81,11 +93,13 @@ protected:
 
     StiffSpringForceField(MechanicalState* object1, MechanicalState* object2, double ks=100.0, double kd=5.0)
         : SpringForceField<DataTypes>(object1, object2, ks, kd)
+        , m_soaStiffness(false)
     {
     }
 
     StiffSpringForceField(double ks=100.0, double kd=5.0)
         : SpringForceField<DataTypes>(ks, kd)
+        , m_soaStiffness(false)
     {
     }
 public:
@@ -27,6 +27,7 @@
 
 #include <SofaDeformable/StiffSpringForceField.h>
 #include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <sofa/core/visual/VisualParams.h>
 
@@ -108,6 +109,23 @@ void StiffSpringForceField<DataTypes>::addSpringForce(
     }
 }
 
+template<class DataTypes>
+typename StiffSpringForceField<DataTypes>::Mat StiffSpringForceField<DataTypes>::getSoAStiffness(unsigned int s) const
+{
+    const Deriv& u = m_soaDirection[s];
+    const Real tgt = m_soaTangent[s];
+    Mat m;
+    for( int j=0; j<N; ++j )
+    {
+        for( int k=0; k<N; ++k )
+        {
+            m[j][k] = (this->m_soaKs[s]-tgt) * u[j] * u[k];
+        }
+        m[j][j] += tgt;
+    }
+    return m;
+}
+
 template<class DataTypes>
 void StiffSpringForceField<DataTypes>::addSpringDForce(VecDeriv& df1,const  VecDeriv& dx1, VecDeriv& df2,const  VecDeriv& dx2, int i, const Spring& spring, double kFactor, double /*bFactor*/)
 {
@@ -132,13 +150,71 @@ void StiffSpringForceField<DataTypes>::addForce(const core::MechanicalParams* /*
     const VecDeriv& v2 =  data_v2.getValue();
 
     const helper::vector<Spring>& springs= this->springs.getValue();
-    this->dfdx.resize(springs.size());
     f1.resize(x1.size());
     f2.resize(x2.size());
     this->m_potentialEnergy = 0;
-    for (unsigned int i=0; i<springs.size(); i++)
+    if (this->d_parallel.getValue())
+    {
+        this->updateSpringStorage();
+        const unsigned int nbSprings = this->m_soaSpring.size();
+        m_soaDirection.resize(nbSprings);
+        m_soaTangent.resize(nbSprings);
+        m_soaStiffness = true;
+
+        // same test and same force as addSpringForce, on the structure-of-arrays storage
+        auto body = [&](unsigned int first, unsigned int last) -> Real
+        {
+            Real ener = 0;
+            for (unsigned int s=first; s<last; ++s)
+            {
+                const unsigned int a = this->m_soaM1[s];
+                const unsigned int b = this->m_soaM2[s];
+                const unsigned char flags = this->m_soaFlags[s];
+                const Real restLength = this->m_soaRestLength[s];
+                Coord u = x2[b]-x1[a];
+                const Real d = u.norm();
+                if( (flags & Inherit::SpringEnabled) && d>1.0e-9 && (!(flags & Inherit::SpringElongationOnly) || d>restLength))
+                {
+                    const Real inverseLength = 1.0f/d;
+                    u *= inverseLength;
+                    const Real ks = this->m_soaKs[s];
+                    const Real elongation = d - restLength;
+                    ener += elongation * elongation * ks / 2;
+                    const Real elongationVelocity = dot(u, v2[b]-v1[a]);
+                    const Real forceIntensity = ks*elongation+this->m_soaKd[s]*elongationVelocity;
+                    const Deriv force = u*forceIntensity;
+                    f1[a]+=force;
+                    f2[b]-=force;
+
+                    m_soaDirection[s] = u;
+                    m_soaTangent[s] = forceIntensity * inverseLength;
+                }
+                else // null length, no force and no stiffness
+                {
+                    m_soaDirection[s] = Deriv();
+                    m_soaTangent[s] = 0;
+                }
+            }
+            return ener;
+        };
+
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const helper::vector<unsigned int>& colorBegin = this->m_soaColorBegin;
+        for (unsigned int c=0; c+1<colorBegin.size(); ++c)
+        {
+            this->m_potentialEnergy += scheduler->parallel_reduce(colorBegin[c], colorBegin[c+1], (Real)0, body,
+                                                                  [](Real a, Real b) { return a+b; }, 1024u);
+        }
+        this->m_potentialEnergy += body(colorBegin.back(), nbSprings);
+    }
+    else
     {
-        this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+        this->dfdx.resize(springs.size());
+        m_soaStiffness = false;
+        for (unsigned int i=0; i<springs.size(); i++)
+        {
+            this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+        }
     }
     data_f1.endEdit();
     data_f2.endEdit();
@@ -158,9 +234,39 @@ void StiffSpringForceField<DataTypes>::addDForce(const core::MechanicalParams* m
     df1.resize(dx1.size());
     df2.resize(dx2.size());
 
-    for (unsigned int i=0; i<springs.size(); i++)
+    if (m_soaStiffness)
+    {
+        // dF = ((k_s-f/l).U.U^T + f/l.I).dX, from the directions computed by addForce
+        auto body = [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int s=first; s<last; ++s)
+            {
+                const unsigned int a = this->m_soaM1[s];
+                const unsigned int b = this->m_soaM2[s];
+                const Deriv d = dx2[b]-dx1[a];
+                const Deriv& u = m_soaDirection[s];
+                const Real tgt = m_soaTangent[s];
+                Deriv dforce = u*((this->m_soaKs[s]-tgt)*dot(u,d)) + d*tgt;
+                dforce *= kFactor;
+                df1[a]+=dforce;
+                df2[b]-=dforce;
+            }
+        };
+
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const helper::vector<unsigned int>& colorBegin = this->m_soaColorBegin;
+        for (unsigned int c=0; c+1<colorBegin.size(); ++c)
+        {
+            scheduler->parallel_for(colorBegin[c], colorBegin[c+1], body, 1024u);
+        }
+        body(colorBegin.back(), (unsigned int)m_soaDirection.size());
+    }
+    else
     {
-        this->addSpringDForce(df1,dx1,df2,dx2, i, springs[i], kFactor, bFactor);
+        for (unsigned int i=0; i<springs.size(); i++)
+        {
+            this->addSpringDForce(df1,dx1,df2,dx2, i, springs[i], kFactor, bFactor);
+        }
     }
 
     data_df1.endEdit();
@@ -180,13 +286,13 @@ void StiffSpringForceField<DataTypes>::addKToMatrix(const core::MechanicalParams
         sofa::core::behavior::MultiMatrixAccessor::MatrixRef mat = matrix->getMatrix(this->mstate1);
         if (!mat) return;
         const sofa::helper::vector<Spring >& ss = this->springs.getValue();
-        const unsigned int n = ss.size() < this->dfdx.size() ? ss.size() : this->dfdx.size();
+        const unsigned int n = m_soaStiffness ? m_soaDirection.size() : ss.size() < this->dfdx.size() ? ss.size() : this->dfdx.size();
         for (unsigned int e=0; e<n; e++)
         {
-            const Spring& s = ss[e];
+            const Spring& s = ss[m_soaStiffness ? this->m_soaSpring[e] : e];
             unsigned p1 = mat.offset+Deriv::total_size*s.m1;
             unsigned p2 = mat.offset+Deriv::total_size*s.m2;
-            const Mat& m = this->dfdx[e];
+            const Mat m = m_soaStiffness ? getSoAStiffness(e) : this->dfdx[e];
             for(int i=0; i<N; i++)
             {
                 for (int j=0; j<N; j++)
@@ -209,13 +315,13 @@ void StiffSpringForceField<DataTypes>::addKToMatrix(const core::MechanicalParams
 
         if (!mat11 && !mat22 && !mat12 && !mat21) return;
         const sofa::helper::vector<Spring >& ss = this->springs.getValue();
-        const unsigned int n = ss.size() < this->dfdx.size() ? ss.size() : this->dfdx.size();
+        const unsigned int n = m_soaStiffness ? m_soaDirection.size() : ss.size() < this->dfdx.size() ? ss.size() : this->dfdx.size();
         for (unsigned int e=0; e<n; e++)
         {
-            const Spring& s = ss[e];
+            const Spring& s = ss[m_soaStiffness ? this->m_soaSpring[e] : e];
             unsigned p1 = /*mat.offset+*/Deriv::total_size*s.m1;
             unsigned p2 = /*mat.offset+*/Deriv::total_size*s.m2;
-            Mat m = this->dfdx[e]* (Real) kFact;
+            Mat m = (m_soaStiffness ? getSoAStiffness(e) : this->dfdx[e]) * (Real) kFact;
             if (mat11)
             {
                 for(int i=0; i<N; i++)
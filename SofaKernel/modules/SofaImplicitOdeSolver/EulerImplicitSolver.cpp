@@ -28,6 +28,7 @@
 #include <sofa/simulation/MechanicalOperations.h>
 #include <sofa/simulation/VectorOperations.h>
 #include <sofa/core/ObjectFactory.h>
+#include <sofa/core/behavior/LinearSolver.h>
 #include <math.h>
 #include <iostream>
 #include <sofa/helper/system/thread/CTime.h>
@@ -55,7 +56,20 @@ EulerImplicitSolver::EulerImplicitSolver()
     , d_trapezoidalScheme( initData(&d_trapezoidalScheme,false,"trapezoidalScheme","Optional: use the trapezoidal scheme instead of the implicit Euler scheme and get second order accuracy in time") )
     , f_solveConstraint( initData(&f_solveConstraint,false,"solveConstraint","Apply ConstraintSolver (requires a ConstraintSolver in the same node as this solver, disabled by by default for now)") )
     , d_threadSafeVisitor(initData(&d_threadSafeVisitor, false, "threadSafeVisitor", "If true, do not use realloc and free visitors in fwdInteractionForceField."))
+    , d_newtonIterations(initData(&d_newtonIterations, 1u, "newtonIterations", "Maximum number of linear solves per time step. Above 1, the solution is refined by Newton iterations (second order implicit Euler only)"))
+    , d_newtonTolerance(initData(&d_newtonTolerance, (SReal)1e-6, "newtonTolerance", "Newton iterations stop when the residual norm is below this ratio of the initial right-hand side norm"))
+    , d_matrixReuseSteps(initData(&d_matrixReuseSteps, 0u, "matrixReuseSteps", "Number of time steps the system matrix (and its factorization) can be reused before being rebuilt (0: rebuilt at each step)"))
+    , d_matrixReuseTolerance(initData(&d_matrixReuseTolerance, (SReal)1e-2, "matrixReuseTolerance", "A reused matrix is rebuilt when the relative residual of the solution on the current system exceeds this threshold (0: no check)"))
+    , d_nbMatrixBuilds(initData(&d_nbMatrixBuilds, 0u, "nbMatrixBuilds", "Output: number of system matrix builds"))
+    , d_nbFactorizations(initData(&d_nbFactorizations, 0u, "nbFactorizations", "Output: number of factorizations of a new assembled matrix requested to the linear solver"))
+    , d_nbIterations(initData(&d_nbIterations, 0u, "nbIterations", "Output: number of linear solves during the last time step"))
+    , m_stepsSinceMatrixBuild(0)
+    , m_matrixSize(0)
+    , m_hasMatrix(false)
 {
+    d_nbMatrixBuilds.setReadOnly(true);
+    d_nbFactorizations.setReadOnly(true);
+    d_nbIterations.setReadOnly(true);
 }
 
 void EulerImplicitSolver::init()
@@ -68,6 +82,8 @@ void EulerImplicitSolver::init()
         for (unsigned int i=0; i<objs.size(); ++i)
             sout << "  " << objs[i]->getClassName() << ' ' << objs[i]->getName() << sendl;
     }
+    msg_warning_when(d_newtonIterations.getValue() > 1 && (f_firstOrder.getValue() || d_trapezoidalScheme.getValue()))
+            << "Newton iterations are only implemented for the second order implicit Euler scheme, a single linearized solve is done per step.";
     sofa::core::behavior::OdeSolver::init();
 }
 
@@ -76,6 +92,9 @@ void EulerImplicitSolver::cleanup()
     // free the locally created vector x (including eventual external mechanical states linked by an InteractionForceField)
     sofa::simulation::common::VectorOperations vop( core::ExecParams::defaultInstance(), this->getContext() );
     vop.v_free(x.id(), !d_threadSafeVisitor.getValue(), true);
+    vop.v_free(m_newtonPos.id(), !d_threadSafeVisitor.getValue(), true);
+    vop.v_free(m_newtonVel.id(), !d_threadSafeVisitor.getValue(), true);
+    vop.v_free(m_newtonCorrection.id(), !d_threadSafeVisitor.getValue(), true);
 }
 
 void EulerImplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::core::MultiVecCoordId xResult, sofa::core::MultiVecDerivId vResult)
@@ -162,10 +181,42 @@ void EulerImplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
 
     core::behavior::MultiMatrix<simulation::common::MechanicalOperations> matrix(&mop);
 
-    if (firstOrder)
-        matrix = MechanicalMatrix(1,0,-h*tr); //MechanicalMatrix::K * (-h*tr) + MechanicalMatrix::M;
+    const MechanicalMatrix mbk = firstOrder ?
+                MechanicalMatrix(1,0,-h*tr) : //MechanicalMatrix::K * (-h*tr) + MechanicalMatrix::M;
+                MechanicalMatrix(1+tr*h*f_rayleighMass.getValue(),-tr*h,-tr*h*(h+f_rayleighStiffness.getValue())); // MechanicalMatrix::K * (-tr*h*(h+f_rayleighStiffness.getValue())) + MechanicalMatrix::B * (-tr*h) + MechanicalMatrix::M * (1+tr*h*f_rayleighMass.getValue());
+    const defaulttype::Vec<3,SReal> mbkFactors(mbk.getMFact(), mbk.getBFact(), mbk.getKFact());
+
+    core::behavior::LinearSolver* linearSolver = this->getContext()->get<core::behavior::LinearSolver>(this->getContext()->getTags(), core::objectmodel::BaseContext::SearchDown);
+    unsigned int nbMatrixBuilds = d_nbMatrixBuilds.getValue();
+    unsigned int nbFactorizations = d_nbFactorizations.getValue();
+
+    // the matrix is kept by the linear solver as long as setSystemMBKMatrix is not called
+    const unsigned int reuseSteps = d_matrixReuseSteps.getValue();
+    unsigned int matrixSize = 0;
+    if (reuseSteps > 0)
+    {
+        unsigned int nbCol = 0;
+        mop.getMatrixDimension(&matrixSize, &nbCol);
+    }
+    const bool reuseMatrix = reuseSteps > 0 && m_hasMatrix && m_stepsSinceMatrixBuild < reuseSteps
+            && matrixSize == m_matrixSize && mbkFactors == m_matrixFactors;
+
+    auto buildMatrix = [&](core::behavior::MultiMatrix<simulation::common::MechanicalOperations>& m)
+    {
+        m = mbk;
+        ++nbMatrixBuilds;
+        if (linearSolver && linearSolver->getSystemBaseMatrix())
+            ++nbFactorizations;
+        m_stepsSinceMatrixBuild = 0;
+        m_matrixSize = matrixSize;
+        m_matrixFactors = mbkFactors;
+        m_hasMatrix = true;
+    };
+
+    if (reuseMatrix)
+        ++m_stepsSinceMatrixBuild;
     else
-        matrix = MechanicalMatrix(1+tr*h*f_rayleighMass.getValue(),-tr*h,-tr*h*(h+f_rayleighStiffness.getValue())); // MechanicalMatrix::K * (-tr*h*(h+f_rayleighStiffness.getValue())) + MechanicalMatrix::B * (-tr*h) + MechanicalMatrix::M * (1+tr*h*f_rayleighMass.getValue());
+        buildMatrix(matrix);
 
     if( verbose )
     {
@@ -178,11 +229,84 @@ void EulerImplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
 #endif
     sofa::helper::AdvancedTimer::stepNext ("MBKBuild", "MBKSolve");
     matrix.solve(x, b); //Call to ODE resolution: x is the solution of the system
+
+    if (reuseMatrix && d_matrixReuseTolerance.getValue() > 0)
+    {
+        // residual of the solution on the current linearized system, r = b - A x, computed without assembly
+        MultiVecDeriv r(&vop);
+        mop.propagateDx(x);
+        mop.addMBKdx(r, mbk.getMFact(), mbk.getBFact(), mbk.getKFact());
+        r.eq(b, r, -1.0);
+        mop.projectResponse(r);
+        const SReal bNorm = b.norm();
+        if (r.norm() > d_matrixReuseTolerance.getValue() * bNorm)
+        {
+            if (verbose)
+                serr << "EulerImplicitSolver, reused matrix refreshed, relative residual = " << r.norm() / bNorm << sendl;
+            sofa::helper::AdvancedTimer::stepNext ("MBKSolve", "MBKBuild");
+            buildMatrix(matrix);
+            sofa::helper::AdvancedTimer::stepNext ("MBKBuild", "MBKSolve");
+            matrix.solve(x, b);
+        }
+    }
     sofa::helper::AdvancedTimer::stepEnd  ("MBKSolve");
 #ifdef SOFA_DUMP_VISITOR_INFO
     simulation::Visitor::printCloseNode("SystemSolution");
 #endif
 
+    unsigned int nbIterations = 1;
+    const unsigned int maxIterations = d_newtonIterations.getValue();
+    if (maxIterations > 1 && !firstOrder && !optTrapezoidal)
+    {
+        sofa::helper::AdvancedTimer::stepBegin("NewtonIterations");
+
+        // the iterates are stored apart as xResult and vResult may be the current position and velocity
+        m_newtonPos.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+        m_newtonVel.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+        m_newtonCorrection.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+
+        sofa::simulation::common::MechanicalOperations mopNewton( params, this->getContext() );
+        mopNewton->setImplicit(true);
+        core::behavior::MultiMatrix<simulation::common::MechanicalOperations> newtonMatrix(&mopNewton);
+
+        const SReal tolerance = d_newtonTolerance.getValue() * b.norm();
+        for ( ; nbIterations < maxIterations; ++nbIterations)
+        {
+            // forces at the current iterate
+            m_newtonVel.eq(vel, x);
+            m_newtonPos.eq(pos, m_newtonVel, h);
+            mopNewton.computeForce(this->getContext()->getTime()+h, f, m_newtonPos, m_newtonVel);
+
+            // b = h ( f - rm M v + rs K v ) - M dv
+            b.eq(f);
+            mopNewton.addMBKv(b, -f_rayleighMass.getValue(), 0, f_rayleighStiffness.getValue());
+            b.teq(h);
+            mopNewton.propagateDx(x);
+            mopNewton.addMBKdx(b, -1, 0, 0);
+            mopNewton.projectResponse(b);
+
+            const SReal residual = b.norm();
+            if( verbose )
+                serr<<"EulerImplicitSolver, Newton iteration "<< nbIterations <<", residual = "<< residual <<sendl;
+            if (residual <= tolerance)
+                break;
+
+            // the Jacobian is updated at the iterate, unless the matrix is reused (quasi-Newton)
+            if (reuseSteps == 0)
+                buildMatrix(newtonMatrix);
+            newtonMatrix.solve(m_newtonCorrection, b);
+            x.peq(m_newtonCorrection);
+        }
+
+        sofa::helper::AdvancedTimer::stepEnd("NewtonIterations");
+    }
+
+    d_nbIterations.setValue(nbIterations);
+    if (nbMatrixBuilds != d_nbMatrixBuilds.getValue())
+        d_nbMatrixBuilds.setValue(nbMatrixBuilds);
+    if (nbFactorizations != d_nbFactorizations.getValue())
+        d_nbFactorizations.setValue(nbFactorizations);
+
     // mop.projectResponse(x);
     // x is the solution of the system
     // apply the solution
@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <sofa/core/behavior/OdeSolver.h>
+#include <sofa/defaulttype/Vec.h>
 
 namespace sofa
 {
@@ -99,6 +100,22 @@ namespace odesolver
  *
  *   \f$ ( M + h/2 K ) v_{t+h} = f_ext \f$
  *
+ *** Newton iterations ***
+ *
+ * The system above is a single linearization of the implicit equation. With newtonIterations > 1 (second order implicit Euler only),
+ * the solution is refined by Newton iterations on the residual of the non-linear equation
+ *
+ *   \f$ R(dv) = h ( f(x_t + h v_{t+h}, v_{t+h}) - r_M M v_{t+h} + r_K K v_{t+h} ) - M dv \f$
+ *
+ * until \f$ |R| \f$ falls below newtonTolerance times the norm of the initial right-hand side.
+ *
+ *** Matrix reuse ***
+ *
+ * With matrixReuseSteps > 0, the assembled system matrix (and the factorization kept by the linear solver) is reused for
+ * up to matrixReuseSteps time steps, and for the Newton iterations, instead of being rebuilt (quasi-Newton). The matrix is rebuilt
+ * earlier when the system size or the matrix coefficients change, or when the residual of the solution computed with the reused matrix,
+ * measured on the current system, exceeds matrixReuseTolerance times the norm of the right-hand side.
+ *
  */
 class SOFA_IMPLICIT_ODE_SOLVER_API EulerImplicitSolver : public sofa::core::behavior::OdeSolver
 {
@@ -113,6 +130,13 @@ public:
     Data<bool> d_trapezoidalScheme; ///< Optional: use the trapezoidal scheme instead of the implicit Euler scheme and get second order accuracy in time
     Data<bool> f_solveConstraint; ///< Apply ConstraintSolver (requires a ConstraintSolver in the same node as this solver, disabled by by default for now)
     Data<bool> d_threadSafeVisitor;
+    Data<unsigned int> d_newtonIterations; ///< Maximum number of linear solves per time step (1: a single linearized solve)
+    Data<SReal> d_newtonTolerance; ///< Newton iterations stop when the residual norm is below this ratio of the initial right-hand side norm
+    Data<unsigned int> d_matrixReuseSteps; ///< Number of time steps the system matrix can be reused before being rebuilt (0: rebuilt at each step)
+    Data<SReal> d_matrixReuseTolerance; ///< A reused matrix is rebuilt when the relative residual of the solution exceeds this threshold (0: no check)
+    Data<unsigned int> d_nbMatrixBuilds; ///< Output: number of system matrix builds
+    Data<unsigned int> d_nbFactorizations; ///< Output: number of factorizations of a new assembled matrix requested to the linear solver
+    Data<unsigned int> d_nbIterations; ///< Output: number of linear solves during the last time step
 
 protected:
     EulerImplicitSolver();
@@ -167,6 +191,17 @@ protected:
     /// the solution vector is stored for warm-start
     core::behavior::MultiVecDeriv x;
 
+    /// state of the current Newton iterate, and Newton correction
+    core::behavior::MultiVecCoord m_newtonPos;
+    core::behavior::MultiVecDeriv m_newtonVel;
+    core::behavior::MultiVecDeriv m_newtonCorrection;
+
+    /// description of the last built system matrix, used to decide whether it can be reused
+    unsigned int m_stepsSinceMatrixBuild;
+    unsigned int m_matrixSize;
+    defaulttype::Vec<3,SReal> m_matrixFactors;
+    bool m_hasMatrix;
+
 };
 
 } // namespace odesolver
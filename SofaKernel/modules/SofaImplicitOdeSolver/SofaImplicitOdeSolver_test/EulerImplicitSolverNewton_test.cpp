@@ -0,0 +1,231 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+#include <SceneCreator/SceneCreator.h>
+#include <SceneCreator/SceneUtils.h>
+#include <SofaImplicitOdeSolver/EulerImplicitSolver.h>
+#include <SofaBaseLinearSolver/CGLinearSolver.h>
+#include <SofaBoundaryCondition/FixedConstraint.h>
+
+#include <sofa/simulation/Simulation.h>
+#include <SofaSimulationGraph/SimpleApi.h>
+
+#include <SofaTest/TestMessageHandler.h>
+
+
+namespace sofa {
+
+using namespace modeling;
+using namespace defaulttype;
+
+using sofa::component::projectiveconstraintset::FixedConstraint;
+using sofa::component::odesolver::EulerImplicitSolver;
+typedef component::linearsolver::CGLinearSolver<component::linearsolver::GraphScatteredMatrix, component::linearsolver::GraphScatteredVector> CGLinearSolver;
+
+
+/** Newton iterations and matrix reuse of the EulerImplicitSolver.
+ * Mass-spring string composed of two particles in gravity, one is fixed,
+ * which must relax to the same equilibrium as with the default settings.
+ */
+struct EulerImplicitSolverNewton_test : public Sofa_test<>
+{
+    simulation::Node::SPtr root;
+    EulerImplicitSolver::SPtr eulerSolver;
+
+    void SetUp()
+    {
+        root = modeling::initSofa();
+
+        eulerSolver = addNew<EulerImplicitSolver>(root);
+        CGLinearSolver::SPtr linearSolver = addNew<CGLinearSolver>(root);
+        linearSolver->f_maxIter.setValue(100);
+        linearSolver->f_tolerance.setValue(1e-12);
+        linearSolver->f_smallDenominatorThreshold.setValue(1e-12);
+
+        simulation::Node::SPtr string = massSpringString(
+                    root, // attached to root node
+                    0,1,0,     // first particle position
+                    0,0,0,     // last  particle position
+                    2,      // number of particles
+                    2.0,    // total mass
+                    1000.0, // stiffness
+                    0.1     // damping ratio
+                    );
+        FixedConstraint<Vec3Types>::SPtr fixed = modeling::addNew<FixedConstraint<Vec3Types> >(string,"fixedConstraint");
+        fixed->addConstraint(0);      // attach first particle
+    }
+
+    /// Run until the motion stops, return the number of steps
+    unsigned runToEquilibrium()
+    {
+        EXPECT_MSG_NOEMIT(Error) ;
+        initScene(root);
+
+        Vector x0 = getVector( core::VecId::position() );
+        Vector v0 = getVector( core::VecId::velocity() );
+        Vector x1, v1;
+
+        SReal dx, dv;
+        unsigned n=0;
+        const unsigned nMax=100;
+        do {
+            sofa::simulation::getSimulation()->animate(root.get(),1.0);
+
+            x1 = getVector( core::VecId::position() );
+            v1 = getVector( core::VecId::velocity() );
+
+            dx = (x0-x1).lpNorm<Eigen::Infinity>();
+            dv = (v0-v1).lpNorm<Eigen::Infinity>();
+            x0 = x1;
+            v0 = v1;
+            n++;
+        } while( (dx>1.e-4 || dv>1.e-4) && n<nMax );
+
+        EXPECT_LT(n, nMax) << "Solver test has not converged in " << nMax << " iterations";
+
+        // test position of the second particle
+        Vec3d expected(0,-0.00981,0);
+        Vec3d actual( x0[3],x0[4],x0[5]);
+        EXPECT_LE(vectorMaxDiff(expected,actual), 1e-4) << "expected: " << expected << " actual " << actual;
+
+        return n;
+    }
+};
+
+TEST_F( EulerImplicitSolverNewton_test, defaultSettings )
+{
+    const unsigned n = runToEquilibrium();
+    EXPECT_EQ(eulerSolver->d_nbIterations.getValue(), 1u);
+    EXPECT_EQ(eulerSolver->d_nbMatrixBuilds.getValue(), n);
+    // the conjugate gradient does not assemble nor factorize the matrix
+    EXPECT_EQ(eulerSolver->d_nbFactorizations.getValue(), 0u);
+}
+
+TEST_F( EulerImplicitSolverNewton_test, newtonIterations )
+{
+    eulerSolver->d_newtonIterations.setValue(10);
+    eulerSolver->d_newtonTolerance.setValue(1e-8);
+    runToEquilibrium();
+    EXPECT_GE(eulerSolver->d_nbIterations.getValue(), 1u);
+    EXPECT_LE(eulerSolver->d_nbIterations.getValue(), 10u);
+}
+
+TEST_F( EulerImplicitSolverNewton_test, matrixReuse )
+{
+    eulerSolver->d_matrixReuseSteps.setValue(5);
+    const unsigned n = runToEquilibrium();
+    EXPECT_LT(eulerSolver->d_nbMatrixBuilds.getValue(), n);
+}
+
+
+/** Newton iterations on a nonlinear step.
+ * A stretched spring, one end fixed, the other end launched orthogonally to it without gravity,
+ * turns by a large angle during the time step, so that a single linearized solve is inaccurate.
+ * The nonlinear residual of the step, h f(x1,v1) - M (v1-v0), is computed from the final state.
+ */
+struct EulerImplicitSolverNewtonRotation_test : public Sofa_test<>
+{
+    const SReal dt = 0.2;
+    const SReal stiffness = 100;
+    const SReal restLength = 1;
+    const SReal mass = 1;
+    const Vec3d x0 = Vec3d(1.2,0,0);
+    const Vec3d v0 = Vec3d(0,2,0);
+
+    simulation::Node::SPtr root;
+    EulerImplicitSolver::SPtr eulerSolver;
+
+    void SetUp()
+    {
+        root = modeling::initSofa();
+        root->setGravity(Vec3d(0,0,0));
+
+        eulerSolver = addNew<EulerImplicitSolver>(root);
+        CGLinearSolver::SPtr linearSolver = addNew<CGLinearSolver>(root);
+        linearSolver->f_maxIter.setValue(100);
+        linearSolver->f_tolerance.setValue(1e-20);
+        linearSolver->f_smallDenominatorThreshold.setValue(1e-20);
+
+        simulation::Node::SPtr spring = simpleapi::createChild(root, "spring");
+        simpleapi::createObject(spring, "MechanicalObject", {
+                                    {"position", "0 0 0  " + simpleapi::str(x0)},
+                                    {"velocity", "0 0 0  " + simpleapi::str(v0)}});
+        simpleapi::createObject(spring, "UniformMass", {{"vertexMass", simpleapi::str(mass)}});
+        simpleapi::createObject(spring, "StiffSpringForceField", {
+                                    {"spring", "0 1 " + simpleapi::str(stiffness) + " 0 " + simpleapi::str(restLength)}});
+        FixedConstraint<Vec3Types>::SPtr fixed = modeling::addNew<FixedConstraint<Vec3Types> >(spring,"fixedConstraint");
+        fixed->addConstraint(0);
+    }
+
+    /// force of the spring on the free particle
+    Vec3d springForce(const Vec3d& x) const
+    {
+        return x * (-stiffness * (x.norm() - restLength) / x.norm());
+    }
+
+    /// norm of the right-hand side of the first linear solve, h ( f + h K v0 ), the reference of newtonTolerance
+    SReal initialRightHandSide() const
+    {
+        const Vec3d u = x0 / x0.norm();
+        const Vec3d Kv = ((v0 - u*(u*v0)) * (1 - restLength/x0.norm()) + u*(u*v0)) * (-stiffness);
+        return ((springForce(x0) + Kv*dt) * dt).norm();
+    }
+
+    /// Do one time step, return the norm of the nonlinear residual relative to initialRightHandSide()
+    SReal relativeResidual()
+    {
+        EXPECT_MSG_NOEMIT(Error) ;
+        initScene(root);
+        sofa::simulation::getSimulation()->animate(root.get(),dt);
+
+        const Vector x = getVector( core::VecId::position() );
+        const Vector v = getVector( core::VecId::velocity() );
+        const Vec3d x1(x[3],x[4],x[5]);
+        const Vec3d v1(v[3],v[4],v[5]);
+        EXPECT_LE(vectorMaxDiff(x1, x0 + v1*dt), 1e-10) << "implicit Euler position update";
+
+        const Vec3d residual = springForce(x1)*dt - (v1 - v0)*mass;
+        return residual.norm() / initialRightHandSide();
+    }
+};
+
+TEST_F( EulerImplicitSolverNewtonRotation_test, singleSolve )
+{
+    // the linearized solve does not satisfy the nonlinear step
+    EXPECT_GT(relativeResidual(), 1e-2);
+    EXPECT_EQ(eulerSolver->d_nbIterations.getValue(), 1u);
+}
+
+TEST_F( EulerImplicitSolverNewtonRotation_test, newtonIterations )
+{
+    const unsigned maxIterations = 20;
+    const SReal tolerance = 1e-6;
+    eulerSolver->d_newtonIterations.setValue(maxIterations);
+    eulerSolver->d_newtonTolerance.setValue(tolerance);
+
+    // the iterations stop on the tolerance, not on the maximum count
+    EXPECT_LE(relativeResidual(), tolerance);
+    EXPECT_GT(eulerSolver->d_nbIterations.getValue(), 1u);
+    EXPECT_LT(eulerSolver->d_nbIterations.getValue(), maxIterations);
+}
+
+}// namespace sofa
@@ -134,6 +134,101 @@ struct TetrahedronFEMForceField_test : public ForceField_test<_TetrahedronFEMFor
 
         EXPECT_EQ(fem->getComponentState(), ComponentState::Invalid) ;
     }
+
+    /// the batched large displacements method gives the same forces as the element by element one
+    void checkBatchedLargeMethod()
+    {
+        this->clearSceneGraph();
+
+        // a cube of n^3 hexahedra, each split into 5 tetrahedra
+        const int n = 4;
+        std::stringstream positions, tetrahedra;
+        for (int z=0; z<=n; ++z)
+            for (int y=0; y<=n; ++y)
+                for (int x=0; x<=n; ++x)
+                    positions << x << " " << y << " " << z << " ";
+        const int split[5][4] = { {0,1,2,4}, {3,2,1,7}, {5,1,4,7}, {6,2,7,4}, {1,2,4,7} };
+        for (int z=0; z<n; ++z)
+            for (int y=0; y<n; ++y)
+                for (int x=0; x<n; ++x)
+                    for (int t=0; t<5; ++t)
+                        for (int k=0; k<4; ++k)
+                        {
+                            const int c = split[t][k];
+                            tetrahedra << (x+(c&1)) + (n+1)*((y+((c>>1)&1)) + (n+1)*(z+((c>>2)&1))) << " ";
+                        }
+
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node name='Root'>\n" ;
+        for (int batched=0; batched<2; ++batched)
+        {
+            scene << "  <Node name='node" << batched << "'>\n"
+                     "    <MechanicalObject name='dofs' position='" << positions.str() << "'/>\n"
+                     "    <MeshTopology tetrahedra='" << tetrahedra.str() << "'/>\n"
+                     "    <TetrahedronFEMForceField name='fem' method='large' youngModulus='1000' poissonRatio='0.3' updateStiffnessMatrix='1' batched='" << batched << "'/>\n"
+                     "  </Node>\n" ;
+        }
+        scene << "</Node>\n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene.str().c_str(),
+                                                          scene.str().size()) ;
+        root->init(ExecParams::defaultInstance()) ;
+
+        DOF* dofs[2];
+        ForceType* fem[2];
+        for (int batched=0; batched<2; ++batched)
+        {
+            std::stringstream name;
+            name << "node" << batched;
+            Node* node = root->getTreeNode(name.str());
+            ASSERT_NE(node, nullptr);
+            dofs[batched] = dynamic_cast<DOF*>(node->getObject("dofs"));
+            fem[batched] = dynamic_cast<ForceType*>(node->getObject("fem"));
+            ASSERT_NE(dofs[batched], nullptr);
+            ASSERT_NE(fem[batched], nullptr);
+        }
+
+        // same deformation and same position change for both
+        const size_t nbPoints = dofs[0]->getSize();
+        VecCoord p = dofs[0]->readPositions().ref();
+        VecDeriv dp(nbPoints);
+        for (size_t i=0; i<nbPoints; ++i)
+        {
+            const Real a = (Real)(0.1*std::sin(1.7*i)), b = (Real)(0.1*std::cos(2.3*i)), c = (Real)(0.1*std::sin(0.3*i+1));
+            DataTypes::set( p[i], p[i][0]+a+(Real)0.2*p[i][2], p[i][1]+b, p[i][2]+c );
+            DataTypes::set( dp[i], c, a, b );
+        }
+
+        VecDeriv force[2], dforce[2];
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+        for (int batched=0; batched<2; ++batched)
+        {
+            dofs[batched]->writePositions().wref() = p;
+
+            core::objectmodel::Data<VecDeriv> f;
+            f.setValue(VecDeriv(nbPoints));
+            fem[batched]->addForce(&mparams, f, *dofs[batched]->read(core::ConstVecCoordId::position()), *dofs[batched]->read(core::ConstVecDerivId::velocity()));
+            force[batched] = f.getValue();
+
+            core::objectmodel::Data<VecDeriv> df, dx;
+            df.setValue(VecDeriv(nbPoints));
+            dx.setValue(dp);
+            fem[batched]->addDForce(&mparams, df, dx);
+            dforce[batched] = df.getValue();
+        }
+
+        for (size_t i=0; i<nbPoints; ++i)
+        {
+            for (int c=0; c<3; ++c)
+            {
+                EXPECT_NEAR(force[0][i][c], force[1][i][c], 1e-4*(1+std::abs(force[0][i][c]))) << "point " << i;
+                EXPECT_NEAR(dforce[0][i][c], dforce[1][i][c], 1e-4*(1+std::abs(dforce[0][i][c]))) << "point " << i;
+            }
+        }
+    }
 };
 
 // ========= Define the list of types to instanciate.
@@ -170,4 +265,9 @@ TYPED_TEST(TetrahedronFEMForceField_test, checkGracefullHandlingWhenTopologyIsMi
     this->checkGracefullHandlingWhenTopologyIsMissing();
 }
 
+TYPED_TEST(TetrahedronFEMForceField_test, checkBatchedLargeMethod)
+{
+    this->checkBatchedLargeMethod();
+}
+
 } // namespace sofa
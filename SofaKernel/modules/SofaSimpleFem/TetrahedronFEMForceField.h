@@ -229,6 +229,7 @@ public:
     /// Suppress field for save as function
     Data<bool>  isToPrint;
     Data<bool>  _updateStiffness; ///< udpate structures (precomputed in init) using stiffness parameters in each iteration (set listening=1)
+    Data<bool>  d_batched; ///< compute the large displacements method by batches of elements stored in structure-of-arrays layout, in parallel on the task scheduler
 
     helper::vector<defaulttype::Vec<6,Real> > elemDisplacements;
 
@@ -317,6 +318,30 @@ protected:
 
     void applyStiffnessCorotational( Vector& f, const Vector& x, int i=0, Index a=0,Index b=1,Index c=2,Index d=3, SReal fact=1.0  );
 
+    ////////////// batched large displacements method
+    /// The elements are colored so that two elements of the same color share no vertex, and each color is
+    /// split into batches of BatchSize elements. Each per-element value of a batch is stored in BatchSize
+    /// consecutive Reals, so that the kernels process all the elements of a batch in the innermost loops.
+    enum { BatchSize = 8 };
+    enum { BatchK = 0,                  ///< the 12 non-zero values of the material stiffness
+           BatchJ = BatchK + 12,        ///< the 3 non-zero values of each row of the strain-displacement matrix
+           BatchRest = BatchJ + 36,     ///< the 6 non-zero rest coordinates in the element frame
+           BatchRotation = BatchRest + 6, ///< the rotation of the element
+           BatchValueCount = BatchRotation + 9
+         };
+    helper::vector<Real> _batchValues;            ///< BatchValueCount*BatchSize values per batch
+    helper::vector<Index> _batchNodes;            ///< 4*BatchSize vertices per batch
+    helper::vector<Index> _batchElements;         ///< BatchSize elements per batch, the unused lanes repeat the first element
+    helper::vector<unsigned int> _batchLaneCount; ///< number of elements in each batch
+    helper::vector<unsigned int> _batchColorBegin; ///< first batch of each color, plus the end of the last color
+
+    bool useBatches() const;
+    void initBatches();
+    void updateBatchStiffness();
+    static void computeForceBatch( Real F[12][BatchSize], const Real D[12][BatchSize], const Real* values, Real fact );
+    void accumulateForceLargeBatch( Vector& f, const Vector& p, unsigned int batch );
+    void applyStiffnessCorotationalBatch( Vector& f, const Vector& x, unsigned int batch, Real fact );
+
     void handleTopologyChange() override { needUpdateTopology = true; }
 
     void computeVonMisesStress();
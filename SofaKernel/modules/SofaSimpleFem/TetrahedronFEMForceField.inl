@@ -33,6 +33,9 @@
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <sofa/simulation/AnimateBeginEvent.h>
 #include <sofa/simulation/AnimateEndEvent.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <algorithm>
+#include <limits>
 
 
 namespace sofa
@@ -74,6 +77,7 @@ TetrahedronFEMForceField<DataTypes>::TetrahedronFEMForceField()
     , _showVonMisesStressPerNode(initData(&_showVonMisesStressPerNode,false,"showVonMisesStressPerNode","draw points  showing vonMises stress interpolated in nodes"))
     , isToPrint( initData(&isToPrint, false, "isToPrint", "suppress somes data before using save as function"))
     , _updateStiffness(initData(&_updateStiffness,false,"updateStiffness","udpate structures (precomputed in init) using stiffness parameters in each iteration (set listening=1)"))
+    , d_batched(initData(&d_batched,false,"batched","compute the large displacements method by batches of elements stored in structure-of-arrays layout, in parallel on the task scheduler (ignored with plasticity or computeGlobalMatrix)"))
 {
     _poissonRatio.setRequired(true);
     _youngModulus.setRequired(true);
@@ -1313,6 +1317,355 @@ inline void TetrahedronFEMForceField<DataTypes>::applyStiffnessCorotational( Vec
 }
 
 
+//////////////////////////////////////////////////////////////////////
+//////////////  batched large displacements method  //////////////////
+//////////////////////////////////////////////////////////////////////
+
+template<class DataTypes>
+inline bool TetrahedronFEMForceField<DataTypes>::useBatches() const
+{
+    return d_batched.getValue() && method == LARGE && !_assembling.getValue()
+            && _plasticMaxThreshold.getValue() <= 0 && !_batchColorBegin.empty();
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::initBatches()
+{
+    _batchValues.clear();
+    _batchNodes.clear();
+    _batchElements.clear();
+    _batchLaneCount.clear();
+    _batchColorBegin.clear();
+
+    if (!d_batched.getValue() || method != LARGE || _indexedElements->empty())
+        return;
+
+    const VecElement& elements = *_indexedElements;
+    const unsigned int nbElements = elements.size();
+
+    // elements around each vertex
+    unsigned int nbPoints = 0;
+    for (unsigned int e=0; e<nbElements; ++e)
+        for (int k=0; k<4; ++k)
+            nbPoints = std::max(nbPoints, (unsigned int)elements[e][k]+1);
+
+    helper::vector<unsigned int> vertexBegin;
+    vertexBegin.resize(nbPoints+1, 0);
+    for (unsigned int e=0; e<nbElements; ++e)
+        for (int k=0; k<4; ++k)
+            ++vertexBegin[elements[e][k]+1];
+    for (unsigned int v=0; v<nbPoints; ++v)
+        vertexBegin[v+1] += vertexBegin[v];
+    helper::vector<unsigned int> vertexElements(vertexBegin.back());
+    helper::vector<unsigned int> fill(vertexBegin.begin(), vertexBegin.end()-1);
+    for (unsigned int e=0; e<nbElements; ++e)
+        for (int k=0; k<4; ++k)
+            vertexElements[fill[elements[e][k]]++] = e;
+
+    // greedy coloring: each element takes the first color not used by the elements sharing one of its vertices
+    helper::vector<int> color;
+    color.resize(nbElements, -1);
+    helper::vector<unsigned int> colorStamp;
+    for (unsigned int e=0; e<nbElements; ++e)
+    {
+        for (int k=0; k<4; ++k)
+        {
+            const Index v = elements[e][k];
+            for (unsigned int n=vertexBegin[v]; n<vertexBegin[v+1]; ++n)
+            {
+                const int c = color[vertexElements[n]];
+                if (c >= 0) colorStamp[c] = e+1;
+            }
+        }
+        unsigned int c = 0;
+        while (c < colorStamp.size() && colorStamp[c] == e+1) ++c;
+        if (c == colorStamp.size()) colorStamp.push_back(0);
+        color[e] = c;
+    }
+    const unsigned int nbColors = colorStamp.size();
+
+    // elements sorted by color
+    helper::vector<unsigned int> colorBegin;
+    colorBegin.resize(nbColors+1, 0);
+    for (unsigned int e=0; e<nbElements; ++e)
+        ++colorBegin[color[e]+1];
+    for (unsigned int c=0; c<nbColors; ++c)
+        colorBegin[c+1] += colorBegin[c];
+    helper::vector<unsigned int> sorted(nbElements);
+    fill.assign(colorBegin.begin(), colorBegin.end()-1);
+    for (unsigned int e=0; e<nbElements; ++e)
+        sorted[fill[color[e]]++] = e;
+
+    // each color split into batches
+    for (unsigned int c=0; c<nbColors; ++c)
+    {
+        _batchColorBegin.push_back(_batchLaneCount.size());
+        for (unsigned int first=colorBegin[c]; first<colorBegin[c+1]; first+=BatchSize)
+        {
+            const unsigned int count = std::min((unsigned int)BatchSize, colorBegin[c+1]-first);
+            _batchLaneCount.push_back(count);
+            for (unsigned int l=0; l<BatchSize; ++l)
+                _batchElements.push_back(sorted[first + (l<count ? l : 0)]);
+        }
+    }
+    _batchColorBegin.push_back(_batchLaneCount.size());
+
+    const unsigned int nbBatches = _batchLaneCount.size();
+    _batchNodes.resize(nbBatches*4*BatchSize);
+    _batchValues.resize(nbBatches*BatchValueCount*BatchSize);
+    static const int JColumns[3][3] = { {0,3,5}, {1,3,4}, {2,4,5} };
+    for (unsigned int b=0; b<nbBatches; ++b)
+    {
+        Real* values = &_batchValues[b*BatchValueCount*BatchSize];
+        for (unsigned int l=0; l<BatchSize; ++l)
+        {
+            const Index i = _batchElements[b*BatchSize+l];
+            for (int k=0; k<4; ++k)
+                _batchNodes[(b*4+k)*BatchSize+l] = elements[i][k];
+
+            const StrainDisplacement& J = strainDisplacements[i];
+            for (int r=0; r<12; ++r)
+                for (int t=0; t<3; ++t)
+                    values[(BatchJ+r*3+t)*BatchSize+l] = J[r][JColumns[r%3][t]];
+
+            const helper::fixed_array<Coord,4>& rest = _rotatedInitialElements[i];
+            values[(BatchRest+0)*BatchSize+l] = rest[1][0];
+            values[(BatchRest+1)*BatchSize+l] = rest[2][0];
+            values[(BatchRest+2)*BatchSize+l] = rest[2][1];
+            values[(BatchRest+3)*BatchSize+l] = rest[3][0];
+            values[(BatchRest+4)*BatchSize+l] = rest[3][1];
+            values[(BatchRest+5)*BatchSize+l] = rest[3][2];
+
+            for (int r=0; r<3; ++r)
+                for (int c=0; c<3; ++c)
+                    values[(BatchRotation+r*3+c)*BatchSize+l] = rotations[i][r][c];
+        }
+    }
+    updateBatchStiffness();
+
+    msg_info() << nbBatches << " batches of " << (int)BatchSize << " elements in " << nbColors << " colors";
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::updateBatchStiffness()
+{
+    const unsigned int nbBatches = _batchLaneCount.size();
+    for (unsigned int b=0; b<nbBatches; ++b)
+    {
+        Real* values = &_batchValues[b*BatchValueCount*BatchSize];
+        for (unsigned int l=0; l<BatchSize; ++l)
+        {
+            const MaterialStiffness& K = materialsStiffnesses[_batchElements[b*BatchSize+l]];
+            for (int r=0; r<3; ++r)
+                for (int c=0; c<3; ++c)
+                    values[(BatchK+r*3+c)*BatchSize+l] = K[r][c];
+            values[(BatchK+ 9)*BatchSize+l] = K[3][3];
+            values[(BatchK+10)*BatchSize+l] = K[4][4];
+            values[(BatchK+11)*BatchSize+l] = K[5][5];
+        }
+    }
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::computeForceBatch( Real F[12][BatchSize], const Real D[12][BatchSize], const Real* values, Real fact )
+{
+    // same computation as computeForce, restricted to the non-zero values of K and J
+    static const int JColumns[3][3] = { {0,3,5}, {1,3,4}, {2,4,5} };
+    const Real* K = values + BatchK*BatchSize;
+    const Real* J = values + BatchJ*BatchSize;
+
+    Real JtD[6][BatchSize];
+    for (int c=0; c<6; ++c)
+        for (int l=0; l<BatchSize; ++l)
+            JtD[c][l] = 0;
+    for (int r=0; r<12; ++r)
+        for (int t=0; t<3; ++t)
+        {
+            Real* JtDc = JtD[JColumns[r%3][t]];
+            const Real* Jrt = J + (r*3+t)*BatchSize;
+            for (int l=0; l<BatchSize; ++l)
+                JtDc[l] += Jrt[l] * D[r][l];
+        }
+
+    Real KJtD[6][BatchSize];
+    for (int r=0; r<3; ++r)
+        for (int l=0; l<BatchSize; ++l)
+            KJtD[r][l] = fact * ( K[(r*3+0)*BatchSize+l]*JtD[0][l] + K[(r*3+1)*BatchSize+l]*JtD[1][l] + K[(r*3+2)*BatchSize+l]*JtD[2][l] );
+    for (int r=3; r<6; ++r)
+        for (int l=0; l<BatchSize; ++l)
+            KJtD[r][l] = fact * K[(6+r)*BatchSize+l] * JtD[r][l];
+
+    for (int r=0; r<12; ++r)
+    {
+        const int* cols = JColumns[r%3];
+        const Real* Jr = J + r*3*BatchSize;
+        for (int l=0; l<BatchSize; ++l)
+            F[r][l] = Jr[l]*KJtD[cols[0]][l] + Jr[BatchSize+l]*KJtD[cols[1]][l] + Jr[2*BatchSize+l]*KJtD[cols[2]][l];
+    }
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::accumulateForceLargeBatch( Vector& f, const Vector& p, unsigned int batch )
+{
+    Real* values = &_batchValues[batch*BatchValueCount*BatchSize];
+    const Index* nodes = &_batchNodes[batch*4*BatchSize];
+    const Index* elementIndex = &_batchElements[batch*BatchSize];
+    const unsigned int count = _batchLaneCount[batch];
+    const Real* rest = values + BatchRest*BatchSize;
+    Real* J = values + BatchJ*BatchSize;
+    Real* rot = values + BatchRotation*BatchSize;
+
+    // edges from the first vertex
+    Real e[3][3][BatchSize];
+    for (int k=0; k<3; ++k)
+        for (int l=0; l<BatchSize; ++l)
+        {
+            const Coord& p0 = p[nodes[l]];
+            const Coord& pk = p[nodes[(k+1)*BatchSize+l]];
+            e[k][0][l] = pk[0]-p0[0];
+            e[k][1][l] = pk[1]-p0[1];
+            e[k][2][l] = pk[2]-p0[2];
+        }
+
+    // rotation (deformed and displaced tetrahedron/world), as in computeRotationLarge, and positions in its frame
+    Real R[3][3][BatchSize];
+    Real deforme[6][BatchSize]; // non-zero coordinates of the vertices 1, 2 and 3 relative to vertex 0
+    const Real epsilon = std::numeric_limits<Real>::epsilon();
+    for (int l=0; l<BatchSize; ++l)
+    {
+        Real x0 = e[0][0][l], x1 = e[0][1][l], x2 = e[0][2][l];
+        Real n = helper::rsqrt(x0*x0 + x1*x1 + x2*x2);
+        Real inv = n > epsilon ? 1/n : 1;
+        x0 *= inv; x1 *= inv; x2 *= inv;
+
+        Real y0 = e[1][0][l], y1 = e[1][1][l], y2 = e[1][2][l];
+        n = helper::rsqrt(y0*y0 + y1*y1 + y2*y2);
+        inv = n > epsilon ? 1/n : 1;
+        y0 *= inv; y1 *= inv; y2 *= inv;
+
+        Real z0 = x1*y2 - x2*y1, z1 = x2*y0 - x0*y2, z2 = x0*y1 - x1*y0;
+        n = helper::rsqrt(z0*z0 + z1*z1 + z2*z2);
+        inv = n > epsilon ? 1/n : 1;
+        z0 *= inv; z1 *= inv; z2 *= inv;
+
+        y0 = z1*x2 - z2*x1; y1 = z2*x0 - z0*x2; y2 = z0*x1 - z1*x0;
+        n = helper::rsqrt(y0*y0 + y1*y1 + y2*y2);
+        inv = n > epsilon ? 1/n : 1;
+        y0 *= inv; y1 *= inv; y2 *= inv;
+
+        R[0][0][l] = x0; R[0][1][l] = x1; R[0][2][l] = x2;
+        R[1][0][l] = y0; R[1][1][l] = y1; R[1][2][l] = y2;
+        R[2][0][l] = z0; R[2][1][l] = z1; R[2][2][l] = z2;
+
+        deforme[0][l] = x0*e[0][0][l] + x1*e[0][1][l] + x2*e[0][2][l];
+        deforme[1][l] = x0*e[1][0][l] + x1*e[1][1][l] + x2*e[1][2][l];
+        deforme[2][l] = y0*e[1][0][l] + y1*e[1][1][l] + y2*e[1][2][l];
+        deforme[3][l] = x0*e[2][0][l] + x1*e[2][1][l] + x2*e[2][2][l];
+        deforme[4][l] = y0*e[2][0][l] + y1*e[2][1][l] + y2*e[2][2][l];
+        deforme[5][l] = z0*e[2][0][l] + z1*e[2][1][l] + z2*e[2][2][l];
+    }
+
+    // displacement
+    Real D[12][BatchSize];
+    for (int l=0; l<BatchSize; ++l)
+    {
+        D[0][l] = D[1][l] = D[2][l] = D[4][l] = D[5][l] = D[8][l] = 0;
+        D[3][l]  = rest[0*BatchSize+l] - deforme[0][l];
+        D[6][l]  = rest[1*BatchSize+l] - deforme[1][l];
+        D[7][l]  = rest[2*BatchSize+l] - deforme[2][l];
+        D[9][l]  = rest[3*BatchSize+l] - deforme[3][l];
+        D[10][l] = rest[4*BatchSize+l] - deforme[4][l];
+        D[11][l] = rest[5*BatchSize+l] - deforme[5][l];
+    }
+
+    if(_updateStiffnessMatrix.getValue())
+    {
+        // the first non-zero value of the rows 0, 1, 2, 3, 4, 5, 7, 8 and 11, as in accumulateForceLarge
+        for (int l=0; l<BatchSize; ++l)
+        {
+            const Real b0 = deforme[0][l], c0 = deforme[1][l], c1 = deforme[2][l], d0 = deforme[3][l], d1 = deforme[4][l], d2 = deforme[5][l];
+            J[( 0*3)*BatchSize+l] = - c1*d2;
+            J[( 1*3)*BatchSize+l] = c0*d2 - b0*d2;
+            J[( 2*3)*BatchSize+l] = c1*d0 - c0*d1 + b0*d1 - b0*c1;
+            J[( 3*3)*BatchSize+l] = c1*d2;
+            J[( 4*3)*BatchSize+l] = - c0*d2;
+            J[( 5*3)*BatchSize+l] = - c1*d0 + c0*d1;
+            J[( 7*3)*BatchSize+l] = b0*d2;
+            J[( 8*3)*BatchSize+l] = - b0*d1;
+            J[(11*3)*BatchSize+l] = b0*c1;
+        }
+        for (unsigned int l=0; l<count; ++l)
+        {
+            StrainDisplacement& Ji = strainDisplacements[elementIndex[l]];
+            Ji[0][0] = J[( 0*3)*BatchSize+l];
+            Ji[1][1] = J[( 1*3)*BatchSize+l];
+            Ji[2][2] = J[( 2*3)*BatchSize+l];
+            Ji[3][0] = J[( 3*3)*BatchSize+l];
+            Ji[4][1] = J[( 4*3)*BatchSize+l];
+            Ji[5][2] = J[( 5*3)*BatchSize+l];
+            Ji[7][1] = J[( 7*3)*BatchSize+l];
+            Ji[8][2] = J[( 8*3)*BatchSize+l];
+            Ji[11][2] = J[(11*3)*BatchSize+l];
+        }
+    }
+
+    Real F[12][BatchSize];
+    computeForceBatch( F, D, values, 1 );
+
+    // rotations[i] is the transpose of R
+    for (int r=0; r<3; ++r)
+        for (int c=0; c<3; ++c)
+            for (int l=0; l<BatchSize; ++l)
+                rot[(r*3+c)*BatchSize+l] = R[c][r][l];
+
+    for (unsigned int l=0; l<count; ++l)
+    {
+        Transformation& Ri = rotations[elementIndex[l]];
+        for (int r=0; r<3; ++r)
+            for (int c=0; c<3; ++c)
+                Ri[r][c] = R[c][r][l];
+
+        for (int k=0; k<4; ++k)
+        {
+            Deriv& fk = f[nodes[k*BatchSize+l]];
+            for (int c=0; c<3; ++c)
+                fk[c] += R[0][c][l]*F[k*3][l] + R[1][c][l]*F[k*3+1][l] + R[2][c][l]*F[k*3+2][l];
+        }
+    }
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::applyStiffnessCorotationalBatch( Vector& f, const Vector& x, unsigned int batch, Real fact )
+{
+    const Real* values = &_batchValues[batch*BatchValueCount*BatchSize];
+    const Index* nodes = &_batchNodes[batch*4*BatchSize];
+    const unsigned int count = _batchLaneCount[batch];
+    const Real* rot = values + BatchRotation*BatchSize;
+
+    // rotate by rotations[i] transposed
+    Real X[12][BatchSize];
+    for (int k=0; k<4; ++k)
+        for (int l=0; l<BatchSize; ++l)
+        {
+            const Coord& xk = x[nodes[k*BatchSize+l]];
+            for (int c=0; c<3; ++c)
+                X[k*3+c][l] = rot[(0*3+c)*BatchSize+l]*xk[0] + rot[(1*3+c)*BatchSize+l]*xk[1] + rot[(2*3+c)*BatchSize+l]*xk[2];
+        }
+
+    Real F[12][BatchSize];
+    computeForceBatch( F, X, values, fact );
+
+    // rotate by rotations[i]
+    for (unsigned int l=0; l<count; ++l)
+        for (int k=0; k<4; ++k)
+        {
+            Deriv& fk = f[nodes[k*BatchSize+l]];
+            for (int r=0; r<3; ++r)
+                fk[r] -= rot[(r*3+0)*BatchSize+l]*F[k*3][l] + rot[(r*3+1)*BatchSize+l]*F[k*3+1][l] + rot[(r*3+2)*BatchSize+l]*F[k*3+2][l];
+        }
+}
+
+
 //////////////////////////////////////////////////////////////////////
 ////////////////  generic main computations methods  /////////////////
 //////////////////////////////////////////////////////////////////////
@@ -1575,6 +1928,8 @@ inline void TetrahedronFEMForceField<DataTypes>::reinit()
     }
     }
 
+    initBatches();
+
     if (_computeVonMisesStress.getValue() > 0) {
         elemDisplacements.resize(  _indexedElements->size() );
 
@@ -1628,6 +1983,21 @@ inline void TetrahedronFEMForceField<DataTypes>::addForce (const core::Mechanica
     }
     case LARGE :
     {
+        if (useBatches())
+        {
+            // the batches of a color share no vertex
+            simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+            for (unsigned int c=0; c+1<_batchColorBegin.size(); ++c)
+            {
+                scheduler->parallel_for(_batchColorBegin[c], _batchColorBegin[c+1], [&](unsigned int first, unsigned int last)
+                {
+                    for (unsigned int b=first; b<last; ++b)
+                        accumulateForceLargeBatch( f, p, b );
+                });
+            }
+            break;
+        }
+
         for(it=_indexedElements->begin(), i = 0 ; it!=_indexedElements->end(); ++it,++i)
         {
 
@@ -1680,6 +2050,18 @@ inline void TetrahedronFEMForceField<DataTypes>::addDForce(const core::Mechanica
             applyStiffnessSmall( df,dx, i, a,b,c,d, kFactor );
         }
     }
+    else if( useBatches() )
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        for (unsigned int c=0; c+1<_batchColorBegin.size(); ++c)
+        {
+            scheduler->parallel_for(_batchColorBegin[c], _batchColorBegin[c+1], [&](unsigned int first, unsigned int last)
+            {
+                for (unsigned int b=first; b<last; ++b)
+                    applyStiffnessCorotationalBatch( df, dx, b, kFactor );
+            });
+        }
+    }
     else
     {
         for(it = _indexedElements->begin(), i = 0 ; it != _indexedElements->end() ; ++it, ++i)
@@ -2280,6 +2662,7 @@ void TetrahedronFEMForceField<DataTypes>::handleEvent(core::objectmodel::Event *
                 Index d = (*it)[3];
                 this->computeMaterialStiffness(i,a,b,c,d);
             }
+            updateBatchStiffness();
         }
     }
     if (sofa::simulation::AnimateEndEvent::checkEventType(event)) {
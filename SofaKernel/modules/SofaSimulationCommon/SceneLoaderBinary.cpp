@@ -0,0 +1,835 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "SceneLoaderBinary.h"
+
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/core/objectmodel/BaseNode.h>
+#include <sofa/defaulttype/DataTypeInfo.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/system/Locale.h>
+#include <sofa/helper/system/SetDirectory.h>
+#include <sofa/helper/logging/Messaging.h>
+#include <sofa/simulation/Simulation.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <SofaSimulationCommon/FindByTypeVisitor.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+// register the loader in the factory
+const SceneLoader* loaderBinary = SceneLoaderFactory::getInstance()->addEntry(new SceneLoaderBinary());
+
+const char SceneLoaderBinary::Magic[8] = { 'S', 'O', 'F', 'A', 'S', 'C', 'N', 'B' };
+const std::uint32_t SceneLoaderBinary::Version;
+const std::size_t SceneLoaderBinary::MinBinaryValues;
+bool SceneLoaderBinary::parallelInstantiation = true;
+
+namespace
+{
+
+using core::objectmodel::Base;
+using core::objectmodel::BaseData;
+using core::objectmodel::BaseLink;
+using core::objectmodel::BaseObject;
+using core::objectmodel::BaseObjectDescription;
+using defaulttype::AbstractTypeInfo;
+
+enum FieldKind
+{
+    FIELD_TEXT = 0,     ///< value parsed when the component is created, including the links between components
+    FIELD_DATALINK = 1, ///< path of the parent Data, connected once all the components are created
+    FIELD_VALUES = 2    ///< raw values of a numeric Data
+};
+
+/// Absolute path of a node or a component, empty for the root node
+std::string getPath(const Base* base)
+{
+    if (const BaseObject* object = base->toBaseObject())
+        return object->getPathName();
+    if (const core::objectmodel::BaseNode* node = base->toBaseNode())
+        return node->getPathName();
+    return std::string();
+}
+
+/// The numeric Data stored as raw values
+bool isStoredAsValues(const BaseData* data)
+{
+    const AbstractTypeInfo* info = data->getValueTypeInfo();
+    if (!info->ValidInfo() || !info->Container() || !info->SimpleLayout() || info->Text())
+        return false;
+    const AbstractTypeInfo* valueType = info->ValueType();
+    if (!(valueType->Scalar() || valueType->Integer()) || valueType->name() == "bool")
+        return false;
+    const void* ptr = data->getValueVoidPtr();
+    return info->size(ptr) >= SceneLoaderBinary::MinBinaryValues && info->getValuePtr(ptr) != NULL;
+}
+
+class BinarySceneWriter
+{
+public:
+    bool write(Node* root, const std::string& filename)
+    {
+        buffer.clear();
+        writeBytes(SceneLoaderBinary::Magic, sizeof(SceneLoaderBinary::Magic));
+        writeValue(SceneLoaderBinary::Version);
+        writeValue(std::uint32_t(0)); // flags, for future use
+        writeNode(root);
+
+        // written to a temporary file then moved, so that a process mapping the previous
+        // version of the file never sees it truncated
+        const std::string tmpFilename = helper::io::MappedFile::getTemporaryFileName(filename);
+        {
+            std::ofstream file(tmpFilename.c_str(), std::ios::binary);
+            if (!file.is_open())
+                return false;
+            file.write(buffer.data(), buffer.size());
+            file.close();
+            if (file.fail())
+            {
+                std::remove(tmpFilename.c_str());
+                return false;
+            }
+        }
+        return helper::io::MappedFile::replaceFile(tmpFilename, filename);
+    }
+
+protected:
+    void writeBytes(const void* data, std::size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    template<class T>
+    void writeValue(const T& value)
+    {
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeString(const std::string& str)
+    {
+        writeValue(std::uint32_t(str.size()));
+        writeBytes(str.data(), str.size());
+    }
+
+    /// Pad to 8 bytes, so that the raw values are aligned in the mapped file
+    void align()
+    {
+        buffer.resize((buffer.size() + 7) & ~std::size_t(7), 0);
+    }
+
+    /// Path of the parent Data, made absolute if possible
+    std::string getDataLinkPath(const BaseData* data)
+    {
+        const BaseData* parent = data->getParent();
+        if (parent && parent->getOwner())
+        {
+            const std::string ownerPath = getPath(parent->getOwner());
+            if (!ownerPath.empty())
+                return "@" + ownerPath + "." + parent->getName();
+        }
+        return data->getLinkPath();
+    }
+
+    /// Paths of the linked components, made absolute if possible
+    std::string getLinkPath(const BaseLink* link)
+    {
+        std::string value;
+        for (std::size_t i = 0; i < link->getSize(); ++i)
+        {
+            std::string path;
+            if (Base* base = link->getLinkedBase(i))
+                path = getPath(base);
+            if (!path.empty())
+            {
+                path = "@" + path;
+                if (const BaseData* data = link->getLinkedData(i))
+                    path += "." + data->getName();
+            }
+            else
+            {
+                path = link->getLinkedPath(i);
+            }
+            if (path.empty())
+                continue;
+            if (!value.empty())
+                value += ' ';
+            value += path;
+        }
+        return value.empty() ? link->getValueString() : value;
+    }
+
+    /// Write the Data and links saved by Base::writeDatas
+    void writeFields(Base* base)
+    {
+        const std::size_t countPos = buffer.size();
+        std::uint32_t count = 0;
+        writeValue(count);
+
+        const Base::VecData& datas = base->getDataFields();
+        for (Base::VecData::const_iterator it = datas.begin(); it != datas.end(); ++it)
+        {
+            const BaseData* data = *it;
+            if (!data->getLinkPath().empty())
+            {
+                writeValue(std::uint8_t(FIELD_DATALINK));
+                writeString(data->getName());
+                writeString(getDataLinkPath(data));
+            }
+            else if (!data->isPersistent() || !data->isSet())
+            {
+                continue;
+            }
+            else if (isStoredAsValues(data))
+            {
+                const AbstractTypeInfo* info = data->getValueTypeInfo();
+                const void* ptr = data->getValueVoidPtr();
+                const std::uint64_t size = info->size(ptr);
+                const std::uint32_t byteSize = (std::uint32_t)info->byteSize();
+                writeValue(std::uint8_t(FIELD_VALUES));
+                writeString(data->getName());
+                writeString(info->ValueType()->name());
+                writeValue(byteSize);
+                writeValue(size);
+                align();
+                writeBytes(info->getValuePtr(ptr), size * byteSize);
+            }
+            else
+            {
+                const std::string value = data->getValueString();
+                if (value.empty())
+                    continue;
+                writeValue(std::uint8_t(FIELD_TEXT));
+                writeString(data->getName());
+                writeString(value);
+            }
+            ++count;
+        }
+
+        const Base::VecLink& links = base->getLinks();
+        for (Base::VecLink::const_iterator it = links.begin(); it != links.end(); ++it)
+        {
+            const BaseLink* link = *it;
+            if (!link->storePath())
+                continue;
+            const std::string value = getLinkPath(link);
+            if (value.empty())
+                continue;
+            writeValue(std::uint8_t(FIELD_TEXT));
+            writeString(link->getName());
+            writeString(value);
+            ++count;
+        }
+
+        std::memcpy(&buffer[countPos], &count, sizeof(count));
+    }
+
+    /// Interaction components are created after the children nodes, as in XMLPrintVisitor
+    static bool isInteraction(BaseObject* obj)
+    {
+        return obj->toBaseInteractionForceField() != NULL
+            || obj->toBaseInteractionConstraint() != NULL
+            || obj->toBaseInteractionProjectiveConstraintSet() != NULL
+            || obj->toBaseLMConstraint() != NULL;
+    }
+
+    void writeNode(Node* node)
+    {
+        writeFields(node);
+
+        writeValue(std::uint32_t(node->object.size()));
+        for (Node::ObjectIterator it = node->object.begin(); it != node->object.end(); ++it)
+        {
+            BaseObject* obj = it->get();
+            writeValue(std::uint8_t(isInteraction(obj) ? 1 : 0));
+            writeString(obj->getClassName());
+            writeString(obj->getTemplateName());
+            writeFields(obj);
+        }
+
+        // the nodes with several parents are only saved in the first one, as in XMLPrintVisitor
+        std::vector<Node*> children;
+        for (Node::ChildIterator it = node->child.begin(); it != node->child.end(); ++it)
+        {
+            if (visited.insert(it->get()).second)
+                children.push_back(it->get());
+        }
+        writeValue(std::uint32_t(children.size()));
+        for (std::size_t i = 0; i < children.size(); ++i)
+            writeNode(children[i]);
+    }
+
+    std::vector<char> buffer;
+    std::set<Node*> visited;
+};
+
+
+struct BinaryField
+{
+    FieldKind kind;
+    std::string name;
+    std::string value;          ///< text or path
+    std::string valueTypeName;  ///< FIELD_VALUES: type of the values
+    std::uint32_t byteSize;     ///< FIELD_VALUES: size of each value
+    std::uint64_t size;         ///< FIELD_VALUES: number of values
+    const char* values;         ///< FIELD_VALUES: values in the mapped file
+};
+
+struct BinaryObject
+{
+    bool interaction;
+    std::string type;
+    std::string templateName;
+    std::vector<BinaryField> fields;
+    BaseObject::SPtr object;
+};
+
+struct BinaryNode
+{
+    std::string name;
+    std::size_t index;     ///< index in the children of the parent node
+    std::vector<BinaryField> fields;
+    std::vector<BinaryObject> objects;
+    std::vector< std::unique_ptr<BinaryNode> > children;
+    std::map<std::string, std::size_t> childIndex;
+    std::vector<std::size_t> group;    ///< union-find of the children linking to each other
+    std::vector< std::vector<std::size_t> > groups; ///< children to populate in sequence
+    Node::SPtr node;
+
+    std::size_t findGroup(std::size_t i)
+    {
+        while (group[i] != i)
+            i = group[i] = group[group[i]];
+        return i;
+    }
+
+    void mergeGroups(std::size_t i, std::size_t j)
+    {
+        i = findGroup(i);
+        j = findGroup(j);
+        if (i < j) group[j] = i;
+        else if (j < i) group[i] = j;
+    }
+};
+
+class BinarySceneReader
+{
+public:
+    BinarySceneReader(const char* data, std::size_t size) : data(data), size(size), pos(0) {}
+
+    bool readHeader()
+    {
+        char magic[sizeof(SceneLoaderBinary::Magic)];
+        std::uint32_t version = 0, flags = 0;
+        return readBytes(magic, sizeof(magic))
+            && std::memcmp(magic, SceneLoaderBinary::Magic, sizeof(magic)) == 0
+            && readValue(version) && version == SceneLoaderBinary::Version
+            && readValue(flags);
+    }
+
+    bool readNode(BinaryNode& node)
+    {
+        std::uint32_t nbObjects = 0, nbChildren = 0;
+        if (!readFields(node.fields) || !readValue(nbObjects) || nbObjects > size - pos)
+            return false;
+        for (std::size_t i = 0; i < node.fields.size(); ++i)
+        {
+            if (node.fields[i].kind == FIELD_TEXT && node.fields[i].name == "name")
+                node.name = node.fields[i].value;
+        }
+
+        node.objects.resize(nbObjects);
+        for (std::size_t i = 0; i < nbObjects; ++i)
+        {
+            BinaryObject& obj = node.objects[i];
+            std::uint8_t interaction = 0;
+            if (!readValue(interaction) || !readString(obj.type) || !readString(obj.templateName) || !readFields(obj.fields))
+                return false;
+            obj.interaction = (interaction != 0);
+        }
+
+        if (!readValue(nbChildren) || nbChildren > size - pos)
+            return false;
+        node.children.resize(nbChildren);
+        node.group.resize(nbChildren);
+        for (std::size_t i = 0; i < nbChildren; ++i)
+        {
+            node.children[i].reset(new BinaryNode);
+            node.children[i]->index = i;
+            node.group[i] = i;
+            if (!readNode(*node.children[i]))
+                return false;
+            node.childIndex.insert(std::make_pair(node.children[i]->name, i));
+        }
+        return true;
+    }
+
+protected:
+    bool readBytes(void* dest, std::size_t n)
+    {
+        if (n > size - pos)
+            return false;
+        std::memcpy(dest, data + pos, n);
+        pos += n;
+        return true;
+    }
+
+    template<class T>
+    bool readValue(T& value)
+    {
+        return readBytes(&value, sizeof(T));
+    }
+
+    bool readString(std::string& str)
+    {
+        std::uint32_t length = 0;
+        if (!readValue(length) || length > size - pos)
+            return false;
+        str.assign(data + pos, length);
+        pos += length;
+        return true;
+    }
+
+    bool readFields(std::vector<BinaryField>& fields)
+    {
+        std::uint32_t count = 0;
+        if (!readValue(count) || count > size - pos)
+            return false;
+        fields.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            BinaryField& field = fields[i];
+            std::uint8_t kind = 0;
+            if (!readValue(kind) || !readString(field.name))
+                return false;
+            field.kind = (FieldKind)kind;
+            field.byteSize = 0;
+            field.size = 0;
+            field.values = NULL;
+            switch (field.kind)
+            {
+            case FIELD_TEXT:
+            case FIELD_DATALINK:
+                if (!readString(field.value))
+                    return false;
+                break;
+            case FIELD_VALUES:
+                if (!readString(field.valueTypeName) || !readValue(field.byteSize) || !readValue(field.size))
+                    return false;
+                pos = (pos + 7) & ~std::size_t(7);
+                if (pos > size || field.byteSize == 0 || field.size > (size - pos) / field.byteSize)
+                    return false;
+                field.values = data + pos;
+                pos += field.size * field.byteSize;
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char* data;
+    std::size_t size;
+    std::size_t pos;
+};
+
+
+/// Stored value converted to the type of the destination Data, when it differs from the stored type
+template<class T>
+T getStoredValue(const BinaryField& field, std::size_t i)
+{
+    const char* ptr = field.values + i * field.byteSize;
+    const std::string& type = field.valueTypeName;
+#define SOFA_BINARY_SCENE_VALUE(TYPE) \
+    if (type == #TYPE && field.byteSize == sizeof(TYPE)) { TYPE v; std::memcpy(&v, ptr, sizeof(v)); return static_cast<T>(v); }
+    SOFA_BINARY_SCENE_VALUE(double)
+    SOFA_BINARY_SCENE_VALUE(float)
+    SOFA_BINARY_SCENE_VALUE(int)
+    SOFA_BINARY_SCENE_VALUE(unsigned int)
+    SOFA_BINARY_SCENE_VALUE(char)
+    SOFA_BINARY_SCENE_VALUE(unsigned char)
+    SOFA_BINARY_SCENE_VALUE(short)
+    SOFA_BINARY_SCENE_VALUE(unsigned short)
+    SOFA_BINARY_SCENE_VALUE(long)
+    SOFA_BINARY_SCENE_VALUE(unsigned long)
+    SOFA_BINARY_SCENE_VALUE(long long)
+    SOFA_BINARY_SCENE_VALUE(unsigned long long)
+#undef SOFA_BINARY_SCENE_VALUE
+    return T();
+}
+
+class BinarySceneBuilder
+{
+public:
+    BinarySceneBuilder(bool parallel) : parallel(parallel) {}
+
+    Node::SPtr build(BinaryNode& root)
+    {
+        computeGroups(root);
+        createNodes(root, NULL);
+        populate(root);
+        connectDataLinks(root);
+        return root.node;
+    }
+
+protected:
+    /// Group the sibling subtrees linking to each other, the other ones can be populated concurrently
+    void computeGroups(BinaryNode& root)
+    {
+        std::vector<BinaryNode*> ancestors;
+        addDependencies(root, root, ancestors);
+
+        std::vector<BinaryNode*> stack(1, &root);
+        while (!stack.empty())
+        {
+            BinaryNode* node = stack.back();
+            stack.pop_back();
+            std::map<std::size_t, std::size_t> groupOf;
+            for (std::size_t i = 0; i < node->children.size(); ++i)
+            {
+                const std::size_t g = node->findGroup(i);
+                std::map<std::size_t, std::size_t>::iterator it = groupOf.find(g);
+                if (it == groupOf.end())
+                {
+                    it = groupOf.insert(std::make_pair(g, node->groups.size())).first;
+                    node->groups.push_back(std::vector<std::size_t>());
+                }
+                node->groups[it->second].push_back(i);
+                stack.push_back(node->children[i].get());
+            }
+        }
+    }
+
+    void addDependencies(BinaryNode& root, BinaryNode& node, std::vector<BinaryNode*>& ancestors)
+    {
+        ancestors.push_back(&node);
+        // the Data links are only connected once all the components are created
+        for (std::size_t i = 0; i < node.objects.size(); ++i)
+        {
+            const std::vector<BinaryField>& fields = node.objects[i].fields;
+            for (std::size_t f = 0; f < fields.size(); ++f)
+            {
+                if (fields[f].kind == FIELD_TEXT && !fields[f].value.empty() && fields[f].value[0] == '@')
+                    addDependency(root, ancestors, fields[f].value);
+            }
+        }
+        for (std::size_t i = 0; i < node.children.size(); ++i)
+            addDependencies(root, *node.children[i], ancestors);
+        ancestors.pop_back();
+    }
+
+    /// Merge the groups of the two sibling subtrees containing the node and the linked component
+    void addDependency(BinaryNode& root, const std::vector<BinaryNode*>& ancestors, const std::string& value)
+    {
+        std::istringstream paths(value);
+        std::string path;
+        while (paths >> path)
+        {
+            if (path.size() < 2 || path[0] != '@' || path[1] != '/')
+                continue; // relative paths are left unresolved by the writer
+
+            BinaryNode* node = &root;
+            std::size_t begin = 2;
+            for (std::size_t depth = 1; depth < ancestors.size() && begin < path.size(); ++depth)
+            {
+                std::size_t end = path.find('/', begin);
+                std::string name = path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+                std::map<std::string, std::size_t>::const_iterator it = node->childIndex.find(name);
+                if (it == node->childIndex.end() && end == std::string::npos)
+                    it = node->childIndex.find(name.substr(0, name.rfind('.'))); // link to the Data of a node
+                if (it == node->childIndex.end())
+                    break; // component of a common ancestor
+
+                const std::size_t source = ancestors[depth]->index;
+                if (it->second != source)
+                {
+                    node->mergeGroups(source, it->second);
+                    break;
+                }
+                node = ancestors[depth];
+                if (end == std::string::npos)
+                    break;
+                begin = end + 1;
+            }
+        }
+    }
+
+    /// Create the whole node hierarchy, so that the components can find their ancestors
+    void createNodes(BinaryNode& desc, Node* parent)
+    {
+        desc.node = getSimulation()->createNewNode(desc.name);
+        BaseObjectDescription arg(desc.name.c_str(), "Node");
+        for (std::size_t i = 0; i < desc.fields.size(); ++i)
+        {
+            if (desc.fields[i].kind == FIELD_TEXT)
+                arg.setAttribute(desc.fields[i].name, desc.fields[i].value.c_str());
+        }
+        desc.node->parse(&arg);
+        setValues(desc.node.get(), desc.fields);
+        if (parent)
+            parent->addChild(desc.node);
+
+        for (std::size_t i = 0; i < desc.children.size(); ++i)
+            createNodes(*desc.children[i], desc.node.get());
+    }
+
+    void populate(BinaryNode& desc)
+    {
+        for (std::size_t i = 0; i < desc.objects.size(); ++i)
+        {
+            if (!desc.objects[i].interaction)
+                createObject(desc, desc.objects[i]);
+        }
+
+        TaskScheduler* scheduler = parallel && desc.groups.size() > 1 ? TaskScheduler::getInstance() : NULL;
+        if (scheduler)
+        {
+            scheduler->parallel_for(std::size_t(0), desc.groups.size(), [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t g = first; g < last; ++g)
+                    populateGroup(desc, g);
+            }, std::size_t(1));
+        }
+        else
+        {
+            for (std::size_t g = 0; g < desc.groups.size(); ++g)
+                populateGroup(desc, g);
+        }
+
+        for (std::size_t i = 0; i < desc.objects.size(); ++i)
+        {
+            if (desc.objects[i].interaction)
+                createObject(desc, desc.objects[i]);
+        }
+    }
+
+    void populateGroup(BinaryNode& desc, std::size_t g)
+    {
+        const std::vector<std::size_t>& group = desc.groups[g];
+        for (std::size_t i = 0; i < group.size(); ++i)
+            populate(*desc.children[group[i]]);
+    }
+
+    void createObject(BinaryNode& desc, BinaryObject& obj)
+    {
+        BaseObjectDescription arg(NULL, obj.type.c_str());
+        if (!obj.templateName.empty())
+            arg.setAttribute("template", obj.templateName.c_str());
+        for (std::size_t i = 0; i < obj.fields.size(); ++i)
+        {
+            if (obj.fields[i].kind == FIELD_TEXT)
+                arg.setAttribute(obj.fields[i].name, obj.fields[i].value.c_str());
+        }
+
+        obj.object = core::ObjectFactory::CreateObject(desc.node.get(), &arg);
+        if (obj.object == NULL)
+        {
+            std::stringstream errors;
+            for (std::size_t i = 0; i < arg.getErrors().size(); ++i)
+                errors << arg.getErrors()[i] << msgendl;
+            msg_error(desc.node.get()) << errors.str();
+            return;
+        }
+        setValues(obj.object.get(), obj.fields);
+    }
+
+    /// Copy the raw values into the Data, converting them if the type of the Data differs
+    static void setValues(Base* base, const std::vector<BinaryField>& fields)
+    {
+        for (std::size_t f = 0; f < fields.size(); ++f)
+        {
+            const BinaryField& field = fields[f];
+            if (field.kind != FIELD_VALUES)
+                continue;
+            BaseData* data = base->findData(field.name);
+            if (!data)
+            {
+                msg_warning(base) << "Unknown Data field: " << field.name;
+                continue;
+            }
+
+            const AbstractTypeInfo* info = data->getValueTypeInfo();
+            void* ptr = data->beginEditVoidPtr();
+            info->setSize(ptr, (std::size_t)field.size);
+            const std::size_t size = std::min<std::size_t>(info->size(ptr), (std::size_t)field.size);
+            if (info->SimpleLayout() && info->byteSize() == field.byteSize && info->ValueType()->name() == field.valueTypeName)
+            {
+                std::memcpy(info->getValuePtr(ptr), field.values, size * field.byteSize);
+            }
+            else if (info->ValueType()->Integer())
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                    info->setIntegerValue(ptr, i, getStoredValue<long long>(field, i));
+            }
+            else
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                    info->setScalarValue(ptr, i, getStoredValue<double>(field, i));
+            }
+            data->endEditVoidPtr();
+        }
+    }
+
+    static void connectDataLinks(Base* base, const std::vector<BinaryField>& fields)
+    {
+        for (std::size_t f = 0; f < fields.size(); ++f)
+        {
+            if (fields[f].kind == FIELD_DATALINK)
+                base->parseField(fields[f].name, fields[f].value);
+        }
+    }
+
+    /// Connect the Data links in the order they would be created by exportXML
+    void connectDataLinks(BinaryNode& desc)
+    {
+        connectDataLinks(desc.node.get(), desc.fields);
+        for (std::size_t i = 0; i < desc.objects.size(); ++i)
+        {
+            if (!desc.objects[i].interaction && desc.objects[i].object)
+                connectDataLinks(desc.objects[i].object.get(), desc.objects[i].fields);
+        }
+        for (std::size_t i = 0; i < desc.children.size(); ++i)
+            connectDataLinks(*desc.children[i]);
+        for (std::size_t i = 0; i < desc.objects.size(); ++i)
+        {
+            if (desc.objects[i].interaction && desc.objects[i].object)
+                connectDataLinks(desc.objects[i].object.get(), desc.objects[i].fields);
+        }
+    }
+
+    bool parallel;
+};
+
+} // namespace
+
+
+bool SceneLoaderBinary::canLoadFileExtension(const char *extension)
+{
+    std::string ext = extension;
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return (ext=="scnb");
+}
+
+bool SceneLoaderBinary::canWriteFileExtension(const char *extension)
+{
+    return canLoadFileExtension(extension);
+}
+
+/// get the file type description
+std::string SceneLoaderBinary::getFileTypeDesc()
+{
+    return "Binary scenes";
+}
+
+/// get the list of file extensions
+void SceneLoaderBinary::getExtensionList(ExtensionList* list)
+{
+    list->clear();
+    list->push_back("scnb");
+}
+
+sofa::simulation::Node::SPtr SceneLoaderBinary::load(const char *filename)
+{
+    if (!canLoadFileName(filename))
+        return 0;
+
+    notifyLoadingScene();
+
+    helper::io::MappedFile file;
+    if (!file.open(filename))
+    {
+        msg_error("SceneLoaderBinary") << "Unable to open the file " << filename;
+        return 0;
+    }
+
+    BinarySceneReader reader(file.getData(), file.getSize());
+    BinaryNode rootDesc;
+    rootDesc.index = std::size_t(-1);
+    if (!reader.readHeader() || !reader.readNode(rootDesc))
+    {
+        msg_error("SceneLoaderBinary") << filename << " is not a valid binary scene of version " << Version
+                                       << ", it must be compiled again from its source scene.";
+        return 0;
+    }
+
+    // We go the the current file's directory so that all relative path are correct
+    helper::system::SetDirectory chdir ( filename );
+
+    // the Data stored as text are parsed with the "C" numeric format
+    helper::system::TemporaryLocale locale(LC_NUMERIC, "C");
+
+    BinarySceneBuilder builder(parallelInstantiation);
+    Node::SPtr root = builder.build(rootDesc);
+
+    // Find the Simulation component in the scene
+    FindByTypeVisitor<Simulation> findSimu(core::ExecParams::defaultInstance());
+    findSimu.execute(root.get());
+    if( !findSimu.found.empty() )
+        setSimulation( findSimu.found[0] );
+
+    return root;
+}
+
+void SceneLoaderBinary::write(Node *node, const char *filename)
+{
+    if (!writeBinary(node, filename))
+        msg_error("SceneLoaderBinary") << "Unable to write the file " << filename;
+}
+
+bool SceneLoaderBinary::writeBinary(Node* root, const std::string& filename)
+{
+    BinarySceneWriter writer;
+    return writer.write(root, filename);
+}
+
+bool SceneLoaderBinary::compile(const std::string& sceneFilename, const std::string& binaryFilename)
+{
+    Node::SPtr root = getSimulation()->load(sceneFilename.c_str());
+    if (!root)
+    {
+        msg_error("SceneLoaderBinary") << "Unable to load the scene " << sceneFilename;
+        return false;
+    }
+    const bool written = writeBinary(root.get(), binaryFilename);
+    if (!written)
+        msg_error("SceneLoaderBinary") << "Unable to write the file " << binaryFilename;
+    getSimulation()->unload(root);
+    return written;
+}
+
+} // namespace simulation
+
+} // namespace sofa
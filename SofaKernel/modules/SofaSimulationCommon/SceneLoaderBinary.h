@@ -0,0 +1,99 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_SCENELOADERBINARY_H
+#define SOFA_SIMULATION_SCENELOADERBINARY_H
+
+#include <sofa/simulation/SceneLoaderFactory.h>
+
+#include <cstdint>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+/** Loader of the precompiled binary scenes (.scnb).
+ *
+ *  A binary scene is written from a scene graph that is loaded but not initialized yet, whatever
+ *  the format it was loaded from (XML, Python...). It stores the same nodes, components and Data
+ *  as exportXML, except that:
+ *  - the numeric Data holding many values (positions, indices...) are stored as raw values,
+ *    which are copied into the Data instead of being parsed;
+ *  - the links are stored as absolute paths, resolved when the scene is compiled.
+ *
+ *  The loader creates all the nodes first. The components are then created node by node: the
+ *  components of a node before its children, and the interaction components after them, as in
+ *  exportXML. The sibling subtrees that do not link to each other are populated concurrently
+ *  with the TaskScheduler, the ones linking to each other in the order of the scene. The links
+ *  between Data are connected last, from the loading thread.
+ *
+ *  The components are initialized by Simulation::init, in the order of the scene.
+ *
+ *  The file holds native byte order values: it is meant to be compiled on the computer loading it.
+ */
+class SOFA_SIMULATION_COMMON_API SceneLoaderBinary : public SceneLoader
+{
+public:
+    static const char Magic[8];
+    static const std::uint32_t Version = 1;
+    /// Minimum number of values for a numeric Data to be stored as raw values instead of text
+    static const std::size_t MinBinaryValues = 16;
+
+    /// Pre-loading check
+    virtual bool canLoadFileExtension(const char *extension);
+
+    /// Pre-saving check
+    virtual bool canWriteFileExtension(const char *extension);
+
+    /// load the file
+    virtual sofa::simulation::Node::SPtr load(const char *filename);
+
+    /// write the file
+    virtual void write(sofa::simulation::Node* node, const char *filename);
+
+    /// get the file type description
+    virtual std::string getFileTypeDesc();
+
+    /// get the list of file extensions
+    virtual void getExtensionList(ExtensionList* list);
+
+    /// Load a scene file of any registered format and write it as a binary scene
+    static bool compile(const std::string& sceneFilename, const std::string& binaryFilename);
+
+    /// Write a loaded scene graph as a binary scene, before its initialization
+    static bool writeBinary(Node* root, const std::string& filename);
+
+    /// Enable the concurrent population of the independent subtrees (enabled by default)
+    static void setParallelInstantiation(bool enabled) { parallelInstantiation = enabled; }
+    static bool getParallelInstantiation() { return parallelInstantiation; }
+
+protected:
+    static bool parallelInstantiation;
+};
+
+} // namespace simulation
+
+} // namespace sofa
+
+
+#endif // SOFA_SIMULATION_SCENELOADERBINARY_H
@@ -9,9 +9,50 @@ using sofa::core::ExecParams;
 #include <SofaSimulationGraph/testing/BaseSimulationTest.h>
 using sofa::helper::testing::BaseSimulationTest ;
 
+#include <sofa/core/DataEngine.h>
+#include <sofa/simulation/TaskScheduler.h>
+
 namespace sofa
 {
 
+/// output = a + b
+class SumEngine : public core::DataEngine
+{
+public:
+    SOFA_CLASS(SumEngine,core::DataEngine);
+
+    Data<int> a;
+    Data<int> b;
+    Data<int> output;
+    int nbUpdates;
+
+    SumEngine()
+        : a(initData(&a,0,"a","a"))
+        , b(initData(&b,0,"b","b"))
+        , output(initData(&output,0,"output","output"))
+        , nbUpdates(0)
+    {}
+
+    void init() override
+    {
+        addInput(&a);
+        addInput(&b);
+        addOutput(&output);
+        setDirtyValue();
+    }
+
+    void reinit() override
+    {
+        update();
+    }
+
+    void doUpdate() override
+    {
+        ++nbUpdates;
+        output.setValue(a.getValue() + b.getValue());
+    }
+};
+
 struct DefaultAnimationLoop_test : public BaseSimulationTest
 {
 
@@ -33,8 +74,57 @@ struct DefaultAnimationLoop_test : public BaseSimulationTest
         sofa::simulation::getSimulation()->animate ( root, (SReal)0.01 );
     }
 
+
+    /// left and right read a same Data, bottom sums their outputs
+    void testDataUpdate(bool parallelDataUpdate)
+    {
+        EXPECT_MSG_NOEMIT(Error, Warning) ;
+
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node 	name='Root' gravity='0 -9.81 0' time='0' animate='0' >               \n"
+                 "   <DefaultAnimationLoop parallelDataUpdate='" << parallelDataUpdate << "' />  \n"
+                 "</Node>                                                                        \n" ;
+
+        SceneInstance c("xml", scene.str()) ;
+        Node* root = c.root.get() ;
+        ASSERT_NE(root, nullptr) ;
+
+        SumEngine::SPtr left = core::objectmodel::New<SumEngine>();
+        SumEngine::SPtr right = core::objectmodel::New<SumEngine>();
+        SumEngine::SPtr bottom = core::objectmodel::New<SumEngine>();
+        root->addObject(left);
+        root->addObject(right);
+        root->addObject(bottom);
+        right->a.setParent(&left->a);
+        right->b.setValue(10);
+        bottom->a.setParent(&left->output);
+        bottom->b.setParent(&right->output);
+        c.initScene() ;
+
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        scheduler->init(4);
+        for (int v=1; v<5; ++v)
+        {
+            left->a.setValue(v);
+            const int nbUpdates = left->nbUpdates + right->nbUpdates + bottom->nbUpdates;
+            sofa::simulation::getSimulation()->animate ( root, (SReal)0.01 );
+            if (parallelDataUpdate)
+            {
+                // the engines were updated by the step, without any read of their outputs
+                ASSERT_FALSE(bottom->output.isDirty());
+                ASSERT_EQ(nbUpdates+3, left->nbUpdates + right->nbUpdates + bottom->nbUpdates);
+            }
+            else
+                ASSERT_TRUE(bottom->output.isDirty());
+            ASSERT_EQ(2*v + 10, bottom->output.getValue());
+        }
+        scheduler->stop();
+    }
 };
 
 TEST_F(DefaultAnimationLoop_test, testOneStep ) { testOneStep(); }
+TEST_F(DefaultAnimationLoop_test, testDataUpdate ) { testDataUpdate(false); }
+TEST_F(DefaultAnimationLoop_test, testParallelDataUpdate ) { testDataUpdate(true); }
 
 }
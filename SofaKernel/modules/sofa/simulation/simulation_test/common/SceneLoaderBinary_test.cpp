@@ -0,0 +1,248 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimulationGraph/testing/BaseSimulationTest.h>
+using sofa::helper::testing::BaseSimulationTest ;
+
+#include <SofaSimulationCommon/SceneLoaderBinary.h>
+using sofa::simulation::SceneLoaderBinary ;
+
+#include <SofaComponentBase/initComponentBase.h>
+#include <sofa/simulation/XMLPrintVisitor.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/core/objectmodel/BaseData.h>
+#include <sofa/core/ObjectFactory.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace sofa {
+
+using core::objectmodel::BaseData ;
+using simulation::Node ;
+
+/// Records how many instances are being constructed at the same time. When waitForOthers is set,
+/// the constructor waits (for a while) for another instance to be constructed concurrently.
+class ConcurrentComponent : public core::objectmodel::BaseObject
+{
+public:
+    SOFA_CLASS(ConcurrentComponent, core::objectmodel::BaseObject);
+
+    static std::mutex mutex;
+    static std::condition_variable condition;
+    static int nbStarted;
+    static int nbRunning;
+    static int maxRunning;
+    static bool waitForOthers;
+
+    static void reset(bool wait)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        nbStarted = nbRunning = maxRunning = 0;
+        waitForOthers = wait;
+    }
+
+protected:
+    ConcurrentComponent()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        const int index = nbStarted++;
+        ++nbRunning;
+        maxRunning = std::max(maxRunning, nbRunning);
+        condition.notify_all();
+        if (waitForOthers)
+            condition.wait_for(lock, std::chrono::seconds(5), [index] { return nbStarted > index + 1 || nbRunning > 1; });
+        --nbRunning;
+    }
+};
+
+std::mutex ConcurrentComponent::mutex;
+std::condition_variable ConcurrentComponent::condition;
+int ConcurrentComponent::nbStarted = 0;
+int ConcurrentComponent::nbRunning = 0;
+int ConcurrentComponent::maxRunning = 0;
+bool ConcurrentComponent::waitForOthers = false;
+
+int ConcurrentComponentClass = core::RegisterObject("Component recording its concurrent instantiations")
+        .add< ConcurrentComponent >();
+
+const char* filename = "SceneLoaderBinary_test.scnb";
+
+/// 8 points and 6 triangles: stored as raw values.
+/// B links to A, C and D are independent subtrees which can be populated concurrently.
+const std::string scene =
+        "<?xml version='1.0'?>"
+        "<Node name='root'>"
+        "   <Node name='A'>"
+        "       <MechanicalObject name='dofs' position='0 0 0  1 0 0  0 1 0  0 0 1  1 1 0  1 0 1  0 1 1  1 1 1'/>"
+        "       <UniformMass name='mass' totalMass='2'/>"
+        "       <Node name='mapped'>"
+        "           <MechanicalObject name='mappedDofs'/>"
+        "           <IdentityMapping input='@../dofs' output='@mappedDofs'/>"
+        "       </Node>"
+        "   </Node>"
+        "   <Node name='B'>"
+        "       <MeshTopology name='topo' position='@../A/dofs.position' triangles='0 1 2  1 2 3  2 3 4  3 4 5  4 5 6  5 6 7'/>"
+        "   </Node>"
+        "   <Node name='C'>"
+        "       <MechanicalObject name='dofs' position='0 0 0  1 0 0'/>"
+        "       <ConcurrentComponent name='concurrent'/>"
+        "   </Node>"
+        "   <Node name='D'>"
+        "       <MechanicalObject name='dofs' position='0 1 0  0 0 1'/>"
+        "       <ConcurrentComponent name='concurrent'/>"
+        "   </Node>"
+        "</Node>";
+
+struct SceneLoaderBinary_test : public BaseSimulationTest
+{
+    SceneLoaderBinary_test()
+    {
+        sofa::component::initComponentBase();
+    }
+
+    ~SceneLoaderBinary_test()
+    {
+        std::remove(filename);
+    }
+
+    static std::string print(Node* root)
+    {
+        std::ostringstream out;
+        simulation::XMLPrintVisitor printer(core::ExecParams::defaultInstance(), out);
+        root->execute(printer);
+        return out.str();
+    }
+
+    static std::string getValue(Node* root, const std::string& path, const std::string& dataName)
+    {
+        core::objectmodel::BaseObject* object = root->getObject(path);
+        if (!object)
+            return "not found";
+        BaseData* data = object->findData(dataName);
+        return data ? data->getValueString() : "not found";
+    }
+
+    static Node::SPtr loadBinary(bool parallel)
+    {
+        SceneLoaderBinary loader;
+        SceneLoaderBinary::setParallelInstantiation(parallel);
+        Node::SPtr root = loader.load(filename);
+        SceneLoaderBinary::setParallelInstantiation(true);
+        return root;
+    }
+
+    void writeAndLoad()
+    {
+        SceneInstance source("xml", scene);
+        ASSERT_NE(nullptr, source.root);
+        ASSERT_TRUE(SceneLoaderBinary::writeBinary(source.root.get(), filename));
+
+        Node::SPtr root = loadBinary(false);
+        ASSERT_NE(nullptr, root);
+        EXPECT_EQ("root", root->getName());
+        ASSERT_NE(nullptr, root->getChild("A"));
+        ASSERT_NE(nullptr, root->getChild("B"));
+        EXPECT_NE(nullptr, root->getChild("A")->getChild("mapped"));
+
+        // the raw values and the text values are restored
+        EXPECT_EQ(getValue(source.root.get(), "/A/dofs", "position"), getValue(root.get(), "/A/dofs", "position"));
+        EXPECT_EQ(getValue(source.root.get(), "/B/topo", "triangles"), getValue(root.get(), "/B/topo", "triangles"));
+        EXPECT_EQ("2", getValue(root.get(), "/A/mass", "totalMass"));
+
+        // the links are stored as absolute paths
+        core::objectmodel::BaseObject* topology = root->getObject("/B/topo");
+        ASSERT_NE(nullptr, topology);
+        BaseData* position = topology->findData("position");
+        ASSERT_NE(nullptr, position);
+        EXPECT_EQ("@/A/dofs.position", position->getLinkPath());
+        EXPECT_NE(nullptr, position->getParent());
+
+        // the mapping finds its input and output
+        sofa::simulation::getSimulation()->init(root.get());
+        EXPECT_EQ(getValue(root.get(), "/A/dofs", "position"), getValue(root.get(), "/A/mapped/mappedDofs", "position"));
+
+        sofa::simulation::getSimulation()->unload(root);
+    }
+
+    void parallelLoad()
+    {
+        SceneInstance source("xml", scene);
+        ASSERT_NE(nullptr, source.root);
+        ASSERT_TRUE(SceneLoaderBinary::writeBinary(source.root.get(), filename));
+
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        scheduler->init(4);
+
+        ConcurrentComponent::reset(false);
+        Node::SPtr serialRoot = loadBinary(false);
+        EXPECT_EQ(1, ConcurrentComponent::maxRunning);
+
+        // C and D are populated concurrently, A and B in the same task
+        ConcurrentComponent::reset(true);
+        Node::SPtr parallelRoot = loadBinary(true);
+        EXPECT_EQ(2, ConcurrentComponent::maxRunning);
+        ConcurrentComponent::reset(false);
+        scheduler->stop();
+
+        ASSERT_NE(nullptr, serialRoot);
+        ASSERT_NE(nullptr, parallelRoot);
+        EXPECT_EQ(print(serialRoot.get()), print(parallelRoot.get()));
+        EXPECT_EQ(getValue(serialRoot.get(), "/D/dofs", "position"), getValue(parallelRoot.get(), "/D/dofs", "position"));
+        EXPECT_EQ(getValue(serialRoot.get(), "/B/topo", "triangles"), getValue(parallelRoot.get(), "/B/topo", "triangles"));
+
+        sofa::simulation::getSimulation()->unload(serialRoot);
+        sofa::simulation::getSimulation()->unload(parallelRoot);
+    }
+
+    void invalidFile()
+    {
+        {
+            std::ofstream out(filename, std::ios::binary);
+            out << "<Node name='root'/>";
+        }
+        EXPECT_MSG_EMIT(Error);
+        SceneLoaderBinary loader;
+        EXPECT_EQ(nullptr, loader.load(filename));
+    }
+};
+
+TEST_F(SceneLoaderBinary_test, writeAndLoad)
+{
+    this->writeAndLoad();
+}
+
+TEST_F(SceneLoaderBinary_test, parallelLoad)
+{
+    this->parallelLoad();
+}
+
+TEST_F(SceneLoaderBinary_test, invalidFile)
+{
+    this->invalidFile();
+}
+
+} // namespace sofa
@@ -0,0 +1,227 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimulationGraph/testing/BaseSimulationTest.h>
+using sofa::helper::testing::BaseSimulationTest ;
+
+#include <sofa/simulation/VisualAspectBuffer.h>
+using sofa::simulation::VisualAspectBuffer ;
+
+#include <sofa/core/DataEngine.h>
+
+namespace sofa {
+
+using core::objectmodel::Data ;
+using simulation::Node ;
+
+/// output = 2 * input, the output being drawn
+class DoubleEngine : public core::DataEngine
+{
+public:
+    SOFA_CLASS(DoubleEngine, core::DataEngine);
+
+    Data<int> input;
+    Data<int> output;
+    Data<int> setting; ///< not read by the rendering
+    int nbUpdates;
+
+    DoubleEngine()
+        : input(initData(&input, 1, "input", "input"))
+        , output(initData(&output, 0, "output", "output"))
+        , setting(initData(&setting, 0, "setting", "setting"))
+        , nbUpdates(0)
+    {
+        output.setVisual(true);
+    }
+
+    void init() override
+    {
+        addInput(&input);
+        addOutput(&output);
+        setDirtyValue();
+    }
+
+    void reinit() override
+    {
+        update();
+    }
+
+    void doUpdate() override
+    {
+        ++nbUpdates;
+        output.setValue(2 * input.getValue());
+    }
+};
+
+/// Exposes the generation of the last full copy into each aspect
+class TestVisualAspectBuffer : public VisualAspectBuffer
+{
+public:
+    TestVisualAspectBuffer(Node* root) : VisualAspectBuffer(root) {}
+    using VisualAspectBuffer::copiedGeneration;
+    using VisualAspectBuffer::generation;
+};
+
+struct VisualAspectBuffer_test : public BaseSimulationTest
+{
+    SceneInstance scene;
+    DoubleEngine::SPtr engine;
+
+    VisualAspectBuffer_test()
+        : engine(core::objectmodel::New<DoubleEngine>())
+    {
+        scene.root->addObject(engine);
+        engine->init();
+    }
+
+    /// value of a Data in the aspect rendered by buffer
+    template<class T>
+    static T getRendered(VisualAspectBuffer& buffer, const Data<T>& data)
+    {
+        buffer.beginRender();
+        const T value = data.getValue();
+        buffer.endRender();
+        return value;
+    }
+
+    void publishAndRender()
+    {
+        TestVisualAspectBuffer buffer(scene.root.get());
+        core::ExecParams* params = core::ExecParams::defaultInstance();
+
+        // nothing published yet: the current aspect is rendered
+        EXPECT_EQ(0, buffer.beginRender());
+        buffer.endRender();
+
+        engine->input.setValue(3);
+        EXPECT_EQ(6, engine->output.getValue());
+        buffer.publish(params);
+
+        const int aspect = buffer.beginRender();
+        EXPECT_NE(0, aspect);
+        EXPECT_EQ(aspect, params->aspectID());
+        EXPECT_EQ(6, engine->output.getValue());
+        // nested calls keep the aspect
+        EXPECT_EQ(aspect, buffer.beginRender());
+        buffer.endRender();
+        EXPECT_EQ(aspect, params->aspectID());
+        buffer.endRender();
+        EXPECT_EQ(0, params->aspectID());
+
+        // the aspect being rendered is not written by the next publications
+        EXPECT_EQ(aspect, buffer.beginRender());
+        params->setAspectID(0);
+        engine->input.setValue(4);
+        EXPECT_EQ(8, engine->output.getValue());
+        buffer.publish(params);
+        buffer.publish(params);
+        params->setAspectID(aspect);
+        EXPECT_EQ(6, engine->output.getValue());
+        buffer.endRender();
+
+        EXPECT_EQ(8, getRendered(buffer, engine->output));
+    }
+
+    void dirtyDataAreNotUpdatedByTheRendering()
+    {
+        VisualAspectBuffer buffer(scene.root.get());
+        core::ExecParams* params = core::ExecParams::defaultInstance();
+
+        // full copy of a dirty output, then copy of the visual Data only
+        for (int i=0; i<core::SOFA_DATA_MAX_ASPECTS+1; ++i)
+        {
+            engine->input.setValue(10 + i);
+            ASSERT_TRUE(engine->output.isDirty());
+            const int nbUpdates = engine->nbUpdates;
+            buffer.publish(params);
+
+            buffer.beginRender();
+            EXPECT_FALSE(engine->output.isDirty());
+            engine->output.getValue();
+            buffer.endRender();
+            EXPECT_EQ(nbUpdates, engine->nbUpdates);
+            EXPECT_TRUE(engine->output.isDirty());
+        }
+    }
+
+    void generationSkipping()
+    {
+        TestVisualAspectBuffer buffer(scene.root.get());
+        core::ExecParams* params = core::ExecParams::defaultInstance();
+
+        // every aspect is fully copied once, then only the visual Data are copied
+        bool visualOnlyCopy = false;
+        for (int i=0; i<core::SOFA_DATA_MAX_ASPECTS+1; ++i)
+        {
+            const helper::fixed_array<int, core::SOFA_DATA_MAX_ASPECTS> copied = buffer.copiedGeneration;
+            engine->input.setValue(i);
+            engine->setting.setValue(i);
+            engine->output.getValue();
+            buffer.publish(params);
+
+            const int aspect = buffer.beginRender();
+            ASSERT_NE(0, aspect);
+            EXPECT_EQ(buffer.generation, buffer.copiedGeneration[aspect]);
+            EXPECT_EQ(2*i, engine->output.getValue());
+            if (copied[aspect] == buffer.generation)
+            {
+                // a setting changed since the full copy keeps its previous value
+                EXPECT_NE(i, engine->setting.getValue());
+                visualOnlyCopy = true;
+            }
+            else
+                EXPECT_EQ(i, engine->setting.getValue());
+            buffer.endRender();
+        }
+        EXPECT_TRUE(visualOnlyCopy);
+
+        // after invalidate, the next publication copies everything again
+        const int generation = buffer.generation;
+        buffer.invalidate();
+        EXPECT_EQ(generation+1, buffer.generation);
+        engine->setting.setValue(100);
+        buffer.publish(params);
+        const int aspect = buffer.beginRender();
+        EXPECT_EQ(buffer.generation, buffer.copiedGeneration[aspect]);
+        EXPECT_EQ(100, engine->setting.getValue());
+        buffer.endRender();
+    }
+};
+
+TEST_F(VisualAspectBuffer_test, publishAndRender)
+{
+    if (!VisualAspectBuffer::isSupported()) return; // requires SOFA_MAX_THREADS >= 2
+    this->publishAndRender();
+}
+
+TEST_F(VisualAspectBuffer_test, dirtyDataAreNotUpdatedByTheRendering)
+{
+    if (!VisualAspectBuffer::isSupported()) return;
+    this->dirtyDataAreNotUpdatedByTheRendering();
+}
+
+TEST_F(VisualAspectBuffer_test, generationSkipping)
+{
+    if (!VisualAspectBuffer::isSupported()) return;
+    this->generationSkipping();
+}
+
+} // namespace sofa
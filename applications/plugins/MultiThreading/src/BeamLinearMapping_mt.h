@@ -26,7 +26,7 @@
 #include <SofaMiscMapping/BeamLinearMapping.h>
 
 
-#include <sofa/simulation/Task.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 
 
@@ -100,114 +100,12 @@ public:
 
 private:
 
+	// kernels run by the scheduler on the point range [first, last)
+	void applyRange(const helper::ReadAccessor< Data< typename In::VecCoord > >& in, helper::WriteAccessor< Data< typename Out::VecCoord > >& out, size_t first, size_t last);
 
-	// all tasks here
-
-	class applyTask : public simulation::Task
-	{
-	
-		typedef typename BeamLinearMapping<TIn,TOut>::Out::VecCoord  VecCoord;
-		typedef typename BeamLinearMapping<TIn,TOut>::In::VecCoord  InVecCoord;
-
-	public:
-
-		virtual bool run() final;
-
-	protected:
-
-		applyTask( const simulation::Task::Status* status );
-
-	private:
-
-		BeamLinearMapping_mt<TIn,TOut>* _mapping;
-		
-		const helper::ReadAccessor< Data< typename In::VecCoord > >* _in;
-		helper::WriteAccessor< Data< typename Out::VecCoord > >* _out;
-
-		size_t _firstPoint;
-		size_t _lastPoint;
-
-		friend class BeamLinearMapping_mt<TIn,TOut>;
-	};
-
-	
-	class applyJTask : public simulation::Task
-	{
-	
-		typedef typename BeamLinearMapping<TIn,TOut>::Out::VecDeriv  VecDeriv;
-		typedef typename BeamLinearMapping<TIn,TOut>::In::VecDeriv  InVecDeriv;
-
-	public:
-	
-		applyJTask( const simulation::Task::Status* status );
-
-		virtual bool run() final;
-
-	private:
-
-		BeamLinearMapping_mt<TIn,TOut>* _mapping;
-
-		const helper::ReadAccessor< Data< typename In::VecDeriv > >* _in;
-		helper::WriteAccessor< Data< typename Out::VecDeriv > >* _out;
-
-		size_t _firstPoint;
-		size_t _lastPoint;
-
-		friend class BeamLinearMapping_mt<TIn,TOut>;
-	};
-
-
-	class applyJTmechTask : public simulation::Task
-	{
-		typedef typename BeamLinearMapping<TIn,TOut>::Out::VecDeriv  VecDeriv;
-		typedef typename BeamLinearMapping<TIn,TOut>::In::VecDeriv  InVecDeriv;
-
-	public:
-		
-		applyJTmechTask( const simulation::Task::Status* status );
-	
-		virtual bool run() final;
-
-	private:
-
-		BeamLinearMapping_mt<TIn,TOut>* _mapping;
-
-		const helper::ReadAccessor< Data< typename Out::VecDeriv > >* _in;
-		helper::WriteAccessor< Data< typename In::VecDeriv > >* _out;
-
-		size_t _firstPoint;
-		size_t _lastPoint;
-
-		friend class BeamLinearMapping_mt<TIn,TOut>;
-	};
-
-
-	//class applyJTconstrTask : public simulation::Task
-	//{
-	//public:
-	//	applyJTconstrTask( const simulation::Task::Status* status );
-
-	//	virtual bool run( simulation::WorkerThread* );
-
-	//private:
-
-	//	BeamLinearMapping_mt<TIn,TOut>* _mapping;
-
-	//	helper::WriteAccessor< Data< typename In::MatrixDeriv > >* _out;
-	//	const helper::ReadAccessor< Data< typename Out::MatrixDeriv > >* _in;
-
-	//	size_t _firstPoint;
-	//	size_t _lastPoint;
-
-	//	friend class BeamLinearMapping_mt<TIn,TOut>;
-	//};
-
-
-	friend class applyTask;
-	friend class applyJTask;
-	friend class applyJTmechTask;
-	//friend class applyJTconstrTask;
+	void applyJRange(const helper::ReadAccessor< Data< typename In::VecDeriv > >& in, helper::WriteAccessor< Data< typename Out::VecDeriv > >& out, size_t first, size_t last);
 
+	void applyJTRange(const helper::ReadAccessor< Data< typename Out::VecDeriv > >& in, helper::WriteAccessor< Data< typename In::VecDeriv > >& out, size_t first, size_t last);
 
 };
 
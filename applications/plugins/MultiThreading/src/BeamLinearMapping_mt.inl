@@ -24,10 +24,10 @@
 
 #include "BeamLinearMapping_mt.h"
 
-#include "BeamLinearMapping_tasks.inl"
-
 #include <sofa/simulation/TaskScheduler.h>
 
+#include <algorithm>
+
 namespace sofa
 {
 
@@ -72,86 +72,21 @@ namespace mapping
 	template <class TIn, class TOut>
     void BeamLinearMapping_mt< TIn, TOut>::apply(const core::MechanicalParams* mparams /* PARAMS FIRST */, Data<VecCoord>& _out, const Data<typename In::VecCoord>& _in)
 	{
-
-		//Inherit::apply(mparams, dOut, dIn);
-		//boost::pool<> task_pool(sizeof(BeamLinearMapping_mt< TIn, TOut>::applyTask));
-
-        unsigned int numPoints = this->points.size();
+        const size_t numPoints = this->points.size();
 
 		if ( numPoints >  2*mGrainSize.getValue()  )
 		{		
 			helper::WriteAccessor< Data< typename Out::VecCoord > > out = _out;
 			helper::ReadAccessor< Data< typename In::VecCoord > > in = _in;
 
-			//const InVecCoord& in= _in.getValue();
-			//VecCoord& out = *_out.beginEdit();
-
-            this->rotatedPoints0.resize(this->points.size());
-            this->rotatedPoints1.resize(this->points.size());
-            out.resize(this->points.size());
-
-
-			// create tasks
-            simulation::Task::Status status;
-            simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
-
-			const int taskSize = 2*mGrainSize.getValue();
-
-			int nbTasks = numPoints / taskSize;
-			int pointsLeft = numPoints % taskSize;
-
-			for ( int i=0; i<nbTasks; ++i)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyTask( &status );
-
-				task->_mapping = this;
-				//task->_mparams = mparams;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = i*taskSize;
-				task->_lastPoint = i*taskSize + mGrainSize.getValue();
-
-                scheduler->addTask( task );
-
-			}
-			if ( pointsLeft > 0)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyTask( &status );
-
-				task->_mapping = this;
-				//task->_mparams = mparams;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = nbTasks*taskSize;
-				task->_lastPoint = nbTasks*taskSize + pointsLeft;
-
-                scheduler->addTask( task );
-
-			}
-
-            scheduler->workUntilDone(&status);
-
-
-			for ( int i=0; i<nbTasks; ++i)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyTask( &status );
-
-				task->_mapping = this;
-				//task->_mparams = mparams;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = i*taskSize + mGrainSize.getValue();
-				task->_lastPoint = i*taskSize + taskSize;
-
-                scheduler->addTask( task );
-
-			}
-
-            scheduler->workUntilDone(&status);
+            this->rotatedPoints0.resize(numPoints);
+            this->rotatedPoints1.resize(numPoints);
+            out.resize(numPoints);
 
+            // each point only writes its own output
+            simulation::TaskScheduler::getInstance()->parallel_for(size_t(0), numPoints,
+                [&](size_t first, size_t last) { applyRange(in, out, first, last); },
+                size_t(mGrainSize.getValue()));
 		}
 		else
 		{
@@ -160,89 +95,26 @@ namespace mapping
 
 		}
 
-		// it doesn't call the destructor
-		//task_pool.purge_memory();
-
 	}
 
 
 
 	template <class TIn, class TOut>
-	//void AdaptiveBeamMapping< TIn, TOut>::applyJ( typename Out::VecDeriv& out, const typename In::VecDeriv& in )
 	void BeamLinearMapping_mt< TIn, TOut>::applyJ(const core::MechanicalParams * params /* PARAMS FIRST */, Data< typename Out::VecDeriv >& _out, const Data< typename In::VecDeriv >& _in)
 	{
-
-		//boost::pool<> task_pool(sizeof(BeamLinearMapping_mt< TIn, TOut>::applyJTask));
-        unsigned int numPoints = this->points.size();
+        const size_t numPoints = this->points.size();
 
 		if ( numPoints >  2*mGrainSize.getValue()  )
 		{		
 			helper::WriteAccessor< Data< typename Out::VecDeriv > > out = _out;
 			helper::ReadAccessor< Data< typename In::VecDeriv > > in = _in;
 
-			//const InVecDeriv& in= dIn.getValue();
-			//VecDeriv& out = *dOut.beginEdit();
-
-
-            out.resize(this->points.size());
-
-            simulation::Task::Status status;
-            simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
-
-			const int taskSize = 2*mGrainSize.getValue();
-
-			int nbTasks = numPoints / taskSize;
-			int pointsLeft = numPoints % taskSize;
-
-			for ( int i=0; i<nbTasks; ++i)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyJTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyJTask( &status );
-
-				task->_mapping = this;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = i*taskSize;
-				task->_lastPoint = i*taskSize + mGrainSize.getValue();
-
-                scheduler->addTask( task );
-
-			}
-			if ( pointsLeft > 0)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyJTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyJTask( &status );
-
-				task->_mapping = this;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = nbTasks*taskSize;
-				task->_lastPoint = nbTasks*taskSize + pointsLeft;
-
-                scheduler->addTask( task );
-
-			}
-
-            scheduler->workUntilDone(&status);
-
-
-			for ( int i=0; i<nbTasks; ++i)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyJTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyJTask( &status );
-
-				task->_mapping = this;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = i*taskSize + mGrainSize.getValue();
-				task->_lastPoint = i*taskSize + taskSize;
-
-                scheduler->addTask( task );
-
-			}
-
-            scheduler->workUntilDone(&status);
+            out.resize(numPoints);
 
+            // each point only writes its own output
+            simulation::TaskScheduler::getInstance()->parallel_for(size_t(0), numPoints,
+                [&](size_t first, size_t last) { applyJRange(in, out, first, last); },
+                size_t(mGrainSize.getValue()));
 		}
 		else
 		{
@@ -251,9 +123,6 @@ namespace mapping
 
 		}
 
-		// it doesn't call the destructor
-		//task_pool.purge_memory();
-
 	}
 
 
@@ -262,85 +131,148 @@ namespace mapping
 	template <class TIn, class TOut>
 	void BeamLinearMapping_mt<TIn, TOut>::applyJT(const core::MechanicalParams * mparams /* PARAMS FIRST */, Data< typename In::VecDeriv >& _out, const Data< typename Out::VecDeriv >& _in)
 	{
-
-		//boost::pool<> task_pool(sizeof(BeamLinearMapping_mt< TIn, TOut>::applyJTmechTask));
-
-        unsigned int numPoints = this->points.size();
+        const size_t numPoints = this->points.size();
 
 		if ( numPoints >  2*mGrainSize.getValue()  )
 		{		
 			helper::WriteAccessor< Data< typename In::VecDeriv > > out = _out;
 			helper::ReadAccessor< Data< typename Out::VecDeriv > > in = _in;
 
-
-            simulation::Task::Status status;
             simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
 
-			const int taskSize = 2*mGrainSize.getValue();
-
-			int nbTasks = numPoints / taskSize;
-			int pointsLeft = numPoints % taskSize;
-
-			for ( int i=0; i<nbTasks; ++i)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyJTmechTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyJTmechTask( &status );
-
-				task->_mapping = this;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = i*taskSize;
-				task->_lastPoint = i*taskSize + mGrainSize.getValue();
-
-                scheduler->addTask( task );
+            // points accumulate into the two beam nodes around them: the points are
+            // cut in blocks of grain size, and the even and odd blocks are processed
+            // in two passes so that neighbouring blocks never run at the same time
+            const size_t grainSize = std::max<size_t>(1, mGrainSize.getValue());
+            const size_t taskSize = 2*grainSize;
+            const size_t nbBlocks = (numPoints + taskSize - 1) / taskSize;
+
+            for (size_t pass = 0; pass < 2; ++pass)
+            {
+                scheduler->parallel_for(size_t(0), nbBlocks, [&](size_t firstBlock, size_t lastBlock)
+                {
+                    for (size_t block = firstBlock; block < lastBlock; ++block)
+                    {
+                        const size_t first = block*taskSize + pass*grainSize;
+                        const size_t last = std::min(first + grainSize, numPoints);
+                        if (first < last)
+                            applyJTRange(in, out, first, last);
+                    }
+                }, size_t(1));
+            }
 
-			}
-			if ( pointsLeft > 0)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyJTmechTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyJTmechTask( &status );
-
-				task->_mapping = this;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = nbTasks*taskSize;
-				task->_lastPoint = nbTasks*taskSize + pointsLeft;
+		}
+		else
+		{
 
-                scheduler->addTask( task );
+			BeamLinearMapping<TIn,TOut>::applyJT( mparams, _out, _in );
 
-			}
+		}
 
-            scheduler->workUntilDone(&status);
+	}
 
 
-			for ( int i=0; i<nbTasks; ++i)
-			{
-				typename BeamLinearMapping_mt< TIn, TOut>::applyJTmechTask* task = 
-					new typename BeamLinearMapping_mt< TIn, TOut>::applyJTmechTask( &status );
+	template <class TIn, class TOut>
+	void BeamLinearMapping_mt< TIn, TOut>::applyRange(const helper::ReadAccessor< Data< typename In::VecCoord > >& in, helper::WriteAccessor< Data< typename Out::VecCoord > >& out, size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; ++i )
+		{
+			Coord inpos = this->points[i];
+			int in0 = helper::rfloor(inpos[0]);
+			if (in0<0) 
+				in0 = 0; 
+			else if (in0 > (int)in.size()-2) 
+				in0 = in.size()-2;
+			inpos[0] -= in0;
+
+            const typename In::Coord _in0 = in[in0];
+            const typename In::Coord _in1 = in[in0+1];
+			Real beamLengh = this->beamLength[in0];
+			Coord& rotatedPoint0 = this->rotatedPoints0[i];
+			Coord& rotatedPoint1 = this->rotatedPoints1[i];
+
+			rotatedPoint0 = _in0.getOrientation().rotate(inpos) * beamLengh;
+			Coord out0 = _in0.getCenter() + rotatedPoint0;
+			Coord inpos1 = inpos; inpos1[0] -= 1;
+			rotatedPoint1 = _in1.getOrientation().rotate(inpos1) * beamLengh;
+			Coord out1 = _in1.getCenter() + rotatedPoint1;
+			
+			Real fact = (Real)inpos[0];
+			fact = 3*(fact*fact)-2*(fact*fact*fact);
+			out[i] = out0 * (1-fact) + out1 * (fact);
+		}
+	}
 
-				task->_mapping = this;
-				task->_in = &in;
-				task->_out = &out;
-				task->_firstPoint = i*taskSize + mGrainSize.getValue();
-				task->_lastPoint = i*taskSize + taskSize;
 
-                scheduler->addTask( task );
+	template <class TIn, class TOut>
+	void BeamLinearMapping_mt< TIn, TOut>::applyJRange(const helper::ReadAccessor< Data< typename In::VecDeriv > >& in, helper::WriteAccessor< Data< typename Out::VecDeriv > >& out, size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; ++i )
+		{
 
-			}
+			// out = J in
+			// J = [ I -OM^ ]
+			//out[i] =  v - cross(rotatedPoints[i],omega);
+
+            defaulttype::Vec<N, typename In::Real> inpos = this->points[i];
+			int in0 = helper::rfloor(inpos[0]);
+			if (in0<0) 
+				in0 = 0; 
+			else if (in0 > (int)in.size()-2) 
+				in0 = in.size()-2;
+			inpos[0] -= in0;
+
+            const typename In::Deriv _in0 = in[in0];
+            const typename In::Deriv _in1 = in[in0+1];
+			const Coord& rotatedPoint0 = this->rotatedPoints0[i];
+			const Coord& rotatedPoint1 = this->rotatedPoints1[i];
+
+			Deriv omega0 = getVOrientation( _in0 );
+			Deriv out0 = getVCenter( _in0 ) - cross( rotatedPoint0, omega0);
+			Deriv omega1 = getVOrientation( _in1 );
+			Deriv out1 = getVCenter( _in1 ) - cross( rotatedPoint1, omega1);
+			Real fact = (Real)inpos[0];
+			fact = 3*(fact*fact)-2*(fact*fact*fact);
+			
+			out[i] = out0 * (1-fact) + out1 * (fact);
+		}
+	}
 
-            scheduler->workUntilDone(&status);
 
-		}
-		else
+	template <class TIn, class TOut>
+	void BeamLinearMapping_mt< TIn, TOut>::applyJTRange(const helper::ReadAccessor< Data< typename Out::VecDeriv > >& in, helper::WriteAccessor< Data< typename In::VecDeriv > >& out, size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; ++i )
 		{
 
-			BeamLinearMapping<TIn,TOut>::applyJT( mparams, _out, _in );
+			// out = Jt in
+			// Jt = [ I     ]
+			//      [ -OM^t ]
+			// -OM^t = OM^
+
+			defaulttype::Vec<N, typename In::Real> inpos = this->points[i];
+			int in0 = helper::rfloor(inpos[0]);
+			if (in0<0) 
+				in0 = 0; 
+			else if (in0 > (int)out.size()-2) 
+				in0 = out.size()-2;
+			inpos[0] -= in0;
+
+            typename In::Deriv& _out0 = out[in0];
+            typename In::Deriv& _out1 = out[in0+1];
+			const Coord& rotatedPoint0 = this->rotatedPoints0[i];
+			const Coord& rotatedPoint1 = this->rotatedPoints1[i];
+
+			Deriv f = in[i];
+			Real fact = (Real)inpos[0];
+			fact = 3*(fact*fact)-2*(fact*fact*fact);
+
+			getVCenter(_out0) += f * (1-fact);
+			getVOrientation(_out0) += cross( rotatedPoint0, f) * (1-fact);
+			getVCenter(_out1) += f * (fact);
+			getVOrientation(_out1) += cross( rotatedPoint1, f) * (fact);
 
 		}
-
-		// it doesn't call the destructor
-		//task_pool.purge_memory();
-
 	}
 
 
@@ -20,6 +20,9 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <sstream>
+#include <map>
+#include <cstring>
+#include <algorithm>
 
 #include "Binding_Data.h"
 #include "Binding_LinearSpring.h"
@@ -340,6 +343,238 @@ static int SetDataValuePythonList(BaseData* data, PyObject* args,
 
 
 
+/// @name Buffer protocol
+/// Data whose value is a contiguous array of numbers (helper::vector<Vec3d>, helper::vector<unsigned int>,
+/// Vec3f...) are exposed through the Python buffer protocol, so numpy.asarray(data) and memoryview(data)
+/// map the value without copy. The views are read-only, except inside an edit scope opened by
+/// Data.beginEdit() or a 'with data:' block, which marks the Data dirty when it closes. A view is
+/// invalidated when the Data is resized.
+/// @{
+
+/// Edit scopes opened from python: depth and value returned by beginEditVoidPtr
+struct DataEditScope
+{
+    int depth;
+    void* value;
+};
+
+static std::map<const BaseData*, DataEditScope>& getDataEditScopes()
+{
+    static std::map<const BaseData*, DataEditScope> scopes;
+    return scopes;
+}
+
+static void* getDataEditValue(const BaseData* data)
+{
+    std::map<const BaseData*, DataEditScope>& scopes = getDataEditScopes();
+    std::map<const BaseData*, DataEditScope>::const_iterator it = scopes.find(data);
+    return it == scopes.end() ? NULL : it->second.value;
+}
+
+/// struct format character of the values of a Data, NULL if they can't be exposed as a buffer
+static const char* getBufferFormat(const AbstractTypeInfo* valuetypeinfo)
+{
+    static const std::map<std::string, const char*> formats = {
+        {"double", "d"}, {"float", "f"}, {"bool", "?"},
+        {"char", "b"}, {"unsigned char", "B"},
+        {"short", "h"}, {"unsigned short", "H"},
+        {"int", "i"}, {"unsigned int", "I"},
+        {"long", "l"}, {"unsigned long", "L"},
+        {"long long", "q"}, {"unsigned long long", "Q"}
+    };
+    std::map<std::string, const char*>::const_iterator it = formats.find(valuetypeinfo->name());
+    return it == formats.end() ? NULL : it->second;
+}
+
+/// Shape of the buffer of a Data: (rows, row width) for the resizable containers of fixed size
+/// rows, and (size) for the others. Returns false if the value is not a contiguous array of numbers.
+static bool getDataBufferShape(const BaseData* data, const void* valueVoidPtr,
+                               const char*& format, Py_ssize_t& itemsize, int& ndim, Py_ssize_t shape[2])
+{
+    const AbstractTypeInfo* typeinfo = data->getValueTypeInfo();
+    if (!typeinfo || !typeinfo->ValidInfo() || !typeinfo->SimpleLayout() || typeinfo->Text())
+        return false;
+
+    format = getBufferFormat(typeinfo->ValueType());
+    if (!format)
+        return false;
+    itemsize = (Py_ssize_t)typeinfo->byteSize();
+
+    const size_t nbValues = typeinfo->size(valueVoidPtr);
+    const size_t rowWidth = typeinfo->size();
+    if (typeinfo->FixedSize() || rowWidth <= 1)
+    {
+        ndim = 1;
+        shape[0] = (Py_ssize_t)nbValues;
+    }
+    else
+    {
+        ndim = 2;
+        shape[0] = (Py_ssize_t)(nbValues / rowWidth);
+        shape[1] = (Py_ssize_t)rowWidth;
+    }
+    return true;
+}
+
+static int Data_getbuffer(PyObject* self, Py_buffer* view, int flags)
+{
+    view->obj = NULL;
+    BaseData* data = get_basedata( self );
+
+    void* editValue = getDataEditValue(data);
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && !editValue)
+    {
+        PyErr_SetString(PyExc_BufferError, "writable views of a Data are only available inside Data.beginEdit()/Data.endEdit() or a 'with data:' block");
+        return -1;
+    }
+    const void* valueVoidPtr = editValue ? editValue : data->getValueVoidPtr();
+
+    const char* format;
+    Py_ssize_t itemsize;
+    int ndim;
+    Py_ssize_t shape[2];
+    if (!getDataBufferShape(data, valueVoidPtr, format, itemsize, ndim, shape))
+    {
+        PyErr_Format(PyExc_BufferError, "Data %s of type %s is not a contiguous array of numbers",
+                     data->getName().c_str(), data->getValueTypeString().c_str());
+        return -1;
+    }
+
+    /// shape and strides live as long as the view
+    Py_ssize_t* layout = new Py_ssize_t[4];
+    layout[0] = shape[0];
+    layout[1] = ndim == 2 ? shape[1] : 1;
+    layout[2] = ndim == 2 ? shape[1]*itemsize : itemsize;
+    layout[3] = itemsize;
+
+    /// an empty container may have no storage
+    static char emptyStorage[16];
+    const void* values = data->getValueTypeInfo()->getValuePtr(valueVoidPtr);
+    const Py_ssize_t nbItems = ndim == 2 ? shape[0]*shape[1] : shape[0];
+
+    view->buf = const_cast<void*>(values && nbItems ? values : (const void*)emptyStorage);
+    view->obj = self;
+    Py_INCREF(self);
+    view->len = nbItems*itemsize;
+    view->readonly = editValue ? 0 : 1;
+    view->itemsize = itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(format) : NULL;
+    view->ndim = ndim;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? layout : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? layout+2 : NULL;
+    view->suboffsets = NULL;
+    view->internal = layout;
+    return 0;
+}
+
+static void Data_releasebuffer(PyObject* /*self*/, Py_buffer* view)
+{
+    delete[] (Py_ssize_t*)view->internal;
+    view->internal = NULL;
+}
+
+/// Value of the item i of a buffer, as a double or as an integer depending on its format
+static bool getBufferItem(const char* format, const void* buf, Py_ssize_t i, double& scalar, long long& integer, bool& isInteger)
+{
+    isInteger = true;
+    switch (format[0])
+    {
+    case 'd': scalar = ((const double*)buf)[i]; isInteger = false; return true;
+    case 'f': scalar = ((const float*)buf)[i]; isInteger = false; return true;
+    case '?': integer = ((const bool*)buf)[i]; return true;
+    case 'b': integer = ((const signed char*)buf)[i]; return true;
+    case 'B': integer = ((const unsigned char*)buf)[i]; return true;
+    case 'h': integer = ((const short*)buf)[i]; return true;
+    case 'H': integer = ((const unsigned short*)buf)[i]; return true;
+    case 'i': integer = ((const int*)buf)[i]; return true;
+    case 'I': integer = ((const unsigned int*)buf)[i]; return true;
+    case 'l': integer = ((const long*)buf)[i]; return true;
+    case 'L': integer = ((const unsigned long*)buf)[i]; return true;
+    case 'q': integer = ((const long long*)buf)[i]; return true;
+    case 'Q': integer = (long long)((const unsigned long long*)buf)[i]; return true;
+    default: return false;
+    }
+}
+
+/// Copy a contiguous buffer of numbers (numpy array, memoryview, array.array...) into the Data.
+/// When the formats match the values are copied at once, otherwise they are converted one by one.
+static int SetDataValuePythonBuffer(BaseData* data, PyObject* args)
+{
+    const AbstractTypeInfo *typeinfo = data->getValueTypeInfo();
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(args, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+        return -1;
+
+    /// native byte order only
+    const char* format = view.format ? view.format : "B";
+    if (format[0] == '@') ++format;
+    if (strlen(format) != 1 || !strchr("dfbBhHiIlLqQ?", format[0]))
+    {
+        PyErr_Format(PyExc_TypeError, "unsupported buffer format '%s' for data %s", view.format ? view.format : "B", data->getName().c_str());
+        PyBuffer_Release(&view);
+        return -1;
+    }
+    const bool isIntegerBuffer = (format[0] != 'd' && format[0] != 'f');
+    if (!isIntegerBuffer && !typeinfo->Scalar())
+    {
+        PyBuffer_Release(&view);
+        PyErr_BadArgument();
+        return -1;
+    }
+
+    const size_t rowWidth = typeinfo->size();
+    if (view.ndim == 2 && !typeinfo->FixedSize() && (size_t)view.shape[1] != rowWidth)
+    {
+        PyErr_Format(PyExc_ValueError, "row size mismatch for data %s: %d values per row expected", data->getName().c_str(), (int)rowWidth);
+        PyBuffer_Release(&view);
+        return -1;
+    }
+
+    void* editVoidPtr = data->beginEditVoidPtr();
+
+    /// try to resize (of course, it is not possible with every container, the resize policy is defined in DataTypeInfo)
+    size_t size = view.itemsize ? (size_t)(view.len / view.itemsize) : 0;
+    if (typeinfo->size(editVoidPtr) != size)
+    {
+        typeinfo->setSize(editVoidPtr, size);
+        if (typeinfo->size(editVoidPtr) != size)
+        {
+            /// only a warning and not an exception, as for lists
+            SP_MESSAGE_WARNING( "buffer size mismatch for data \""<<data->getName()<<"\" (incorrect values count)" )
+            size = std::min(size, typeinfo->size(editVoidPtr));
+        }
+    }
+
+    const char* dataFormat = typeinfo->SimpleLayout() ? getBufferFormat(typeinfo->ValueType()) : NULL;
+    if (dataFormat && dataFormat[0] == format[0] && (Py_ssize_t)typeinfo->byteSize() == view.itemsize)
+    {
+        if (size)
+            memcpy(typeinfo->getValuePtr(editVoidPtr), view.buf, size*view.itemsize);
+    }
+    else
+    {
+        double scalar = 0;
+        long long integer = 0;
+        bool isInteger = false;
+        for (size_t i=0; i<size; ++i)
+        {
+            getBufferItem(format, view.buf, (Py_ssize_t)i, scalar, integer, isInteger);
+            if (typeinfo->Scalar())
+                typeinfo->setScalarValue(editVoidPtr, i, isInteger ? (double)integer : scalar);
+            else
+                typeinfo->setIntegerValue(editVoidPtr, i, integer);
+        }
+    }
+
+    data->endEditVoidPtr();
+    PyBuffer_Release(&view);
+    return 0;
+}
+
+/// @}
+
+
 int SetDataValuePython(BaseData* data, PyObject* args)
 {
     if (PyString_Check(args))
@@ -423,6 +658,13 @@ int SetDataValuePython(BaseData* data, PyObject* args)
         return SetDataValuePythonList(data, args, rowWidth, nbRows);
     }
 
+    /// numpy arrays and other buffers of numbers, except Data which are copied below
+    if ( valid && (typeinfo->Scalar() || typeinfo->Integer()) && PyObject_CheckBuffer(args)
+         && !PyObject_TypeCheck(args, &SP_SOFAPYTYPEOBJECT(Data)) )
+    {
+        return SetDataValuePythonBuffer(data, args);
+    }
+
     /// BaseData
     if( BaseData* targetData = get_basedata(args) )
     {
@@ -865,6 +1107,72 @@ static PyObject * Data_getHelp(PyObject *self, PyObject * args)
 }
 
 
+/// opens an edit scope: the buffer views of the Data are writable until the matching endEdit
+static PyObject * Data_beginEdit(PyObject *self, PyObject * /*args*/)
+{
+    BaseData* data = get_basedata( self );
+
+    std::map<const BaseData*, DataEditScope>& scopes = getDataEditScopes();
+    std::map<const BaseData*, DataEditScope>::iterator it = scopes.find(data);
+    if (it == scopes.end())
+    {
+        DataEditScope scope;
+        scope.depth = 1;
+        scope.value = data->beginEditVoidPtr();
+        scopes[data] = scope;
+    }
+    else
+    {
+        ++it->second.depth;
+    }
+
+    Py_RETURN_NONE;
+}
+
+/// closes an edit scope; the last one marks the Data dirty, so its outputs are updated with the new value
+static PyObject * Data_endEdit(PyObject *self, PyObject * /*args*/)
+{
+    BaseData* data = get_basedata( self );
+
+    std::map<const BaseData*, DataEditScope>& scopes = getDataEditScopes();
+    std::map<const BaseData*, DataEditScope>::iterator it = scopes.find(data);
+    if (it == scopes.end())
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Data.endEdit() without a matching Data.beginEdit()") ;
+        return NULL;
+    }
+
+    if (--it->second.depth == 0)
+    {
+        scopes.erase(it);
+        data->endEditVoidPtr();
+        data->setDirtyOutputs();
+    }
+
+    Py_RETURN_NONE;
+}
+
+/// 'with data:' opens an edit scope for the block
+static PyObject * Data___enter__(PyObject *self, PyObject * args)
+{
+    PyObject* res = Data_beginEdit(self, args);
+    if (!res)
+        return NULL;
+    Py_DECREF(res);
+    Py_INCREF(self);
+    return self;
+}
+
+static PyObject * Data___exit__(PyObject *self, PyObject * args)
+{
+    PyObject* res = Data_endEdit(self, args);
+    if (!res)
+        return NULL;
+    Py_DECREF(res);
+    Py_RETURN_FALSE;
+}
+
+
 /// implementation of __str__ to cast a Data to a string
 static PyObject * Data_str(PyObject *self)
 {
@@ -915,6 +1223,10 @@ SP_CLASS_METHOD(Data,getValueVoidPtr)
 SP_CLASS_METHOD(Data,getCounter)
 SP_CLASS_METHOD(Data,isDirty)
 SP_CLASS_METHOD(Data,getAsACreateObjectParameter)
+SP_CLASS_METHOD_DOC(Data,beginEdit, "Open an edit scope: numpy.asarray(data) and memoryview(data) are writable views of the value until the matching endEdit().")
+SP_CLASS_METHOD_DOC(Data,endEdit, "Close an edit scope opened by beginEdit(). Closing the last one marks the data dirty.")
+SP_CLASS_METHOD_DOC(Data,__enter__, "Open an edit scope for a 'with' block, see beginEdit().")
+SP_CLASS_METHOD_DOC(Data,__exit__, "Close the edit scope of a 'with' block, see endEdit().")
 SP_CLASS_METHODS_END
 
 
@@ -927,6 +1239,15 @@ namespace {
 static struct patch {
     patch() {
         SP_SOFAPYTYPEOBJECT(Data).tp_str = Data_str; /// adding __str__ function
+
+        /// zero-copy views of the value: numpy.asarray(data), memoryview(data)
+        static PyBufferProcs bufferProcs;
+        bufferProcs.bf_getbuffer = Data_getbuffer;
+        bufferProcs.bf_releasebuffer = Data_releasebuffer;
+        SP_SOFAPYTYPEOBJECT(Data).tp_as_buffer = &bufferProcs;
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+        SP_SOFAPYTYPEOBJECT(Data).tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
     }
 } patcher;
 }
@@ -64,6 +64,7 @@ public:
 SetOfPythonScenes scenes = {"test_BindingBase.py",
                             "test_BindingBaseObject.py",
                             "test_BindingData.py",
+                            "test_BindingDataBuffer.py",
                             "test_BindingLink.py",
                             "test_BindingNode.py",
                             "test_BindingSofa.py",
@@ -0,0 +1,52 @@
+# -*- coding: utf-8 -*-
+
+import Sofa
+import SofaTest
+import numpy
+
+def createScene(rootNode):
+    dofs = rootNode.createObject("MechanicalObject", template="Vec3d", name="dofs", position="0 1 2  3 4 5  6 7 8  9 10 11")
+    position = dofs.findData("position")
+
+    ### Zero-copy read-only view, with the shape and the type of the values
+    x = numpy.asarray(position)
+    ASSERT_EQ(x.shape, (4,3))
+    ASSERT_EQ(x.dtype, numpy.float64)
+    ASSERT_EQ(x[2,1], 7.0)
+    ASSERT_FALSE(x.flags.writeable)
+
+    ### Writable view inside an edit scope, the data is modified when the scope closes
+    t = position.getCounter()
+    with position:
+        w = numpy.asarray(position)
+        ASSERT_TRUE(w.flags.writeable)
+        w[:,1] += 10.0
+    ASSERT_NEQ(position.getCounter(), t)
+    ASSERT_EQ(dofs.position[2][1], 17.0)
+    ASSERT_EQ(x[2,1], 17.0)
+
+    position.beginEdit()
+    numpy.asarray(position)[0,0] = -1.0
+    position.endEdit()
+    ASSERT_EQ(dofs.position[0][0], -1.0)
+
+    endEditWithoutBeginEdit = False
+    try:
+        position.endEdit()
+    except RuntimeError:
+        endEditWithoutBeginEdit = True
+    ASSERT_TRUE(endEditWithoutBeginEdit)
+
+    ### Setting the value from arrays, with a resize and with a conversion of the values
+    dofs.position = numpy.zeros((6,3))
+    ASSERT_EQ(len(dofs.position), 6)
+    dofs.position = numpy.arange(6, dtype=numpy.float32).reshape(2,3)
+    ASSERT_EQ(len(dofs.position), 2)
+    ASSERT_EQ(dofs.position[1][2], 5.0)
+
+    ### One-dimensional integer values
+    fc = rootNode.createObject("FixedConstraint", name="fc", indices="0 1")
+    indices = fc.findData("indices")
+    ASSERT_EQ(numpy.asarray(indices).dtype, numpy.uint32)
+    fc.indices = numpy.array([3, 2, 1])
+    ASSERT_EQ(list(numpy.asarray(indices)), [3, 2, 1])
@@ -467,7 +467,7 @@ protected:
         Real pressure;
         Deriv normal;
         Real curvature;
-        sofa::helper::vector< std::pair<int,Real> > neighbors; ///< indice + r/h
+        sofa::helper::vector< std::pair<int,Real> > neighbors; ///< indice + r/h, each pair is stored on both particles
 #ifdef SOFA_DEBUG_SPATIALGRIDCONTAINER
         sofa::helper::vector< std::pair<int,Real> > neighbors2; ///< indice + r/h
 #endif
@@ -484,14 +484,13 @@ protected:
     friend class SPHFluidForceFieldInternalData<DataTypes>;
 
 public:
-    /// this method is called by the SpatialGrid when w connection between two particles is detected
+    /// this method is called by the SpatialGrid for each particle i1 and each of its neighbors i2
+    ///
+    /// Only particle i1 is modified, so that the particles can be processed in parallel.
     void addNeighbor(int i1, int i2, Real r2, Real h2)
     {
         Real r_h = (Real)sqrt(r2/h2);
-        if (i1<i2)
-            particles[i1].neighbors.push_back(std::make_pair(i2,r_h));
-        else
-            particles[i2].neighbors.push_back(std::make_pair(i1,r_h));
+        particles[i1].neighbors.push_back(std::make_pair(i2,r_h));
     }
 
 protected:
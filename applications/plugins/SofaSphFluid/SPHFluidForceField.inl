@@ -25,6 +25,7 @@
 #include <SofaSphFluid/SPHFluidForceField.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaSphFluid/SpatialGridContainer.inl>
+#include <sofa/simulation/TaskScheduler.h>
 #include <sofa/helper/system/config.h>
 #include <math.h>
 #include <iostream>
@@ -269,45 +270,54 @@ void SPHFluidForceField<DataTypes>::computeNeighbors(const core::MechanicalParam
 
     //int n0 = particles.size();
     particles.resize(n);
-    for (int i=0; i<n; i++)
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    scheduler->parallel_for(0, n, [&](int first, int last)
     {
-        particles[i].neighbors.clear();
+        for (int i=first; i<last; i++)
+        {
+            particles[i].neighbors.clear();
 #ifdef SOFA_DEBUG_SPATIALGRIDCONTAINER
-        particles[i].neighbors2.clear();
+            particles[i].neighbors2.clear();
 #endif
-    }
+        }
+    }, 1024);
 
     // First compute the neighbors
     // This is an O(n2) step, except if a hash-grid is used to optimize it
+    // Each particle stores all its neighbors, so that the particles can be processed in parallel
     if (grid == NULL)
     {
-        for (int i=0; i<n; i++)
+        scheduler->parallel_for(0, n, [&](int first, int last)
         {
-            const Coord& ri = x[i];
-            for (int j=i+1; j<n; j++)
+            for (int i=first; i<last; i++)
             {
-                const Coord& rj = x[j];
-                Real r2 = (rj-ri).norm2();
-                if (r2 < h2)
+                const Coord& ri = x[i];
+                for (int j=0; j<n; j++)
                 {
-                    Real r_h = (Real)sqrt(r2/h2);
-                    particles[i].neighbors.push_back(std::make_pair(j,r_h));
-                    //particles[j].neighbors.push_back(std::make_pair(i,r_h));
+                    if (j == i) continue;
+                    const Coord& rj = x[j];
+                    Real r2 = (rj-ri).norm2();
+                    if (r2 < h2)
+                    {
+                        Real r_h = (Real)sqrt(r2/h2);
+                        particles[i].neighbors.push_back(std::make_pair(j,r_h));
+                    }
                 }
             }
-        }
+        }, 64);
     }
     else
     {
         grid->updateGrid(x.ref());
-        grid->findNeighbors(this, h);
+        grid->findAllNeighbors(this, h);
 #ifdef SOFA_DEBUG_SPATIALGRIDCONTAINER
         // Check grid
         for (int i=0; i<n; i++)
         {
             const Coord& ri = x[i];
-            for (int j=i+1; j<n; j++)
+            for (int j=0; j<n; j++)
             {
+                if (j == i) continue;
                 const Coord& rj = x[j];
                 Real r2 = (rj-ri).norm2();
                 if (r2 < h2)
@@ -379,79 +389,77 @@ void SPHFluidForceField<DataTypes>::computeForce(const core::MechanicalParams* /
     dforces.clear();
     //int n0 = particles.size();
     particles.resize(n);
-    for (int i=0; i<n; i++)
-    {
-        particles[i].density = 0;
-        particles[i].pressure = 0;
-        particles[i].normal.clear();
-        particles[i].curvature = 0;
-    }
 
     TKd Kd(h);
     TKp Kp(h);
     TKv Kv(h);
     TKc Kc(h);
 
+    // Each pass only gathers the contributions of the neighbors of a particle
+    // into this particle, so that the particles can be processed in parallel.
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const int grain = 256;
+
     // Compute density and pressure
+    scheduler->parallel_for(0, n, [&](int first, int last)
     {
+        for (int i=first; i<last; i++)
         {
-            for (int i=0; i<n; i++)
-            {
-                Particle& Pi = particles[i];
-                Real density = Pi.density;
-
-                density += m*Kd.W(0); // density from current particle
+            Particle& Pi = particles[i];
+            const std::pair<int,Real>* neighbors = Pi.neighbors.data();
+            const int nbNeighbors = (int)Pi.neighbors.size();
 
-                for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
-                {
-                    const int j = it->first;
-                    const Real r_h = it->second;
-                    Particle& Pj = particles[j];
-                    Real d = m*Kd.W(r_h);
-                    density += d;
-                    Pj.density += d;
+            Real density = m*Kd.W(0); // density from current particle
+            for (int nb=0; nb<nbNeighbors; nb++)
+                density += m*Kd.W(neighbors[nb].second);
 
-                }
-                Pi.density = density;
-                Pi.pressure = k*(density - d0);
-            }
+            Pi.density = density;
+            Pi.pressure = k*(density - d0);
+            Pi.normal.clear();
+            Pi.curvature = 0;
         }
-    }
+    }, grain);
 
     // Compute surface normal and curvature
     if (surfaceTensionType == 1)
     {
-        for (int i=0; i<n; i++)
+        scheduler->parallel_for(0, n, [&](int first, int last)
         {
-            Particle& Pi = particles[i];
-            for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
+            for (int i=first; i<last; i++)
             {
-                const int j = it->first;
-                const Real r_h = it->second;
-                Particle& Pj = particles[j];
-                Deriv n = Kc.gradW(x[i]-x[j],r_h) * (m / Pj.density - m / Pi.density);
-                Pi.normal += n;
-                Pj.normal -= n;
-                Real c = Kc.laplacianW(r_h) * (m / Pj.density - m / Pi.density);
-                Pi.curvature += c;
-                Pj.curvature -= c;
+                Particle& Pi = particles[i];
+                for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
+                {
+                    const int j = it->first;
+                    const Real r_h = it->second;
+                    const Particle& Pj = particles[j];
+                    Deriv n = Kc.gradW(x[i]-x[j],r_h) * (m / Pj.density - m / Pi.density);
+                    // same signs as when each pair was accumulated from its lowest index
+                    if (i < j)
+                        Pi.normal += n;
+                    else
+                        Pi.normal -= n;
+                    Pi.curvature += Kc.laplacianW(r_h) * (m / Pj.density - m / Pi.density);
+                }
             }
-        }
+        }, grain);
     }
 
+    // Compute the forces
+    scheduler->parallel_for(0, n, [&](int first, int last)
     {
-        // Compute the forces
-        for (int i=0; i<n; i++)
+        for (int i=first; i<last; i++)
         {
-            Particle& Pi = particles[i];
+            const Particle& Pi = particles[i];
+            Deriv fi;
             // Gravity
-            //f[i] += g*(m*Pi.density);
+            //fi += g*(m*Pi.density);
 
             for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
             {
                 const int j = it->first;
                 const Real r_h = it->second;
-                Particle& Pj = particles[j];
+                const Particle& Pj = particles[j];
                 // Pressure
 
                 Real pressureFV = ( - m2 * (Pi.pressure / (Pi.density*Pi.density) + Pj.pressure / (Pj.density*Pj.density)) );
@@ -462,9 +470,7 @@ void SPHFluidForceField<DataTypes>::computeForce(const core::MechanicalParams* /
                 case 0: break;
                 case 1:
                 {
-                    Deriv fviscosity = ( v[j] - v[i] ) * ( m2 * viscosity / (Pi.density * Pj.density) * Kv.laplacianW(r_h) );
-                    f[i] += fviscosity;
-                    f[j] -= fviscosity;
+                    fi += ( v[j] - v[i] ) * ( m2 * viscosity / (Pi.density * Pj.density) * Kv.laplacianW(r_h) );
                     break;
                 }
                 case 2:
@@ -480,10 +486,7 @@ void SPHFluidForceField<DataTypes>::computeForce(const core::MechanicalParams* /
                     break;
                 }
 
-                Deriv fpressure = Kp.gradW(x[i]-x[j],r_h) * pressureFV;
-                f[i] += fpressure;
-                f[j] -= fpressure;
-
+                fi += Kp.gradW(x[i]-x[j],r_h) * pressureFV;
             }
 
             switch(surfaceTensionT)
@@ -494,8 +497,7 @@ void SPHFluidForceField<DataTypes>::computeForce(const core::MechanicalParams* /
                 Real n = Pi.normal.norm();
                 if (n > 0.000001)
                 {
-                    Deriv fsurface = Pi.normal * ( - m * surfaceTension * Pi.curvature / n );
-                    f[i] += fsurface;
+                    fi += Pi.normal * ( - m * surfaceTension * Pi.curvature / n );
                 }
                 break;
             }
@@ -506,8 +508,10 @@ void SPHFluidForceField<DataTypes>::computeForce(const core::MechanicalParams* /
             default:
                 break;
             }
+
+            f[i] += fi;
         }
-    }
+    }, grain);
 }
 
 template<class DataTypes>
@@ -607,6 +611,7 @@ void SPHFluidForceField<DataTypes>::draw(const core::visual::VisualParams* vpara
         for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
         {
             const int j = it->first;
+            if (j < (int)i) continue; // each pair is stored on both particles
             const float r_h = (float)it->second;
             float f = r_h*2;
             if (f < 1)
@@ -0,0 +1,269 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSphFluid/SPHFluidForceField.h>
+#include <SofaSphFluid/SpatialGridContainer.inl>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaTest/Sofa_test.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sofa {
+
+using simulation::Node;
+using component::forcefield::SPHKernel;
+using component::forcefield::SPH_KERNEL_DEFAULT_DENSITY;
+using component::forcefield::SPH_KERNEL_DEFAULT_PRESSURE;
+using component::forcefield::SPH_KERNEL_DEFAULT_VISCOSITY;
+
+/** Test the neighbor search of the compact grid and the parallel passes of SPHFluidForceField against
+ *  the hashing grid, the brute force search and the previous symmetric accumulation of the forces.
+ */
+struct SPHFluidForceField_test : public Sofa_test<SReal>
+{
+    typedef defaulttype::Vec3dTypes DataTypes;
+    typedef DataTypes::VecCoord VecCoord;
+    typedef DataTypes::VecDeriv VecDeriv;
+    typedef DataTypes::Deriv Deriv;
+    typedef DataTypes::Real Real;
+    typedef component::container::MechanicalObject<DataTypes> DOF;
+    typedef component::container::SpatialGridContainer<DataTypes> GridContainer;
+    typedef component::forcefield::SPHFluidForceField<DataTypes> ForceField;
+
+    enum { N = 8 };
+    const Real h = 1.0;
+    const Real mass = 0.4;
+    const Real stiffness = 50;
+    const Real density0 = 1;
+    const Real viscosity = 0.1;
+    const Real surfaceTension = 0.05;
+
+    VecCoord x;
+    VecDeriv v;
+    unsigned int threadCount;
+
+    SPHFluidForceField_test()
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        threadCount = scheduler->getThreadCount();
+        scheduler->init(4);
+
+        // a jittered block of N^3 particles, denser than the rest density, with a swirling velocity
+        x.resize(N*N*N);
+        v.resize(N*N*N);
+        for (int i=0; i<N*N*N; ++i)
+        {
+            const int px = i%N, py = (i/N)%N, pz = i/(N*N);
+            x[i] = Deriv(0.45*px + 0.1*std::sin(1.7*i), 0.45*py + 0.1*std::cos(2.3*i), 0.45*pz + 0.1*std::sin(0.3*i+1));
+            v[i] = Deriv(-0.3*(py-N/2), 0.3*(px-N/2), 0.05*std::cos(0.5*i));
+        }
+    }
+
+    ~SPHFluidForceField_test()
+    {
+        simulation::TaskScheduler::getInstance()->init(threadCount);
+    }
+
+    /// the neighbors of each particle, sorted
+    struct NeighborList
+    {
+        std::vector< std::vector<int> > neighbors;
+        NeighborList(std::size_t n) : neighbors(n) {}
+        /// called concurrently for different i1 by the compact grid
+        void addNeighbor(int i1, int i2, Real /*r2*/, Real /*h2*/) { neighbors[i1].push_back(i2); }
+        void sort() { for (std::size_t i=0; i<neighbors.size(); ++i) std::sort(neighbors[i].begin(), neighbors[i].end()); }
+    };
+
+    NeighborList bruteForceNeighbors() const
+    {
+        NeighborList list(x.size());
+        for (std::size_t i=0; i<x.size(); ++i)
+            for (std::size_t j=0; j<x.size(); ++j)
+                if (i != j && (x[j]-x[i]).norm2() < h*h)
+                    list.neighbors[i].push_back((int)j);
+        return list;
+    }
+
+    /// a node with the particles, a grid if gridType > 0 (1: hashing grid, 2: compact grid), and the force field
+    Node::SPtr createScene(int gridType, GridContainer::SPtr& grid, ForceField::SPtr& ff)
+    {
+        Node::SPtr root = simulation::getSimulation()->createNewGraph("root");
+        DOF::SPtr dof = core::objectmodel::New<DOF>();
+        dof->resize((int)x.size());
+        {
+            DOF::WriteVecCoord xdof = dof->writePositions();
+            copyToData(xdof, x);
+            DOF::WriteVecDeriv vdof = dof->writeVelocities();
+            copyToData(vdof, v);
+        }
+        root->addObject(dof);
+        if (gridType > 0)
+        {
+            grid = core::objectmodel::New<GridContainer>();
+            grid->d_cellWidth.setValue(h);
+            grid->d_compactGrid.setValue(gridType == 2);
+            root->addObject(grid);
+        }
+        ff = core::objectmodel::New<ForceField>();
+        ff->particleRadius.setValue(h);
+        ff->particleMass.setValue(mass);
+        ff->pressureStiffness.setValue(stiffness);
+        ff->density0.setValue(density0);
+        ff->viscosity.setValue(viscosity);
+        ff->surfaceTension.setValue(surfaceTension);
+        root->addObject(ff);
+        simulation::getSimulation()->init(root.get());
+        return root;
+    }
+
+    VecDeriv computeForces(ForceField* ff)
+    {
+        core::MechanicalParams mparams;
+        core::objectmodel::Data<VecCoord> dataX;
+        core::objectmodel::Data<VecDeriv> dataV, dataF;
+        dataX.setValue(x);
+        dataV.setValue(v);
+        ff->addForce(&mparams, dataF, dataX, dataV);
+        return dataF.getValue();
+    }
+
+    /// The previous version of SPHFluidForceField::computeForce with the default kernels: each pair is
+    /// visited once and scattered to both particles
+    VecDeriv referenceForces() const
+    {
+        SPHKernel<SPH_KERNEL_DEFAULT_DENSITY,Deriv> Kd(h), Kc(h);
+        SPHKernel<SPH_KERNEL_DEFAULT_PRESSURE,Deriv> Kp(h);
+        SPHKernel<SPH_KERNEL_DEFAULT_VISCOSITY,Deriv> Kv(h);
+        const Real m2 = mass*mass;
+        const std::size_t n = x.size();
+
+        std::vector< std::pair<int,int> > pairs;
+        std::vector<Real> pairRh;
+        for (std::size_t i=0; i<n; ++i)
+            for (std::size_t j=i+1; j<n; ++j)
+            {
+                const Real r2 = (x[j]-x[i]).norm2();
+                if (r2 < h*h)
+                {
+                    pairs.push_back(std::make_pair((int)i, (int)j));
+                    pairRh.push_back(std::sqrt(r2/(h*h)));
+                }
+            }
+
+        std::vector<Real> density(n, mass*Kd.W(0)), pressure(n), curvature(n, 0);
+        VecDeriv normal(n), f(n);
+        for (std::size_t p=0; p<pairs.size(); ++p)
+        {
+            const Real d = mass*Kd.W(pairRh[p]);
+            density[pairs[p].first] += d;
+            density[pairs[p].second] += d;
+        }
+        for (std::size_t i=0; i<n; ++i)
+            pressure[i] = stiffness*(density[i] - density0);
+
+        for (std::size_t p=0; p<pairs.size(); ++p)
+        {
+            const int i = pairs[p].first, j = pairs[p].second;
+            const Deriv nij = Kc.gradW(x[i]-x[j], pairRh[p]) * (mass/density[j] - mass/density[i]);
+            normal[i] += nij;
+            normal[j] -= nij;
+            const Real c = Kc.laplacianW(pairRh[p]) * (mass/density[j] - mass/density[i]);
+            curvature[i] += c;
+            curvature[j] -= c;
+        }
+
+        for (std::size_t p=0; p<pairs.size(); ++p)
+        {
+            const int i = pairs[p].first, j = pairs[p].second;
+            const Real pressureFV = - m2 * (pressure[i]/(density[i]*density[i]) + pressure[j]/(density[j]*density[j]));
+            const Deriv fviscosity = (v[j] - v[i]) * (m2 * viscosity / (density[i]*density[j]) * Kv.laplacianW(pairRh[p]));
+            const Deriv fpressure = Kp.gradW(x[i]-x[j], pairRh[p]) * pressureFV;
+            f[i] += fviscosity + fpressure;
+            f[j] -= fviscosity + fpressure;
+        }
+        for (std::size_t i=0; i<n; ++i)
+        {
+            const Real norm = normal[i].norm();
+            if (norm > 0.000001)
+                f[i] += normal[i] * (- mass * surfaceTension * curvature[i] / norm);
+        }
+        return f;
+    }
+
+    /// both grids report the neighbors of the brute force search, in both orders
+    void checkNeighbors()
+    {
+        NeighborList expected = bruteForceNeighbors();
+        for (int gridType=1; gridType<=2; ++gridType)
+        {
+            GridContainer::SPtr grid;
+            ForceField::SPtr ff;
+            Node::SPtr root = createScene(gridType, grid, ff);
+            ASSERT_EQ(gridType == 2, grid->isCompact());
+
+            NeighborList list(x.size());
+            grid->updateGrid(x);
+            grid->findAllNeighbors(&list, h);
+            list.sort();
+            for (std::size_t i=0; i<x.size(); ++i)
+                EXPECT_EQ(expected.neighbors[i], list.neighbors[i]) << "grid " << gridType << ", particle " << i;
+
+            simulation::getSimulation()->unload(root);
+        }
+    }
+
+    /// the forces with each neighbor search are the ones of the previous implementation
+    void checkForces()
+    {
+        const VecDeriv expected = referenceForces();
+        Real maxForce = 0;
+        for (std::size_t i=0; i<expected.size(); ++i)
+            maxForce = std::max(maxForce, expected[i].norm());
+        ASSERT_LT(0, maxForce);
+
+        for (int gridType=0; gridType<=2; ++gridType)
+        {
+            GridContainer::SPtr grid;
+            ForceField::SPtr ff;
+            Node::SPtr root = createScene(gridType, grid, ff);
+            const VecDeriv f = computeForces(ff.get());
+            ASSERT_EQ(expected.size(), f.size());
+            EXPECT_LT(this->vectorMaxDiff(expected, f), 1e-10*maxForce) << "grid " << gridType;
+            simulation::getSimulation()->unload(root);
+        }
+    }
+};
+
+TEST_F(SPHFluidForceField_test, neighbors)
+{
+    this->checkNeighbors();
+}
+
+TEST_F(SPHFluidForceField_test, forces)
+{
+    this->checkForces();
+}
+
+} // namespace sofa
@@ -323,6 +323,111 @@ protected:
 
 };
 
+/// Compact grid for large particle sets.
+///
+/// Instead of hashing blocks of cells, the particles are sorted by the Morton
+/// (Z-order) key of their cell with a radix sort, so that each occupied cell is
+/// a contiguous range of the sorted arrays, and neighboring cells are mostly
+/// close in memory. The neighbor search runs in parallel over the cells on the
+/// task scheduler.
+template<class DataTypes>
+class SortedSpatialGrid
+{
+public:
+    typedef typename DataTypes::Real Real;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef unsigned long long Key;
+    typedef defaulttype::Vec<3,int> CellCoord;
+
+    enum { KEY_BITS = 21 }; ///< bits per axis in a Morton key
+
+public:
+    SortedSpatialGrid(Real cellWidth);
+
+    void update(const VecCoord& x);
+
+    void draw(const core::visual::VisualParams* vparams);
+
+    /// Call dest->addNeighbor(i1, i2, r2, dist2) once for each pair of particles
+    /// closer than dist, with i1 < i2.
+    ///
+    /// All the calls for a given i1 are made by the same thread, so a listener
+    /// storing the pair on its first particle does not need any lock.
+    template<class NeighborListener>
+    void findNeighbors(NeighborListener* dest, Real dist)
+    {
+        findNeighbors(dest, dist, false);
+    }
+
+    /// Call dest->addNeighbor(i1, i2, r2, dist2) for each particle i1 and each
+    /// particle i2 closer than dist, i.e. twice for each pair.
+    ///
+    /// All the calls for a given i1 are made by the same thread.
+    template<class NeighborListener>
+    void findAllNeighbors(NeighborListener* dest, Real dist)
+    {
+        findNeighbors(dest, dist, true);
+    }
+
+    /// Renumber the particles in the order of the grid, i.e. along the Morton curve
+    ///
+    /// Fill the old2new and new2old arrays giving the permutation to apply
+    void reorderIndices(helper::vector<unsigned int>* old2new, helper::vector<unsigned int>* new2old);
+
+    Real getCellWidth() const { return cellWidth; }
+    Real getInvCellWidth() const { return invCellWidth; }
+
+    unsigned int getNbCells() const { return (unsigned int)cellKeys.size(); }
+
+    /// The particles of cell c are getSortedIndex()[getCellBegin()[c]] to getSortedIndex()[getCellBegin()[c+1]-1]
+    const helper::vector<unsigned int>& getCellBegin() const { return cellBegin; }
+    const helper::vector<unsigned int>& getSortedIndex() const { return sortedIndex; }
+    const helper::vector<Coord>& getSortedPositions() const { return sortedPos; }
+
+    /// Interleave the bits of the three cell coordinates
+    static Key mortonKey(unsigned int x, unsigned int y, unsigned int z)
+    {
+        return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+    }
+
+protected:
+    const Real cellWidth;
+    const Real invCellWidth;
+
+    CellCoord origin; ///< coordinates of the lowest cell
+    CellCoord extent; ///< largest coordinates of a cell, relative to origin
+
+    helper::vector<CellCoord> particleCell;
+    helper::vector<Key> particleKey, tmpKey;
+    helper::vector<unsigned int> sortedIndex, tmpIndex;
+    helper::vector<Coord> sortedPos;
+
+    helper::vector<Key> cellKeys; ///< key of each occupied cell, in increasing order
+    helper::vector<CellCoord> cellCoords; ///< coordinates of each occupied cell, relative to origin
+    helper::vector<unsigned int> cellBegin;
+
+    static Key spreadBits(Key v)
+    {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffULL;
+        v = (v | v << 16) & 0x1f0000ff0000ffULL;
+        v = (v | v << 8) & 0x100f00f00f00f00fULL;
+        v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+        v = (v | v << 2) & 0x1249249249249249ULL;
+        return v;
+    }
+
+    /// Index of the occupied cell with the given coordinates, or -1
+    int findCell(int x, int y, int z) const;
+
+    /// Sorted and merged ranges of particles of the cells within range cells of cell c
+    void getNeighborRanges(int c, int range, helper::vector< std::pair<unsigned int,unsigned int> >& ranges) const;
+
+    template<class NeighborListener>
+    void findNeighbors(NeighborListener* dest, Real dist, bool allPairs);
+};
+
 template<class DataTypes>
 class SpatialGridContainer : public virtual core::objectmodel::BaseObject
 {
@@ -333,11 +438,14 @@ public:
     typedef typename DataTypes::VecCoord VecCoord;
     typedef SpatialGridTypes<DataTypes> GridTypes;
     typedef SpatialGrid< GridTypes > Grid;
+    typedef SortedSpatialGrid< GridTypes > SortedGrid;
     Grid* grid;
+    SortedGrid* sortedGrid;
     Data<Real> d_cellWidth; ///< Width each cell in the grid. If it is used to compute neighboors, it should be greater that the max radius considered.
     Data<bool> d_showGrid; ///< activate rendering of the grid
     Data<bool> d_autoUpdate; ///< Automatically update the grid at each iteration.
     Data<bool> d_sortPoints; ///< Sort points depending on which cell they are in the grid. This is required for efficient collision detection.
+    Data<bool> d_compactGrid; ///< Store the particles in a compact grid sorted along a Morton curve, searched in parallel, instead of the hashing grid
 
     /// Pre-construction check method called by ObjectFactory.
     /// Check that DataTypes matches the MechanicalState.
@@ -358,18 +466,46 @@ public:
     virtual void handleEvent(sofa::core::objectmodel::Event* event) override;
 
     Grid* getGrid() { return grid; }
+    SortedGrid* getSortedGrid() { return sortedGrid; }
+    bool isCompact() const { return sortedGrid != NULL; }
+
     void updateGrid(const VecCoord& x)
     {
-        grid->update(x);
+        if (sortedGrid)
+            sortedGrid->update(x);
+        else
+            grid->update(x);
     }
 
     core::behavior::MechanicalState<DataTypes>* getMState() { return mstate; }
 
+    /// Call listener->addNeighbor(i1, i2, r2, r*r) once for each pair of particles closer than r
     template<class NeighborListener>
     void findNeighbors(NeighborListener* listener, Real r)
     {
-        grid->findNeighbors(listener, r);
+        if (sortedGrid)
+            sortedGrid->findNeighbors(listener, r);
+        else
+            grid->findNeighbors(listener, r);
+    }
+
+    /// Call listener->addNeighbor(i1, i2, r2, r*r) for each particle i1 and each particle i2
+    /// closer than r, i.e. twice for each pair.
+    ///
+    /// With the compact grid the calls for a given i1 all come from the same
+    /// thread, but different particles are processed in parallel.
+    template<class NeighborListener>
+    void findAllNeighbors(NeighborListener* listener, Real r)
+    {
+        if (sortedGrid)
+            sortedGrid->findAllNeighbors(listener, r);
+        else
+        {
+            SymmetricListener<NeighborListener> symmetric(listener);
+            grid->findNeighbors(&symmetric, r);
+        }
     }
+
     bool sortPoints();
 
     virtual std::string getTemplateName() const override
@@ -383,16 +519,32 @@ public:
     }
 protected:
     core::behavior::MechanicalState<DataTypes>* mstate;
+
+    /// Forward each pair found by the hashing grid in both orders
+    template<class NeighborListener>
+    class SymmetricListener
+    {
+    public:
+        NeighborListener* dest;
+        SymmetricListener(NeighborListener* dest) : dest(dest) {}
+        void addNeighbor(int i1, int i2, Real r2, Real h2)
+        {
+            dest->addNeighbor(i1, i2, r2, h2);
+            dest->addNeighbor(i2, i1, r2, h2);
+        }
+    };
 };
 
 #if  !defined(SOFA_COMPONENT_CONTAINER_SPATIALGRIDCONTAINER_CPP)
 #ifndef SOFA_FLOAT
 extern template class SpatialGridContainer< defaulttype::Vec3dTypes >;
 extern template class SOFA_SPH_FLUID_API SpatialGrid< SpatialGridTypes< sofa::defaulttype::Vec3dTypes > >;
+extern template class SOFA_SPH_FLUID_API SortedSpatialGrid< SpatialGridTypes< sofa::defaulttype::Vec3dTypes > >;
 #endif
 #ifndef SOFA_DOUBLE
 extern template class SpatialGridContainer< defaulttype::Vec3fTypes >;
 extern template class SOFA_SPH_FLUID_API SpatialGrid< SpatialGridTypes< sofa::defaulttype::Vec3fTypes > >;
+extern template class SOFA_SPH_FLUID_API SortedSpatialGrid< SpatialGridTypes< sofa::defaulttype::Vec3fTypes > >;
 #endif
 #endif
 
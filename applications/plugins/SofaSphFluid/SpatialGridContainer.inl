@@ -44,6 +44,8 @@
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/helper/system/gl.h>
 #include <SofaBaseMechanics/MechanicalObject.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <algorithm>
 
 
 namespace sofa
@@ -672,13 +674,238 @@ void SpatialGrid<DataTypes>::draw(const core::visual::VisualParams* )
 #endif /* SOFA_NO_OPENGL */
 }
 
+template<class DataTypes>
+SortedSpatialGrid<DataTypes>::SortedSpatialGrid(Real cellWidth)
+    : cellWidth(cellWidth), invCellWidth(1/cellWidth)
+{
+    cellBegin.push_back(0);
+}
+
+template<class DataTypes>
+void SortedSpatialGrid<DataTypes>::update(const VecCoord& x)
+{
+    const unsigned int n = (unsigned int)x.size();
+    particleCell.resize(n);
+    particleKey.resize(n);
+    sortedIndex.resize(n);
+    sortedPos.resize(n);
+    cellKeys.clear();
+    cellCoords.clear();
+    cellBegin.clear();
+    if (n == 0)
+    {
+        cellBegin.push_back(0);
+        return;
+    }
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const Real inv = invCellWidth;
+    scheduler->parallel_for(0u, n, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i=first; i<last; ++i)
+            for (int c=0; c<3; ++c)
+                particleCell[i][c] = helper::rfloor(x[i][c]*inv);
+    }, 1024u);
+
+    // bounds of the occupied cells, and number of bits needed per axis
+    CellCoord cmin = particleCell[0], cmax = particleCell[0];
+    for (unsigned int i=1; i<n; ++i)
+        for (int c=0; c<3; ++c)
+        {
+            if (particleCell[i][c] < cmin[c]) cmin[c] = particleCell[i][c];
+            else if (particleCell[i][c] > cmax[c]) cmax[c] = particleCell[i][c];
+        }
+    origin = cmin;
+    int bits = 0;
+    for (int c=0; c<3; ++c)
+    {
+        // far away particles are clamped to the last cell, which stays correct as the distances are checked
+        extent[c] = std::min(cmax[c]-cmin[c], (1<<KEY_BITS)-1);
+        while ((1<<bits) <= extent[c]) ++bits;
+    }
+
+    scheduler->parallel_for(0u, n, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i=first; i<last; ++i)
+        {
+            CellCoord& p = particleCell[i];
+            for (int c=0; c<3; ++c)
+                p[c] = std::min(p[c]-origin[c], extent[c]);
+            particleKey[i] = mortonKey(p[0], p[1], p[2]);
+        }
+    }, 1024u);
+
+    // LSD radix sort of the keys, each pass is a stable counting sort of 8 bits
+    for (unsigned int i=0; i<n; ++i)
+        sortedIndex[i] = i;
+    tmpKey.resize(n);
+    tmpIndex.resize(n);
+    const int nbPasses = (3*bits+7)/8;
+    for (int pass=0; pass<nbPasses; ++pass)
+    {
+        const int shift = 8*pass;
+        unsigned int count[257];
+        std::fill(count, count+257, 0u);
+        for (unsigned int i=0; i<n; ++i)
+            ++count[((particleKey[i] >> shift) & 255) + 1];
+        for (int b=0; b<256; ++b)
+            count[b+1] += count[b];
+        for (unsigned int i=0; i<n; ++i)
+        {
+            const unsigned int dest = count[(particleKey[i] >> shift) & 255]++;
+            tmpKey[dest] = particleKey[i];
+            tmpIndex[dest] = sortedIndex[i];
+        }
+        particleKey.swap(tmpKey);
+        sortedIndex.swap(tmpIndex);
+    }
+
+    // particleKey is now sorted: each run of equal keys is an occupied cell
+    for (unsigned int s=0; s<n; ++s)
+    {
+        if (s == 0 || particleKey[s] != particleKey[s-1])
+        {
+            cellKeys.push_back(particleKey[s]);
+            cellCoords.push_back(particleCell[sortedIndex[s]]);
+            cellBegin.push_back(s);
+        }
+    }
+    cellBegin.push_back(n);
+
+    scheduler->parallel_for(0u, n, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int s=first; s<last; ++s)
+            sortedPos[s] = x[sortedIndex[s]];
+    }, 1024u);
+}
+
+template<class DataTypes>
+int SortedSpatialGrid<DataTypes>::findCell(int x, int y, int z) const
+{
+    if (x < 0 || y < 0 || z < 0 || x > extent[0] || y > extent[1] || z > extent[2])
+        return -1;
+    const Key k = mortonKey(x, y, z);
+    typename helper::vector<Key>::const_iterator it = std::lower_bound(cellKeys.begin(), cellKeys.end(), k);
+    if (it == cellKeys.end() || *it != k)
+        return -1;
+    return (int)(it - cellKeys.begin());
+}
+
+template<class DataTypes>
+void SortedSpatialGrid<DataTypes>::getNeighborRanges(int c, int range, helper::vector< std::pair<unsigned int,unsigned int> >& ranges) const
+{
+    ranges.clear();
+    const CellCoord& p = cellCoords[c];
+    for (int z = p[2]-range; z <= p[2]+range; ++z)
+        for (int y = p[1]-range; y <= p[1]+range; ++y)
+            for (int x = p[0]-range; x <= p[0]+range; ++x)
+            {
+                const int nc = findCell(x, y, z);
+                if (nc >= 0)
+                    ranges.push_back(std::make_pair(cellBegin[nc], cellBegin[nc+1]));
+            }
+
+    // cells that follow each other on the Morton curve are merged into longer loops
+    std::sort(ranges.begin(), ranges.end());
+    unsigned int nbRanges = 0;
+    for (unsigned int r=0; r<ranges.size(); ++r)
+    {
+        if (nbRanges > 0 && ranges[nbRanges-1].second == ranges[r].first)
+            ranges[nbRanges-1].second = ranges[r].second;
+        else
+            ranges[nbRanges++] = ranges[r];
+    }
+    ranges.resize(nbRanges);
+}
+
+template<class DataTypes> template<class NeighborListener>
+void SortedSpatialGrid<DataTypes>::findNeighbors(NeighborListener* dest, Real dist, bool allPairs)
+{
+    const Real dist2 = dist*dist;
+    const int range = std::max(1, helper::rceil(dist*invCellWidth));
+    const int nbCells = (int)cellKeys.size();
+
+    simulation::TaskScheduler::getInstance()->parallel_for(0, nbCells, [&](int first, int last)
+    {
+        helper::vector< std::pair<unsigned int,unsigned int> > ranges;
+        for (int c=first; c<last; ++c)
+        {
+            getNeighborRanges(c, range, ranges);
+            for (unsigned int a=cellBegin[c]; a<cellBegin[c+1]; ++a)
+            {
+                const unsigned int i1 = sortedIndex[a];
+                const Coord p1 = sortedPos[a];
+                for (unsigned int r=0; r<ranges.size(); ++r)
+                {
+                    for (unsigned int b=ranges[r].first; b<ranges[r].second; ++b)
+                    {
+                        const unsigned int i2 = sortedIndex[b];
+                        if (allPairs ? i2 == i1 : i2 <= i1) continue;
+                        const Real r2 = (sortedPos[b] - p1).norm2();
+                        if (r2 < dist2)
+                            dest->addNeighbor((int)i1, (int)i2, r2, dist2);
+                    }
+                }
+            }
+        }
+    }, 16);
+}
+
+template<class DataTypes>
+void SortedSpatialGrid<DataTypes>::reorderIndices(helper::vector<unsigned int>* old2new, helper::vector<unsigned int>* new2old)
+{
+    const unsigned int n = (unsigned int)sortedIndex.size();
+    if (old2new != NULL)
+        old2new->resize(n);
+    if (new2old != NULL)
+        new2old->resize(n);
+    for (unsigned int s=0; s<n; ++s)
+    {
+        if (old2new != NULL)
+            (*old2new)[sortedIndex[s]] = s;
+        if (new2old != NULL)
+            (*new2old)[s] = sortedIndex[s];
+        sortedIndex[s] = s;
+    }
+}
+
+template<class DataTypes>
+void SortedSpatialGrid<DataTypes>::draw(const core::visual::VisualParams* vparams)
+{
+    std::vector<defaulttype::Vector3> points;
+    points.reserve(cellCoords.size()*24);
+    for (unsigned int c=0; c<cellCoords.size(); ++c)
+    {
+        const defaulttype::Vector3 p0((origin[0]+cellCoords[c][0])*cellWidth,
+                                      (origin[1]+cellCoords[c][1])*cellWidth,
+                                      (origin[2]+cellCoords[c][2])*cellWidth);
+        for (int axis=0; axis<3; ++axis)
+        {
+            const int u = (axis+1)%3, v = (axis+2)%3;
+            for (int e=0; e<4; ++e)
+            {
+                defaulttype::Vector3 a = p0;
+                if (e&1) a[u] += cellWidth;
+                if (e&2) a[v] += cellWidth;
+                defaulttype::Vector3 b = a;
+                b[axis] += cellWidth;
+                points.push_back(a);
+                points.push_back(b);
+            }
+        }
+    }
+    vparams->drawTool()->drawLines(points, 1, defaulttype::Vec4f(0.5f,0.5f,0.5f,1.0f));
+}
+
 template<class DataTypes>
 SpatialGridContainer<DataTypes>::SpatialGridContainer()
     : grid(NULL)
+    , sortedGrid(NULL)
     , d_cellWidth(initData(&d_cellWidth, (Real)1.0, "cellWidth", "Width each cell in the grid. If it is used to compute neighboors, it should be greater that the max radius considered."))
     , d_showGrid(initData(&d_showGrid, false, "showGrid", "activate rendering of the grid"))
     , d_autoUpdate(initData(&d_autoUpdate, false, "autoUpdate", "Automatically update the grid at each iteration."))
     , d_sortPoints(initData(&d_sortPoints, false, "sortPoints", "Sort points depending on which cell they are in the grid. This is required for efficient collision detection."))
+    , d_compactGrid(initData(&d_compactGrid, false, "compactGrid", "Store the particles in a compact grid sorted along a Morton curve, searched in parallel, instead of the hashing grid"))
     , mstate(NULL)
 {
     this->f_listening.setValue(true);
@@ -689,6 +916,8 @@ SpatialGridContainer<DataTypes>::~SpatialGridContainer()
 {
     if (grid != NULL)
         delete grid;
+    if (sortedGrid != NULL)
+        delete sortedGrid;
 }
 
 template<class DataTypes>
@@ -696,6 +925,8 @@ void SpatialGridContainer<DataTypes>::init()
 {
     mstate = dynamic_cast<core::behavior::MechanicalState<DataTypes>*>(this->getContext()->getMechanicalState());
     grid = new Grid(d_cellWidth.getValue());
+    if (d_compactGrid.getValue())
+        sortedGrid = new SortedGrid(d_cellWidth.getValue());
 }
 
 template<class DataTypes>
@@ -707,6 +938,13 @@ void SpatialGridContainer<DataTypes>::reinit()
             delete grid;
         grid = new Grid(d_cellWidth.getValue());
     }
+    if (sortedGrid != NULL && (!d_compactGrid.getValue() || sortedGrid->getCellWidth() != d_cellWidth.getValue()))
+    {
+        delete sortedGrid;
+        sortedGrid = NULL;
+    }
+    if (sortedGrid == NULL && d_compactGrid.getValue())
+        sortedGrid = new SortedGrid(d_cellWidth.getValue());
 }
 
 template<class DataTypes>
@@ -718,7 +956,10 @@ bool SpatialGridContainer<DataTypes>::sortPoints()
     msg_info() << "sortPoints(): sorting...";
 
     helper::vector<unsigned int> old2new, new2old;
-    grid->reorderIndices(&old2new, &new2old);
+    if (sortedGrid)
+        sortedGrid->reorderIndices(&old2new, &new2old);
+    else
+        grid->reorderIndices(&old2new, &new2old);
     // check if the mapping actually changed something
     bool identity = true;
     for (unsigned int i=0; i<old2new.size(); ++i)
@@ -795,7 +1036,9 @@ void SpatialGridContainer<DataTypes>::draw(const core::visual::VisualParams* vpa
 {
     if (!d_showGrid.getValue())
         return;
-    if (grid != NULL)
+    if (sortedGrid != NULL)
+        sortedGrid->draw(vparams);
+    else if (grid != NULL)
         grid->draw(vparams);
 }
 
@@ -67,6 +67,16 @@ public:
     /// Compute one simulation time-step
     void step();
 
+    /// Start computing one simulation time-step on the simulation thread, and return
+    /// without waiting for it. The output meshes, the time, the time-step, the gravity
+    /// and the animated state keep returning the values of the previous step until
+    /// waitStep() is called. The other methods first wait for the step to finish.
+    void stepAsync();
+
+    /// Wait for the step started by stepAsync() and publish its output meshes
+    /// (returns immediately if no step was started)
+    void waitStep();
+
     /// Reset the simulation to its initial state
     void reset();
 
@@ -138,6 +148,12 @@ public:
 };
 
 /// Class describing one output mesh (i.e. visual model) in the simulation
+///
+/// The values are copies of the visual model made at the end of the last step
+/// (snapshots). The returned arrays are not modified until the end of the next
+/// step (i.e. step() or waitStep()), and can be read while stepAsync() computes it.
+/// The arrays that did not change (e.g. the topology) are shared between the
+/// snapshots and keep their revision.
 class SOFA_SOFAPHYSICSAPI_API SofaPhysicsOutputMesh
 {
 public:
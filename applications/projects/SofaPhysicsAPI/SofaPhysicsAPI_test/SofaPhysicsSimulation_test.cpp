@@ -0,0 +1,151 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaPhysicsAPI/SofaPhysicsAPI.h>
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace sofa {
+
+const char* filename = "SofaPhysicsSimulation_test.scn";
+
+/// a falling triangle, seen by an output mesh
+const char* scene =
+        "<?xml version='1.0'?>"
+        "<Node name='root' dt='0.01' gravity='0 -10 0'>"
+        "   <EulerImplicitSolver/>"
+        "   <CGLinearSolver iterations='25' tolerance='1e-9' threshold='1e-9'/>"
+        "   <MechanicalObject name='dofs' position='0 0 0  1 0 0  0 1 0'/>"
+        "   <UniformMass totalMass='1'/>"
+        "   <Node name='visual'>"
+        "       <VisualModel name='mesh' position='0 0 0  1 0 0  0 1 0' triangles='0 1 2'/>"
+        "       <IdentityMapping input='@../dofs' output='@mesh'/>"
+        "   </Node>"
+        "</Node>";
+
+struct SofaPhysicsSimulation_test : public BaseTest
+{
+    void SetUp()
+    {
+        std::ofstream out(filename);
+        out << scene;
+    }
+
+    void TearDown()
+    {
+        std::remove(filename);
+    }
+
+    static std::vector<Real> getPositions(SofaPhysicsOutputMesh* mesh)
+    {
+        const Real* positions = mesh->getVPositions();
+        return std::vector<Real>(positions, positions + 3*mesh->getNbVertices());
+    }
+
+    /// positions of the output mesh after each step
+    static std::vector< std::vector<Real> > run(bool async, int nbSteps)
+    {
+        std::vector< std::vector<Real> > results;
+        SofaPhysicsAPI simulation(false);
+        EXPECT_TRUE(simulation.load(filename));
+        simulation.start();
+        EXPECT_TRUE(simulation.isAnimated());
+        EXPECT_DOUBLE_EQ(0.01, simulation.getTimeStep());
+        if (simulation.getNbOutputMeshes() != 1u)
+        {
+            ADD_FAILURE() << "the output mesh is not found";
+            return results;
+        }
+        SofaPhysicsOutputMesh* mesh = simulation.getOutputMeshes()[0];
+        EXPECT_EQ(3u, mesh->getNbVertices());
+
+        for (int i=0; i<nbSteps; ++i)
+        {
+            if (async)
+            {
+                const std::vector<Real> previous = getPositions(mesh);
+                const Real* previousBuffer = mesh->getVPositions();
+                simulation.stepAsync();
+
+                // until waitStep, the values of the previous step are published
+                EXPECT_DOUBLE_EQ(0.01*i, simulation.getTime());
+                EXPECT_TRUE(simulation.isAnimated());
+                double* gravity = simulation.getGravity();
+                EXPECT_DOUBLE_EQ(-10.0, gravity[1]);
+                delete[] gravity;
+                EXPECT_EQ(previous, getPositions(mesh));
+                EXPECT_EQ(previousBuffer, mesh->getVPositions());
+
+                simulation.waitStep();
+                // the buffer of the previous step is kept, the other one is published
+                EXPECT_NE(previousBuffer, mesh->getVPositions());
+            }
+            else
+            {
+                simulation.step();
+            }
+            EXPECT_DOUBLE_EQ(0.01*(i+1), simulation.getTime());
+            results.push_back(getPositions(mesh));
+        }
+        return results;
+    }
+
+    void stepAsync()
+    {
+        const std::vector< std::vector<Real> > sync = run(false, 5);
+        const std::vector< std::vector<Real> > async = run(true, 5);
+        ASSERT_EQ(sync.size(), async.size());
+        for (std::size_t i=0; i<sync.size(); ++i)
+            EXPECT_EQ(sync[i], async[i]) << "step " << i;
+        // the triangle falls
+        ASSERT_FALSE(sync.empty());
+        EXPECT_GT(0.0f, sync.back()[1]);
+    }
+
+    void waitWithoutStep()
+    {
+        SofaPhysicsAPI simulation(false);
+        ASSERT_TRUE(simulation.load(filename));
+        simulation.waitStep();
+        EXPECT_DOUBLE_EQ(0.0, simulation.getTime());
+        simulation.stepAsync();
+        simulation.waitStep();
+        simulation.waitStep();
+        EXPECT_DOUBLE_EQ(0.01, simulation.getTime());
+    }
+};
+
+TEST_F(SofaPhysicsSimulation_test, stepAsync)
+{
+    this->stepAsync();
+}
+
+TEST_F(SofaPhysicsSimulation_test, waitWithoutStep)
+{
+    this->waitWithoutStep();
+}
+
+} // namespace sofa
@@ -144,6 +144,8 @@ using namespace sofa::core::objectmodel;
 
 SofaPhysicsOutputMesh::Impl::Impl()
 	: sObj(NULL)
+    , front(0)
+    , backUpdated(false)
 {
 }
 
@@ -153,11 +155,12 @@ SofaPhysicsOutputMesh::Impl::~Impl()
 
 void SofaPhysicsOutputMesh::Impl::setObject(SofaOutputMesh* o)
 {
-	if (!sObj)
+	if (!o)
 		return;
 
     sObj = o;
     sVA.clear();
+    vaNames.clear();
     sofa::core::objectmodel::BaseContext* context = sObj->getContext();
     sofa::helper::vector<SofaVAttribute::SPtr> vSE;
     context->get<SofaVAttribute>(&vSE,sofa::core::objectmodel::BaseContext::Local);
@@ -167,8 +170,67 @@ void SofaPhysicsOutputMesh::Impl::setObject(SofaOutputMesh* o)
         if (se->getSEType() == sofa::core::visual::ShaderElement::SE_ATTRIBUTE)
         {
             sVA.push_back(se);
+            vaNames.push_back(se->getSEID());
         }
     }
+    snapshots[0] = Snapshot();
+    snapshots[1] = Snapshot();
+    backUpdated = false;
+}
+
+template<class T>
+void SofaPhysicsOutputMesh::Impl::copyArray(SharedArray<T>& dst, const SharedArray<T>& last, const sofa::core::objectmodel::BaseData& data, const void* values, std::size_t size)
+{
+    const int revision = data.getCounter();
+    if (last.values && last.revision == revision)
+    {
+        dst = last;
+        return;
+    }
+    const T* begin = (const T*)values;
+    dst.values = std::shared_ptr< const std::vector<T> >(new std::vector<T>(begin, begin + size));
+    dst.revision = revision;
+}
+
+void SofaPhysicsOutputMesh::Impl::updateSnapshot()
+{
+    if (!sObj) return;
+    const Snapshot& last = snapshots[front];
+    Snapshot& next = snapshots[1-front];
+
+    // we cannot use getVertices() method directly as we need the Data revision
+    const Data<ResizableExtVector<Coord> > * vertices =
+        (!sObj->m_vertPosIdx.getValue().empty()) ?
+        &(sObj->m_vertices2) : &(sObj->m_positions);
+    const ResizableExtVector<Coord>& x = vertices->getValue();
+    copyArray(next.positions, last.positions, *vertices, x.getData(), x.size()*3);
+    const ResizableExtVector<Deriv>& n = sObj->m_vnormals.getValue();
+    copyArray(next.normals, last.normals, sObj->m_vnormals, n.getData(), n.size()*3);
+    const ResizableExtVector<TexCoord>& t = sObj->m_vtexcoords.getValue();
+    copyArray(next.texCoords, last.texCoords, sObj->m_vtexcoords, t.getData(), t.size()*2);
+
+    next.attributes.resize(sVA.size());
+    for (unsigned int i = 0; i < sVA.size(); ++i)
+    {
+        const sofa::core::objectmodel::BaseData* data = sVA[i]->getSEValue();
+        const ResizableExtVector<Real>* a = (const ResizableExtVector<Real>*)data->getValueVoidPtr(); // make sure the data is updated
+        copyArray(next.attributes[i], i < last.attributes.size() ? last.attributes[i] : SharedArray<Real>(), *data, a->getData(), a->size());
+    }
+
+    // the topology is only copied when its revision changes
+    const ResizableExtVector<Triangle>& triangles = sObj->m_triangles.getValue();
+    copyArray(next.triangles, last.triangles, sObj->m_triangles, triangles.getData(), triangles.size()*3);
+    const ResizableExtVector<Quad>& quads = sObj->m_quads.getValue();
+    copyArray(next.quads, last.quads, sObj->m_quads, quads.getData(), quads.size()*4);
+
+    backUpdated = true;
+}
+
+void SofaPhysicsOutputMesh::Impl::swapSnapshots()
+{
+    if (!backUpdated) return;
+    front = 1-front;
+    backUpdated = false;
 }
 
 const char* SofaPhysicsOutputMesh::Impl::getName() ///< (non-unique) name of this object
@@ -184,46 +246,30 @@ ID SofaPhysicsOutputMesh::Impl::getID() ///< unique ID of this object
 
 unsigned int SofaPhysicsOutputMesh::Impl::getNbVertices() ///< number of vertices
 {
-    if (!sObj) return 0;
-    // we cannot use getVertices() method directly as we need the Data revision
-    Data<ResizableExtVector<Coord> > * data =
-        (!sObj->m_vertPosIdx.getValue().empty()) ?
-        &(sObj->m_vertices2) : &(sObj->m_positions);
-    return (unsigned int) data->getValue().size();
+    return getFront().positions.size() / 3;
 }
 const Real* SofaPhysicsOutputMesh::Impl::getVPositions()  ///< vertices positions (Vec3)
 {
-    Data<ResizableExtVector<Coord> > * data =
-        (!sObj->m_vertPosIdx.getValue().empty()) ?
-        &(sObj->m_vertices2) : &(sObj->m_positions);
-    return (const Real*) data->getValue().getData();
+    return getFront().positions.data();
 }
 const Real* SofaPhysicsOutputMesh::Impl::getVNormals()    ///< vertices normals   (Vec3)
 {
-    Data<ResizableExtVector<Deriv> > * data = &(sObj->m_vnormals);
-    return (const Real*) data->getValue().getData();
+    return getFront().normals.data();
 }
 
 const Real* SofaPhysicsOutputMesh::Impl::getVTexCoords()  ///< vertices UVs       (Vec2)
 {
-    Data<ResizableExtVector<TexCoord> > * data = &(sObj->m_vtexcoords);
-    return (const Real*) data->getValue().getData();
+    return getFront().texCoords.data();
 }
 
 int SofaPhysicsOutputMesh::Impl::getTexCoordRevision()    ///< changes each time tex coord data are updated
 {
-    Data<ResizableExtVector<TexCoord> > * data = &(sObj->m_vtexcoords);
-    data->getValue(); // make sure the data is updated
-    return data->getCounter();
+    return getFront().texCoords.revision;
 }
 
 int SofaPhysicsOutputMesh::Impl::getVerticesRevision()    ///< changes each time vertices data are updated
 {
-    Data<ResizableExtVector<Coord> > * data =
-        (!sObj->m_vertPosIdx.getValue().empty()) ?
-        &(sObj->m_vertices2) : &(sObj->m_positions);
-    data->getValue(); // make sure the data is updated
-    return data->getCounter();
+    return getFront().positions.revision;
 }
 
 
@@ -234,24 +280,19 @@ unsigned int SofaPhysicsOutputMesh::Impl::getNbVAttributes()
 
 unsigned int SofaPhysicsOutputMesh::Impl::getNbAttributes(int index)            ///< number of attributes in specified vertex attribute
 {
-  if ((unsigned)index >= sVA.size())
-    return 0;
-  else 
-    return dynamic_cast< Data<ResizableExtVector<Real> >* >(sVA[index]->getSEValue())->getValue().size();
+    const Snapshot& s = getFront();
+    if ((unsigned)index >= s.attributes.size())
+        return 0;
+    else
+        return s.attributes[index].size();
 }
 
 const char*  SofaPhysicsOutputMesh::Impl::getVAttributeName(int index)          ///< vertices attribute name
 {
-    // Quick fix: buffer to use for return value
-    // May remove if getSEID() is made to return a non-temp std::string
-    static std::string buffer;
-  
-    if ((unsigned)index >= sVA.size())
+    if ((unsigned)index >= vaNames.size())
         return "";
-    else {
-        buffer= sVA[index]->getSEID();
-        return buffer.c_str();
-    }
+    else
+        return vaNames[index].c_str();
 }
 
 int          SofaPhysicsOutputMesh::Impl::getVAttributeSizePerVertex(int index) ///< vertices attribute #
@@ -264,21 +305,20 @@ int          SofaPhysicsOutputMesh::Impl::getVAttributeSizePerVertex(int index)
 
 const Real*  SofaPhysicsOutputMesh::Impl::getVAttributeValue(int index)         ///< vertices attribute (Vec#)
 {
-    if ((unsigned)index >= sVA.size())
+    const Snapshot& s = getFront();
+    if ((unsigned)index >= s.attributes.size())
         return NULL;
     else
-        return (const Real*)((ResizableExtVector<Real>*)sVA[index]->getSEValue()->getValueVoidPtr())->getData();
+        return s.attributes[index].data();
 }
 
 int          SofaPhysicsOutputMesh::Impl::getVAttributeRevision(int index)      ///< changes each time vertices attribute is updated
 {
-    if ((unsigned)index >= sVA.size())
+    const Snapshot& s = getFront();
+    if ((unsigned)index >= s.attributes.size())
         return 0;
     else
-    {
-        sVA[index]->getSEValue()->getValueVoidPtr(); // make sure the data is updated
-        return sVA[index]->getSEValue()->getCounter();
-    }
+        return s.attributes[index].revision;
 }
 
 
@@ -297,34 +337,26 @@ int SofaPhysicsOutputMesh::Impl::getLinesRevision()    ///< changes each time li
 
 unsigned int SofaPhysicsOutputMesh::Impl::getNbTriangles() ///< number of triangles
 {
-    Data<ResizableExtVector<Triangle> > * data = &(sObj->m_triangles);
-    return (unsigned int) data->getValue().size();
+    return getFront().triangles.size() / 3;
 }
 const Index* SofaPhysicsOutputMesh::Impl::getTriangles()   ///< triangles topology (3 indices / triangle)
 {
-    Data<ResizableExtVector<Triangle> > * data = &(sObj->m_triangles);
-    return (const Index*) data->getValue().getData();
+    return getFront().triangles.data();
 }
 int SofaPhysicsOutputMesh::Impl::getTrianglesRevision()    ///< changes each time triangles data is updated
 {
-    Data<ResizableExtVector<Triangle> > * data = &(sObj->m_triangles);
-    data->getValue(); // make sure the data is updated
-    return data->getCounter();
+    return getFront().triangles.revision;
 }
 
 unsigned int SofaPhysicsOutputMesh::Impl::getNbQuads() ///< number of quads
 {
-    Data<ResizableExtVector<Quad> > * data = &(sObj->m_quads);
-    return (unsigned int) data->getValue().size();
+    return getFront().quads.size() / 4;
 }
 const Index* SofaPhysicsOutputMesh::Impl::getQuads()   ///< quads topology (4 indices / quad)
 {
-    Data<ResizableExtVector<Quad> > * data = &(sObj->m_quads);
-    return (const Index*) data->getValue().getData();
+    return getFront().quads.data();
 }
 int SofaPhysicsOutputMesh::Impl::getQuadsRevision()    ///< changes each time quads data is updated
 {
-    Data<ResizableExtVector<Quad> > * data = &(sObj->m_quads);
-    data->getValue(); // make sure the data is updated
-    return data->getCounter();
+    return getFront().quads.revision;
 }
@@ -28,6 +28,10 @@
 #include <sofa/core/visual/VisualModel.h>
 #include <sofa/core/visual/Shader.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 class SOFA_SOFAPHYSICSAPI_API SofaPhysicsOutputMesh::Impl
 {
 public:
@@ -79,10 +83,53 @@ public:
 protected:
     SofaOutputMesh::SPtr sObj;
     sofa::helper::vector<SofaVAttribute::SPtr> sVA;
+    std::vector<std::string> vaNames;
+
+    /// Values of a Data copied at a given revision, shared by the snapshots until the Data changes
+    template<class T>
+    struct SharedArray
+    {
+        std::shared_ptr< const std::vector<T> > values;
+        int revision;
+
+        SharedArray() : revision(0) {}
+        const T* data() const { return values && !values->empty() ? values->data() : NULL; }
+        unsigned int size() const { return values ? (unsigned int)values->size() : 0; }
+    };
+
+    /// Immutable copy of the mesh at the end of a step
+    struct Snapshot
+    {
+        SharedArray<Real> positions;
+        SharedArray<Real> normals;
+        SharedArray<Real> texCoords;
+        std::vector< SharedArray<Real> > attributes;
+        SharedArray<Index> triangles;
+        SharedArray<Index> quads;
+    };
+
+    /// The getters return the front snapshot, the next one is copied in the back snapshot
+    Snapshot snapshots[2];
+    int front;
+    bool backUpdated;
+
+    const Snapshot& getFront() const { return snapshots[front]; }
+
+    /// Copy the values of the Data in dst, or share the ones of the front snapshot if the Data did not change
+    template<class T>
+    void copyArray(SharedArray<T>& dst, const SharedArray<T>& last, const sofa::core::objectmodel::BaseData& data, const void* values, std::size_t size);
 
 public:
     SofaOutputMesh* getObject() { return sObj.get(); }
     void setObject(SofaOutputMesh* o);
+
+    /// Copy the current state of the visual model in the back snapshot.
+    /// Called at the end of a step, possibly from the thread computing it.
+    void updateSnapshot();
+    /// Return true if the back snapshot was updated since the last swap
+    bool isSnapshotUpdated() const { return backUpdated; }
+    /// Publish the back snapshot. The arrays returned by the getters are not modified until the next update.
+    void swapSnapshots();
 };
 
 #endif // SOFAPHYSICSOUTPUTMESH_IMPL_H
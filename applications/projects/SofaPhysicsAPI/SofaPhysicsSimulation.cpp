@@ -35,6 +35,7 @@
 #include <sofa/core/ObjectFactory.h>
 #include <SofaComponentGeneral/initComponentGeneral.h>
 #include <sofa/core/objectmodel/GUIEvent.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <sofa/gui/GUIManager.h>
 #include <sofa/gui/Main.h>
@@ -93,6 +94,16 @@ void SofaPhysicsAPI::step()
     impl->step();
 }
 
+void SofaPhysicsAPI::stepAsync()
+{
+    impl->stepAsync();
+}
+
+void SofaPhysicsAPI::waitStep()
+{
+    impl->waitStep();
+}
+
 void SofaPhysicsAPI::reset()
 {
     impl->reset();
@@ -206,6 +217,12 @@ static sofa::core::ObjectFactory::ClassEntry::SPtr classVisualModel;
 SofaPhysicsSimulation::SofaPhysicsSimulation(bool useGUI_, int GUIFramerate_)
     : useGUI(useGUI_)
     , GUIFramerate(GUIFramerate_)
+    , stepRequested(false)
+    , stepThreadClosing(false)
+    , stepPending(false)
+    , sceneAnimated(false)
+    , sceneTime(0.0)
+    , sceneDt(0.0)
 {
     sofa::helper::init();
     static bool first = true;
@@ -259,6 +276,17 @@ SofaPhysicsSimulation::SofaPhysicsSimulation(bool useGUI_, int GUIFramerate_)
 
 SofaPhysicsSimulation::~SofaPhysicsSimulation()
 {
+    waitStep();
+    if (stepThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(stepMutex);
+            stepThreadClosing = true;
+        }
+        stepCondition.notify_all();
+        stepThread.join();
+    }
+
     for (std::map<SofaOutputMesh*, SofaPhysicsOutputMesh*>::const_iterator it = outputMeshMap.begin(), itend = outputMeshMap.end(); it != itend; ++it)
     {
         if (it->second) delete it->second;
@@ -288,6 +316,7 @@ bool SofaPhysicsSimulation::load(const char* cfilename)
     std::cout << "FROM APP: SofaPhysicsSimulation::load(" << filename << ")" << std::endl;
     sofa::helper::BackTrace::autodump();
 
+    waitStep();
     //bool wasAnimated = isAnimated();
     bool success = true;
     sofa::helper::system::DataRepository.findFile(filename);
@@ -296,6 +325,7 @@ bool SofaPhysicsSimulation::load(const char* cfilename)
     {
         sceneFileName = filename;
         m_Simulation->init(m_RootNode.get());
+        updateSceneState();
         updateOutputMeshes();
 
         if ( useGUI ) {
@@ -305,6 +335,7 @@ bool SofaPhysicsSimulation::load(const char* cfilename)
     else
     {
         m_RootNode = m_Simulation->createNewGraph("");
+        updateSceneState();
         success = false;
     }
     initTexturesDone = false;
@@ -319,6 +350,7 @@ bool SofaPhysicsSimulation::load(const char* cfilename)
 
 void SofaPhysicsSimulation::createScene()
 {
+    waitStep();
     m_RootNode = sofa::modeling::createRootWithCollisionPipeline();
     if (m_RootNode.get())
     {
@@ -327,6 +359,7 @@ void SofaPhysicsSimulation::createScene()
 
         m_Simulation->init(m_RootNode.get());
 
+        updateSceneState();
         updateOutputMeshes();
     }
     else
@@ -342,6 +375,7 @@ void SofaPhysicsSimulation::createScene_impl()
 
 void SofaPhysicsSimulation::sendValue(const char* name, double value)
 {
+    waitStep();
     // send a GUIEvent to the tree
     if (m_RootNode!=0)
     {
@@ -355,9 +389,7 @@ void SofaPhysicsSimulation::sendValue(const char* name, double value)
 
 bool SofaPhysicsSimulation::isAnimated() const
 {
-    if (getScene())
-        return getScene()->getContext()->getAnimate();
-    return false;
+    return sceneAnimated;
 }
 
 void SofaPhysicsSimulation::setAnimated(bool val)
@@ -368,26 +400,22 @@ void SofaPhysicsSimulation::setAnimated(bool val)
 
 double SofaPhysicsSimulation::getTimeStep() const
 {
-    if (getScene())
-        return getScene()->getContext()->getDt();
-    else
-        return 0.0;
+    return sceneDt;
 }
 
 void SofaPhysicsSimulation::setTimeStep(double dt)
 {
+    waitStep();
     if (getScene())
     {
         getScene()->getContext()->setDt(dt);
+        updateSceneState();
     }
 }
 
 double SofaPhysicsSimulation::getTime() const
 {
-    if (getScene())
-        return getScene()->getContext()->getTime();
-    else
-        return 0.0;
+    return sceneTime;
 }
 
 double SofaPhysicsSimulation::getCurrentFPS() const
@@ -399,31 +427,31 @@ double *SofaPhysicsSimulation::getGravity() const
 {
     double* gravityVec = new double[3];
 
-    if (getScene())
-    {
-        const Vec3d& g = getScene()->getContext()->getGravity();
-        gravityVec[0] = g.x();
-        gravityVec[1] = g.y();
-        gravityVec[2] = g.z();
-    }
+    gravityVec[0] = sceneGravity.x();
+    gravityVec[1] = sceneGravity.y();
+    gravityVec[2] = sceneGravity.z();
 
     return gravityVec;
 }
 
 void SofaPhysicsSimulation::setGravity(double* gravity)
 {
+    waitStep();
     Vec3d g = Vec3d(gravity[0], gravity[1], gravity[2]);
     getScene()->getContext()->setGravity(g);
+    updateSceneState();
 }
 
 
 void SofaPhysicsSimulation::start()
 {
     std::cout << "FROM APP: start()" << std::endl;
+    waitStep();
     if (isAnimated()) return;
     if (getScene())
     {
         getScene()->getContext()->setAnimate(true);
+        updateSceneState();
         //animatedChanged();
     }
 }
@@ -431,10 +459,12 @@ void SofaPhysicsSimulation::start()
 void SofaPhysicsSimulation::stop()
 {
     std::cout << "FROM APP: stop()" << std::endl;
+    waitStep();
     if (!isAnimated()) return;
     if (getScene())
     {
         getScene()->getContext()->setAnimate(false);
+        updateSceneState();
         //animatedChanged();
     }
 }
@@ -443,15 +473,19 @@ void SofaPhysicsSimulation::stop()
 void SofaPhysicsSimulation::reset()
 {
     std::cout << "FROM APP: reset()" << std::endl;
+    waitStep();
     if (getScene())
     {
         getSimulation()->reset(getScene());
         this->update();
+        updateSceneState();
+        updateOutputMeshes();
     }
 }
 
 void SofaPhysicsSimulation::resetView()
 {
+    waitStep();
     if (getScene() && currentCamera)
     {
         currentCamera->setDefaultView(getScene()->getGravity());
@@ -470,11 +504,79 @@ void SofaPhysicsSimulation::update()
 
 void SofaPhysicsSimulation::step()
 {
+    waitStep();
     sofa::simulation::Node* groot = getScene();
     if (!groot) return;
     beginStep();
+    computeStep();
+    stepGUI();
+    endStep();
+}
+
+void SofaPhysicsSimulation::stepAsync()
+{
+    waitStep();
+    if (!getScene()) return;
+    beginStep();
+    if (!stepThread.joinable())
+        stepThread = std::thread(&SofaPhysicsSimulation::runStepThread, this);
+    {
+        std::lock_guard<std::mutex> lock(stepMutex);
+        stepRequested = true;
+    }
+    stepPending = true;
+    stepCondition.notify_all();
+}
+
+void SofaPhysicsSimulation::waitStep()
+{
+    if (!stepPending) return;
+    {
+        std::unique_lock<std::mutex> lock(stepMutex);
+        stepCondition.wait(lock, [this] { return !stepRequested; });
+    }
+    stepPending = false;
+    stepGUI();
+    endStep();
+}
+
+void SofaPhysicsSimulation::runStepThread()
+{
+    // the parallel components queue their tasks from this thread
+    sofa::simulation::TaskScheduler* scheduler = sofa::simulation::TaskScheduler::getInstance();
+    if (!scheduler->attachCurrentThread("SofaPhysicsStep"))
+        std::cerr << "WARNING: no task scheduler slot is free for the simulation thread, its tasks will run sequentially" << std::endl;
+
+    std::unique_lock<std::mutex> lock(stepMutex);
+    for (;;)
+    {
+        stepCondition.wait(lock, [this] { return stepRequested || stepThreadClosing; });
+        if (stepThreadClosing)
+        {
+            scheduler->detachCurrentThread();
+            return;
+        }
+        lock.unlock();
+        computeStep();
+        lock.lock();
+        stepRequested = false;
+        stepCondition.notify_all();
+    }
+}
+
+void SofaPhysicsSimulation::computeStep()
+{
+    sofa::simulation::Node* groot = getScene();
     getSimulation()->animate(groot);
     getSimulation()->updateVisual(groot);
+
+    // copy the output meshes while the scene is not modified
+    for (unsigned int i=0; i<outputMeshes.size(); ++i)
+        outputMeshes[i]->impl->updateSnapshot();
+}
+
+void SofaPhysicsSimulation::stepGUI()
+{
     if ( useGUI ) {
       sofa::gui::BaseGUI* gui = sofa::gui::GUIManager::getGUI();
       gui->stepMainLoop();
@@ -488,7 +590,6 @@ void SofaPhysicsSimulation::step()
           }
       }
     }
-    endStep();
 }
 
 void SofaPhysicsSimulation::beginStep()
@@ -499,9 +600,19 @@ void SofaPhysicsSimulation::endStep()
 {
     update();
     updateCurrentFPS();
+    updateSceneState();
     updateOutputMeshes();
 }
 
+void SofaPhysicsSimulation::updateSceneState()
+{
+    sofa::simulation::Node* groot = getScene();
+    sceneAnimated = groot ? groot->getContext()->getAnimate() : false;
+    sceneTime = groot ? groot->getContext()->getTime() : 0.0;
+    sceneDt = groot ? groot->getContext()->getDt() : 0.0;
+    sceneGravity = groot ? groot->getContext()->getGravity() : Vec3d();
+}
+
 void SofaPhysicsSimulation::updateCurrentFPS()
 {
     if (frameCounter==0)
@@ -552,6 +663,11 @@ void SofaPhysicsSimulation::updateOutputMeshes()
             oMesh->impl->setObject(sMesh);
         }
         outputMeshes[i] = oMesh;
+
+        // the meshes which were not copied by a step (new meshes, reset...) are copied now
+        if (!oMesh->impl->isSnapshotUpdated())
+            oMesh->impl->updateSnapshot();
+        oMesh->impl->swapSnapshots();
     }
 }
 
@@ -583,6 +699,7 @@ unsigned int SofaPhysicsSimulation::getNbDataMonitors()
 
 SofaPhysicsDataMonitor** SofaPhysicsSimulation::getDataMonitors()
 {
+    waitStep();
     if (dataMonitors.empty())
     {
         sofa::simulation::Node* groot = getScene();
@@ -610,6 +727,7 @@ unsigned int SofaPhysicsSimulation::getNbDataControllers()
 
 SofaPhysicsDataController** SofaPhysicsSimulation::getDataControllers()
 {
+    waitStep();
     if (dataControllers.empty())
     {
         sofa::simulation::Node* groot = getScene();
@@ -632,6 +750,7 @@ SofaPhysicsDataController** SofaPhysicsSimulation::getDataControllers()
 
 void SofaPhysicsSimulation::drawGL()
 {
+    waitStep();
     GLint viewport[4];
     glGetIntegerv(GL_VIEWPORT,viewport);
 
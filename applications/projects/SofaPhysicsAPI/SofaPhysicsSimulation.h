@@ -33,7 +33,10 @@
 #include <SofaBaseVisual/InteractiveCamera.h>
 #include <sofa/helper/gl/Texture.h>
 
+#include <condition_variable>
 #include <map>
+#include <mutex>
+#include <thread>
 
 
 class SOFA_SOFAPHYSICSAPI_API SofaPhysicsSimulation
@@ -50,6 +53,8 @@ public:
     void start();
     void stop();
     void step();
+    void stepAsync();
+    void waitStep();
     void reset();
     void resetView();
     void sendValue(const char* name, double value);
@@ -116,7 +121,29 @@ protected:
     int frameCounter;
     double currentFPS;
 
+    /// Thread computing the steps started by stepAsync()
+    std::thread stepThread;
+    std::mutex stepMutex;
+    std::condition_variable stepCondition;
+    bool stepRequested; ///< a step was started and the simulation thread did not finish it, guarded by stepMutex
+    bool stepThreadClosing; ///< guarded by stepMutex
+    bool stepPending; ///< a step was started by stepAsync() and waitStep() was not called yet
+
+    /// State of the scene at the end of the last step, read by the const accessors
+    /// as the scene may be modified by the simulation thread
+    bool sceneAnimated;
+    double sceneTime;
+    double sceneDt;
+    sofa::defaulttype::Vec3d sceneGravity;
+
+    void runStepThread();
+    /// Animate and update the visual models, then copy the output meshes
+    void computeStep();
+    /// GUI updates after a step, on the thread of the application
+    void stepGUI();
+
     void update();
+    void updateSceneState();
     void updateOutputMeshes();
     void updateCurrentFPS();
     void beginStep();
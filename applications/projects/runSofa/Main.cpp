@@ -221,6 +221,7 @@ int main(int argc, char** argv)
     string colorsStatus = "unset";
     string messageHandler = "auto";
     bool enableInteraction = false ;
+    bool asyncSimulation = false ;
     int width = 800;
     int height = 600;
 
@@ -256,6 +257,7 @@ int main(int argc, char** argv)
     argParser->addArgument(po::value<std::string>(&colorsStatus)->default_value("unset", "auto")->implicit_value("yes"),     "colors,c", "use colors on stdout and stderr (yes, no, auto)");
     argParser->addArgument(po::value<std::string>(&messageHandler)->default_value("auto"), "formatting,f",          "select the message formatting to use (auto, clang, sofa, rich, test)");
     argParser->addArgument(po::value<bool>(&enableInteraction)->default_value(false)->implicit_value(true),         "interactive,i", "enable interactive mode for the GUI which includes idle and mouse events (EXPERIMENTAL)");
+    argParser->addArgument(po::value<bool>(&asyncSimulation)->default_value(false)->implicit_value(true),           "asyncSimulation", "run the animation in its own thread, the viewer draws the latest visual state it published (requires SOFA_MAX_THREADS >= 2)");
     argParser->addArgument(po::value<std::vector<std::string> >()->multitoken(), "argv",                            "forward extra args to the python interpreter");
 
 #ifdef SOFA_SMP
@@ -19,12 +19,16 @@
 *                                                                             *
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
-#include <iostream>
-#include <fstream>
-#include <ctime>
-
 #include <sofa/helper/ArgumentParser.h>
+#include <sofa/helper/BackTrace.h>
+#include <sofa/helper/io/BinaryStateFile.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/system/FileRepository.h>
 #include <sofa/helper/system/PluginManager.h>
+#include <sofa/helper/system/SetDirectory.h>
+#include <sofa/helper/system/thread/CTime.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/core/behavior/OdeSolver.h>
 
 #include <SofaComponentBase/initComponentBase.h>
 #include <SofaComponentCommon/initComponentCommon.h>
@@ -32,165 +36,396 @@
 #include <SofaComponentAdvanced/initComponentAdvanced.h>
 #include <SofaComponentMisc/initComponentMisc.h>
 
-#include <sofa/helper/system/FileRepository.h>
-#include <sofa/helper/system/SetDirectory.h>
+#include <SofaSimulationCommon/SceneLoaderBinary.h>
 #include <SofaSimulationTree/init.h>
 #include <SofaSimulationTree/TreeSimulation.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
-
-#include <sofa/helper/Factory.h>
-#include <sofa/helper/BackTrace.h>
-#include <SofaExporter/WriteState.h>
-
-
-
-using std::cerr;
-using std::endl;
-using std::cout;
+using sofa::helper::io::BinaryStateWriter;
+using sofa::helper::system::thread::CTime;
+using sofa::helper::system::thread::ctime_t;
+using sofa::simulation::Node;
+using sofa::simulation::SceneLoaderBinary;
 
 // ---------------------------------------------------------------------
 // ---
 // ---------------------------------------------------------------------
 
-
-void apply(std::string &input, unsigned int nbsteps, std::string &output)
+/// One line of the tasks file: a scene, a number of time steps and an output name
+struct BatchTask
 {
-    cout<<"\n****SIMULATION*  (.scn:"<< input<<", #steps:"<<nbsteps<<", .simu:"<<output<<")"<<endl;
+    std::string input;
+    unsigned int nbsteps;
+    std::string output;
+};
 
-    // --- Create simulation graph ---
-    sofa::simulation::Node::SPtr groot = sofa::core::objectmodel::SPtr_dynamic_cast<sofa::simulation::Node>( sofa::simulation::getSimulation()->load(input.c_str()));
-    if (groot==NULL)
+/// Result of a run, printed as it ends and summed up at the end of the batch
+struct RunReport
+{
+    bool success;
+    double startup; ///< load and init time, in seconds
+    double steps;   ///< time of the time steps, in seconds
+    std::size_t nbValues; ///< number of values written per vector and per frame
+};
+
+/// Options shared by all the runs
+struct BatchOptions
+{
+    std::string outputDir;
+    BinaryStateWriter::Encoding encoding;
+    bool writeV;
+};
+
+/// Scene graph creation, initialization and deletion change the current directory and locale
+/// of the process: they are serialized, the time steps of the runs are concurrent.
+std::mutex sceneMutex;
+/// Serializes the reports of the runs
+std::mutex reportMutex;
+
+/// Read the tasks file: one "scene #steps output" task per line, "//" and "#" starting comments
+bool readTasks(const std::string& filename, std::vector<BatchTask>& tasks)
+{
+    std::ifstream in(filename.c_str());
+    if (!in)
     {
-        groot = sofa::simulation::getSimulation()->createNewGraph("");
+        std::cerr << "Unable to open the tasks file " << filename << std::endl;
+        return false;
     }
-
-    if (!groot)
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(in, line))
     {
-        cerr << "Error, unable to access groot" << std::endl;
-        return;
+        ++lineNumber;
+        std::istringstream str(line);
+        BatchTask task;
+        if (!(str >> task.input) || task.input.compare(0, 2, "//") == 0 || task.input[0] == '#')
+            continue;
+        if (!(str >> task.nbsteps >> task.output))
+        {
+            std::cerr << filename << ":" << lineNumber << ": expected a scene, a number of time steps and an output name" << std::endl;
+            return false;
+        }
+        tasks.push_back(task);
     }
+    return true;
+}
 
-    sofa::simulation::getSimulation()->init(groot.get());
-    groot->setAnimate(true);
-
-
-    // --- Init output file ---
-    std::string outputdir =  sofa::helper::system::SetDirectory::GetParentDir(sofa::helper::system::DataRepository.getFirstPath().c_str()) + std::string("/applications/projects/sofaBatch/simulation/");
-    std::string mstate = outputdir + sofa::helper::system::SetDirectory::GetFileName(output.c_str());
-
-    // --- Init Write state visitor ---
-    sofa::component::misc::WriteStateCreator visitor(sofa::core::ExecParams::defaultInstance());
-    visitor.setSceneName(mstate);
-    visitor.execute(groot.get());
+/// Parse each scene once: the scene is compiled to a binary scene (.scnb) and all its runs are
+/// loaded from it. The binary scene is written next to the source scene, so that its relative file
+/// paths are kept, under a name private to this process: no other process maps it, and it is
+/// removed at the end of the batch (see removePrototypes).
+/// The scenes which can't be compiled are loaded from their source by each run.
+std::string createPrototype(const std::string& input)
+{
+    const std::string extension = sofa::helper::system::SetDirectory::GetExtension(input.c_str());
+    if (extension == "scnb")
+        return input;
+
+    const std::string base = input.substr(0, input.size() - extension.size() - 1);
+    const std::string prototype = sofa::helper::io::MappedFile::getTemporaryFileName(base) + ".scnb";
+    const double freq = (double)CTime::getRefTicksPerSec();
+    const ctime_t t = CTime::getRefTime();
+    if (!SceneLoaderBinary::compile(input, prototype))
+    {
+        std::cerr << "Unable to compile " << input << ", each run will load it" << std::endl;
+        return input;
+    }
+    std::cout << input << " compiled to " << prototype << " in " << (CTime::getRefTime() - t) / freq << " s" << std::endl;
+    return prototype;
+}
 
-    sofa::component::misc::WriteStateActivator v_write(sofa::core::ExecParams::defaultInstance(), true);
-    v_write.execute(groot.get());
+/// Remove the binary scenes compiled by createPrototype
+void removePrototypes(const std::map<std::string, std::string>& prototypes)
+{
+    for (std::map<std::string, std::string>::const_iterator it = prototypes.begin(); it != prototypes.end(); ++it)
+        if (it->second != it->first)
+            std::remove(it->second.c_str());
+}
 
+/// The mechanical states integrated by a solver, i.e. the ones a WriteStateCreator records
+void getSimulatedStates(Node* root, std::vector<sofa::core::behavior::BaseMechanicalState*>& states)
+{
+    std::vector<sofa::core::behavior::BaseMechanicalState*> all;
+    root->getTreeObjects<sofa::core::behavior::BaseMechanicalState>(&all);
+    for (std::size_t i = 0; i < all.size(); ++i)
+    {
+        Node* node = dynamic_cast<Node*>(all[i]->getContext());
+        sofa::core::behavior::OdeSolver* solver = NULL;
+        all[i]->getContext()->get(solver);
+        if (node && !node->mechanicalMapping && solver)
+            states.push_back(all[i]);
+    }
+}
 
-    // --- Sofa GUI Batch animationLoop ---
-    sofa::simulation::getSimulation()->animate(groot.get());
+/// Append a vector of all the simulated states to the frame being written
+void addStatesVector(BinaryStateWriter& writer, char name, sofa::core::ConstVecId v,
+                     const std::vector<sofa::core::behavior::BaseMechanicalState*>& states,
+                     sofa::helper::vector<double>& values)
+{
+    values.clear();
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+        const sofa::core::objectmodel::BaseData* data = states[i]->baseRead(v);
+        if (!data)
+            continue;
+        const sofa::defaulttype::AbstractTypeInfo* info = data->getValueTypeInfo();
+        const void* ptr = data->getValueVoidPtr();
+        const std::size_t size = info->size(ptr);
+        const std::size_t offset = values.size();
+        values.resize(offset + size);
+        if (size && info->SimpleLayout() && info->ValueType()->Scalar() && info->byteSize() == sizeof(double))
+        {
+            const double* begin = (const double*)info->getValuePtr(ptr);
+            std::copy(begin, begin + size, values.begin() + offset);
+        }
+        else
+        {
+            for (std::size_t j = 0; j < size; ++j)
+                values[offset + j] = info->getScalarValue(ptr, j);
+        }
+    }
+    writer.addVector(name, values.data(), values.size());
+}
 
-    std::cout << "Computing "<<nbsteps<<" iterations." << std::endl;
-    sofa::simulation::Visitor::ctime_t rtfreq = sofa::helper::system::thread::CTime::getRefTicksPerSec();
-    sofa::simulation::Visitor::ctime_t tfreq = sofa::helper::system::thread::CTime::getTicksPerSec();
-    sofa::simulation::Visitor::ctime_t rt = sofa::helper::system::thread::CTime::getRefTime();
-    sofa::simulation::Visitor::ctime_t t = sofa::helper::system::thread::CTime::getFastTime();
-    for (unsigned int i=0; i<nbsteps; i++)
-        sofa::simulation::getSimulation()->animate(groot.get());
+/// Simulate a task, writing the simulated states in a single binary state file per run
+RunReport run(const BatchTask& task, const std::string& scene, const BatchOptions& options)
+{
+    RunReport report = { false, 0, 0, 0 };
+    const double freq = (double)CTime::getRefTicksPerSec();
+    const std::string baseName = options.outputDir + sofa::helper::system::SetDirectory::GetFileName(task.output.c_str());
 
-    t = sofa::helper::system::thread::CTime::getFastTime()-t;
-    rt = sofa::helper::system::thread::CTime::getRefTime()-rt;
+    // --- Create the simulation graph from the prototype ---
+    Node::SPtr root;
+    ctime_t t = CTime::getRefTime();
+    {
+        std::lock_guard<std::mutex> lock(sceneMutex);
+        root = sofa::simulation::getSimulation()->load(scene.c_str());
+        if (root)
+            sofa::simulation::getSimulation()->init(root.get());
+    }
+    report.startup = (CTime::getRefTime() - t) / freq;
+    if (!root)
+    {
+        std::cerr << "Unable to load " << scene << std::endl;
+        return report;
+    }
+    root->setAnimate(true);
 
-    std::cout << nbsteps << " iterations done in "<< ((double)t)/((double)tfreq) << " s ( " << (((double)tfreq)*nbsteps)/((double)t) << " FPS)." << std::endl;
-    std::cout << nbsteps << " iterations done in "<< ((double)rt)/((double)rtfreq) << " s ( " << (((double)rtfreq)*nbsteps)/((double)rt) << " FPS)." << std::endl;
+    std::vector<sofa::core::behavior::BaseMechanicalState*> states;
+    getSimulatedStates(root.get(), states);
 
-    // --- Exporting output simulation ---
-    std::string simulationFileName = mstate + std::string(".simu") ;
-    std::ofstream out(simulationFileName.c_str());
-    if (!out.fail())
+    // --- Simulate, one frame per time step ---
+    BinaryStateWriter writer;
+    if (writer.open(baseName + ".bin", options.encoding))
     {
-        out << input.c_str() << " Init: 0.000 s End: " << nbsteps*groot.get()->getDt() << " s " << groot.get()->getDt() << " baseName: "<<mstate;
-        out.close();
-
-        std::cout << "Simulation parameters saved in "<<simulationFileName<<std::endl;
+        sofa::helper::vector<double> values;
+        t = CTime::getRefTime();
+        for (unsigned int i = 0; i <= task.nbsteps; i++)
+        {
+            if (i > 0)
+                sofa::simulation::getSimulation()->animate(root.get());
+
+            // encoded here, written by the thread of the binary file
+            writer.beginFrame(root->getTime());
+            addStatesVector(writer, 'X', sofa::core::VecId::position(), states, values);
+            if (options.writeV)
+                addStatesVector(writer, 'V', sofa::core::VecId::velocity(), states, values);
+            writer.endFrame();
+            report.nbValues = values.size();
+        }
+        report.steps = (CTime::getRefTime() - t) / freq;
+        writer.close();
+
+        // --- Description of the run: the scene and the layout of the vectors of the frames ---
+        std::ofstream out((baseName + ".simu").c_str());
+        if (out)
+        {
+            out << task.input << " Init: 0.000 s End: " << task.nbsteps*root->getDt() << " s " << root->getDt() << " baseName: " << baseName << ".bin" << std::endl;
+            std::size_t offset = 0;
+            for (std::size_t i = 0; i < states.size(); ++i)
+            {
+                const sofa::core::objectmodel::BaseData* data = states[i]->baseRead(sofa::core::VecId::position());
+                const std::size_t size = data ? data->getValueTypeInfo()->size(data->getValueVoidPtr()) : 0;
+                out << "state " << states[i]->getPathName() << " offset " << offset << " size " << size << std::endl;
+                offset += size;
+            }
+            report.success = true;
+        }
+        else
+        {
+            std::cerr << baseName << ".simu file error" << std::endl;
+        }
     }
     else
     {
-        std::cout<<simulationFileName<<" file error\n";
+        std::cerr << "Unable to write " << baseName << ".bin" << std::endl;
     }
 
-
-    sofa::simulation::getSimulation()->unload(groot);
-
-    return;
+    {
+        std::lock_guard<std::mutex> lock(sceneMutex);
+        sofa::simulation::getSimulation()->unload(root);
+    }
+    return report;
 }
 
-
 int main(int argc, char** argv)
 {
-    sofa::simulation::tree::init();
-    sofa::component::initComponentBase();
-    sofa::component::initComponentCommon();
-    sofa::component::initComponentGeneral();
-    sofa::component::initComponentAdvanced();
-    sofa::component::initComponentMisc();
+    sofa::helper::BackTrace::autodump();
 
-    // --- Parameter initialisation ---
-    std::vector<std::string> files;
-    std::string fileName ;
+    bool showHelp = false;
+    unsigned int nbJobs = 0;
+    std::string outputDir;
+    std::string compression;
+    bool noVelocity = false;
     std::vector<std::string> plugins;
-    std::vector<unsigned int> nbstepsations;
-
-    sofa::helper::parse(&files, "\nThis is a SOFA batch that permits to run and to save simulation states without GUI.\nGive a name file containing actions == list of (input .scn, #simulated time steps, output .simu). See file tasks for an example.\n\nHere are the command line arguments")
-    .option(&plugins,'l',"load","load given plugins")
-    (argc,argv);
+    std::vector<std::string> files;
 
+    sofa::helper::ArgumentParser* argParser = new sofa::helper::ArgumentParser(argc, argv);
+    argParser->addArgument(po::value<bool>(&showHelp)->default_value(false)->implicit_value(true),    "help,h", "Display this help message");
+    argParser->addArgument(po::value<unsigned int>(&nbJobs)->default_value(0),                        "jobs,j", "number of scenes simulated concurrently (0: one per hardware thread)");
+    argParser->addArgument(po::value<std::string>(&outputDir)->default_value(""),                     "output,o", "directory of the output files (default: the simulation directory of sofaBatch)");
+    argParser->addArgument(po::value<std::string>(&compression)->default_value("none"),               "compression,c", "compression of the output states: none (doubles), float, or delta (16 bits differences to the last keyframe)");
+    argParser->addArgument(po::value<bool>(&noVelocity)->default_value(false)->implicit_value(true),  "no-velocity", "only write the positions");
+    argParser->addArgument(po::value<std::vector<std::string>>(&plugins),                            "load,l", "load given plugins");
+    argParser->parse();
+    files = argParser->getInputFileList();
+
+    if (showHelp || (files.size() != 1 && files.size() != 3))
+    {
+        std::cout << "This is a SOFA batch that permits to run and to save simulation states without GUI." << std::endl
+                  << "Give a tasks file, listing lines of (input scene, #simulated time steps, output name), see file tasks for an example," << std::endl
+                  << "or a single task as three arguments. Each run writes its states in output.bin and describes them in output.simu." << std::endl;
+        argParser->showHelp();
+        return showHelp ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    // --- check input file
-    if (!files.empty())
-        fileName = files[0];
+    BatchOptions options;
+    options.writeV = !noVelocity;
+    if (compression == "none") options.encoding = BinaryStateWriter::ENCODING_DOUBLE;
+    else if (compression == "float") options.encoding = BinaryStateWriter::ENCODING_FLOAT;
+    else if (compression == "delta") options.encoding = BinaryStateWriter::ENCODING_DELTA16;
     else
     {
-        cerr<<"No input tasks file\nsee help\n";
-        return 0;
+        std::cerr << "Unknown compression " << compression << std::endl;
+        return EXIT_FAILURE;
     }
 
-    fileName = sofa::helper::system::DataRepository.getFile(fileName);
-    //sofa::helper::system::DataRepository.findFile(fileName);
+    // --- Parameter initialisation ---
+    std::vector<BatchTask> tasks;
+    if (files.size() == 1)
+    {
+        std::string fileName = sofa::helper::system::DataRepository.getFile(files[0]);
+        if (!readTasks(fileName, tasks))
+            return EXIT_FAILURE;
+    }
+    else
+    {
+        BatchTask task;
+        task.input = files[0];
+        task.nbsteps = (unsigned int)atoi(files[1].c_str());
+        task.output = files[2];
+        tasks.push_back(task);
+    }
 
+    if (outputDir.empty())
+        outputDir = sofa::helper::system::SetDirectory::GetParentDir(sofa::helper::system::DataRepository.getFirstPath().c_str()) + std::string("/applications/projects/sofaBatch/simulation");
+    options.outputDir = outputDir + "/";
 
-    // --- Init component ---
+    // --- Init component, shared by all the runs ---
+    sofa::simulation::tree::init();
+    sofa::component::initComponentBase();
+    sofa::component::initComponentCommon();
+    sofa::component::initComponentGeneral();
+    sofa::component::initComponentAdvanced();
+    sofa::component::initComponentMisc();
     sofa::simulation::setSimulation(new sofa::simulation::tree::TreeSimulation());
 
-
     // --- plugins ---
     for (unsigned int i=0; i<plugins.size(); i++)
         sofa::helper::system::PluginManager::getInstance().loadPlugin(plugins[i]);
-
     sofa::helper::system::PluginManager::getInstance().init();
 
+    // --- Prototypes: each scene is parsed once ---
+    std::map<std::string, std::string> prototypes;
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+    {
+        sofa::helper::system::DataRepository.findFile(tasks[i].input);
+        if (prototypes.find(tasks[i].input) == prototypes.end())
+            prototypes[tasks[i].input] = createPrototype(tasks[i].input);
+    }
 
-    // --- Perform task list ---
-    //std::ifstream end(fileName.c_str());
-
-    std::string input;
-//    int nbsteps;
-    std::string output;
+    // --- Perform task list on a bounded pool of threads ---
+    if (nbJobs == 0)
+        nbJobs = std::max(1u, std::thread::hardware_concurrency());
+    nbJobs = std::min(nbJobs, (unsigned int)tasks.size());
 
-//    while( end >> input && end >>nbsteps && end >> output  )
-//    {
-//        std::cout<<"input "<<input<<std::endl;
-//        sofa::helper::system::DataRepository.findFile(input);
-//        apply(input, nbsteps, output);
-//    }
-//    end.close();
+    std::cout << "Running " << tasks.size() << " tasks on " << nbJobs << " threads." << std::endl;
+    std::vector<RunReport> reports(tasks.size());
+    std::atomic<std::size_t> nextTask(0);
+    std::atomic<std::size_t> nbDone(0);
+    const double freq = (double)CTime::getRefTicksPerSec();
+    const ctime_t batchStart = CTime::getRefTime();
 
-    std::string strfilename(argv[1]);
-    std::string stroutput(argv[3]);
-    sofa::helper::system::DataRepository.findFile(strfilename);
-    apply(strfilename, atoi(argv[2]), stroutput);
+    auto worker = [&]()
+    {
+        for (std::size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+        {
+            const BatchTask& task = tasks[i];
+            RunReport& report = reports[i];
+            report = run(task, prototypes.at(task.input), options);
+
+            std::lock_guard<std::mutex> lock(reportMutex);
+            std::cout << "[" << ++nbDone << "/" << tasks.size() << "] " << task.output << ": ";
+            if (report.success)
+                std::cout << task.nbsteps << " steps in " << report.steps << " s (" << (report.steps > 0 ? task.nbsteps / report.steps : 0)
+                          << " steps/s), startup " << report.startup << " s, " << report.nbValues << " values per frame" << std::endl;
+            else
+                std::cout << "failed" << std::endl;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nbJobs; ++i)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (std::size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    const double batchTime = (CTime::getRefTime() - batchStart) / freq;
+    removePrototypes(prototypes);
+
+    // --- Throughput report ---
+    std::size_t nbFailed = 0;
+    double totalSteps = 0;
+    double stepsTime = 0;
+    double startupTime = 0;
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+    {
+        if (!reports[i].success)
+        {
+            ++nbFailed;
+            continue;
+        }
+        totalSteps += tasks[i].nbsteps;
+        stepsTime += reports[i].steps;
+        startupTime += reports[i].startup;
+    }
+    const std::size_t nbSucceeded = tasks.size() - nbFailed;
+    std::cout << std::endl << nbSucceeded << " runs done, " << nbFailed << " failed, in " << batchTime << " s: "
+              << (batchTime > 0 ? totalSteps / batchTime : 0) << " steps/s, " << (batchTime > 0 ? nbSucceeded / batchTime : 0) << " runs/s." << std::endl;
+    if (nbSucceeded)
+        std::cout << "Per run: " << (stepsTime > 0 ? totalSteps / stepsTime : 0) << " steps/s, startup " << startupTime / nbSucceeded << " s." << std::endl;
 
     sofa::simulation::tree::cleanup();
-    return 0;
+    return nbFailed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
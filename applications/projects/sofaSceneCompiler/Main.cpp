@@ -0,0 +1,191 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/ArgumentParser.h>
+#include <sofa/helper/BackTrace.h>
+#include <sofa/helper/system/FileRepository.h>
+#include <sofa/helper/system/PluginManager.h>
+#include <sofa/helper/system/SetDirectory.h>
+#include <sofa/helper/system/thread/CTime.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <SofaComponentBase/initComponentBase.h>
+#include <SofaComponentCommon/initComponentCommon.h>
+#include <SofaComponentGeneral/initComponentGeneral.h>
+#include <SofaComponentAdvanced/initComponentAdvanced.h>
+#include <SofaComponentMisc/initComponentMisc.h>
+
+#include <SofaSimulationCommon/SceneLoaderBinary.h>
+#include <SofaSimulationGraph/init.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+
+using sofa::helper::system::thread::CTime;
+using sofa::helper::system::thread::ctime_t;
+using sofa::simulation::Node;
+using sofa::simulation::SceneLoaderBinary;
+
+// ---------------------------------------------------------------------
+// ---
+// ---------------------------------------------------------------------
+
+/// Time of a load and of the init of the loaded scene, in seconds
+struct StartupTime
+{
+    double load;
+    double init;
+};
+
+StartupTime startup(const std::string& filename)
+{
+    StartupTime time = { 0, 0 };
+    const double freq = (double)CTime::getRefTicksPerSec();
+
+    ctime_t t = CTime::getRefTime();
+    Node::SPtr root = sofa::simulation::getSimulation()->load(filename.c_str());
+    time.load = (CTime::getRefTime() - t) / freq;
+    if (!root)
+    {
+        std::cerr << "Unable to load " << filename << std::endl;
+        return time;
+    }
+
+    t = CTime::getRefTime();
+    sofa::simulation::getSimulation()->init(root.get());
+    time.init = (CTime::getRefTime() - t) / freq;
+
+    sofa::simulation::getSimulation()->unload(root);
+    return time;
+}
+
+/// Print the times of the first startup (cold) and the average of the following ones (warm)
+void benchmark(const std::string& label, const std::string& filename, unsigned int nbRuns)
+{
+    const StartupTime cold = startup(filename);
+    StartupTime warm = { 0, 0 };
+    for (unsigned int i = 0; i < nbRuns; ++i)
+    {
+        const StartupTime t = startup(filename);
+        warm.load += t.load / nbRuns;
+        warm.init += t.init / nbRuns;
+    }
+
+    std::cout << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(4)
+              << std::setw(12) << cold.load << std::setw(12) << cold.init
+              << std::setw(12) << warm.load << std::setw(12) << warm.init << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    sofa::helper::BackTrace::autodump();
+
+    bool showHelp = false;
+    std::string output;
+    unsigned int nbRuns = 0;
+    unsigned int nbThreads = 0;
+    bool serial = false;
+    std::vector<std::string> plugins;
+    std::vector<std::string> files;
+
+    sofa::helper::ArgumentParser* argParser = new sofa::helper::ArgumentParser(argc, argv);
+    argParser->addArgument(po::value<bool>(&showHelp)->default_value(false)->implicit_value(true),  "help,h", "Display this help message");
+    argParser->addArgument(po::value<std::string>(&output)->default_value(""),                      "output,o", "binary scene to write, only with a single input scene (default: the input scene with the .scnb extension)."
+                                                                                                              " The relative file paths of the scene are kept: the binary scene should be written in the directory of its source");
+    argParser->addArgument(po::value<unsigned int>(&nbRuns)->default_value(0),                      "benchmark,b", "compare the startup of the source and binary scenes: one cold startup, then the average of this number of warm ones");
+    argParser->addArgument(po::value<unsigned int>(&nbThreads)->default_value(0),                   "threads,t", "number of threads of the task scheduler (0: one per core)");
+    argParser->addArgument(po::value<bool>(&serial)->default_value(false)->implicit_value(true),    "serial,s", "create the components of the binary scenes on a single thread");
+    argParser->addArgument(po::value<std::vector<std::string>>(&plugins),                          "load,l", "load given plugins");
+    argParser->parse();
+    files = argParser->getInputFileList();
+
+    if (showHelp || files.empty())
+    {
+        std::cout << "Compile scenes (.scn, .py...) to binary scenes (.scnb), which are faster to load." << std::endl;
+        argParser->showHelp();
+        return files.empty() && !showHelp ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    if (!output.empty() && files.size() > 1)
+    {
+        std::cerr << "The output file can only be given with a single input scene" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    sofa::simulation::graph::init();
+    sofa::component::initComponentBase();
+    sofa::component::initComponentCommon();
+    sofa::component::initComponentGeneral();
+    sofa::component::initComponentAdvanced();
+    sofa::component::initComponentMisc();
+    sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+
+    for (unsigned int i=0; i<plugins.size(); i++)
+        sofa::helper::system::PluginManager::getInstance().loadPlugin(plugins[i]);
+    sofa::helper::system::PluginManager::getInstance().init();
+
+    sofa::simulation::TaskScheduler::getInstance()->init(nbThreads);
+    SceneLoaderBinary::setParallelInstantiation(!serial);
+
+    int result = EXIT_SUCCESS;
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        std::string filename = files[i];
+        sofa::helper::system::DataRepository.findFile(filename);
+
+        std::string binaryFilename = output;
+        if (binaryFilename.empty())
+        {
+            const std::string extension = sofa::helper::system::SetDirectory::GetExtension(filename.c_str());
+            binaryFilename = filename.substr(0, filename.size() - extension.size()) + "scnb";
+        }
+
+        const double freq = (double)CTime::getRefTicksPerSec();
+        const ctime_t t = CTime::getRefTime();
+        if (!SceneLoaderBinary::compile(filename, binaryFilename))
+        {
+            result = EXIT_FAILURE;
+            continue;
+        }
+        std::cout << filename << " compiled to " << binaryFilename << " in " << (CTime::getRefTime() - t) / freq << " s" << std::endl;
+
+        if (nbRuns > 0)
+        {
+            std::cout << std::left << std::setw(24) << "startup (s)" << std::right
+                      << std::setw(12) << "cold load" << std::setw(12) << "cold init"
+                      << std::setw(12) << "warm load" << std::setw(12) << "warm init" << std::endl;
+            benchmark("source scene", filename, nbRuns);
+            SceneLoaderBinary::setParallelInstantiation(false);
+            benchmark("binary, serial", binaryFilename, nbRuns);
+            if (!serial)
+            {
+                SceneLoaderBinary::setParallelInstantiation(true);
+                std::ostringstream label;
+                label << "binary, " << sofa::simulation::TaskScheduler::getInstance()->getThreadCount() << " threads";
+                benchmark(label.str(), binaryFilename, nbRuns);
+            }
+        }
+    }
+
+    sofa::simulation::graph::cleanup();
+    return result;
+}
@@ -53,6 +53,9 @@
 #include <sofa/gui/BaseViewer.h>
 #include <SofaSimulationCommon/xml/XML.h>
 #include <sofa/simulation/DeactivatedNodeVisitor.h>
+#include <sofa/simulation/DefaultVisualManagerLoop.h>
+#include <sofa/simulation/VisualAspectBuffer.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <SofaBaseVisual/VisualStyle.h>
 #include <sofa/helper/AdvancedTimer.h>
 #include <sofa/helper/system/SetDirectory.h>
@@ -482,6 +485,8 @@ RealGUI::RealGUI ( const char* viewername)
 
 RealGUI::~RealGUI()
 {
+    stopSimulationThread();
+
 #ifdef SOFA_PML
     if ( pmlreader )
     {
@@ -1022,6 +1027,8 @@ void RealGUI::setScene(Node::SPtr root, const char* filename, bool temporaryFile
 
 void RealGUI::unloadScene(bool _withViewer)
 {
+    stopSimulationThread();
+
     if(_withViewer && getViewer())
         getViewer()->unload();
 
@@ -1748,6 +1755,15 @@ void RealGUI::parseOptions()
         m_enableInteraction = vm["interactive"].as<bool>();
     if(vm.find("msaa") != vm.end())
         m_viewerMSAANbSampling = vm["msaa"].as<unsigned int>();
+    if(vm.find("asyncSimulation") != vm.end())
+        m_asyncSimulation = vm["asyncSimulation"].as<bool>();
+
+    if(m_asyncSimulation && !simulation::VisualAspectBuffer::isSupported())
+    {
+        msg_warning("runSofa") << "the asynchronous simulation requires SOFA to be compiled with SOFA_MAX_THREADS >= 2, "
+                                  "the animation will run in the GUI thread.";
+        m_asyncSimulation = false;
+    }
 
     if(m_enableInteraction)
         msg_warning("runSofa") << "you activated the interactive mode. This is currently an experimental feature "
@@ -2028,10 +2044,75 @@ void RealGUI::playpauseGUI ( bool value )
     {
         m_clockBeforeLastStep = 0;
         frameCounter=0;
-        timerStep->start(0);
+        if (m_asyncSimulation)
+            startSimulationThread();
+        // with a simulation thread, the timer only refreshes the display
+        timerStep->start(m_simulationThread.joinable() ? 16 : 0);
     }
     else
+    {
         timerStep->stop();
+        stopSimulationThread();
+    }
+}
+
+//------------------------------------
+
+void RealGUI::startSimulationThread()
+{
+    Node* root = currentSimulation();
+    if ( root == NULL || m_simulationThread.joinable() ) return;
+
+    simulation::DefaultVisualManagerLoop* visualLoop = dynamic_cast<simulation::DefaultVisualManagerLoop*>(root->getVisualLoop());
+    if ( !visualLoop || !visualLoop->setAsyncRendering(true) )
+    {
+        msg_warning("runSofa") << "the visual loop of this scene can't be rendered asynchronously, "
+                                  "the animation will run in the GUI thread.";
+        return;
+    }
+
+    m_simulationThreadRunning = true;
+    m_simulationThread = std::thread(&RealGUI::simulationThreadLoop, this);
+}
+
+//------------------------------------
+
+bool RealGUI::stopSimulationThread()
+{
+    if ( !m_simulationThread.joinable() ) return false;
+
+    m_simulationThreadRunning = false;
+    m_simulationThread.join();
+
+    // back to a synchronous rendering of the simulation aspect
+    Node* root = currentSimulation();
+    simulation::DefaultVisualManagerLoop* visualLoop = root ? dynamic_cast<simulation::DefaultVisualManagerLoop*>(root->getVisualLoop()) : NULL;
+    if ( visualLoop )
+        visualLoop->setAsyncRendering(false);
+    emit newStep();
+    return true;
+}
+
+//------------------------------------
+
+void RealGUI::simulationThreadLoop()
+{
+    // the parallel components queue their tasks from this thread
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    if ( !scheduler->attachCurrentThread("Simulation") )
+        msg_warning("runSofa") << "no task scheduler slot is free for the simulation thread, its tasks will run sequentially.";
+
+    Node* root = currentSimulation();
+    while ( m_simulationThreadRunning )
+    {
+        // the visual loop publishes the visual state at the end of updateVisual
+        simulation::getSimulation()->animate ( root );
+        simulation::getSimulation()->updateVisual ( root );
+        if ( !root->getContext()->getAnimate() )
+            m_simulationThreadRunning = false;
+    }
+
+    scheduler->detachCurrentThread();
 }
 
 //------------------------------------
@@ -2046,6 +2127,23 @@ void RealGUI::interactionGUI ( bool )
 //called at each step of the rendering
 void RealGUI::step()
 {
+    if ( m_simulationThread.joinable() )
+    {
+        // the animation runs in its own thread: only refresh the display with the latest published state
+        if ( !m_simulationThreadRunning )
+        {
+            startButton->setChecked ( false );
+            return;
+        }
+        simulation::DefaultVisualManagerLoop* visualLoop = static_cast<simulation::DefaultVisualManagerLoop*>(currentSimulation()->getVisualLoop());
+        visualLoop->beginRender();
+        eventNewStep();
+        eventNewTime();
+        emit newStep();
+        visualLoop->endRender();
+        return;
+    }
+
     sofa::helper::AdvancedTimer::begin("Animate");
 
     Node* root = currentSimulation();
@@ -2126,6 +2224,7 @@ void RealGUI::setDt(const QString& value)
 // Reset the simulation to t=0
 void RealGUI::resetScene()
 {
+    const bool simulationThreadWasRunning = stopSimulationThread();
     Node* root = currentSimulation();
     startDumpVisitor();
     emit ( newScene() );
@@ -2139,6 +2238,8 @@ void RealGUI::resetScene()
     }
     getViewer()->getPickHandler()->reset();
     stopDumpVisitor();
+    if ( simulationThreadWasRunning )
+        startSimulationThread();
 }
 
 //------------------------------------
@@ -45,6 +45,8 @@
 #include <QDockWidget>
 #include <QWindow>
 #include <time.h>
+#include <thread>
+#include <atomic>
 
 #include <sofa/helper/system/FileMonitor.h>
 
@@ -209,6 +211,9 @@ protected:
     std::set<std::string>   m_modifiedLogFiles;
 
     bool m_enableInteraction {false};
+    bool m_asyncSimulation {false};
+    std::thread m_simulationThread;
+    std::atomic<bool> m_simulationThreadRunning {false};
 private:
     //currently unused: scale is experimental
     float object_Scale[2];
@@ -292,6 +297,13 @@ protected:
     void startDumpVisitor();
     void stopDumpVisitor();
 
+    /// Run the animation in its own thread, the viewer then draws the visual state published by the
+    /// DefaultVisualManagerLoop at each step (see --asyncSimulation).
+    void startSimulationThread();
+    /// Join the simulation thread, return true if it was running.
+    bool stopSimulationThread();
+    void simulationThreadLoop();
+
     /// init the viewer for the GUI (embeded or not we have to connect some info about viewer in the GUI)
     virtual void initViewer(BaseViewer* _viewer);
 
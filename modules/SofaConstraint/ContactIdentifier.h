@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <sofa/core/collision/DetectionOutput.h>
+#include <sofa/core/behavior/BaseConstraint.h>
 
 #include <SofaConstraint/initConstraint.h>
 
@@ -70,6 +71,22 @@ inline long cantorPolynomia(sofa::core::collision::DetectionOutput::ContactId x,
     return (long)(((x+y)*(x+y)+3*x+y)/2);
 }
 
+/// Identifier of a contact which persists across time steps: it depends on the pair of colliding elements and
+/// on the id of the contact between them, and not on the order of the detection outputs nor on the contact object,
+/// so that the constraint solvers can reuse the force of the same contact in the previous step as initial guess.
+inline sofa::core::behavior::BaseConstraint::PersistentID persistentContactId(const sofa::core::collision::DetectionOutput* o)
+{
+    const unsigned long long keys[3] = { (unsigned long long)o->elem.first.getIndex(), (unsigned long long)o->elem.second.getIndex(), (unsigned long long)o->id };
+    unsigned long long h = 0;
+    for (unsigned long long k : keys)
+    {
+        h = (h ^ k) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 31;
+    }
+    // positive and not null, as the solvers use the sign of the ids
+    return (sofa::core::behavior::BaseConstraint::PersistentID)(h >> 2) + 1;
+}
+
 } // collision
 
 } // component
@@ -236,7 +236,7 @@ void FrictionContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::creat
             long index = cantorPolynomia(o->id /*cantorPolynomia(index1, index2)*/,id);
 
             // Add contact in unilateral constraint
-            m_constraint->addContact(mu_, o->normal, distance, index1, index2, index, o->id);
+            m_constraint->addContact(mu_, o->normal, distance, index1, index2, index, persistentContactId(o));
         }
 
         if (parent!=NULL)
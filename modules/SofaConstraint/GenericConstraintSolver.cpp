@@ -30,6 +30,7 @@
 #include <sofa/simulation/VectorOperations.h>
 
 #include <sofa/simulation/Simulation.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <sofa/helper/AdvancedTimer.h>
 #include <sofa/helper/system/thread/CTime.h>
 #include <math.h>
@@ -69,6 +70,7 @@ GenericConstraintSolver::GenericConstraintSolver()
 , allVerified( initData(&allVerified, false, "allVerified", "All contraints must be verified (each constraint's error < tolerance)"))
 , schemeCorrection( initData(&schemeCorrection, false, "schemeCorrection", "Apply new scheme where compliance is progressively corrected"))
 , unbuilt(initData(&unbuilt, false, "unbuilt", "Compliance is not fully built"))
+, d_resolutionMethod(initData(&d_resolutionMethod, "resolutionMethod", "Resolution of the built system: GaussSeidel (sequential), ParallelGaussSeidel (constraint groups colored by shared DOFs, each color solved concurrently; falls back to GaussSeidel when the coloring is too sequential) or Jacobi (all groups solved concurrently, each update being damped by the number of coupled groups)"))
 , computeGraphs(initData(&computeGraphs, false, "computeGraphs", "Compute graphs of errors and forces during resolution"))
 , graphErrors( initData(&graphErrors,"graphErrors","Sum of the constraints' errors at each iteration"))
 , graphConstraints( initData(&graphConstraints,"graphConstraints","Graph of each constraint's error at the end of the resolution"))
@@ -84,6 +86,10 @@ GenericConstraintSolver::GenericConstraintSolver()
 {
     addAlias(&maxIt, "maxIt");
 
+    sofa::helper::OptionsGroup methods(3, "GaussSeidel", "ParallelGaussSeidel", "Jacobi");
+    methods.setSelectedItem(GenericConstraintProblem::GAUSS_SEIDEL);
+    d_resolutionMethod.setValue(methods);
+
     graphErrors.setWidget("graph");
     graphErrors.setGroup("Graph");
 
@@ -369,6 +375,7 @@ bool GenericConstraintSolver::solveSystem(const core::ConstraintParams * /*cPara
     current_cp->allVerified = allVerified.getValue();
     current_cp->sor = sor.getValue();
     current_cp->unbuilt = unbuilt.getValue();
+    current_cp->resolutionMethod = d_resolutionMethod.getValue().getSelectedId();
 
     if (unbuilt.getValue())
     {
@@ -650,6 +657,19 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
         }
     }
 
+    // From a thread which is not attached to the task scheduler (e.g. the haptic thread), the parallel sweeps run inline.
+    bool parallel = (resolutionMethod != GAUSS_SEIDEL);
+    const bool jacobi = (resolutionMethod == JACOBI);
+    if(parallel && !computeGroupColors(w) && !jacobi)
+    {
+        if(solver && !sequentialFallbackWarned)
+        {
+            msg_warning(solver) << "Constraint groups too coupled for a colored Gauss-Seidel, using the sequential Gauss-Seidel" ;
+            sequentialFallbackWarned = true;
+        }
+        parallel = false;
+    }
+
     bool showGraphs = false;
     sofa::helper::vector<double>* graph_residuals = NULL;
     std::map < std::string, sofa::helper::vector<double> > *graph_forces = NULL, *graph_violations = NULL;
@@ -684,67 +704,79 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
         }
 
         error=0.0;
-        for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+        if(parallel)
         {
-			//1. nbLines provide the dimension of the constraint
-			nb = constraintsResolutions[j]->getNbLines();
+            error = parallelSweep(w, d, dfree, force, tol, jacobi, constraintsAreVerified);
+            if(solver)
+            {
+                for(unsigned int g=0; g+1<groupLines.size(); g++)
+                    tabErrors[groupLines[g]] = groupErrors[g];
+            }
+        }
+        else
+        {
+            for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+            {
+				//1. nbLines provide the dimension of the constraint
+				nb = constraintsResolutions[j]->getNbLines();
 
-            //2. for each line we compute the actual value of d
-            //   (a)d is set to dfree
+                //2. for each line we compute the actual value of d
+                //   (a)d is set to dfree
             
-            std::vector<double> errF(nb, 0);
+                std::vector<double> errF(nb, 0);
 
-            for(l=0; l<nb; l++)
-            {
-                errF[l] = force[j+l];
-                d[j+l] = dfree[j+l];
-            }
-            //   (b) contribution of forces are added to d     => TODO => optimization (no computation when force= 0 !!)
-            for(k=0; k<dimension; k++)
                 for(l=0; l<nb; l++)
-                    d[j+l] += w[j+l][k] * force[k];
+                {
+                    errF[l] = force[j+l];
+                    d[j+l] = dfree[j+l];
+                }
+                //   (b) contribution of forces are added to d     => TODO => optimization (no computation when force= 0 !!)
+                for(k=0; k<dimension; k++)
+                    for(l=0; l<nb; l++)
+                        d[j+l] += w[j+l][k] * force[k];
 
-            //3. the specific resolution of the constraint(s) is called
-            constraintsResolutions[j]->resolution(j, w, d, force, dfree);
+                //3. the specific resolution of the constraint(s) is called
+                constraintsResolutions[j]->resolution(j, w, d, force, dfree);
 
-            //4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
-            double contraintError = 0.0;
-            if(nb > 1)
-            {
-                for(l=0; l<nb; l++)
+                //4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
+                double contraintError = 0.0;
+                if(nb > 1)
                 {
-                    double lineError = 0.0;
-                    for (int m=0; m<nb; m++)
+                    for(l=0; l<nb; l++)
                     {
-                        double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
-                        lineError += dofError * dofError;
+                        double lineError = 0.0;
+                        for (int m=0; m<nb; m++)
+                        {
+                            double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
+                            lineError += dofError * dofError;
+                        }
+                        lineError = sqrt(lineError);
+                        if(lineError > tol)
+                            constraintsAreVerified = false;
+
+                        contraintError += lineError;
                     }
-                    lineError = sqrt(lineError);
-                    if(lineError > tol)
+                }
+                else
+                {
+                    contraintError = fabs(w[j][j] * (force[j] - errF[0]));
+                    if(contraintError > tol)
                         constraintsAreVerified = false;
-
-                    contraintError += lineError;
                 }
-            }
-            else
-            {
-                contraintError = fabs(w[j][j] * (force[j] - errF[0]));
-                if(contraintError > tol)
-                    constraintsAreVerified = false;
-            }
 
-			if(constraintsResolutions[j]->getTolerance())
-            {
-				if(contraintError > constraintsResolutions[j]->getTolerance())
-                    constraintsAreVerified = false;
-				contraintError *= tol / constraintsResolutions[j]->getTolerance();
-            }
+				if(constraintsResolutions[j]->getTolerance())
+                {
+					if(contraintError > constraintsResolutions[j]->getTolerance())
+                        constraintsAreVerified = false;
+					contraintError *= tol / constraintsResolutions[j]->getTolerance();
+                }
 
-            error += contraintError;
-            if(solver)
-                tabErrors[j] = contraintError;
+                error += contraintError;
+                if(solver)
+                    tabErrors[j] = contraintError;
 
-            j += nb;
+                j += nb;
+            }
         }
 
         if(showGraphs)
@@ -840,6 +872,189 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
     }
 }
 
+bool GenericConstraintProblem::computeGroupColors(double** w)
+{
+    groupLines.clear();
+    for(int i=0; i<dimension; i += constraintsResolutions[i]->getNbLines())
+        groupLines.push_back(i);
+    const int nbGroups = (int)groupLines.size();
+    groupLines.push_back(dimension);
+
+    std::vector<int> lineGroup(dimension);
+    for(int g=0; g<nbGroups; g++)
+        for(int l=groupLines[g]; l<groupLines[g+1]; l++)
+            lineGroup[l] = g;
+
+    // two groups are coupled when they share DOFs, i.e. when their block of W is not null
+    groupNeighbors.resize(nbGroups);
+    std::vector<int> mark(nbGroups, -1);
+    for(int g=0; g<nbGroups; g++)
+    {
+        std::vector<int>& neighbors = groupNeighbors[g];
+        neighbors.clear();
+        neighbors.push_back(g);
+        mark[g] = g;
+        for(int l=groupLines[g]; l<groupLines[g+1]; l++)
+        {
+            for(int k=0; k<dimension; k++)
+            {
+                if(w[l][k] != 0.0 && mark[lineGroup[k]] != g)
+                {
+                    mark[lineGroup[k]] = g;
+                    neighbors.push_back(lineGroup[k]);
+                }
+            }
+        }
+    }
+
+    // greedy coloring, in the order of the groups
+    std::vector<int> color(nbGroups, -1);
+    std::vector<int> forbidden(nbGroups, -1);
+    int nbColors = 0;
+    for(int g=0; g<nbGroups; g++)
+    {
+        const std::vector<int>& neighbors = groupNeighbors[g];
+        for(unsigned int n=0; n<neighbors.size(); n++)
+        {
+            if(color[neighbors[n]] >= 0)
+                forbidden[color[neighbors[n]]] = g;
+        }
+        int c = 0;
+        while(forbidden[c] == g)
+            ++c;
+        color[g] = c;
+        nbColors = std::max(nbColors, c+1);
+    }
+
+    colorBegin.assign(nbColors+1, 0);
+    for(int g=0; g<nbGroups; g++)
+        colorBegin[color[g]+1]++;
+    for(int c=0; c<nbColors; c++)
+        colorBegin[c+1] += colorBegin[c];
+    colorGroups.resize(nbGroups);
+    std::vector<int> next(colorBegin.begin(), colorBegin.end()-1);
+    for(int g=0; g<nbGroups; g++)
+        colorGroups[next[color[g]]++] = g;
+
+    return 2*nbColors <= nbGroups;
+}
+
+double GenericConstraintProblem::resolveGroup(int group, double** w, double* d, double* dfree, double* force, const double* sweepForce, double relaxation, double tol, bool& verified)
+{
+    const int j = groupLines[group];
+    const int nb = groupLines[group+1] - j;
+
+    std::vector<double> errF(nb, 0);
+    for(int l=0; l<nb; l++)
+    {
+        errF[l] = force[j+l];
+        d[j+l] = dfree[j+l];
+    }
+
+    // only the coupled groups contribute to d
+    const std::vector<int>& neighbors = groupNeighbors[group];
+    for(unsigned int n=0; n<neighbors.size(); n++)
+    {
+        const int kBegin = groupLines[neighbors[n]];
+        const int kEnd = groupLines[neighbors[n]+1];
+        for(int l=0; l<nb; l++)
+            for(int k=kBegin; k<kEnd; k++)
+                d[j+l] += w[j+l][k] * sweepForce[k];
+    }
+
+    constraintsResolutions[j]->resolution(j, w, d, force, dfree);
+
+    // a convex combination of the previous and the new forces: the constraint laws are still satisfied
+    if(relaxation != 1.0)
+    {
+        for(int l=0; l<nb; l++)
+            force[j+l] = errF[l] + relaxation * (force[j+l] - errF[l]);
+    }
+
+    double contraintError = 0.0;
+    if(nb > 1)
+    {
+        for(int l=0; l<nb; l++)
+        {
+            double lineError = 0.0;
+            for (int m=0; m<nb; m++)
+            {
+                double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
+                lineError += dofError * dofError;
+            }
+            lineError = sqrt(lineError);
+            if(lineError > tol)
+                verified = false;
+
+            contraintError += lineError;
+        }
+    }
+    else
+    {
+        contraintError = fabs(w[j][j] * (force[j] - errF[0]));
+        if(contraintError > tol)
+            verified = false;
+    }
+
+    if(constraintsResolutions[j]->getTolerance())
+    {
+        if(contraintError > constraintsResolutions[j]->getTolerance())
+            verified = false;
+        contraintError *= tol / constraintsResolutions[j]->getTolerance();
+    }
+
+    return contraintError;
+}
+
+double GenericConstraintProblem::parallelSweep(double** w, double* d, double* dfree, double* force, double tol, bool jacobi, bool& constraintsAreVerified)
+{
+    const int nbGroups = (int)groupLines.size() - 1;
+    groupErrors.resize(nbGroups);
+    groupVerified.resize(nbGroups);
+
+    // each group only writes its own lines of d and force
+    const double* sweepForce = force;
+    if(jacobi)
+    {
+        jacobiForces.assign(force, force+dimension);
+        sweepForce = jacobiForces.data();
+    }
+
+    auto solveGroups = [&](int first, int last)
+    {
+        for(int i=first; i<last; i++)
+        {
+            const int g = jacobi ? i : colorGroups[i];
+            // damped Jacobi: each group only takes its share of the correction among the groups it is coupled with,
+            // which keeps the sweeps convergent for a symmetric positive definite W
+            const double relaxation = jacobi ? 1.0 / groupNeighbors[g].size() : 1.0;
+            bool verified = true;
+            groupErrors[g] = resolveGroup(g, w, d, dfree, force, sweepForce, relaxation, tol, verified);
+            groupVerified[g] = verified;
+        }
+    };
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    if(jacobi)
+        scheduler->parallel_for(0, nbGroups, solveGroups);
+    else
+    {
+        for(unsigned int c=0; c+1<colorBegin.size(); c++)
+            scheduler->parallel_for(colorBegin[c], colorBegin[c+1], solveGroups);
+    }
+
+    // summed in the order of the groups, so that the error does not depend on the scheduling
+    double error = 0.0;
+    for(int g=0; g<nbGroups; g++)
+    {
+        error += groupErrors[g];
+        if(!groupVerified[g])
+            constraintsAreVerified = false;
+    }
+    return error;
+}
+
+
 
 void GenericConstraintProblem::unbuiltGaussSeidel(double timeout, GenericConstraintSolver* solver)
 {
@@ -35,6 +35,7 @@
 #include <SofaBaseLinearSolver/SparseMatrix.h>
 
 #include <sofa/helper/map.h>
+#include <sofa/helper/OptionsGroup.h>
 
 namespace sofa
 {
@@ -53,6 +54,7 @@ public:
     sofa::component::linearsolver::FullVector<double> _d;
 	std::vector<core::behavior::ConstraintResolution*> constraintsResolutions;
 	bool scaleTolerance, allVerified, unbuilt;
+	int resolutionMethod;
 	double sor;
 	double sceneTime;
     double currentError;
@@ -67,11 +69,22 @@ public:
 	typedef std::vector< core::behavior::BaseConstraintCorrection* >::iterator ConstraintCorrectionIterator;
 
 	std::vector< ConstraintCorrections > cclist_elems;
-	
 
-	GenericConstraintProblem() : scaleTolerance(true), allVerified(false), sor(1.0)
+	enum { GAUSS_SEIDEL = 0, PARALLEL_GAUSS_SEIDEL, JACOBI };
+
+	// For parallel versions :
+	std::vector<int> groupLines;                    // first line of each constraint group
+	std::vector< std::vector<int> > groupNeighbors; // groups coupled to each group by W (itself included)
+	std::vector<int> colorBegin;                    // groups of color c are colorGroups[colorBegin[c]..colorBegin[c+1]-1]
+	std::vector<int> colorGroups;
+	std::vector<double> groupErrors;
+	std::vector<char> groupVerified;
+	std::vector<double> jacobiForces;
+	bool sequentialFallbackWarned;
+
+	GenericConstraintProblem() : scaleTolerance(true), allVerified(false), resolutionMethod(GAUSS_SEIDEL), sor(1.0)
         , sceneTime(0.0), currentError(0.0), currentIterations(0)
-		, change_sequence(false) {}
+		, change_sequence(false), sequentialFallbackWarned(false) {}
 	~GenericConstraintProblem() { freeConstraintResolutions(); }
 
 	void clear(int nbConstraints);
@@ -81,6 +94,16 @@ public:
 	void gaussSeidel(double timeout=0, GenericConstraintSolver* solver = NULL);
 	void unbuiltGaussSeidel(double timeout=0, GenericConstraintSolver* solver = NULL);
 
+	/// Color the constraint groups so that groups of the same color are not coupled by W.
+	/// Returns false if the coloring leaves too few groups per color to be worth a parallel sweep.
+	bool computeGroupColors(double** w);
+	/// One sweep over all the constraint groups, the groups of a color being solved concurrently.
+	/// With jacobi, all the groups are solved concurrently from the forces of the previous sweep, the correction of
+	/// each group being weighted by the inverse of the number of groups it is coupled with.
+	double parallelSweep(double** w, double* d, double* dfree, double* force, double tol, bool jacobi, bool& constraintsAreVerified);
+	/// Solve a group, its new forces being relaxation * new + (1 - relaxation) * previous.
+	double resolveGroup(int group, double** w, double* d, double* dfree, double* force, const double* sweepForce, double relaxation, double tol, bool& verified);
+
     int getNumConstraints();
     int getNumConstraintGroups();
 };
@@ -119,6 +142,7 @@ public:
 	Data<bool> allVerified; ///< All contraints must be verified (each constraint's error < tolerance)
 	Data<bool> schemeCorrection; ///< Apply new scheme where compliance is progressively corrected
 	Data<bool> unbuilt; ///< Compliance is not fully built
+	Data<sofa::helper::OptionsGroup> d_resolutionMethod; ///< Resolution of the built system: sequential or colored parallel Gauss-Seidel, or parallel Jacobi
 	Data<bool> computeGraphs; ///< Compute graphs of errors and forces during resolution
 	Data<std::map < std::string, sofa::helper::vector<double> > > graphErrors; ///< Sum of the constraints' errors at each iteration
 	Data<std::map < std::string, sofa::helper::vector<double> > > graphConstraints; ///< Graph of each constraint's error at the end of the resolution
@@ -263,7 +263,7 @@ LCPConstraintSolver::LCPConstraintSolver()
     constraintGroups.endEdit();
 
     f_graph.setWidget("graph");
-    _Wdiag = new sofa::component::linearsolver::SparseMatrix<double>();
+    _Wdiag = new sofa::component::linearsolver::BlockDiagonalMatrix<3,double>();
 
     tol.setRequired(true);
     maxIt.setRequired(true);
@@ -718,8 +718,9 @@ void LCPConstraintSolver::build_problem_info()
     lcp->mu = _mu;
     lcp->clear(_numConstraints);
 
-    // as _Wdiag is a sparse matrix resize do not allocate memory
+    // only the 3x3 diagonal blocks of the contacts are used by the unbuilt resolution
     _Wdiag->resize(_numConstraints,_numConstraints);
+    _Wdiag->clear();
 
     sofa::helper::AdvancedTimer::stepBegin("Get Constraint Value");
     MechanicalGetConstraintViolationVisitor(&cparams, _dFree).execute(context);
@@ -796,7 +797,7 @@ void LCPConstraintSolver::computeInitialGuess()
             if (prevIndex >= 0 && prevIndex+nbl <= (int) _previousForces.size())
             {
                 for (int l=0; l<nbl; ++l)
-                    (*_result)[c0 + c*nbl + l] = _previousForces[prevIndex + l];
+                    (*_result)[c0 + c*info.nbLines + l] = _previousForces[prevIndex + l];
             }
         }
     }
@@ -811,13 +812,9 @@ void LCPConstraintSolver::keepContactForcesValue()
     _previousForces.resize(_numConstraints);
     for (unsigned int c=0; c<_numConstraints; ++c)
         _previousForces[c] = (*_result)[c];
-    // clear previous history
-    for (std::map<core::behavior::BaseConstraint*, ConstraintBlockBuf>::iterator it = _previousConstraints.begin(), itend = _previousConstraints.end(); it != itend; ++it)
-    {
-        ConstraintBlockBuf& buf = it->second;
-        for (std::map<PersistentID,int>::iterator it2 = buf.persistentToConstraintIdMap.begin(), it2end = buf.persistentToConstraintIdMap.end(); it2 != it2end; ++it2)
-            it2->second = -1;
-    }
+    // clear previous history: only the constraints of this step are kept, as a constraint which
+    // disappeared may be deleted and a new one allocated at the same address
+    _previousConstraints.clear();
     // fill info from current ids
     for (unsigned cb = 0; cb < constraintBlockInfo.size(); ++cb)
     {
@@ -977,13 +974,14 @@ int LCPConstraintSolver::nlcp_gaussseidel_unbuilt(double *dfree, double *f, std:
     helper::LocalBlock33 *W33 = &(unbuilt_W33[0]); //new helper::LocalBlock33[numContacts];
     for (c1=0; c1<numContacts; c1++)
     {
+        const defaulttype::Mat<3,3,double>& b = _Wdiag->bloc(c1);
         double w[6];
-        w[0] = _Wdiag->element(3*c1  , 3*c1  );
-        w[1] = _Wdiag->element(3*c1  , 3*c1+1);
-        w[2] = _Wdiag->element(3*c1  , 3*c1+2);
-        w[3] = _Wdiag->element(3*c1+1, 3*c1+1);
-        w[4] = _Wdiag->element(3*c1+1, 3*c1+2);
-        w[5] = _Wdiag->element(3*c1+2, 3*c1+2);
+        w[0] = b[0][0];
+        w[1] = b[0][1];
+        w[2] = b[0][2];
+        w[3] = b[1][1];
+        w[4] = b[1][2];
+        w[5] = b[2][2];
         W33[c1].compute(w[0], w[1] , w[2], w[3], w[4] , w[5]);
     }
 
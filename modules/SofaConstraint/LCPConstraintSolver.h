@@ -30,7 +30,7 @@
 #include <sofa/simulation/MechanicalVisitor.h>
 
 #include <SofaBaseLinearSolver/FullMatrix.h>
-#include <SofaBaseLinearSolver/SparseMatrix.h>
+#include <SofaBaseLinearSolver/DiagonalMatrix.h>
 
 #include <sofa/helper/set.h>
 #include <sofa/helper/map.h>
@@ -220,7 +220,7 @@ public:
     int nlcp_gaussseidel_unbuilt(double *dfree, double *f, std::vector<double>* residuals = NULL);
     int gaussseidel_unbuilt(double *dfree, double *f, std::vector<double>* residuals = NULL) { if (_mu == 0.0) return lcp_gaussseidel_unbuilt(dfree, f, residuals); else return nlcp_gaussseidel_unbuilt(dfree, f, residuals); }
 
-    sofa::component::linearsolver::SparseMatrix<double> *_Wdiag;
+    sofa::component::linearsolver::BlockDiagonalMatrix<3,double> *_Wdiag; ///< 3x3 diagonal blocks of the compliance, for the unbuilt resolution
     std::vector<core::behavior::BaseConstraintCorrection*> _cclist_elem1;
     std::vector<core::behavior::BaseConstraintCorrection*> _cclist_elem2;
 
@@ -25,6 +25,8 @@
 
 #include <sofa/core/behavior/ConstraintCorrection.h>
 #include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/helper/OptionsGroup.h>
+#include <sofa/helper/io/BinaryMatrixFile.h>
 
 #include <SofaBaseLinearSolver/FullMatrix.h>
 
@@ -72,6 +74,9 @@ public:
 	Data<double> debugViewFrameScale; ///< Scale on computed node's frame
 	sofa::core::objectmodel::DataFileName f_fileCompliance; ///< Precomputed compliance matrix data file
 	Data<std::string> fileDir; ///< If not empty, the compliance will be saved in this repertory
+    Data<bool> d_useCache; ///< use a binary cache of the compliance, keyed on the parameters of the objects of the node
+    Data<helper::OptionsGroup> d_cacheEncoding; ///< scalar type of the values in the cache
+    Data<bool> d_cacheSymmetric; ///< only store the upper triangle of the compliance in the cache
     
 protected:
     PrecomputedConstraintCorrection(sofa::core::behavior::MechanicalState<DataTypes> *mm = NULL);
@@ -128,10 +133,12 @@ public:
     {
         Real* data;
         int nbref;
-        InverseStorage() : data(NULL), nbref(0) {}
+        helper::io::BinaryMatrixFile* cache; ///< if not NULL, data is the mapping of the cache file
+        InverseStorage() : data(NULL), nbref(0), cache(NULL) {}
     };
 
     std::string invName;
+    std::uint64_t cacheKey; ///< key of the cache, computed before the precomputation modifies the node
     InverseStorage* invM;
     Real* appCompliance;
     unsigned int dimensionAppCompliance;
@@ -192,6 +199,29 @@ protected:
      */
     std::string buildFileName();
 
+    /**
+     * @brief Hash of what the compliance is computed from: the rest positions, the topology,
+     * and the parameters of the mass, the force fields and the solvers.
+     */
+    std::uint64_t computeCacheKey();
+
+    /**
+     * @brief Builds the path of the cache file of the given key.
+     */
+    std::string buildCacheFileName(std::uint64_t key);
+
+    /**
+     * @brief Load the compliance matrix from the binary cache.
+     *
+     * @return Loading success.
+     */
+    bool loadCache(std::uint64_t key);
+
+    /**
+     * @brief Save the compliance matrix into the binary cache.
+     */
+    void saveCache(std::uint64_t key);
+
     /**
      * @brief Compute dx correction from motion space force vector.
      */
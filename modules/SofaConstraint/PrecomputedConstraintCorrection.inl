@@ -38,6 +38,12 @@
 
 #include <sofa/core/behavior/RotationFinder.h>
 
+#include <sofa/core/behavior/BaseMass.h>
+#include <sofa/core/behavior/BaseForceField.h>
+#include <sofa/core/behavior/OdeSolver.h>
+#include <sofa/core/behavior/LinearSolver.h>
+#include <sofa/core/topology/BaseMeshTopology.h>
+
 #include <sofa/helper/system/FileRepository.h>
 #include <sofa/helper/Quater.h>
 
@@ -48,6 +54,9 @@
 #include <sstream>
 #include <list>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 
 //#define NEW_METHOD_UNBUILT
 
@@ -69,6 +78,10 @@ PrecomputedConstraintCorrection<DataTypes>::PrecomputedConstraintCorrection(sofa
     , debugViewFrameScale(initData(&debugViewFrameScale, 1.0, "debugViewFrameScale", "Scale on computed node's frame"))
     , f_fileCompliance(initData(&f_fileCompliance, "fileCompliance", "Precomputed compliance matrix data file"))
     , fileDir(initData(&fileDir, "fileDir", "If not empty, the compliance will be saved in this repertory"))
+    , d_useCache(initData(&d_useCache, false, "useCache", "if true, the compliance is saved in a binary cache, keyed on the parameters of the objects of the node, and mapped in memory when loaded"))
+    , d_cacheEncoding(initData(&d_cacheEncoding, helper::OptionsGroup(3,"native","float","half"), "cacheEncoding", "scalar type of the values in the cache: native (used in place, shared by the processes loading the same cache), float or half (16 bits values relative to the largest value of their row)"))
+    , d_cacheSymmetric(initData(&d_cacheSymmetric, false, "cacheSymmetric", "if true, only the upper triangle of the compliance is stored in the cache"))
+    , cacheKey(0)
     , invM(NULL)
     , appCompliance(NULL)
     , nbRows(0), nbCols(0), dof_on_node(0), nbNodes(0)
@@ -104,7 +117,8 @@ void PrecomputedConstraintCorrection<DataTypes>::releaseInverse(std::string name
     std::map< std::string, InverseStorage >& registry = getInverseMap();
     if (--inv->nbref == 0)
     {
-        if (inv->data) delete[] inv->data;
+        if (inv->cache) delete inv->cache; // data is the mapping of the cache
+        else if (inv->data) delete[] inv->data;
         registry.erase(name);
     }
 }
@@ -125,6 +139,147 @@ std::string PrecomputedConstraintCorrection<DataTypes>::buildFileName()
     return ss.str();
 }
 
+/// hash of the Data of an object the compliance depends on
+static inline std::uint64_t hashParameters(const core::objectmodel::Base* obj, std::uint64_t key)
+{
+    typedef helper::io::BinaryMatrixFile BinaryMatrixFile;
+    static const char* ignoredData[] = { "name", "printLog", "tags", "bbox", "listening" };
+
+    key = BinaryMatrixFile::hash(obj->getClassName(), key);
+    const core::objectmodel::Base::VecData& fields = obj->getDataFields();
+    for (unsigned int i = 0; i < fields.size(); ++i)
+    {
+        const core::objectmodel::BaseData* data = fields[i];
+        if (!std::strcmp(data->getGroup(), "Visualization"))
+            continue;
+        if (std::find_if(std::begin(ignoredData), std::end(ignoredData), [&](const char* n) { return data->getName() == n; }) != std::end(ignoredData))
+            continue;
+        key = BinaryMatrixFile::hash(data->getName(), key);
+        key = BinaryMatrixFile::hash(data->getValueString(), key);
+    }
+    return key;
+}
+
+template<class T>
+static inline std::uint64_t hashElements(const helper::vector<T>& elements, std::uint64_t key)
+{
+    const std::uint64_t size = elements.size();
+    key = helper::io::BinaryMatrixFile::hash(&size, sizeof(size), key);
+    return elements.empty() ? key : helper::io::BinaryMatrixFile::hash(&elements[0], elements.size() * sizeof(T), key);
+}
+
+template<class DataTypes>
+std::uint64_t PrecomputedConstraintCorrection<DataTypes>::computeCacheKey()
+{
+    typedef helper::io::BinaryMatrixFile BinaryMatrixFile;
+
+    std::ostringstream ss;
+    ss << sizeof(Real) << " " << dof_on_node << " " << nbRows << " " << std::setprecision(17) << this->getContext()->getDt();
+
+    // the compliance is computed around the rest positions, the current state does not matter
+    const VecCoord& x0 = this->mstate->read(core::ConstVecCoordId::restPosition())->getValue();
+    for (unsigned int i = 0; i < x0.size(); ++i)
+        ss << " " << x0[i];
+    std::uint64_t key = BinaryMatrixFile::hash(ss.str());
+
+    core::topology::BaseMeshTopology* topology = this->getContext()->getMeshTopology();
+    if (topology)
+    {
+        key = hashElements(topology->getEdges(), key);
+        key = hashElements(topology->getTriangles(), key);
+        key = hashElements(topology->getQuads(), key);
+        key = hashElements(topology->getTetrahedra(), key);
+        key = hashElements(topology->getHexahedra(), key);
+    }
+
+    core::behavior::BaseMass* mass = NULL;
+    this->getContext()->get(mass, core::objectmodel::BaseContext::Local);
+    if (mass)
+        key = hashParameters(mass, key);
+
+    helper::vector<core::behavior::BaseForceField*> forceFields;
+    this->getContext()->template get<core::behavior::BaseForceField>(&forceFields, core::objectmodel::BaseContext::Local);
+    for (unsigned int i = 0; i < forceFields.size(); ++i)
+        key = hashParameters(forceFields[i], key);
+
+    // the solvers used for the precomputation, possibly in a parent node
+    core::behavior::OdeSolver* odeSolver = NULL;
+    this->getContext()->get(odeSolver);
+    if (odeSolver)
+        key = hashParameters(odeSolver, key);
+    core::behavior::LinearSolver* linearSolver = NULL;
+    this->getContext()->get(linearSolver);
+    if (linearSolver)
+        key = hashParameters(linearSolver, key);
+
+    return key;
+}
+
+template<class DataTypes>
+std::string PrecomputedConstraintCorrection<DataTypes>::buildCacheFileName(std::uint64_t key)
+{
+    std::string dir = fileDir.getValue();
+    if (dir.empty())
+        dir = sofa::helper::system::DataRepository.getFirstPath();
+
+    std::stringstream ss;
+    ss << dir << "/" << this->getContext()->getName() << "-" << std::hex << std::setw(16) << std::setfill('0') << key << ".ccache";
+
+    return ss.str();
+}
+
+template<class DataTypes>
+bool PrecomputedConstraintCorrection<DataTypes>::loadCache(std::uint64_t key)
+{
+    const std::string fileName = buildCacheFileName(key);
+
+    helper::io::BinaryMatrixFile* cache = new helper::io::BinaryMatrixFile;
+    if (!cache->open(fileName, key, nbRows))
+    {
+        msg_info(this) << "No valid compliance cache " << fileName;
+        delete cache;
+        return false;
+    }
+
+    const Real* values = (sizeof(Real) == sizeof(double))
+            ? reinterpret_cast<const Real*>(cache->getDoubleValues())
+            : reinterpret_cast<const Real*>(cache->getFloatValues());
+    if (values)
+    {
+        // the compliance is never modified once computed: it is used in place, read-only
+        msg_info(this) << "Compliance cache " << fileName << " mapped";
+        invM->data = const_cast<Real*>(values);
+        invM->cache = cache;
+    }
+    else
+    {
+        msg_info(this) << "Compliance cache " << fileName << " found. Loading...";
+        invM->data = new Real[nbRows * nbCols];
+        cache->read(invM->data);
+        delete cache;
+    }
+    return true;
+}
+
+template<class DataTypes>
+void PrecomputedConstraintCorrection<DataTypes>::saveCache(std::uint64_t key)
+{
+    typedef helper::io::BinaryMatrixFile BinaryMatrixFile;
+    const std::string fileName = buildCacheFileName(key);
+
+    BinaryMatrixFile::Encoding encoding = (sizeof(Real) == sizeof(double)) ? BinaryMatrixFile::ENCODING_DOUBLE : BinaryMatrixFile::ENCODING_FLOAT;
+    switch (d_cacheEncoding.getValue().getSelectedId())
+    {
+    case 1: encoding = BinaryMatrixFile::ENCODING_FLOAT; break;
+    case 2: encoding = BinaryMatrixFile::ENCODING_HALF; break;
+    default: break;
+    }
+
+    msg_info(this) << "saveCompliance in cache " << fileName;
+    if (!BinaryMatrixFile::write(fileName, key, invM->data, nbRows, encoding, d_cacheSymmetric.getValue()))
+        msg_error(this) << "Error while writing the compliance cache " << fileName;
+}
+
 
 
 template<class DataTypes>
@@ -136,6 +291,12 @@ bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string file
     invM = getInverse(fileName);
     dimensionAppCompliance = nbRows;
 
+    if (invM->data == NULL && d_useCache.getValue() && recompute.getValue() == false)
+    {
+        if (loadCache(cacheKey))
+            return true;
+    }
+
     if (invM->data == NULL)
     {
         // Try to load from file
@@ -187,6 +348,12 @@ bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string file
 template<class DataTypes>
 void PrecomputedConstraintCorrection<DataTypes>::saveCompliance(const std::string& fileName)
 {
+    if (d_useCache.getValue())
+    {
+        saveCache(cacheKey);
+        return;
+    }
+
     msg_info(this) << "saveCompliance in " << fileName;
 
     std::string filePathInSofaShare;
@@ -227,6 +394,10 @@ void PrecomputedConstraintCorrection<DataTypes>::bwdInit()
 
     invName = f_fileCompliance.getFullPath().empty() ? buildFileName() : f_fileCompliance.getFullPath();
 
+    // computed before the precomputation changes the gravity, the solver parameters and the state
+    if (d_useCache.getValue())
+        cacheKey = computeCacheKey();
+
     if (!loadCompliance(invName))
     {
         msg_info(this) << "Compliance being built";
@@ -0,0 +1,142 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaConstraint/GenericConstraintSolver.h>
+#include <SofaConstraint/BilateralConstraintResolution.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <cmath>
+
+namespace sofa {
+
+using component::constraintset::GenericConstraintProblem;
+using component::constraintset::BilateralConstraintResolution;
+
+/** Compare the parallel resolutions of GenericConstraintProblem with the sequential Gauss-Seidel.
+ *
+ * The bilateral constraints are grouped in cliques of size n whose lines are all coupled by the compliance a,
+ * each clique being coupled to the next one by the compliance c. The compliance matrix is symmetric positive
+ * definite, but an undamped Jacobi diverges as soon as a*(n-1) > 1.
+ */
+struct GenericConstraintSolver_test : public Sofa_test<double>
+{
+    simulation::TaskScheduler* scheduler;
+
+    GenericConstraintSolver_test()
+        : scheduler(simulation::TaskScheduler::getInstance())
+    {
+        scheduler->init(4);
+    }
+
+    ~GenericConstraintSolver_test()
+    {
+        scheduler->stop();
+    }
+
+    static helper::vector<double> solve(int method, int nbCliques, int cliqueSize, double a, double c, int maxIt)
+    {
+        const int n = nbCliques * cliqueSize;
+        GenericConstraintProblem problem;
+        problem.clear(n);
+        for (int i=0; i<n; ++i)
+        {
+            for (int j=0; j<n; ++j)
+                problem.W.set(i, j, 0.0);
+            problem.W.set(i, i, 1.0);
+            problem.dFree.set(i, std::sin(1.0 + i));
+            problem.f.set(i, 0.0);
+            problem.constraintsResolutions[i] = new BilateralConstraintResolution();
+        }
+        for (int k=0; k<nbCliques; ++k)
+        {
+            const int first = k*cliqueSize;
+            for (int i=first; i<first+cliqueSize; ++i)
+                for (int j=first; j<first+cliqueSize; ++j)
+                    if (i != j)
+                        problem.W.set(i, j, a);
+            if (k+1 < nbCliques)
+            {
+                problem.W.set(first+cliqueSize-1, first+cliqueSize, c);
+                problem.W.set(first+cliqueSize, first+cliqueSize-1, c);
+            }
+        }
+        problem.tolerance = 1e-14;
+        problem.maxIterations = maxIt;
+        problem.scaleTolerance = false;
+        problem.allVerified = false;
+        problem.resolutionMethod = method;
+        problem.gaussSeidel();
+
+        helper::vector<double> forces(n);
+        for (int i=0; i<n; ++i)
+            forces[i] = problem.f[i];
+
+        // W f + dfree = 0 for bilateral constraints
+        if (maxIt > 100)
+        {
+            for (int i=0; i<n; ++i)
+            {
+                double d = problem.dFree[i];
+                for (int j=0; j<n; ++j)
+                    d += problem.W.element(i, j) * forces[j];
+                EXPECT_NEAR(0.0, d, 1e-8) << "line " << i;
+            }
+        }
+        return forces;
+    }
+
+    void coupledProblem()
+    {
+        const helper::vector<double> gaussSeidel = solve(GenericConstraintProblem::GAUSS_SEIDEL, 16, 4, 0.5, 0.1, 5000);
+        const helper::vector<double> parallelGaussSeidel = solve(GenericConstraintProblem::PARALLEL_GAUSS_SEIDEL, 16, 4, 0.5, 0.1, 5000);
+        const helper::vector<double> jacobi = solve(GenericConstraintProblem::JACOBI, 16, 4, 0.5, 0.1, 5000);
+        ASSERT_EQ(gaussSeidel.size(), parallelGaussSeidel.size());
+        ASSERT_EQ(gaussSeidel.size(), jacobi.size());
+        for (std::size_t i=0; i<gaussSeidel.size(); ++i)
+        {
+            EXPECT_NEAR(gaussSeidel[i], parallelGaussSeidel[i], 1e-7) << "line " << i;
+            EXPECT_NEAR(gaussSeidel[i], jacobi[i], 1e-7) << "line " << i;
+        }
+    }
+
+    void sequentialFallback()
+    {
+        // a single clique can't be colored: the parallel Gauss-Seidel falls back to the sequential one
+        const helper::vector<double> gaussSeidel = solve(GenericConstraintProblem::GAUSS_SEIDEL, 1, 8, 0.5, 0.0, 3);
+        const helper::vector<double> parallelGaussSeidel = solve(GenericConstraintProblem::PARALLEL_GAUSS_SEIDEL, 1, 8, 0.5, 0.0, 3);
+        for (std::size_t i=0; i<gaussSeidel.size(); ++i)
+            EXPECT_EQ(gaussSeidel[i], parallelGaussSeidel[i]) << "line " << i;
+    }
+};
+
+TEST_F(GenericConstraintSolver_test, coupledProblem)
+{
+    this->coupledProblem();
+}
+
+TEST_F(GenericConstraintSolver_test, sequentialFallback)
+{
+    this->sequentialFallback();
+}
+
+} // namespace sofa
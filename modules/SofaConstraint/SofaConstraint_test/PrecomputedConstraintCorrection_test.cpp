@@ -0,0 +1,118 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+#include <SofaConstraint/PrecomputedConstraintCorrection.h>
+#include <sofa/defaulttype/Vec3Types.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace sofa {
+
+using simulation::Node;
+using simulation::SceneLoaderXML;
+
+/** Test the binary cache of the compliance of PrecomputedConstraintCorrection
+*/
+struct PrecomputedConstraintCorrection_test: public Sofa_test<SReal>
+{
+    typedef component::constraintset::PrecomputedConstraintCorrection<defaulttype::Vec3Types> PrecomputedConstraintCorrection;
+
+    PrecomputedConstraintCorrection_test()
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+    }
+
+    static Node::SPtr loadScene(bool recompute)
+    {
+        std::ostringstream scene;
+        scene << "<?xml version='1.0'?>"
+                 "<Node name='root' dt='0.01' gravity='0 -9.81 0'>"
+                 "   <Node name='PrecomputedConstraintCorrection_test'>"
+                 "       <EulerImplicitSolver rayleighStiffness='0.1' rayleighMass='0.1'/>"
+                 "       <CGLinearSolver iterations='25' tolerance='1e-9' threshold='1e-9'/>"
+                 "       <MechanicalObject name='dofs' position='0 0 0  1 0 0  0 1 0  0 0 1  1 1 1'/>"
+                 "       <MeshTopology tetrahedra='0 1 2 3  1 2 3 4'/>"
+                 "       <UniformMass totalMass='1'/>"
+                 "       <TetrahedronFEMForceField youngModulus='1000' poissonRatio='0.3'/>"
+                 "       <PrecomputedConstraintCorrection useCache='1' fileDir='.' recompute='" << recompute << "'/>"
+                 "   </Node>"
+                 "</Node>";
+        Node::SPtr root = SceneLoaderXML::loadFromMemory("testscene", scene.str().c_str(), scene.str().size());
+        if (root)
+            sofa::simulation::getSimulation()->init(root.get());
+        return root;
+    }
+
+    void cacheHit()
+    {
+        // precomputed and saved
+        Node::SPtr root = loadScene(true);
+        ASSERT_NE(nullptr, root);
+        PrecomputedConstraintCorrection* correction = NULL;
+        root->getTreeObject(correction);
+        ASSERT_NE(nullptr, correction);
+        ASSERT_NE(nullptr, correction->invM);
+        ASSERT_NE(nullptr, correction->invM->data);
+        EXPECT_EQ(nullptr, correction->invM->cache);
+
+        const std::uint64_t key = correction->cacheKey;
+        std::ostringstream cacheFileName;
+        cacheFileName << "./PrecomputedConstraintCorrection_test-" << std::hex << std::setw(16) << std::setfill('0') << key << ".ccache";
+        EXPECT_TRUE(std::ifstream(cacheFileName.str().c_str()).good());
+        const std::size_t size = correction->nbRows * correction->nbCols;
+        ASSERT_LT(0u, size);
+        helper::vector<SReal> compliance(size);
+        std::copy(correction->invM->data, correction->invM->data + size, compliance.begin());
+        sofa::simulation::getSimulation()->unload(root);
+        root.reset();
+
+        // loaded from the cache: the key does not depend on the changes made by the precomputation
+        root = loadScene(false);
+        ASSERT_NE(nullptr, root);
+        correction = NULL;
+        root->getTreeObject(correction);
+        ASSERT_NE(nullptr, correction);
+        EXPECT_EQ(key, correction->cacheKey);
+        ASSERT_NE(nullptr, correction->invM);
+        EXPECT_NE(nullptr, correction->invM->cache);
+        ASSERT_NE(nullptr, correction->invM->data);
+        for (std::size_t i=0; i<size; ++i)
+            EXPECT_EQ(compliance[i], correction->invM->data[i]);
+        sofa::simulation::getSimulation()->unload(root);
+
+        std::remove(cacheFileName.str().c_str());
+    }
+};
+
+TEST_F(PrecomputedConstraintCorrection_test, cacheHit)
+{
+    this->cacheHit();
+}
+
+} // namespace sofa
@@ -339,7 +339,9 @@ void UnilateralInteractionConstraint<DataTypes>::getConstraintInfo(const core::C
     for (unsigned int i=0; i<contacts.size(); i++)
     {
         Contact& c = contacts[i];
-        ids.push_back( yetIntegrated ? c.contactId : -c.contactId);
+        // the persistent id of the colliding elements if given, otherwise the id of the contact in its response
+        const PersistentID id = c.localId ? c.localId : (PersistentID)c.contactId;
+        ids.push_back( yetIntegrated ? id : -id);
         directions.push_back( c.norm );
         if (friction)
         {
@@ -31,6 +31,8 @@
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/defaulttype/DataTypeInfo.h>
 #include <sofa/simulation/Visitor.h>
+#include <sofa/helper/OptionsGroup.h>
+#include <sofa/helper/io/BinaryStateFile.h>
 
 #ifdef SOFA_HAVE_ZLIB
 #include <zlib.h>
@@ -52,6 +54,8 @@ namespace misc
  * The DoFs to print can be chosen using DOFsX and DOFsV
  * Stop to write the state if the kinematic energy reach a given threshold (stopAt)
  * The energy will be measured at each period determined by keperiod
+ * The states are written as text, compressed if the file name ends with .gz,
+ * or in the binary format of helper::io::BinaryStateFile if it ends with .bin
 */
 class SOFA_EXPORTER_API WriteState: public core::objectmodel::BaseObject
 {
@@ -69,6 +73,8 @@ public:
     Data < helper::vector<unsigned int> > d_DOFsV; ///< set the velocity DOFs to write
     Data < double > d_stopAt; ///< stop the simulation when the given threshold is reached
     Data < double > d_keperiod; ///< set the period to measure the kinetic energy increase
+    Data < helper::OptionsGroup > d_compression; ///< compression of the binary files
+    Data < unsigned int > d_keyframeInterval; ///< maximum number of frames between two keyframes with the delta compression
 
 protected:
     core::behavior::BaseMechanicalState* mmodel;
@@ -76,6 +82,8 @@ protected:
 #ifdef SOFA_HAVE_ZLIB
     gzFile gzfile;
 #endif
+    helper::io::BinaryStateWriter* binaryFile;
+    helper::vector<double> binaryValues;
     unsigned int nextIteration;
     double lastTime;
     bool kineticEnergyThresholdReached;
@@ -98,6 +106,11 @@ public:
 
     virtual void handleEvent(sofa::core::objectmodel::Event* event) override;
 
+protected:
+    /// Add a state vector to the frame of the binary file
+    void writeBinaryVector(char name, core::ConstVecId v);
+
+public:
 
     /// Pre-construction check method called by ObjectFactory.
     /// Check that DataTypes matches the MechanicalState.
@@ -52,11 +52,14 @@ WriteState::WriteState()
     , d_DOFsV( initData(&d_DOFsV, helper::vector<unsigned int>(0), "DOFsV", "set the velocity DOFs to write"))
     , d_stopAt( initData(&d_stopAt, 0.0, "stopAt", "stop the simulation when the given threshold is reached"))
     , d_keperiod( initData(&d_keperiod, 0.0, "keperiod", "set the period to measure the kinetic energy increase"))
+    , d_compression( initData(&d_compression, helper::OptionsGroup(3,"none","float","delta"), "compression", "compression of the binary files (.bin): none, float (32 bits values) or delta (16 bits differences to the last keyframe)"))
+    , d_keyframeInterval( initData(&d_keyframeInterval, 10u, "keyframeInterval", "maximum number of frames between two keyframes with the delta compression"))
     , mmodel(NULL)
     , outfile(NULL)
 #ifdef SOFA_HAVE_ZLIB
     , gzfile(NULL)
 #endif
+    , binaryFile(NULL)
     , nextIteration(0)
     , lastTime(0)
     , kineticEnergyThresholdReached(false)
@@ -75,6 +78,8 @@ WriteState::~WriteState()
     if (gzfile)
         gzclose(gzfile);
 #endif
+    if (binaryFile)
+        delete binaryFile;
 }
 
 
@@ -94,6 +99,17 @@ void WriteState::init()
     const std::string& filename = d_filename.getFullPath();
     if (!filename.empty())
     {
+        if (helper::io::BinaryStateFile::isBinaryStateFile(filename))
+        {
+            binaryFile = new helper::io::BinaryStateWriter;
+            if (!binaryFile->open(filename, (helper::io::BinaryStateFile::Encoding)d_compression.getValue().getSelectedId(), d_keyframeInterval.getValue()))
+            {
+                msg_error() << "Error creating file "<<filename;
+                delete binaryFile;
+                binaryFile = NULL;
+            }
+        }
+        else
 #ifdef SOFA_HAVE_ZLIB
         if (filename.size() >= 3 && filename.substr(filename.size()-3)==".gz")
         {
@@ -233,6 +249,11 @@ if (outfile)
 if (gzfile)
     gzclose(gzfile);
 #endif
+if (binaryFile)
+{
+    delete binaryFile;
+    binaryFile = NULL;
+}
 init();
 }
 void WriteState::reset()
@@ -257,6 +278,7 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
 #ifdef SOFA_HAVE_ZLIB
             && !gzfile
 #endif
+            && !binaryFile
            )
             return;
 
@@ -324,6 +346,21 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
         }
         if (writeCurrent)
         {
+            if (binaryFile)
+            {
+                // encoded here, written by the thread of the binary file
+                binaryFile->beginFrame(time);
+                if (d_writeX.getValue())
+                    writeBinaryVector('X', core::VecId::position());
+                if (d_writeX0.getValue())
+                    writeBinaryVector('R', core::VecId::restPosition());
+                if (d_writeV.getValue())
+                    writeBinaryVector('V', core::VecId::velocity());
+                if (d_writeF.getValue())
+                    writeBinaryVector('F', core::VecId::force());
+                binaryFile->endFrame();
+            }
+            else
 #ifdef SOFA_HAVE_ZLIB
             if (gzfile)
             {
@@ -391,6 +428,27 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
     }
 }
 
+void WriteState::writeBinaryVector(char name, core::ConstVecId v)
+{
+    const core::objectmodel::BaseData* data = mmodel->baseRead(v);
+    if (!data)
+        return;
+    const defaulttype::AbstractTypeInfo* info = data->getValueTypeInfo();
+    const void* ptr = data->getValueVoidPtr();
+    const size_t size = info->size(ptr);
+    if (size && info->SimpleLayout() && info->ValueType()->Scalar() && info->byteSize() == sizeof(double))
+    {
+        binaryFile->addVector(name, (const double*)info->getValuePtr(ptr), size);
+    }
+    else
+    {
+        binaryValues.resize(size);
+        for (size_t i=0; i<size; ++i)
+            binaryValues[i] = info->getScalarValue(ptr, i);
+        binaryFile->addVector(name, binaryValues.data(), size);
+    }
+}
+
 } // namespace misc
 
 } // namespace component
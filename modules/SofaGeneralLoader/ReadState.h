@@ -26,6 +26,7 @@
 #include <sofa/simulation/AnimateBeginEvent.h>
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/simulation/Visitor.h>
+#include <sofa/helper/io/BinaryStateFile.h>
 
 #ifdef SOFA_HAVE_ZLIB
 #include <zlib.h>
@@ -43,6 +44,8 @@ namespace misc
 {
 
 /** Read State vectors from file at each timestep
+ * Binary files (.bin, see helper::io::BinaryStateFile) are mapped in memory, so that
+ * any time can be reached directly, and can be interpolated between their frames.
 */
 class SOFA_GENERAL_LOADER_API ReadState: public core::objectmodel::BaseObject
 {
@@ -54,6 +57,7 @@ public:
     Data < double > d_shift; ///< shift between times in the file and times when they will be read
     Data < bool > d_loop; ///< set to 'true' to re-read the file when reaching the end
     Data < double > d_scalePos; ///< scale the input mechanical object
+    Data < bool > d_interpolate; ///< interpolate linearly between the frames of binary files
 
 protected:
     core::behavior::BaseMechanicalState* mmodel;
@@ -61,6 +65,9 @@ protected:
 #ifdef SOFA_HAVE_ZLIB
     gzFile gzfile;
 #endif
+    helper::io::BinaryStateReader* binaryFile;
+    size_t binaryFrame; ///< last frame read from the binary file
+    helper::vector<double> binaryValues, binaryNextValues;
     double nextTime;
     double lastTime;
     double loopTime;
@@ -83,6 +90,15 @@ public:
     /// Read the next values in the file corresponding to the last timestep before the given time
     bool readNext(double time, std::vector<std::string>& lines);
 
+protected:
+    void processReadBinaryState(double time);
+    /// Read a vector of a frame of the binary file, interpolated with the next frame by alpha
+    bool readBinaryVector(char name, core::VecId v, size_t frame, double alpha);
+    /// Propagate the positions and velocities read
+    void updateState();
+
+public:
+
     /// Pre-construction check method called by ObjectFactory.
     /// Check that DataTypes matches the MechanicalState.
     template<class T>
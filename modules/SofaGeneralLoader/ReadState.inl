@@ -29,6 +29,7 @@
 
 #include <string.h>
 #include <sstream>
+#include <cmath>
 
 namespace sofa
 {
@@ -45,11 +46,14 @@ ReadState::ReadState()
     , d_shift( initData(&d_shift, 0.0, "shift", "shift between times in the file and times when they will be read"))
     , d_loop( initData(&d_loop, false, "loop", "set to 'true' to re-read the file when reaching the end"))
     , d_scalePos( initData(&d_scalePos, 1.0, "scalePos", "scale the input mechanical object"))
+    , d_interpolate( initData(&d_interpolate, false, "interpolate", "interpolate linearly between the frames of binary files (.bin)"))
     , mmodel(NULL)
     , infile(NULL)
 #ifdef SOFA_HAVE_ZLIB
     , gzfile(NULL)
 #endif
+    , binaryFile(NULL)
+    , binaryFrame(0)
     , nextTime(0)
     , lastTime(0)
     , loopTime(0)
@@ -65,6 +69,8 @@ ReadState::~ReadState()
     if (gzfile)
         gzclose(gzfile);
 #endif
+    if (binaryFile)
+        delete binaryFile;
 }
 
 void ReadState::init()
@@ -87,12 +93,27 @@ void ReadState::reset()
         gzfile = NULL;
     }
 #endif
+    if (binaryFile)
+    {
+        delete binaryFile;
+        binaryFile = NULL;
+    }
 
     const std::string& filename = d_filename.getFullPath();
     if (filename.empty())
     {
         msg_error() << "ERROR: empty filename";
     }
+    else if (helper::io::BinaryStateFile::isBinaryStateFile(filename))
+    {
+        binaryFile = new helper::io::BinaryStateReader;
+        if (!binaryFile->open(filename))
+        {
+            msg_error() << "Error opening file "<<filename;
+            delete binaryFile;
+            binaryFile = NULL;
+        }
+    }
 #ifdef SOFA_HAVE_ZLIB
     else if (filename.size() >= 3 && filename.substr(filename.size()-3)==".gz")
     {
@@ -116,6 +137,7 @@ void ReadState::reset()
     nextTime = 0;
     lastTime = 0;
     loopTime = 0;
+    binaryFrame = binaryFile ? binaryFile->getNbFrames() : 0;
 }
 
 void ReadState::handleEvent(sofa::core::objectmodel::Event* event)
@@ -222,6 +244,11 @@ bool ReadState::readNext(double time, std::vector<std::string>& validLines)
 void ReadState::processReadState()
 {
     double time = getContext()->getTime() + d_shift.getValue();
+    if (binaryFile)
+    {
+        processReadBinaryState(time);
+        return;
+    }
     std::vector<std::string> validLines;
     if (!readNext(time, validLines)) return;
     bool updated = false;
@@ -245,14 +272,93 @@ void ReadState::processReadState()
     }
 
     if (updated)
+        updateState();
+}
+
+void ReadState::processReadBinaryState(double time)
+{
+    if (!mmodel) return;
+    const size_t nbFrames = binaryFile->getNbFrames();
+    if (nbFrames == 0) return;
+    lastTime = time;
+    if (d_loop.getValue())
+    {
+        const double start = binaryFile->getTime(0);
+        const double duration = binaryFile->getTime(nbFrames-1) - start;
+        if (duration > 0 && time > start + duration)
+            time = start + std::fmod(time - start, duration);
+    }
+
+    const size_t frame = binaryFile->findFrame(time);
+    if (frame == nbFrames) return; // before the first frame
+    double alpha = 0;
+    if (d_interpolate.getValue() && frame+1 < nbFrames)
+    {
+        const double t0 = binaryFile->getTime(frame);
+        const double t1 = binaryFile->getTime(frame+1);
+        if (t1 > t0)
+            alpha = (time - t0) / (t1 - t0);
+    }
+    if (frame == binaryFrame && alpha == 0)
+        return;
+    binaryFrame = frame;
+
+    bool updated = false;
+    if (readBinaryVector('X', core::VecId::position(), frame, alpha))
+    {
+        mmodel->applyScale(d_scalePos.getValue(), d_scalePos.getValue(), d_scalePos.getValue());
+        updated = true;
+    }
+    if (readBinaryVector('V', core::VecId::velocity(), frame, alpha))
+        updated = true;
+
+    if (updated)
+        updateState();
+}
+
+bool ReadState::readBinaryVector(char name, core::VecId v, size_t frame, double alpha)
+{
+    if (!binaryFile->readVector(frame, name, binaryValues))
+        return false;
+    if (alpha > 0 && binaryFile->readVector(frame+1, name, binaryNextValues) && binaryNextValues.size() == binaryValues.size())
+    {
+        for (size_t i=0; i<binaryValues.size(); ++i)
+            binaryValues[i] += alpha * (binaryNextValues[i] - binaryValues[i]);
+    }
+
+    // the state is resized if the file contains more values, as with the text files
+    const core::objectmodel::BaseData* data = mmodel->baseRead(v);
+    if (!data)
+        return false;
+    const size_t blockSize = data->getValueTypeInfo()->BaseType()->size();
+    if (blockSize > 0 && binaryValues.size() / blockSize > mmodel->getSize())
+        mmodel->resize(binaryValues.size() / blockSize);
+
+    core::objectmodel::BaseData* dest = mmodel->baseWrite(v);
+    const defaulttype::AbstractTypeInfo* info = dest->getValueTypeInfo();
+    void* ptr = dest->beginEditVoidPtr();
+    const size_t size = std::min(info->size(ptr), binaryValues.size());
+    if (size && info->SimpleLayout() && info->ValueType()->Scalar() && info->byteSize() == sizeof(double))
+    {
+        memcpy(info->getValuePtr(ptr), binaryValues.data(), size*sizeof(double));
+    }
+    else
     {
-        sofa::simulation::MechanicalProjectPositionAndVelocityVisitor action0(core::MechanicalParams::defaultInstance());
-        this->getContext()->executeVisitor(&action0);
-        sofa::simulation::MechanicalPropagateOnlyPositionAndVelocityVisitor action1(core::MechanicalParams::defaultInstance());
-        this->getContext()->executeVisitor(&action1);
-        sofa::simulation::UpdateMappingVisitor action2(core::MechanicalParams::defaultInstance());
-        this->getContext()->executeVisitor(&action2);
+        for (size_t i=0; i<size; ++i)
+            info->setScalarValue(ptr, i, binaryValues[i]);
     }
+    dest->endEditVoidPtr();
+    return true;
+}
+
+void ReadState::updateState()
+{
+    sofa::simulation::MechanicalProjectPositionAndVelocityVisitor action0(core::MechanicalParams::defaultInstance());
+    this->getContext()->executeVisitor(&action0);
+    sofa::simulation::MechanicalPropagateOnlyPositionAndVelocityVisitor action1(core::MechanicalParams::defaultInstance());
+    this->getContext()->executeVisitor(&action1);
+    sofa::simulation::UpdateMappingVisitor action2(core::MechanicalParams::defaultInstance());
+    this->getContext()->executeVisitor(&action2);
 }
 
 } // namespace misc
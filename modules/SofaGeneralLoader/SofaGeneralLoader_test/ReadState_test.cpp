@@ -23,6 +23,7 @@
 #include <fstream>
 #include <iterator>
 #include <algorithm>
+#include <cstdio>
 
 #include <SofaTest/Sofa_test.h>
 #include <SofaTest/TestMessageHandler.h>
@@ -69,7 +70,7 @@ namespace sofa {
         }
 
         // Create the scene and the components: export velocity, VariationalSymplecticSolver is exact is velocity
-        void createScene()
+        void createScene(const std::string& filename = std::string(SOFAGENERALLOADER_TESTFILES_DIR)+"particleGravityX.data", bool interpolate = false)
         {
             timeStep = 0.01;
             root->setGravity(Coord(0.0,0.0,0.0)); // no need of gravity, the file .data is just read
@@ -82,7 +83,8 @@ namespace sofa {
             childNode->addObject(mecaObj);
 
             sofa::component::misc::ReadState::SPtr readState =New<sofa::component::misc::ReadState>();
-            readState->d_filename.setValue(std::string(SOFAGENERALLOADER_TESTFILES_DIR)+"particleGravityX.data");
+            readState->d_filename.setValue(filename);
+            readState->d_interpolate.setValue(interpolate);
             childNode->addObject(readState);
 
             EXPECT_TRUE(childNode);
@@ -117,6 +119,22 @@ namespace sofa {
         }
 
 
+        /// Write a binary file with the position z=-t at t=0, 0.04, 0.08
+        void writeBinaryFile(const std::string& filename)
+        {
+            helper::io::BinaryStateWriter writer;
+            ASSERT_TRUE(writer.open(filename));
+            for (int i=0; i<3; ++i)
+            {
+                const double t = 0.04*i;
+                const double x[3] = { 1.0, 2.0, -t };
+                writer.beginFrame(t);
+                writer.addVector('X', x, 3);
+                writer.endFrame();
+            }
+            writer.close();
+        }
+
         /// Unload the scene
         void TearDown()
         {
@@ -143,4 +161,21 @@ namespace sofa {
         ASSERT_TRUE( this->simulation_result_test() );
         this->TearDown();
     }
+
+    // Test : read positions interpolated between the frames of a binary file
+    TYPED_TEST( ReadState_test , test_read_binary_interpolated)
+    {
+        const std::string filename = "ReadState_test.bin";
+        this->writeBinaryFile(filename);
+        this->SetUp();
+        this->createScene(filename, true);
+        this->initScene();
+        this->runScene();
+
+        // read at the beginning of the last step, t=0.06
+        EXPECT_NEAR(2.0, this->mecaObj->x.getValue()[0][1], 1e-12);
+        EXPECT_NEAR(-0.06, this->mecaObj->x.getValue()[0][2], 1e-12);
+        this->TearDown();
+        std::remove(filename.c_str());
+    }
 }
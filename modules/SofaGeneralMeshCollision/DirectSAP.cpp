@@ -28,9 +28,11 @@
 #include <SofaMeshCollision/Point.h>
 #include <sofa/helper/FnDispatcher.h>
 #include <sofa/core/ObjectFactory.h>
-#include <map>
-#include <queue>
-#include <stack>
+#include <sofa/simulation/TaskScheduler.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
 
 #include <sofa/helper/system/gl.h>
 
@@ -43,13 +45,95 @@ namespace component
 namespace collision
 {
 
+namespace
+{
 
+/// Unsigned key in the same order as the float
+inline unsigned int sortKey(float f)
+{
+    unsigned int u;
+    std::memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+/// Float bounds enclosing the double ones, so that the float tests never miss a pair
+inline float lowerBound(double d)
+{
+    float f = (float)d;
+    if (f > d) f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+    return f;
+}
+
+inline float upperBound(double d)
+{
+    float f = (float)d;
+    if (f < d) f = std::nextafter(f, std::numeric_limits<float>::infinity());
+    return f;
+}
 
-inline void DSAPBox::update(int axis, double alarmDist){
-    min->value = (cube.minVect())[axis] - alarmDist;
-    max->value = (cube.maxVect())[axis] + alarmDist;
+/// Stable LSD radix sort of values by keys, 8 bits per pass. Each chunk of the
+/// arrays is counted and scattered by one task.
+void radixSort(helper::vector<unsigned int>& keys, helper::vector<unsigned int>& values,
+               helper::vector<unsigned int>& tmpKeys, helper::vector<unsigned int>& tmpValues)
+{
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const unsigned int n = (unsigned int)keys.size();
+    const unsigned int nbChunks = std::max(1u, std::min(4*scheduler->getThreadCount(), n/4096));
+    tmpKeys.resize(n);
+    tmpValues.resize(n);
+    std::vector<unsigned int> counts(256*nbChunks);
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        std::fill(counts.begin(), counts.end(), 0u);
+        scheduler->parallel_for(0u, nbChunks, [&](unsigned int firstChunk, unsigned int lastChunk)
+        {
+            for (unsigned int c = firstChunk; c < lastChunk; ++c)
+            {
+                unsigned int* count = &counts[256*c];
+                for (unsigned int i = (unsigned int)((unsigned long long)n*c/nbChunks), end = (unsigned int)((unsigned long long)n*(c+1)/nbChunks); i < end; ++i)
+                    ++count[(keys[i] >> shift) & 255];
+            }
+        }, 1u);
+
+        // offsets in (digit, chunk) order keep the sort stable; a pass with a single digit is skipped
+        unsigned int offset = 0;
+        bool singleDigit = false;
+        for (unsigned int d = 0; d < 256; ++d)
+        {
+            const unsigned int digitBegin = offset;
+            for (unsigned int c = 0; c < nbChunks; ++c)
+            {
+                const unsigned int count = counts[256*c+d];
+                counts[256*c+d] = offset;
+                offset += count;
+            }
+            if (offset - digitBegin == n)
+                singleDigit = true;
+        }
+        if (singleDigit)
+            continue;
+
+        scheduler->parallel_for(0u, nbChunks, [&](unsigned int firstChunk, unsigned int lastChunk)
+        {
+            for (unsigned int c = firstChunk; c < lastChunk; ++c)
+            {
+                unsigned int* offsets = &counts[256*c];
+                for (unsigned int i = (unsigned int)((unsigned long long)n*c/nbChunks), end = (unsigned int)((unsigned long long)n*(c+1)/nbChunks); i < end; ++i)
+                {
+                    const unsigned int dest = offsets[(keys[i] >> shift) & 255]++;
+                    tmpKeys[dest] = keys[i];
+                    tmpValues[dest] = values[i];
+                }
+            }
+        }, 1u);
+        keys.swap(tmpKeys);
+        values.swap(tmpValues);
+    }
 }
 
+} // namespace
+
 
 inline double DSAPBox::squaredDistance(const DSAPBox & other,int axis)const{
     const defaulttype::Vector3 & min0 = this->cube.minVect();
@@ -88,15 +172,14 @@ inline bool DSAPBox::overlaps(const DSAPBox &other, int axis, double alarmDist)
 DirectSAP::DirectSAP()
     : bDraw(initData(&bDraw, false, "draw", "enable/disable display of results"))
     , box(initData(&box, "box", "if not empty, objects that do not intersect this bounding-box will be ignored"))
+    , _cur_axis(0)
+    , _nb_pairs(0)
 {
 }
 
 
 DirectSAP::~DirectSAP()
 {
-
-    for(unsigned int i = 0 ; i < _to_del.size() ; ++i)
-        delete[] _to_del[i];
 }
 
 
@@ -153,29 +236,10 @@ void DirectSAP::endBroadPhase()
     }
 
     _boxes.reserve(_boxes.size() + n);
-    EndPoint * end_pts = new EndPoint[2*n];
-    _to_del.push_back(end_pts);
-
-    int cur_EndPtID = 0;
-    int cur_boxID = _boxes.size();
     for(unsigned int i = 0 ; i < cube_models.size() ; ++i){
         CubeModel * cm = cube_models[i];
-        for(int j = 0 ; j < cm->getSize() ; ++j){
-            EndPoint * min = &end_pts[cur_EndPtID];
-            ++cur_EndPtID;
-            EndPoint * max = &end_pts[cur_EndPtID];
-            ++cur_EndPtID;
-
-            min->setBoxID(cur_boxID);
-            max->setBoxID(cur_boxID);
-            max->setMax();
-
-            _end_points.push_back(min);
-            _end_points.push_back(max);
-
-            _boxes.push_back(DSAPBox(Cube(cm,j),min,max));
-            ++cur_boxID;
-        }
+        for(int j = 0 ; j < cm->getSize() ; ++j)
+            _boxes.push_back(DSAPBox(Cube(cm,j)));
     }
 
     _new_cm.clear();
@@ -189,44 +253,29 @@ void DirectSAP::addCollisionModel(core::CollisionModel *cm){
 }
 
 int DirectSAP::greatestVarianceAxis()const{
-    double diff;
-    double v[3];//variances for each axis
-    double m[3];//means for each axis
-    for(int i = 0 ; i < 3 ; ++i)
-        v[i] = m[i] = 0;
-
-    //computing the mean value of end points on each axis
-    for(unsigned int i = 0 ; i < _boxes.size() ; ++i){
-        const defaulttype::Vector3 & min = _boxes[i].cube.minVect();
-        const defaulttype::Vector3 & max = _boxes[i].cube.maxVect();
-        m[0] += min[0] + max[0];
-        m[1] += min[1] + max[1];
-        m[2] += min[2] + max[2];
-    }
+    //sums of the end points and of their squares on each axis
+    typedef defaulttype::Vec<6,double> Sums;
+    const Sums sums = simulation::TaskScheduler::getInstance()->parallel_reduce(std::size_t(0), _sorted_boxes.size(), Sums(),
+        [this](std::size_t first, std::size_t last)
+        {
+            Sums s;
+            for(std::size_t i = first ; i < last ; ++i){
+                const defaulttype::Vector3 & min = _boxes[_sorted_boxes[i]].cube.minVect();
+                const defaulttype::Vector3 & max = _boxes[_sorted_boxes[i]].cube.maxVect();
+                for(int j = 0 ; j < 3 ; ++j){
+                    s[j] += min[j] + max[j];
+                    s[3+j] += min[j]*min[j] + max[j]*max[j];
+                }
+            }
+            return s;
+        },
+        [](const Sums& a, const Sums& b) { return Sums(a + b); });
 
-    m[0] /= 2*_boxes.size();
-    m[1] /= 2*_boxes.size();
-    m[2] /= 2*_boxes.size();
-
-    //computing the variance of end points on each axis
-    for(unsigned int i = 0 ; i < _boxes.size() ; ++i){
-        const defaulttype::Vector3 & min = _boxes[i].cube.minVect();
-        const defaulttype::Vector3 & max = _boxes[i].cube.maxVect();
-
-        diff = min[0] - m[0];
-        v[0] += diff*diff;
-        diff = max[0] - m[0];
-        v[0] += diff*diff;
-
-        diff = min[1] - m[1];
-        v[1] += diff*diff;
-        diff = max[1] - m[1];
-        v[1] += diff*diff;
-
-        diff = min[2] - m[2];
-        v[2] += diff*diff;
-        diff = max[2] - m[2];
-        v[2] += diff*diff;
+    double v[3];//variances for each axis
+    const double nb = 2.0*std::max<std::size_t>(_sorted_boxes.size(),1);
+    for(int j = 0 ; j < 3 ; ++j){
+        const double m = sums[j] / nb;
+        v[j] = sums[3+j] / nb - m*m;
     }
 
     if(v[0] >= v[1] && v[0] >= v[2])
@@ -240,93 +289,167 @@ int DirectSAP::greatestVarianceAxis()const{
 
 
 void DirectSAP::update(){
-    _cur_axis = greatestVarianceAxis();
-    for(unsigned int i = 0 ; i < _boxes.size() ; ++i){
-        _boxes[i].update(_cur_axis,_alarmDist_d2);
+    //boxes out of the box filter are not swept at all
+    _sorted_boxes.clear();
+    _sorted_boxes.reserve(_boxes.size());
+    if(boxModel){
+        const DSAPBox filter(Cube(boxModel.get(),0));
+        for(unsigned int i = 0 ; i < _boxes.size() ; ++i)
+            if(_boxes[i].squaredDistance(filter) <= 0)
+                _sorted_boxes.push_back(i);
+    }
+    else{
+        for(unsigned int i = 0 ; i < _boxes.size() ; ++i)
+            _sorted_boxes.push_back(i);
     }
-}
 
-void DirectSAP::beginNarrowPhase()
-{
-    core::collision::NarrowPhaseDetection::beginNarrowPhase();
-    _alarmDist = getIntersectionMethod()->getAlarmDistance();
-    _sq_alarmDist = _alarmDist * _alarmDist;
-    _alarmDist_d2 = _alarmDist/2.0;
+    _cur_axis = greatestVarianceAxis();
 
-    update();
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const std::size_t n = _sorted_boxes.size();
+    _sort_keys.resize(n);
+    scheduler->parallel_for(std::size_t(0), n, [this](std::size_t first, std::size_t last)
+    {
+        for(std::size_t i = first ; i < last ; ++i)
+            _sort_keys[i] = sortKey(lowerBound(_boxes[_sorted_boxes[i]].cube.minVect()[_cur_axis] - _alarmDist_d2));
+    }, std::size_t(1024));
 
-    CompPEndPoint comp;
+    radixSort(_sort_keys, _sorted_boxes, _tmp_keys, _tmp_boxes);
 
-    sofa::helper::AdvancedTimer::stepBegin("Direct SAP std::sort");
-    std::sort(_end_points.begin(),_end_points.end(),comp);
-    sofa::helper::AdvancedTimer::stepEnd("Direct SAP std::sort");
+    for(int j = 0 ; j < 3 ; ++j){
+        _min[j].resize(n);
+        _max[j].resize(n);
+    }
+    scheduler->parallel_for(std::size_t(0), n, [this](std::size_t first, std::size_t last)
+    {
+        for(std::size_t i = first ; i < last ; ++i){
+            const Cube & cube = _boxes[_sorted_boxes[i]].cube;
+            const defaulttype::Vector3 & min = cube.minVect();
+            const defaulttype::Vector3 & max = cube.maxVect();
+            for(int j = 0 ; j < 3 ; ++j){
+                _min[j][i] = lowerBound(min[j] - _alarmDist_d2);
+                _max[j][i] = upperBound(max[j] + _alarmDist_d2);
+            }
+        }
+    }, std::size_t(1024));
+}
 
-    sofa::helper::AdvancedTimer::stepBegin("Direct SAP intersection");
 
-    std::deque<int> active_boxes;//active boxes are the one that we encoutered only their min (end point), so if there are two boxes b0 and b1,
-                                 //if we encounter b1_min as b0_min < b1_min, on the current axis, the two boxes intersect :  b0_min--------------------b0_max
-                                 //                                                                                                      b1_min---------------------b1_max
-                                 //once we encouter b0_max, b0 will not intersect with nothing (trivial), so we delete it from active_boxes.
-                                 //so the rule is : -every time we encounter a box min end point, we check if it is overlapping with other active_boxes and add the owner (a box) of this end point to
-                                 //                  the active boxes.
-                                 //                 -every time we encounter a max end point of a box, we are sure that we encountered min end point of a box because _end_points is sorted,
-                                 //                  so, we delete the owner box, of this max end point from the active boxes
-    for(EndPointList::iterator it = _end_points.begin() ; it != _end_points.end() ; ++it){
-        if((**it).max()){//erase it from the active_boxes
-            assert(std::find(active_boxes.begin(),active_boxes.end(),(**it).boxID()) != active_boxes.end());
-            active_boxes.erase(std::find(active_boxes.begin(),active_boxes.end(),(**it).boxID()));
+void DirectSAP::sweep(int first, int last){
+    const int n = (int)_sorted_boxes.size();
+    const int axis1 = (_cur_axis+1)%3;
+    const int axis2 = (_cur_axis+2)%3;
+    const float * min0 = _min[_cur_axis].data();
+    const float * max0 = _max[_cur_axis].data();
+    const float * min1 = _min[axis1].data();
+    const float * max1 = _max[axis1].data();
+    const float * min2 = _min[axis2].data();
+    const float * max2 = _max[axis2].data();
+
+    //pairs are first gathered locally, then a block of the shared list is reserved without lock
+    enum { BUFFER_SIZE = 256 };
+    std::pair<unsigned int,unsigned int> buffer[BUFFER_SIZE];
+    int nb = 0;
+    for(int i = first ; i < last ; ++i){
+        const DSAPBox & box0 = _boxes[_sorted_boxes[i]];
+        core::CollisionModel *finalcm1 = box0.cube.getCollisionModel()->getLast();
+        //the boxes are sorted by their min, so the boxes overlapping box i on the sweep axis follow it
+        for(int j = i + 1 ; j < n && min0[j] <= max0[i] ; ++j){
+            if(min1[j] > max1[i] || min1[i] > max1[j] || min2[j] > max2[i] || min2[i] > max2[j])
+                continue;
+
+            const DSAPBox & box1 = _boxes[_sorted_boxes[j]];
+            core::CollisionModel *finalcm2 = box1.cube.getCollisionModel()->getLast();//get the finnest CollisionModel which is not a CubeModel
+            if((finalcm1->isSimulated() || finalcm2->isSimulated()) &&
+                    (((finalcm1->getContext() != finalcm2->getContext()) || finalcm1->canCollideWith(finalcm2)) &&
+                     box0.squaredDistance(box1) <= _sq_alarmDist)){//intersection on all axes
+                buffer[nb++] = std::make_pair((unsigned int)i, (unsigned int)j);
+                if(nb == BUFFER_SIZE){
+                    const std::size_t index = _nb_pairs.fetch_add(nb);
+                    for(int k = 0 ; k < nb && index + k < _pairs.size() ; ++k)
+                        _pairs[index + k] = buffer[k];
+                    nb = 0;
+                }
+            }
         }
-        else{//we encounter a min possible intersection between it and active_boxes
-            int new_box = (**it).boxID();
-
-            DSAPBox & box0 = _boxes[new_box];
-            for(unsigned int i = 0 ; i < active_boxes.size() ; ++i){
-                DSAPBox & box1 = _boxes[active_boxes[i]];
+    }
+    if(nb > 0){
+        const std::size_t index = _nb_pairs.fetch_add(nb);
+        for(int k = 0 ; k < nb && index + k < _pairs.size() ; ++k)
+            _pairs[index + k] = buffer[k];
+    }
+}
 
-                core::CollisionModel *finalcm1 = box0.cube.getCollisionModel()->getLast();//get the finnest CollisionModel which is not a CubeModel
-                core::CollisionModel *finalcm2 = box1.cube.getCollisionModel()->getLast();
-                if((finalcm1->isSimulated() || finalcm2->isSimulated()) &&
-                        (((finalcm1->getContext() != finalcm2->getContext()) || finalcm1->canCollideWith(finalcm2)) &&
-                         /*box0.overlaps(box1,axis1,_alarmDist) && box0.overlaps(box1,axis2,_alarmDist)*/
-                         box0.squaredDistance(box1) <= _sq_alarmDist)){//intersection on all axes
 
-                    bool swapModels = false;
-                    core::collision::ElementIntersector* finalintersector = intersectionMethod->findIntersector(finalcm1, finalcm2, swapModels);//find the method for the finnest CollisionModels
+void DirectSAP::intersect(const DSAPBox & box0, const DSAPBox & box1){
+    core::CollisionModel *finalcm1 = box0.cube.getCollisionModel()->getLast();//get the finnest CollisionModel which is not a CubeModel
+    core::CollisionModel *finalcm2 = box1.cube.getCollisionModel()->getLast();
 
-                    assert(box0.cube.getExternalChildren().first.getIndex() == box0.cube.getIndex());
-                    assert(box1.cube.getExternalChildren().first.getIndex() == box1.cube.getIndex());
+    bool swapModels = false;
+    core::collision::ElementIntersector* finalintersector = intersectionMethod->findIntersector(finalcm1, finalcm2, swapModels);//find the method for the finnest CollisionModels
 
-                    if((!swapModels) && finalcm1->getClass() == finalcm2->getClass() && finalcm1 > finalcm2)//we do that to have only pair (p1,p2) without having (p2,p1)
-                        swapModels = true;
+    assert(box0.cube.getExternalChildren().first.getIndex() == box0.cube.getIndex());
+    assert(box1.cube.getExternalChildren().first.getIndex() == box1.cube.getIndex());
 
+    if((!swapModels) && finalcm1->getClass() == finalcm2->getClass() && finalcm1 > finalcm2)//we do that to have only pair (p1,p2) without having (p2,p1)
+        swapModels = true;
 
-                    if(finalintersector != 0x0){
-                        if(swapModels){
-                            sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm2, finalcm1);
-                            finalintersector->beginIntersect(finalcm2, finalcm1, outputs);//creates outputs if null
+    if(finalintersector != 0x0){
+        if(swapModels){
+            sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm2, finalcm1);
+            finalintersector->beginIntersect(finalcm2, finalcm1, outputs);//creates outputs if null
 
-                            finalintersector->intersect(box1.cube.getExternalChildren().first,box0.cube.getExternalChildren().first,outputs) ;
-                        }
-                        else{
-                            sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm1, finalcm2);
+            finalintersector->intersect(box1.cube.getExternalChildren().first,box0.cube.getExternalChildren().first,outputs) ;
+        }
+        else{
+            sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm1, finalcm2);
 
-                            finalintersector->beginIntersect(finalcm1, finalcm2, outputs);//creates outputs if null
+            finalintersector->beginIntersect(finalcm1, finalcm2, outputs);//creates outputs if null
 
-                            finalintersector->intersect(box0.cube.getExternalChildren().first,box1.cube.getExternalChildren().first,outputs) ;
-                        }
-                    }
-                    else{
-                    }
-                }
-            }
-            active_boxes.push_back(new_box);
+            finalintersector->intersect(box0.cube.getExternalChildren().first,box1.cube.getExternalChildren().first,outputs) ;
         }
     }
+}
+
+void DirectSAP::beginNarrowPhase()
+{
+    core::collision::NarrowPhaseDetection::beginNarrowPhase();
+    _alarmDist = getIntersectionMethod()->getAlarmDistance();
+    _sq_alarmDist = _alarmDist * _alarmDist;
+    _alarmDist_d2 = _alarmDist/2.0;
+
+    sofa::helper::AdvancedTimer::stepBegin("Direct SAP sort");
+    update();
+    sofa::helper::AdvancedTimer::stepEnd("Direct SAP sort");
+
+    sofa::helper::AdvancedTimer::stepBegin("Direct SAP sweep");
+    //the list keeps its size from one step to the next, the sweep is run again in the rare case it was too small
+    const int n = (int)_sorted_boxes.size();
+    if(_pairs.size() < (std::size_t)n)
+        _pairs.resize(n);
+    for(;;){
+        _nb_pairs = 0;
+        simulation::TaskScheduler::getInstance()->parallel_for(0, n, [this](int first, int last)
+        {
+            sweep(first, last);
+        }, 256);
+        if(_nb_pairs <= _pairs.size())
+            break;
+        _pairs.resize(_nb_pairs + _nb_pairs/4);
+    }
+    //the threads append their pairs in any order
+    std::sort(_pairs.begin(), _pairs.begin() + _nb_pairs);
+    sofa::helper::AdvancedTimer::stepEnd("Direct SAP sweep");
+
+    sofa::helper::AdvancedTimer::stepBegin("Direct SAP intersection");
+    //in each pair, the box that comes first in the sweep is the second one of the intersection, as with the former list of active boxes
+    for(std::size_t i = 0 ; i < _nb_pairs ; ++i)
+        intersect(_boxes[_sorted_boxes[_pairs[i].second]], _boxes[_sorted_boxes[_pairs[i].first]]);
     sofa::helper::AdvancedTimer::stepEnd("Direct SAP intersection");
 }
 
 bool DSAPBox::overlaps(const DSAPBox &other,double alarmDist) const{
-    return overlaps(other,0,alarmDist) && overlaps(other,0,alarmDist) && overlaps(other,0,alarmDist);
+    return overlaps(other,0,alarmDist) && overlaps(other,1,alarmDist) && overlaps(other,2,alarmDist);
 }
 
 double DSAPBox::squaredDistance(const DSAPBox & other)const{
@@ -28,11 +28,10 @@
 #include <sofa/core/CollisionElement.h>
 #include <sofa/core/CollisionModel.h>
 #include <SofaBaseCollision/CubeModel.h>
-#include <SofaMeshCollision/EndPoint.h>
 #include <sofa/defaulttype/Vec.h>
 #include <set>
 #include <map>
-#include <deque>
+#include <atomic>
 #include <sofa/helper/AdvancedTimer.h>
 
 namespace sofa
@@ -44,27 +43,18 @@ namespace component
 namespace collision
 {
 
-class EndPoint;
-
 /**
   *SAPBox is a simple bounding box. It contains a Cube which contains only one final
-  *CollisionElement and pointers to min and max EndPoints. min and max end points
-  *are respectively min and max coordinates of the cube on a coordinate axis.
-  *min and max are updated with the method update(int i), so min and max have
-  *min/max values on the i-th axis after the method update(int i).
+  *CollisionElement.
   */
 class SOFA_GENERAL_MESH_COLLISION_API DSAPBox{
 public:
-    DSAPBox(Cube c,EndPoint * mi = 0x0,EndPoint * ma = 0x0) : cube(c),min(mi),max(ma){}
-
-    void update(int axis,double alarmDist);
+    DSAPBox(Cube c) : cube(c){}
 
     bool overlaps(const DSAPBox & other,int axis,double alarmDist)const;
 
     bool overlaps(const DSAPBox &other,double alarmDist)const;
 
-    bool sqOverlaps(const DSAPBox &other,double squaredAlarmDist)const;
-
     double squaredDistance(const DSAPBox & other)const;
 
     double squaredDistance(const DSAPBox & other,int axis)const;
@@ -76,14 +66,17 @@ public:
     }
 
     Cube cube;
-    EndPoint * min;
-    EndPoint * max;
 };
 
 /**
   *This class is an implementation of sweep and prune in its "direct" version, i.e. at each step
   *it sorts all the primitives along an axis (not checking the moving ones) and computes overlaping pairs without
   *saving it. But the memory used to save these primitives is created just once, the first time we add CollisionModels.
+  *
+  *The bounds of the boxes are copied in flat float arrays in sweep order, sorted with a parallel
+  *radix sort along the axis of greatest variance. The sweep is split in intervals processed by the
+  *worker threads of the TaskScheduler, which append the overlapping pairs to a shared list. The
+  *narrow phase then runs on this list, in a deterministic order.
   */
 class SOFA_GENERAL_MESH_COLLISION_API DirectSAP :
     public core::collision::BroadPhaseDetection,
@@ -92,8 +85,6 @@ class SOFA_GENERAL_MESH_COLLISION_API DirectSAP :
 public:
     SOFA_CLASS2(DirectSAP, core::collision::BroadPhaseDetection, core::collision::NarrowPhaseDetection);
 
-    typedef std::vector<EndPoint*> EndPointList;
-
     typedef DSAPBox SAPBox;
 
     //void collidingCubes(std::vector<std::pair<Cube,Cube> > & col_cubes)const;
@@ -111,10 +102,21 @@ private:
     void add(core::CollisionModel * cm);
 
     /**
-      *Updates values of end points. These values are coordinates of AABB on axis that maximazes the variance for the AABBs.
+      *Updates the sorted bounds of the boxes along the axis that maximazes the variance for the AABBs.
+      *Boxes outside of the box filter are ignored.
       */
     void update();
 
+    /**
+      *Appends to _pairs the overlapping pairs of boxes whose sweep starts in [first,last).
+      */
+    void sweep(int first, int last);
+
+    /**
+      *Runs the narrow phase intersection on two overlapping boxes.
+      */
+    void intersect(const DSAPBox & box0, const DSAPBox & box1);
+
     Data<bool> bDraw; ///< enable/disable display of results
 
     Data< helper::fixed_array<defaulttype::Vector3,2> > box; ///< if not empty, objects that do not intersect this bounding-box will be ignored
@@ -122,9 +124,15 @@ private:
     CubeModel::SPtr boxModel;
 
     std::vector<DSAPBox> _boxes;//boxes
-    EndPointList _end_points;//end points of _boxes
     int _cur_axis;//the current greatest variance axis
 
+    helper::vector<unsigned int> _sorted_boxes;//boxes in sweep order
+    helper::vector<unsigned int> _sort_keys, _tmp_keys, _tmp_boxes;
+    helper::vector<float> _min[3], _max[3];//bounds of the boxes in sweep order, inflated by half of the alarm distance
+
+    helper::vector< std::pair<unsigned int,unsigned int> > _pairs;//overlapping pairs, as positions in sweep order
+    std::atomic<std::size_t> _nb_pairs;
+
     std::set<core::CollisionModel*> collisionModels;//used to check if a collision model is added
     std::vector<core::CollisionModel*> _new_cm;//eventual new collision models to  add at a step
 
@@ -136,7 +144,6 @@ protected:
 
     ~DirectSAP();
 
-    std::vector<EndPoint*> _to_del;//EndPoint arrays to delete when deleting DirectSAP
 public:
     void setDraw(bool val) { bDraw.setValue(val); }
 
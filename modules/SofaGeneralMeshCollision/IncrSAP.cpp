@@ -229,9 +229,8 @@ IncrSAP::IncrSAP()
 
 
 IncrSAP::~IncrSAP(){
-    for(int i = 0 ; i < 3 ; ++i)
-        for(EndPointList::iterator it = _end_points[i].begin() ; it != _end_points[i].end() ; ++it)
-            delete (*it);
+    for(unsigned int i = 0 ; i < _end_point_arrays.size() ; ++i)
+        delete[] _end_point_arrays[i];
 
 
     //delete[] _end_points;
@@ -240,12 +239,12 @@ IncrSAP::~IncrSAP(){
 
 
 void IncrSAP::purge(){
-    for(int i = 0 ; i < 3 ; ++i){
-        for(EndPointList::iterator it = _end_points[i].begin() ; it != _end_points[i].end() ; ++it)
-            delete (*it);
+    for(unsigned int i = 0 ; i < _end_point_arrays.size() ; ++i)
+        delete[] _end_point_arrays[i];
+    _end_point_arrays.clear();
 
+    for(int i = 0 ; i < 3 ; ++i)
         _end_points[i].clear();
-    }
 
     _boxes.clear();
     _colliding_elems.clear();
@@ -311,10 +310,15 @@ inline void IncrSAP::addCollisionModel(core::CollisionModel *cm)
         int cube_model_size = cube_model->getSize();
         _boxes.resize(cube_model_size + old_size);
 
+        EndPointID * end_pts = new EndPointID[6*cube_model_size];
+        _end_point_arrays.push_back(end_pts);
+        for(int j = 0 ; j < 3 ; ++j)
+            _end_points[j].reserve(_end_points[j].size() + 2*cube_model_size);
+
         EndPointID * endPts[6];
         for(int i = 0 ; i < cube_model->getSize() ; ++i){
             for(int j = 0 ; j < 6 ; ++j)
-                endPts[j] = new EndPointID;
+                endPts[j] = &end_pts[6*i + j];
 
             ISAPBox & new_box = _boxes[old_size + i];
             new_box.cube = Cube(cube_model,i);
@@ -224,6 +224,7 @@ private:
 
     std::vector<ISAPBox> _boxes;
     EndPointList _end_points[3];
+    std::vector<EndPointID*> _end_point_arrays;//end points are allocated in one array per collision model
     CollidingPM _colliding_elems;
 
 
@@ -81,6 +81,7 @@ void CompositingVisualLoop::defaultRendering(sofa::core::visual::VisualParams* v
 void CompositingVisualLoop::drawStep(sofa::core::visual::VisualParams* vparams)
 {
     if ( !gRoot ) return;
+    RenderScope renderScope(this);
 
     sofa::core::visual::tristate renderingState;
     //vparams->displayFlags().setShowRendering(false);
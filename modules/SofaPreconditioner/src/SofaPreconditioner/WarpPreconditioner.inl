@@ -124,7 +124,11 @@ void WarpPreconditioner<TMatrix,TVector,ThreadManager >::setSystemMBKMatrix(cons
 
     realSolver->setSystemMBKMatrix(mparams);
 
-    if (first) {
+    // after a change of the system size, an asynchronous solver factorizes the new matrix synchronously and
+    // starts factorizing it in the background too: both rotation buffers must hold the current rotations
+    const bool resized = !first && realSolver->hasUpdatedMatrix() && getSystemDimention(mparams) != updateSystemSize;
+
+    if (first || resized) {
         updateSystemSize = getSystemDimention(mparams);
         this->resizeSystem(updateSystemSize);
 
@@ -0,0 +1,270 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2018 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaSparseSolver/SparseLDLSolver.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <cmath>
+
+namespace sofa {
+
+using simulation::Node;
+using simulation::SceneLoaderXML;
+using component::linearsolver::SparseLDLSolver;
+using component::linearsolver::CompressedRowSparseMatrix;
+using component::linearsolver::FullVector;
+using component::linearsolver::NoThreadManager;
+using component::linearsolver::AsyncThreadManager;
+
+/** Test the SparseLDLSolver on the system M - dt^2 K of a grid of springs
+*/
+struct SparseLDLSolver_test : public Sofa_test<SReal>
+{
+    typedef component::container::MechanicalObject<defaulttype::Vec3Types> MechanicalObject3;
+    typedef SparseLDLSolver< CompressedRowSparseMatrix<double>, FullVector<double>, NoThreadManager > SyncSolver;
+    typedef SparseLDLSolver< CompressedRowSparseMatrix<double>, FullVector<double>, AsyncThreadManager > AsyncSolver;
+
+    Node::SPtr root;
+    MechanicalObject3* dofs;
+    core::MechanicalParams mparams;
+
+    SparseLDLSolver_test()
+        : dofs(NULL)
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+        mparams.setMFactor(1.0);
+        mparams.setBFactor(0.0);
+        mparams.setKFactor(-0.01);
+    }
+
+    ~SparseLDLSolver_test()
+    {
+        if (root)
+            sofa::simulation::getSimulation()->unload(root);
+    }
+
+    void createGrid(int n)
+    {
+        std::ostringstream scene;
+        scene << "<?xml version='1.0'?>"
+                 "<Node name='root'>"
+                 "   <RegularGridTopology n='" << n << " " << n << " " << n << "' min='0 0 0' max='1 1 1'/>"
+                 "   <MechanicalObject name='dofs'/>"
+                 "   <UniformMass totalMass='1'/>"
+                 "   <MeshSpringForceField stiffness='100'/>"
+                 "</Node>";
+        root = SceneLoaderXML::loadFromMemory("testscene", scene.str().c_str(), scene.str().size());
+        ASSERT_NE(nullptr, root);
+        root->getTreeObject(dofs);
+        ASSERT_NE(nullptr, dofs);
+    }
+
+    /// move the nodes, which changes the stiffness matrix of the springs
+    void deform(int step)
+    {
+        helper::WriteAccessor< Data<MechanicalObject3::VecCoord> > x = *dofs->write(core::VecCoordId::position());
+        for (std::size_t i=0; i<x.size(); ++i)
+            x[i] += defaulttype::Vec3d(std::sin(0.3*i + step), std::cos(0.7*i + step), std::sin(1.1*i + 2*step)) * 0.05;
+    }
+
+    helper::vector<SReal> solve(core::behavior::LinearSolver* solver)
+    {
+        {
+            helper::WriteAccessor< Data<MechanicalObject3::VecDeriv> > f = *dofs->write(core::VecDerivId::force());
+            for (std::size_t i=0; i<f.size(); ++i)
+                f[i] = defaulttype::Vec3d(std::sin(1.0 + i), std::cos(2.0 + i), 1.0);
+        }
+        solver->setSystemRHVector(core::VecDerivId::force());
+        solver->setSystemLHVector(core::VecDerivId::dx());
+        solver->solveSystem();
+        const defaulttype::BaseVector* x = solver->getSystemLHBaseVector();
+        helper::vector<SReal> solution(x->size());
+        for (std::size_t i=0; i<solution.size(); ++i)
+            solution[i] = x->element(i);
+        return solution;
+    }
+
+    void checkSolutions(const helper::vector<SReal>& expected, const helper::vector<SReal>& solution)
+    {
+        ASSERT_EQ(expected.size(), solution.size());
+        SReal norm = 0;
+        for (std::size_t i=0; i<expected.size(); ++i)
+            norm = std::max(norm, std::fabs(expected[i]));
+        for (std::size_t i=0; i<expected.size(); ++i)
+            EXPECT_NEAR(expected[i], solution[i], 1e-10 * norm) << "dof " << i;
+    }
+
+    /// once the background factorization of a matrix is swapped in, the solution is the one of the synchronous solver
+    void asyncFactorization()
+    {
+        createGrid(4);
+        SyncSolver::SPtr sync = core::objectmodel::New<SyncSolver>();
+        AsyncSolver::SPtr async = core::objectmodel::New<AsyncSolver>();
+        root->addObject(sync);
+        root->addObject(async);
+        sofa::simulation::getSimulation()->init(root.get());
+
+        for (int step=0; step<4; ++step)
+        {
+            deform(step);
+            sync->setSystemMBKMatrix(&mparams);
+
+            // swaps in the factorization of the previous matrix, if finished, and starts the one of the new matrix
+            async->setSystemMBKMatrix(&mparams);
+            async->waitFactorization();
+            async->setSystemMBKMatrix(&mparams);
+            EXPECT_TRUE(async->hasUpdatedMatrix());
+
+            checkSolutions(solve(sync.get()), solve(async.get()));
+        }
+
+        // the destruction waits for the running factorization
+        deform(4);
+        async->setSystemMBKMatrix(&mparams);
+        root->removeObject(async);
+        async.reset();
+    }
+
+    /// the supernodal factorization, sequential and parallel, gives the solution of the scalar one
+    void supernodalFactorization()
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const unsigned int threadCount = scheduler->getThreadCount();
+        scheduler->init(4);
+
+        // large enough for the nested dissection ordering to create supernodes and independent subtrees
+        createGrid(8);
+        SyncSolver::SPtr scalar = core::objectmodel::New<SyncSolver>();
+        SyncSolver::SPtr supernodal = core::objectmodel::New<SyncSolver>();
+        SyncSolver::SPtr parallel = core::objectmodel::New<SyncSolver>();
+        supernodal->d_supernodal.setValue(true);
+        parallel->d_supernodal.setValue(true);
+        parallel->d_parallelFactorization.setValue(true);
+        root->addObject(scalar);
+        root->addObject(supernodal);
+        root->addObject(parallel);
+        sofa::simulation::getSimulation()->init(root.get());
+
+        // the pattern is kept from one step to the next: the symbolic factorization is reused
+        for (int step=0; step<3; ++step)
+        {
+            deform(step);
+            scalar->setSystemMBKMatrix(&mparams);
+            supernodal->setSystemMBKMatrix(&mparams);
+            parallel->setSystemMBKMatrix(&mparams);
+
+            const helper::vector<SReal> expected = solve(scalar.get());
+            checkSolutions(expected, solve(supernodal.get()));
+            checkSolutions(expected, solve(parallel.get()));
+        }
+
+        SyncSolver::InvertData* data = static_cast<SyncSolver::InvertData*>(parallel->getMatrixInvertData(parallel->getSystemMatrix()));
+        ASSERT_NE(nullptr, data);
+        const int nsuper = (int)data->super_begin.size() - 1;
+        EXPECT_LT(0, nsuper);
+        EXPECT_LT(nsuper, data->n);
+        int maxChildren = 0;
+        for (int s=0; s<nsuper; ++s)
+            maxChildren = std::max(maxChildren, data->super_child_ptr[s+1] - data->super_child_ptr[s]);
+        EXPECT_LE(2, maxChildren);
+
+        scheduler->init(threadCount);
+    }
+
+    helper::vector<SReal> invertAndSolve(SyncSolver* solver, CompressedRowSparseMatrix<double>& M)
+    {
+        const int n = M.rowSize();
+        FullVector<double> x(n), b(n);
+        for (int i=0; i<n; ++i)
+            b[i] = std::sin(1.0 + i);
+        solver->invert(M);
+        solver->solve(M, x, b);
+        helper::vector<SReal> solution(n);
+        for (int i=0; i<n; ++i)
+            solution[i] = x[i];
+        return solution;
+    }
+
+    /// an entry stored without its mirror is read from the same triangle by the scalar and the supernodal factorizations
+    void unsymmetricPattern()
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const unsigned int threadCount = scheduler->getThreadCount();
+        scheduler->init(4);
+
+        // laplacian of a 2D grid, one edge out of five being stored on one side only
+        const int size = 16;
+        CompressedRowSparseMatrix<double> M;
+        M.resize(size*size, size*size);
+        int nbEdges = 0;
+        for (int y=0; y<size; ++y)
+            for (int x=0; x<size; ++x)
+            {
+                const int i = x + size*y;
+                M.add(i, i, 4.5);
+                const int neighbors[2] = { x+1 < size ? i+1 : -1, y+1 < size ? i+size : -1 };
+                for (int k=0; k<2; ++k)
+                {
+                    const int j = neighbors[k];
+                    if (j < 0) continue;
+                    if (nbEdges % 5 != 0 || nbEdges % 10 == 0) M.add(i, j, -1.0);
+                    if (nbEdges % 5 != 0 || nbEdges % 10 != 0) M.add(j, i, -1.0);
+                    ++nbEdges;
+                }
+            }
+        M.compress();
+
+        SyncSolver::SPtr scalar = core::objectmodel::New<SyncSolver>();
+        SyncSolver::SPtr supernodal = core::objectmodel::New<SyncSolver>();
+        SyncSolver::SPtr parallel = core::objectmodel::New<SyncSolver>();
+        supernodal->d_supernodal.setValue(true);
+        parallel->d_supernodal.setValue(true);
+        parallel->d_parallelFactorization.setValue(true);
+
+        const helper::vector<SReal> expected = invertAndSolve(scalar.get(), M);
+        checkSolutions(expected, invertAndSolve(supernodal.get(), M));
+        checkSolutions(expected, invertAndSolve(parallel.get(), M));
+
+        scheduler->init(threadCount);
+    }
+};
+
+TEST_F(SparseLDLSolver_test, asyncFactorization)
+{
+    this->asyncFactorization();
+}
+
+TEST_F(SparseLDLSolver_test, supernodalFactorization)
+{
+    this->supernodalFactorization();
+}
+
+TEST_F(SparseLDLSolver_test, unsymmetricPattern)
+{
+    this->unsymmetricPattern();
+}
+
+} // namespace sofa
@@ -44,99 +44,97 @@ using namespace sofa::core::objectmodel;
 using sofa::helper::system::thread::CTime;
 using sofa::helper::system::thread::ctime_t;
 
-template<class TMatrix, class TVector>
-SparseCholeskySolver<TMatrix,TVector>::SparseCholeskySolver()
+template<class TMatrix, class TVector, class TThreadManager>
+SparseCholeskySolver<TMatrix,TVector,TThreadManager>::SparseCholeskySolver()
     : f_verbose( initData(&f_verbose,false,"verbose","Dump system state at each iteration") )
-    , S(NULL), N(NULL)
 {
 }
 
-template<class TMatrix, class TVector>
-SparseCholeskySolver<TMatrix,TVector>::~SparseCholeskySolver()
+template<class TMatrix, class TVector, class TThreadManager>
+SparseCholeskySolver<TMatrix,TVector,TThreadManager>::~SparseCholeskySolver()
 {
-    if (S) cs_sfree (S);
-    if (N) cs_nfree (N);
+    // the background factorization uses the invert data
+    this->waitFactorization();
 }
 
-template<class TMatrix, class TVector>
-void SparseCholeskySolver<TMatrix,TVector>::solveT(double * z, double * r)
+template<class TMatrix, class TVector, class TThreadManager>
+void SparseCholeskySolver<TMatrix,TVector,TThreadManager>::solveT(SparseCholeskyInvertData * data, double * z, double * r)
 {
-    int n = A.n;
+    int n = data->A.n;
+    tmp.resize(n);
 
-    cs_ipvec (n, S->Pinv, r, (double*) &(tmp[0]));	//x = P*b
+    cs_ipvec (n, data->S->Pinv, r, (double*) &(tmp[0]));	//x = P*b
 
-    cs_lsolve (N->L, (double*) &(tmp[0]));			//x = L\x
-    cs_ltsolve (N->L, (double*) &(tmp[0]));			//x = L'\x/
+    cs_lsolve (data->N->L, (double*) &(tmp[0]));			//x = L\x
+    cs_ltsolve (data->N->L, (double*) &(tmp[0]));			//x = L'\x/
 
-    cs_pvec (n, S->Pinv, (double*) &(tmp[0]), z);	 //b = P'*x
+    cs_pvec (n, data->S->Pinv, (double*) &(tmp[0]), z);	 //b = P'*x
 }
 
-template<class TMatrix, class TVector>
-void SparseCholeskySolver<TMatrix,TVector>::solveT(float * z, float * r)
+template<class TMatrix, class TVector, class TThreadManager>
+void SparseCholeskySolver<TMatrix,TVector,TThreadManager>::solveT(SparseCholeskyInvertData * data, float * z, float * r)
 {
-    int n = A.n;
+    int n = data->A.n;
+    tmp.resize(n);
     z_tmp.resize(n);
     r_tmp.resize(n);
     for (int i=0; i<n; i++) r_tmp[i] = (double) r[i];
 
-    cs_ipvec (n, S->Pinv, (double*) &(r_tmp[0]), (double*) &(tmp[0]));	//x = P*b
+    cs_ipvec (n, data->S->Pinv, (double*) &(r_tmp[0]), (double*) &(tmp[0]));	//x = P*b
 
-    cs_lsolve (N->L, (double*) &(tmp[0]));			//x = L\x
-    cs_ltsolve (N->L, (double*) &(tmp[0]));			//x = L'\x/
+    cs_lsolve (data->N->L, (double*) &(tmp[0]));			//x = L\x
+    cs_ltsolve (data->N->L, (double*) &(tmp[0]));			//x = L'\x/
 
-    cs_pvec (n, S->Pinv, (double*) &(tmp[0]), (double*) &(z_tmp[0]));	 //b = P'*x
+    cs_pvec (n, data->S->Pinv, (double*) &(tmp[0]), (double*) &(z_tmp[0]));	 //b = P'*x
 
     for (int i=0; i<n; i++) z[i] = (float) z_tmp[i];
 }
 
 
-template<class TMatrix, class TVector>
-void SparseCholeskySolver<TMatrix,TVector>::solve (Matrix& /*M*/, Vector& z, Vector& r)
+template<class TMatrix, class TVector, class TThreadManager>
+void SparseCholeskySolver<TMatrix,TVector,TThreadManager>::solve (Matrix& M, Vector& z, Vector& r)
 {
-    solveT(z.ptr(),r.ptr());
+    solveT((SparseCholeskyInvertData *) this->getMatrixInvertData(&M), z.ptr(), r.ptr());
 }
 
-template<class TMatrix, class TVector>
-void SparseCholeskySolver<TMatrix,TVector>::invert(Matrix& M)
+template<class TMatrix, class TVector, class TThreadManager>
+void SparseCholeskySolver<TMatrix,TVector,TThreadManager>::invert(Matrix& M)
 {
+    SparseCholeskyInvertData * data = (SparseCholeskyInvertData *) this->getMatrixInvertData(&M);
     int order = -1; //?????
-    if (S) cs_sfree(S);
-    if (N) cs_nfree(N);
-    //if (tmp) cs_free(tmp);
+    if (data->S) cs_sfree(data->S);
+    if (data->N) cs_nfree(data->N);
     M.compress();
 
-    A.nzmax = M.getColsValue().size();	// maximum number of entries
-    A_p = (int *) &(M.getRowBegin()[0]);
-    A_i = (int *) &(M.getColsIndex()[0]);
-    A_x.resize(A.nzmax);
-    for (int i=0; i<A.nzmax; i++) A_x[i] = (double) M.getColsValue()[i];
+    // the factorization keeps its own copy of the matrix, which cs_dropzeros modifies
+    data->A.nzmax = M.getColsValue().size();	// maximum number of entries
+    data->A_p = M.getRowBegin();
+    data->A_i = M.getColsIndex();
+    data->A_x.resize(data->A.nzmax);
+    for (int i=0; i<data->A.nzmax; i++) data->A_x[i] = (double) M.getColsValue()[i];
     //remplir A avec M
-    A.m = M.rowBSize();					// number of rows
-    A.n = M.colBSize();					// number of columns
-    A.p = A_p;							// column pointers (size n+1) or col indices (size nzmax)
-    A.i = A_i;							// row indices, size nzmax
-    A.x = (double*) &(A_x[0]);				// numerical values, size nzmax
-    A.nz = -1;							// # of entries in triplet matrix, -1 for compressed-col
-    cs_dropzeros( &A );
-    //M.check_matrix();
-    //CompressedRowSparseMatrix<double>::check_matrix(-1 /*A.nzmax*/,A.m,A.n,A.p,A.i,A.x);
-    //sout << "diag =";
-    //for (int i=0;i<A.n;++i) sout << " " << M.element(i,i);
-    //sout << sendl;
-    //tmp = (double *) cs_malloc (A.n, sizeof (double)) ;
-    tmp.resize(A.n);
-    S = cs_schol (&A, order) ;		/* ordering and symbolic analysis */
-    N = cs_chol (&A, S) ;		/* numeric Cholesky factorization */
-    //sout << "SparseCholeskySolver: factorization complete, nnz = " << N->L->p[N->L->n] << sendl;
+    data->A.m = M.rowBSize();					// number of rows
+    data->A.n = M.colBSize();					// number of columns
+    data->A.p = (int *) &(data->A_p[0]);			// column pointers (size n+1) or col indices (size nzmax)
+    data->A.i = (int *) &(data->A_i[0]);			// row indices, size nzmax
+    data->A.x = (double*) &(data->A_x[0]);		// numerical values, size nzmax
+    data->A.nz = -1;							// # of entries in triplet matrix, -1 for compressed-col
+    cs_dropzeros( &data->A );
+    data->S = cs_schol (&data->A, order) ;		/* ordering and symbolic analysis */
+    data->N = cs_chol (&data->A, data->S) ;		/* numeric Cholesky factorization */
 }
 
 int SparseCholeskySolverClass = core::RegisterObject("Direct linear solver based on Sparse Cholesky factorization, implemented with the CSPARSE library")
         .add< SparseCholeskySolver< CompressedRowSparseMatrix<double>,FullVector<double> > >(true)
         .add< SparseCholeskySolver< CompressedRowSparseMatrix<float>,FullVector<float> > >()
+        .add< SparseCholeskySolver< CompressedRowSparseMatrix<double>,FullVector<double>,AsyncThreadManager > >()
+        .add< SparseCholeskySolver< CompressedRowSparseMatrix<float>,FullVector<float>,AsyncThreadManager > >()
         ;
 
 template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<double>,FullVector<double> >;
 template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<float>,FullVector<float> >;
+template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<double>,FullVector<double>,AsyncThreadManager >;
+template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<float>,FullVector<float>,AsyncThreadManager >;
 
 } // namespace linearsolver
 
@@ -42,16 +42,38 @@ namespace component
 namespace linearsolver
 {
 
+/// Cholesky factorization of the system matrix
+class SparseCholeskyInvertData : public MatrixInvertData
+{
+public :
+    cs A;
+    css *S;
+    csn *N;
+    helper::vector<int> A_i, A_p;
+    helper::vector<double> A_x;
+
+    SparseCholeskyInvertData()
+    {
+        S=NULL; N=NULL;
+    }
+
+    ~SparseCholeskyInvertData()
+    {
+        if (S) cs_sfree (S);
+        if (N) cs_nfree (N);
+    }
+};
+
 /// Direct linear solver based on Sparse Cholesky factorization, implemented with the CSPARSE library
-template<class TMatrix, class TVector>
-class SparseCholeskySolver : public sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector>
+template<class TMatrix, class TVector, class TThreadManager = NoThreadManager>
+class SparseCholeskySolver : public sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector,TThreadManager>
 {
 public:
-    SOFA_CLASS(SOFA_TEMPLATE2(SparseCholeskySolver,TMatrix,TVector),SOFA_TEMPLATE2(sofa::component::linearsolver::MatrixLinearSolver,TMatrix,TVector));
+    SOFA_CLASS(SOFA_TEMPLATE3(SparseCholeskySolver,TMatrix,TVector,TThreadManager),SOFA_TEMPLATE3(sofa::component::linearsolver::MatrixLinearSolver,TMatrix,TVector,TThreadManager));
 
     typedef TMatrix Matrix;
     typedef TVector Vector;
-    typedef sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector> Inherit;
+    typedef sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector,TThreadManager> Inherit;
 
     Data<bool> f_verbose; ///< Dump system state at each iteration
 
@@ -61,20 +83,23 @@ public:
     void invert(Matrix& M) override;
 
 public :
-    cs A;
-    css *S;
-    csn *N;
-    int * A_i;
-    int * A_p;
-    helper::vector<double> A_x,z_tmp,r_tmp,tmp;
+    helper::vector<double> z_tmp,r_tmp,tmp;
+
+    void solveT(SparseCholeskyInvertData * data, double * z, double * r);
+    void solveT(SparseCholeskyInvertData * data, float * z, float * r);
+
+protected :
 
-    void solveT(double * z, double * r);
-    void solveT(float * z, float * r);
+    MatrixInvertData * createInvertData() override {
+        return new SparseCholeskyInvertData();
+    }
 };
 
 #if  !defined(SOFA_COMPONENT_LINEARSOLVER_SPARSECHOLESKYSOLVER_CPP)
 extern template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<double>,FullVector<double> >;
 extern template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<float>,FullVector<float> >;
+extern template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<double>,FullVector<double>,AsyncThreadManager >;
+extern template class SOFA_SOFASPARSESOLVER_API SparseCholeskySolver< CompressedRowSparseMatrix<float>,FullVector<float>,AsyncThreadManager >;
 #endif
 
 } // namespace linearsolver
@@ -37,21 +37,29 @@ int SparseLDLSolverClass = core::RegisterObject("Direct Linear Solver using a Sp
 #ifdef SOFA_WITH_DOUBLE
         .add< SparseLDLSolver< CompressedRowSparseMatrix<double>,FullVector<double> > >(true)
         .add< SparseLDLSolver< CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> >,FullVector<double> > >()
+        .add< SparseLDLSolver< CompressedRowSparseMatrix<double>,FullVector<double>,AsyncThreadManager > >()
+        .add< SparseLDLSolver< CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> >,FullVector<double>,AsyncThreadManager > >()
 #endif
 #ifdef SOFA_WITH_FLOAT
         .add< SparseLDLSolver< CompressedRowSparseMatrix<float>,FullVector<float> > >(true)
         .add< SparseLDLSolver< CompressedRowSparseMatrix<defaulttype::Mat<3,3,float> >,FullVector<float> > >()
+        .add< SparseLDLSolver< CompressedRowSparseMatrix<float>,FullVector<float>,AsyncThreadManager > >()
+        .add< SparseLDLSolver< CompressedRowSparseMatrix<defaulttype::Mat<3,3,float> >,FullVector<float>,AsyncThreadManager > >()
 #endif
 ;
 
 #ifdef SOFA_WITH_DOUBLE
 template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix<double>,FullVector<double> >;
 template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,double> >,FullVector<double> >;
+template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix<double>,FullVector<double>,AsyncThreadManager >;
+template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,double> >,FullVector<double>,AsyncThreadManager >;
 #endif
 
 #ifdef SOFA_WITH_FLOAT
 template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix<float>,FullVector<float> >;
 template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,float> >,FullVector<float> >;
+template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix<float>,FullVector<float>,AsyncThreadManager >;
+template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,float> >,FullVector<float>,AsyncThreadManager >;
 #endif
 } // namespace linearsolver
 
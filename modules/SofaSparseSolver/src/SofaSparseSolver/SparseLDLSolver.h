@@ -63,6 +63,7 @@ public :
     int numStep;
 
     Data<bool> f_saveMatrixToFile; ///< save matrix to a text file (can be very slow, as full matrix is stored
+    Data<bool> d_frozenPattern; ///< keep the sparsity pattern of the system matrix from one step to the next, for scenes whose topology does not change
 
     MatrixInvertData * createInvertData() override {
         return new InvertData();
@@ -70,6 +71,7 @@ public :
 
 protected :
     SparseLDLSolver();
+    ~SparseLDLSolver();
 
     FullMatrix<Real> Jminv,Jdense;
     sofa::component::linearsolver::CompressedRowSparseMatrix<Real> Mfiltered;
@@ -79,10 +81,14 @@ protected :
 #ifdef SOFA_WITH_DOUBLE
 extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< double>,FullVector<double> >;
 extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,double> >,FullVector<double> >;
+extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< double>,FullVector<double>,AsyncThreadManager >;
+extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,double> >,FullVector<double>,AsyncThreadManager >;
 #endif
 #ifdef SOFA_WITH_FLOAT
 extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< float>,FullVector<float> >;
 extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,float> >,FullVector<float> >;
+extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< float>,FullVector<float>,AsyncThreadManager >;
+extern template class SOFA_SOFASPARSESOLVER_API SparseLDLSolver< CompressedRowSparseMatrix< defaulttype::Mat<3,3,float> >,FullVector<float>,AsyncThreadManager >;
 #endif
 #endif
 
@@ -45,8 +45,16 @@ template<class TMatrix, class TVector, class TThreadManager>
 SparseLDLSolver<TMatrix,TVector,TThreadManager>::SparseLDLSolver()
     : numStep(0)
     , f_saveMatrixToFile( initData(&f_saveMatrixToFile, false, "saveMatrixToFile", "save matrix to a text file (can be very slow, as full matrix is stored"))
+    , d_frozenPattern( initData(&d_frozenPattern, false, "frozenPattern", "keep the sparsity pattern of the system matrix from one step to the next, for scenes whose topology does not change"))
 {}
 
+template<class TMatrix, class TVector, class TThreadManager>
+SparseLDLSolver<TMatrix,TVector,TThreadManager>::~SparseLDLSolver()
+{
+    // the background factorization uses Mfiltered and the invert data
+    this->waitFactorization();
+}
+
 template<class TMatrix, class TVector, class TThreadManager>
 void SparseLDLSolver<TMatrix,TVector,TThreadManager>::solve (Matrix& M, Vector& z, Vector& r) {
     Inherit::solve_cpu(&z[0],&r[0],(InvertData *) this->getMatrixInvertData(&M));
@@ -63,6 +71,9 @@ void SparseLDLSolver<TMatrix,TVector,TThreadManager>::invert(Matrix& M) {
         f.close();
     }
 
+    // takes effect from the next assembly on
+    M.setFrozenPattern(d_frozenPattern.getValue());
+
     Mfiltered.copyNonZeros(M);
     Mfiltered.compress();
 
@@ -25,6 +25,11 @@
 
 #include <sofa/core/behavior/LinearSolver.h>
 #include <SofaBaseLinearSolver/MatrixLinearSolver.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
 
 extern "C" {
 #include <metis.h>
@@ -49,6 +54,13 @@ public :
     VecReal P_values,L_values,LT_values,invD;
     helper::vector<int> Parent;
     bool new_factorization_needed;
+
+    // supernodal structure, computed with the symbolic factorization
+    helper::vector<int> super_begin; ///< first column of each supernode, plus the end of the last one
+    helper::vector<int> super_parent; ///< parent in the supernodal elimination tree, -1 for a root
+    helper::vector<int> super_child_ptr, super_child; ///< children of each supernode
+    helper::vector<int> super_relind_ptr, super_relind; ///< position of the update rows of each supernode in the front of its parent
+    helper::vector<int> super_entry_ptr, super_entry_row, super_entry_pos; ///< rows and positions in the matrix values of the entries of each column of the front
 };
 
 inline void CSPARSE_symbolic (int n,int * M_colptr,int * M_rowind,int * colptr,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz)
@@ -134,6 +146,140 @@ inline void CSPARSE_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,
     }
 }
 
+/// fill the row indices of L from its column counts (colptr) and the elimination tree
+/// the rows of each column are sorted, in the same order as written by CSPARSE_numeric
+inline void CSPARSE_symbolic_pattern(int n,int * M_colptr,int * M_rowind,int * colptr,int * rowind,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz)
+{
+    for (int k = 0 ; k < n ; k++)
+    {
+        Flag [k] = k ;		    /* mark node k as visited */
+        Lnz [k] = 0 ;		    /* count of nonzeros in column k of L */
+        int kk = perm[k];  /* kth original, or permuted, column */
+        for (int p = M_colptr[kk] ; p < M_colptr[kk+1] ; p++)
+        {
+            int i = invperm[M_rowind[p]];
+            if (i < k)
+            {
+                for ( ; Flag [i] != k ; i = Parent [i])
+                {
+                    rowind[colptr[i] + Lnz[i]++] = k ;	/* L (k,i) is nonzero */
+                    Flag [i] = k ;
+                }
+            }
+        }
+    }
+}
+
+/// list the entries of each column of the lower triangle, read from the same triangle as CSPARSE_symbolic:
+/// the entries (i,k), i <= k, of the permuted column k, as the entries (k,i) of column i
+/// the rows of each column are sorted, and pos is the index of the value in M
+inline void CSPARSE_supernodal_entries(int n, const int * M_colptr, const int * M_rowind, const int * perm, const int * invperm,
+                                       helper::vector<int> & ptr, helper::vector<int> & row, helper::vector<int> & pos)
+{
+    ptr.clear();
+    ptr.resize(n + 1, 0);
+    for (int k = 0 ; k < n ; k++)
+    {
+        const int kk = perm[k];
+        for (int p = M_colptr[kk] ; p < M_colptr[kk+1] ; p++)
+        {
+            const int i = invperm[M_rowind[p]];
+            if (i <= k) ptr[i+1]++;
+        }
+    }
+    for (int i = 0 ; i < n ; i++) ptr[i+1] += ptr[i];
+
+    row.resize(ptr[n]);
+    pos.resize(ptr[n]);
+    helper::vector<int> fill(ptr.begin(), ptr.end() - 1);
+    for (int k = 0 ; k < n ; k++)
+    {
+        const int kk = perm[k];
+        for (int p = M_colptr[kk] ; p < M_colptr[kk+1] ; p++)
+        {
+            const int i = invperm[M_rowind[p]];
+            if (i <= k)
+            {
+                row[fill[i]] = k;
+                pos[fill[i]++] = p;
+            }
+        }
+    }
+}
+
+/// group the columns of L into supernodes: consecutive columns j, j+1 belong to the same
+/// supernode when j+1 is the parent of j and the pattern of j is {j+1} plus the pattern of j+1
+inline void CSPARSE_supernodal_symbolic(int n, const int * colptr, const int * rowind, const int * Parent,
+                                        helper::vector<int> & super_begin, helper::vector<int> & super_parent,
+                                        helper::vector<int> & super_child_ptr, helper::vector<int> & super_child,
+                                        helper::vector<int> & super_relind_ptr, helper::vector<int> & super_relind)
+{
+    helper::vector<int> col2super(n);
+
+    super_begin.clear();
+    for (int j = 0 ; j < n ; j++)
+    {
+        const bool merge = j > 0 && Parent[j-1] == j && (colptr[j] - colptr[j-1]) == (colptr[j+1] - colptr[j]) + 1;
+        if (!merge) super_begin.push_back(j);
+        col2super[j] = (int) super_begin.size() - 1;
+    }
+    const int nsuper = (int) super_begin.size();
+    super_begin.push_back(n);
+
+    // the parent of a supernode is the supernode holding the parent of its last column
+    super_parent.resize(nsuper);
+    super_child_ptr.clear();
+    super_child_ptr.resize(nsuper + 1, 0);
+    for (int s = 0 ; s < nsuper ; s++)
+    {
+        const int last = super_begin[s+1] - 1;
+        super_parent[s] = Parent[last] < 0 ? -1 : col2super[Parent[last]];
+        if (super_parent[s] >= 0) super_child_ptr[super_parent[s] + 1]++;
+    }
+    for (int s = 0 ; s < nsuper ; s++) super_child_ptr[s+1] += super_child_ptr[s];
+
+    super_child.resize(super_child_ptr[nsuper]);
+    helper::vector<int> fill(super_child_ptr.begin(), super_child_ptr.end() - 1);
+    for (int s = 0 ; s < nsuper ; s++)
+    {
+        if (super_parent[s] >= 0) super_child[fill[super_parent[s]]++] = s;
+    }
+
+    // the update rows of a supernode are the rows of its first column below the supernode;
+    // they all belong to the front of the parent: supernode columns first, then its update rows
+    super_relind_ptr.resize(nsuper + 1);
+    super_relind_ptr[0] = 0;
+    for (int s = 0 ; s < nsuper ; s++)
+    {
+        const int ncols = super_begin[s+1] - super_begin[s];
+        const int first = super_begin[s];
+        super_relind_ptr[s+1] = super_relind_ptr[s] + (colptr[first+1] - colptr[first]) - (ncols - 1);
+    }
+
+    super_relind.resize(super_relind_ptr[nsuper]);
+    for (int s = 0 ; s < nsuper ; s++)
+    {
+        const int p = super_parent[s];
+        if (p < 0) continue;
+
+        const int ncols = super_begin[s+1] - super_begin[s];
+        const int * rows = rowind + colptr[super_begin[s]] + (ncols - 1);
+
+        const int parent_first = super_begin[p];
+        const int parent_ncols = super_begin[p+1] - parent_first;
+        const int * parent_rows = rowind + colptr[parent_first] + (parent_ncols - 1);
+        const int * parent_rows_end = rowind + colptr[parent_first+1];
+
+        for (int r = 0 ; r < super_relind_ptr[s+1] - super_relind_ptr[s] ; r++)
+        {
+            const int row = rows[r];
+            super_relind[super_relind_ptr[s] + r] = (row < parent_first + parent_ncols)
+                ? row - parent_first
+                : parent_ncols + (int) (std::lower_bound(parent_rows, parent_rows_end, row) - parent_rows);
+        }
+    }
+}
+
 inline bool CSPARSE_need_symbolic_factorization(int s_M, int * M_colptr,int * M_rowind, int s_P, int * P_colptr,int * P_rowind) {
     if (s_M != s_P) return true;
     if (M_colptr[s_M] != P_colptr[s_M] ) return true;
@@ -162,9 +308,16 @@ public:
     typedef TThreadManager ThreadManager;
     typedef typename TMatrix::Real Real;
 
+    Data<bool> d_supernodal; ///< use the supernodal (multifrontal) numeric factorization with dense kernels
+    Data<bool> d_parallelFactorization; ///< factorize independent subtrees of the elimination tree in parallel (supernodal only)
+
 protected :
 
-    SparseLDLSolverImpl() : Inherit() {}
+    SparseLDLSolverImpl()
+        : Inherit()
+        , d_supernodal(initData(&d_supernodal, false, "supernodal", "use the supernodal (multifrontal) numeric factorization, running dense kernels on groups of columns sharing the same pattern"))
+        , d_parallelFactorization(initData(&d_parallelFactorization, false, "parallelFactorization", "factorize the independent subtrees of the elimination tree in parallel on the task scheduler (supernodal factorization only)"))
+    {}
 
     template<class VecInt,class VecReal>
     void solve_cpu(Real * x,const Real * b,SparseLDLImplInvertData<VecInt,VecReal> * data) {
@@ -278,6 +431,234 @@ protected :
         CSPARSE_numeric<Real>(n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,perm,invperm,Parent,Flag.data(),Lnz.data(),Pattern.data(),Y.data());
     }
 
+    /// state shared by the tasks of one supernodal factorization
+    struct SupernodalContext
+    {
+        const Real * M_values;
+        const int * L_colptr;
+        const int * L_rowind;
+        Real * L_values;
+        Real * D;
+        const int * super_begin;
+        const int * super_parent;
+        const int * super_child_ptr;
+        const int * super_child;
+        const int * super_relind_ptr;
+        const int * super_relind;
+        const int * super_entry_ptr;
+        const int * super_entry_row;
+        const int * super_entry_pos;
+
+        // parallel scheduling: the light subtrees are factorized by one task each,
+        // the heavy supernodes above them by one task per supernode
+        helper::vector<int> task_ptr, task_list; ///< supernodes factorized by the task of each supernode
+        std::unique_ptr< std::atomic<int>[] > pending; ///< number of unfinished children tasks
+        simulation::TaskScheduler * scheduler;
+        const simulation::Task::Status * status;
+        std::atomic<bool> failed;
+    };
+
+    class SupernodalTask : public simulation::Task
+    {
+    public:
+        SupernodalTask(SparseLDLSolverImpl * solver, SupernodalContext * context, int super, const simulation::Task::Status * status)
+            : simulation::Task(status), m_solver(solver), m_context(context), m_super(super) {}
+
+        bool run() final
+        {
+            m_solver->runSupernodalTask(m_context, m_super);
+            return true;
+        }
+
+    private:
+        SparseLDLSolverImpl * m_solver;
+        SupernodalContext * m_context;
+        int m_super;
+    };
+
+    /// factorize the columns of supernode s: assemble its frontal matrix from the matrix entries and the
+    /// update matrices of its children, factorize the supernode columns, and compute its own update matrix
+    bool factorizeSupernode(const SupernodalContext * ctx, int s, helper::vector<Real> & front) {
+        const int first = ctx->super_begin[s];
+        const int ncols = ctx->super_begin[s+1] - first;
+        const int nrows = ctx->super_relind_ptr[s+1] - ctx->super_relind_ptr[s];
+        const int m = ncols + nrows;
+        const int * rows = ctx->L_rowind + ctx->L_colptr[first] + (ncols - 1);
+
+        // dense lower triangle, column major
+        front.resize(m * m);
+        std::fill(front.begin(), front.end(), (Real) 0);
+        Real * F = front.data();
+
+        // the entries are read from the triangle used by the symbolic factorization, so their rows are in the pattern
+        for (int c = 0 ; c < ncols ; c++) {
+            const int j = first + c;
+            for (int e = ctx->super_entry_ptr[j] ; e < ctx->super_entry_ptr[j+1] ; e++) {
+                const int i = ctx->super_entry_row[e];
+                const int r = (i < first + ncols) ? i - first : ncols + (int) (std::lower_bound(rows, rows + nrows, i) - rows);
+                assert(r < m && (r < ncols || rows[r - ncols] == i));
+                F[r + c * m] += ctx->M_values[ctx->super_entry_pos[e]];
+            }
+        }
+
+        // extend-add
+        for (int ic = ctx->super_child_ptr[s] ; ic < ctx->super_child_ptr[s+1] ; ic++) {
+            const int child = ctx->super_child[ic];
+            const int nc = ctx->super_relind_ptr[child+1] - ctx->super_relind_ptr[child];
+            const int * relind = ctx->super_relind + ctx->super_relind_ptr[child];
+            const Real * U = super_update[child].data();
+            for (int jj = 0 ; jj < nc ; jj++) {
+                Real * Fcol = F + relind[jj] * m;
+                const Real * Ucol = U + jj * nc;
+                for (int ii = jj ; ii < nc ; ii++) Fcol[relind[ii]] += Ucol[ii];
+            }
+            helper::vector<Real>().swap(super_update[child]);
+        }
+
+        // panel factorization: L11 D L11^T and L21 for the supernode columns
+        for (int k = 0 ; k < ncols ; k++) {
+            Real * colk = F + k * m;
+            const Real d = colk[k];
+            if (d == 0.0) return false;
+
+            for (int j = k + 1 ; j < ncols ; j++) {
+                const Real ljk = colk[j] / d;
+                Real * colj = F + j * m;
+                for (int i = j ; i < m ; i++) colj[i] -= colk[i] * ljk;
+            }
+
+            const Real invd = (Real) 1.0 / d;
+            for (int i = k + 1 ; i < m ; i++) colk[i] *= invd;
+            ctx->D[first + k] = d;
+        }
+
+        // update matrix: U = F22 - L21 D L21^T
+        helper::vector<Real> & update = super_update[s];
+        update.resize(nrows * nrows);
+        for (int jj = 0 ; jj < nrows ; jj++) {
+            Real * Ucol = update.data() + jj * nrows;
+            const Real * Fcol = F + (ncols + jj) * m + ncols;
+            for (int ii = jj ; ii < nrows ; ii++) Ucol[ii] = Fcol[ii];
+
+            for (int k = 0 ; k < ncols ; k++) {
+                const Real * L21 = F + k * m + ncols;
+                const Real w = L21[jj] * ctx->D[first + k];
+                if (w == 0.0) continue;
+                for (int ii = jj ; ii < nrows ; ii++) Ucol[ii] -= L21[ii] * w;
+            }
+        }
+
+        // store the columns of L, in the same order as the symbolic pattern
+        for (int c = 0 ; c < ncols ; c++) {
+            const int j = first + c;
+            std::copy(F + c * m + c + 1, F + (c + 1) * m, ctx->L_values + ctx->L_colptr[j]);
+        }
+
+        return true;
+    }
+
+    void runSupernodalTask(SupernodalContext * ctx, int s) {
+        helper::vector<Real> front;
+        for (int it = ctx->task_ptr[s] ; it < ctx->task_ptr[s+1] && !ctx->failed.load(std::memory_order_relaxed) ; it++) {
+            if (!factorizeSupernode(ctx, ctx->task_list[it], front)) ctx->failed = true;
+        }
+
+        // the last child to finish queues its parent
+        const int parent = ctx->super_parent[s];
+        if (parent >= 0 && ctx->pending[parent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ctx->scheduler->addTask(new SupernodalTask(this, ctx, parent, ctx->status));
+        }
+    }
+
+    template<class VecInt,class VecReal>
+    void LDL_supernodal_numeric(Real * M_values,Real * D,SparseLDLImplInvertData<VecInt,VecReal> * data) {
+        const int nsuper = (int) data->super_begin.size() - 1;
+
+        SupernodalContext ctx;
+        ctx.M_values = M_values;
+        ctx.L_colptr = data->L_colptr.data();
+        ctx.L_rowind = data->L_rowind.data();
+        ctx.L_values = data->L_values.data();
+        ctx.D = D;
+        ctx.super_begin = data->super_begin.data();
+        ctx.super_parent = data->super_parent.data();
+        ctx.super_child_ptr = data->super_child_ptr.data();
+        ctx.super_child = data->super_child.data();
+        ctx.super_relind_ptr = data->super_relind_ptr.data();
+        ctx.super_relind = data->super_relind.data();
+        ctx.super_entry_ptr = data->super_entry_ptr.data();
+        ctx.super_entry_row = data->super_entry_row.data();
+        ctx.super_entry_pos = data->super_entry_pos.data();
+        ctx.failed = false;
+
+        super_update.resize(nsuper);
+
+        // the background thread of an asynchronous solver is not a worker of the task scheduler
+        simulation::TaskScheduler * scheduler = (d_parallelFactorization.getValue() && !ThreadManager::isAsyncSolver()) ? simulation::TaskScheduler::getInstance() : nullptr;
+
+        if (scheduler == nullptr || scheduler->getThreadCount() < 2) {
+            // children are always numbered before their parent
+            helper::vector<Real> front;
+            for (int s = 0 ; s < nsuper && !ctx.failed ; s++) {
+                if (!factorizeSupernode(&ctx, s, front)) ctx.failed = true;
+            }
+        }
+        else {
+            // estimated cost of each subtree
+            helper::vector<double> work(nsuper, 0.0);
+            double totalWork = 0.0;
+            for (int s = 0 ; s < nsuper ; s++) {
+                const double ncols = data->super_begin[s+1] - data->super_begin[s];
+                const double m = ncols + (data->super_relind_ptr[s+1] - data->super_relind_ptr[s]);
+                work[s] += m * m * ncols;
+                if (data->super_parent[s] >= 0) work[data->super_parent[s]] += work[s];
+                else totalWork += work[s];
+            }
+            const double grain = totalWork / (8.0 * scheduler->getThreadCount());
+
+            // owner: the supernode whose task factorizes s. A light subtree hanging from a heavy
+            // supernode (or a root) is a single task, a heavy supernode is a task of its own
+            helper::vector<int> owner(nsuper);
+            for (int s = nsuper - 1 ; s >= 0 ; s--) {
+                const int parent = data->super_parent[s];
+                owner[s] = (parent >= 0 && work[parent] < grain) ? owner[parent] : s;
+            }
+
+            ctx.task_ptr.clear();
+            ctx.task_ptr.resize(nsuper + 1, 0);
+            for (int s = 0 ; s < nsuper ; s++) ctx.task_ptr[owner[s] + 1]++;
+            for (int s = 0 ; s < nsuper ; s++) ctx.task_ptr[s+1] += ctx.task_ptr[s];
+            ctx.task_list.resize(nsuper);
+            helper::vector<int> fill(ctx.task_ptr.begin(), ctx.task_ptr.end() - 1);
+            for (int s = 0 ; s < nsuper ; s++) ctx.task_list[fill[owner[s]]++] = s;
+
+            ctx.pending.reset(new std::atomic<int>[nsuper]);
+            for (int s = 0 ; s < nsuper ; s++) ctx.pending[s] = 0;
+            for (int s = 0 ; s < nsuper ; s++) {
+                const int parent = data->super_parent[s];
+                if (owner[s] == s && parent >= 0) ctx.pending[parent]++;
+            }
+
+            simulation::Task::Status status;
+            ctx.scheduler = scheduler;
+            ctx.status = &status;
+
+            // the tasks are set up before any of them runs: a task may queue its parent at once
+            helper::vector<int> ready;
+            for (int s = 0 ; s < nsuper ; s++) {
+                if (owner[s] == s && ctx.pending[s] == 0) ready.push_back(s);
+            }
+            for (size_t i = 0 ; i < ready.size() ; i++) {
+                scheduler->addTask(new SupernodalTask(this, &ctx, ready[i], &status));
+            }
+            scheduler->workUntilDone(&status);
+        }
+
+        if (ctx.failed) {
+            msg_error("SparseLDLSolver") << "Failed to factorize, D(k,k) is zero" ;
+        }
+    }
+
     template<class VecInt,class VecReal>
     void factorize(int n,int * M_colptr, int * M_rowind, Real * M_values, SparseLDLImplInvertData<VecInt,VecReal> * data) {
         data->new_factorization_needed = data->P_colptr.size() == 0 || data->P_rowind.size() == 0 || CSPARSE_need_symbolic_factorization(n, M_colptr, M_rowind, data->n,
@@ -319,6 +700,22 @@ protected :
             data->L_values.clear();data->L_values.fastResize(data->L_nnz);
             data->LT_rowind.clear();data->LT_rowind.fastResize(data->L_nnz);
             data->LT_values.clear();data->LT_values.fastResize(data->L_nnz);
+
+            data->super_begin.clear();
+        }
+
+        // the supernodal structure is built once per symbolic factorization
+        if (d_supernodal.getValue() && data->super_begin.empty()) {
+            Lnz.resize(data->n);
+            Flag.resize(data->n);
+            CSPARSE_symbolic_pattern(data->n,M_colptr,M_rowind,data->L_colptr.data(),data->L_rowind.data(),
+                                     data->perm.data(),data->invperm.data(),data->Parent.data(),Flag.data(),Lnz.data());
+            CSPARSE_supernodal_symbolic(data->n,data->L_colptr.data(),data->L_rowind.data(),data->Parent.data(),
+                                        data->super_begin,data->super_parent,data->super_child_ptr,data->super_child,
+                                        data->super_relind_ptr,data->super_relind);
+            CSPARSE_supernodal_entries(data->n,M_colptr,M_rowind,data->perm.data(),data->invperm.data(),
+                                       data->super_entry_ptr,data->super_entry_row,data->super_entry_pos);
+            msg_info() << data->super_begin.size() - 1 << " supernodes for " << data->n << " columns" ;
         }
 
         Real * D = data->invD.data();
@@ -330,8 +727,13 @@ protected :
         Real * tran_values = data->LT_values.data();
 
         //Numeric Factorization
-        LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
-                    data->perm.data(),data->invperm.data(),data->Parent.data());
+        if (d_supernodal.getValue()) {
+            LDL_supernodal_numeric(M_values,D,data);
+        }
+        else {
+            LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
+                        data->perm.data(),data->invperm.data(),data->Parent.data());
+        }
 
         //inverse the diagonal
         for (int i=0;i<data->n;i++) D[i] = 1.0/D[i];
@@ -371,6 +773,7 @@ protected : //the folowing variables are used during the factorization they cann
     helper::vector<Real> Y;
     helper::vector<int> Lnz,Flag,Pattern;
     helper::vector<int> tran_countvec;
+    helper::vector< helper::vector<Real> > super_update; ///< update matrix of each supernode, until its parent is factorized
 
 //    helper::vector<int> perm, invperm; //premutation inverse
 
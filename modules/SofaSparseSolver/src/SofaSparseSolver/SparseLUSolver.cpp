@@ -44,6 +44,7 @@ namespace linearsolver
 
 int SparseLUSolverClass = core::RegisterObject("Direct linear solver based on Sparse LU factorization, implemented with the CSPARSE library")
         .add< SparseLUSolver< CompressedRowSparseMatrix<double>,FullVector<double> > >()
+        .add< SparseLUSolver< CompressedRowSparseMatrix<double>,FullVector<double>,AsyncThreadManager > >()
         ;
 
 } // namespace linearsolver
@@ -82,6 +82,7 @@ public:
     Data<double> f_tol; ///< tolerance of factorization
 
     SparseLUSolver();
+    ~SparseLUSolver();
     void solve (Matrix& M, Vector& x, Vector& b) override;
     void invert(Matrix& M) override;
 
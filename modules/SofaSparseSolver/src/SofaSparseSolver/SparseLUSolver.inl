@@ -60,6 +60,13 @@ SparseLUSolver<TMatrix,TVector,TThreadManager>::SparseLUSolver()
 {
 }
 
+template<class TMatrix, class TVector,class TThreadManager>
+SparseLUSolver<TMatrix,TVector,TThreadManager>::~SparseLUSolver()
+{
+    // the background factorization uses the invert data
+    this->waitFactorization();
+}
+
 
 template<class TMatrix, class TVector,class TThreadManager>
 void SparseLUSolver<TMatrix,TVector,TThreadManager>::solve (Matrix& M, Vector& z, Vector& r)